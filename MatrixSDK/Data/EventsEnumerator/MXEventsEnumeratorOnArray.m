@@ -38,6 +38,7 @@
         // Copy the array of events references to be protected against mutation of
         // theMessages.
         // No need of a deep copy as the events it contains are immutable.
+        // Copying a store snapshot is free: it returns the same instance.
         messages = [theMessages copy];
         paginationPosition = messages.count;
     }
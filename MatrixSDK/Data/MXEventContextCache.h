@@ -0,0 +1,83 @@
+/*
+ Copyright 2016 OpenMarket Ltd
+
+ Licensed under the Apache License, Version 2.0 (the "License");
+ you may not use this file except in compliance with the License.
+ You may obtain a copy of the License at
+
+ http://www.apache.org/licenses/LICENSE-2.0
+
+ Unless required by applicable law or agreed to in writing, software
+ distributed under the License is distributed on an "AS IS" BASIS,
+ WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ See the License for the specific language governing permissions and
+ limitations under the License.
+ */
+
+#import <Foundation/Foundation.h>
+
+#import "MXJSONModels.h"
+#import "MXMemoryPressureHandler.h"
+
+/**
+ `MXEventContextCache` keeps the last event context windows (the response of /context
+ requests) used to open timelines on past events (permalinks, search results...).
+
+ A window is the list of events returned around an event with its pagination tokens and
+ the room state. Windows of the same room that overlap are merged. So, the context of any
+ event of a cached window can be provided without requesting the homeserver.
+
+ The least recently used windows are removed when the cache is full.
+ */
+@interface MXEventContextCache : NSObject <MXMemoryPressureHandler>
+
+/**
+ Create a cache.
+
+ @param capacity the max number of windows kept in the cache.
+ @return the newly created instance.
+ */
+- (instancetype)initWithCapacity:(NSUInteger)capacity;
+
+/**
+ Get the context of an event from the cache.
+
+ @param eventId the id of the event.
+ @param roomId the id of the room.
+ @return a MXEventContext built from a cached window. nil if the event is not in the cache.
+ */
+- (MXEventContext*)contextOfEvent:(NSString*)eventId inRoom:(NSString*)roomId;
+
+/**
+ Store the context of an event.
+
+ It is merged with the cached windows of the room it overlaps.
+
+ @param eventContext the /context response.
+ @param roomId the id of the room.
+ */
+- (void)storeContext:(MXEventContext*)eventContext inRoom:(NSString*)roomId;
+
+/**
+ Remove all cached windows of a room.
+
+ @param roomId the id of the room.
+ */
+- (void)removeContextsOfRoom:(NSString*)roomId;
+
+/**
+ Remove all cached windows.
+ */
+- (void)removeAllContexts;
+
+/**
+ The max number of windows kept in the cache.
+ */
+@property (nonatomic, readonly) NSUInteger capacity;
+
+/**
+ The current number of windows in the cache.
+ */
+@property (nonatomic, readonly) NSUInteger count;
+
+@end
@@ -0,0 +1,268 @@
+/*
+ Copyright 2016 OpenMarket Ltd
+
+ Licensed under the Apache License, Version 2.0 (the "License");
+ you may not use this file except in compliance with the License.
+ You may obtain a copy of the License at
+
+ http://www.apache.org/licenses/LICENSE-2.0
+
+ Unless required by applicable law or agreed to in writing, software
+ distributed under the License is distributed on an "AS IS" BASIS,
+ WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ See the License for the specific language governing permissions and
+ limitations under the License.
+ */
+
+#import "MXEventContextCache.h"
+
+#pragma mark - MXEventContextWindow
+/**
+ A continuous list of room events with the tokens to paginate around it.
+ */
+@interface MXEventContextWindow : NSObject
+
+@property (nonatomic) NSString *roomId;
+
+/**
+ The events in chronological order.
+ */
+@property (nonatomic) NSArray<MXEvent*> *events;
+
+/**
+ Index of `events` by event id.
+ */
+@property (nonatomic) NSDictionary<NSString*, NSNumber*> *indexesByEventId;
+
+/**
+ The token to paginate backwards from the first event.
+ */
+@property (nonatomic) NSString *start;
+
+/**
+ The token to paginate forwards from the last event.
+ */
+@property (nonatomic) NSString *end;
+
+/**
+ The state of the room at the last event.
+ */
+@property (nonatomic) NSArray<MXEvent*> *state;
+
+@end
+
+@implementation MXEventContextWindow
+
+- (instancetype)initWithRoomId:(NSString*)roomId events:(NSArray<MXEvent*>*)events start:(NSString*)start end:(NSString*)end state:(NSArray<MXEvent*>*)state
+{
+    self = [super init];
+    if (self)
+    {
+        _roomId = roomId;
+        _events = events;
+        _start = start;
+        _end = end;
+        _state = state;
+
+        NSMutableDictionary *indexesByEventId = [NSMutableDictionary dictionaryWithCapacity:events.count];
+        for (NSUInteger i = 0; i < events.count; i++)
+        {
+            NSString *eventId = events[i].eventId;
+            if (eventId)
+            {
+                indexesByEventId[eventId] = @(i);
+            }
+        }
+        _indexesByEventId = indexesByEventId;
+    }
+    return self;
+}
+
+- (instancetype)initWithEventContext:(MXEventContext*)eventContext roomId:(NSString*)roomId
+{
+    NSMutableArray<MXEvent*> *events = [NSMutableArray arrayWithCapacity:eventContext.eventsBefore.count + 1 + eventContext.eventsAfter.count];
+
+    // eventsBefore are in antichronological order
+    [events addObjectsFromArray:eventContext.eventsBefore.reverseObjectEnumerator.allObjects];
+    if (eventContext.event)
+    {
+        [events addObject:eventContext.event];
+    }
+    [events addObjectsFromArray:eventContext.eventsAfter];
+
+    return [self initWithRoomId:roomId events:events start:eventContext.start end:eventContext.end state:eventContext.state];
+}
+
+- (MXEventContext*)contextOfEvent:(NSString*)eventId
+{
+    NSNumber *index = _indexesByEventId[eventId];
+    if (!index)
+    {
+        return nil;
+    }
+
+    NSUInteger i = index.unsignedIntegerValue;
+
+    MXEventContext *eventContext = [[MXEventContext alloc] init];
+    eventContext.event = _events[i];
+    eventContext.eventsBefore = [[_events subarrayWithRange:NSMakeRange(0, i)] reverseObjectEnumerator].allObjects;
+    eventContext.eventsAfter = [_events subarrayWithRange:NSMakeRange(i + 1, _events.count - i - 1)];
+    eventContext.start = _start;
+    eventContext.end = _end;
+    eventContext.state = _state;
+
+    return eventContext;
+}
+
+/**
+ Merge with a window of the same room.
+
+ @param other the other window.
+ @return the merged window. nil if windows do not overlap.
+ */
+- (MXEventContextWindow*)windowByMergingWith:(MXEventContextWindow*)other
+{
+    MXEventContextWindow *older, *newer;
+
+    if (other.events.firstObject.eventId && _indexesByEventId[other.events.firstObject.eventId])
+    {
+        older = self;
+        newer = other;
+    }
+    else if (_events.firstObject.eventId && other.indexesByEventId[_events.firstObject.eventId])
+    {
+        older = other;
+        newer = self;
+    }
+    else
+    {
+        return nil;
+    }
+
+    // Is the newer window included in the older one?
+    if (!newer.indexesByEventId[older.events.lastObject.eventId])
+    {
+        return older;
+    }
+
+    NSUInteger overlapIndex = [older.indexesByEventId[newer.events.firstObject.eventId] unsignedIntegerValue];
+
+    NSMutableArray<MXEvent*> *events = [NSMutableArray arrayWithArray:[older.events subarrayWithRange:NSMakeRange(0, overlapIndex)]];
+    [events addObjectsFromArray:newer.events];
+
+    return [[MXEventContextWindow alloc] initWithRoomId:_roomId events:events start:older.start end:newer.end state:newer.state];
+}
+
+@end
+
+
+#pragma mark - MXEventContextCache
+@interface MXEventContextCache ()
+{
+    /**
+     The cached windows. The most recently used is the last one.
+     */
+    NSMutableArray<MXEventContextWindow*> *windows;
+}
+
+@end
+
+@implementation MXEventContextCache
+
+- (instancetype)initWithCapacity:(NSUInteger)capacity
+{
+    self = [super init];
+    if (self)
+    {
+        _capacity = capacity;
+        windows = [NSMutableArray arrayWithCapacity:capacity];
+    }
+    return self;
+}
+
+- (MXEventContext *)contextOfEvent:(NSString *)eventId inRoom:(NSString *)roomId
+{
+    for (MXEventContextWindow *window in windows)
+    {
+        if ([window.roomId isEqualToString:roomId] && window.indexesByEventId[eventId])
+        {
+            // Mark it as the most recently used
+            [windows removeObject:window];
+            [windows addObject:window];
+
+            return [window contextOfEvent:eventId];
+        }
+    }
+    return nil;
+}
+
+- (void)storeContext:(MXEventContext *)eventContext inRoom:(NSString *)roomId
+{
+    if (!_capacity || !roomId || !eventContext.event.eventId)
+    {
+        return;
+    }
+
+    MXEventContextWindow *newWindow = [[MXEventContextWindow alloc] initWithEventContext:eventContext roomId:roomId];
+
+    // Merge it with windows it overlaps
+    for (MXEventContextWindow *window in [windows copy])
+    {
+        if ([window.roomId isEqualToString:roomId])
+        {
+            MXEventContextWindow *mergedWindow = [newWindow windowByMergingWith:window];
+            if (mergedWindow)
+            {
+                [windows removeObject:window];
+                newWindow = mergedWindow;
+            }
+        }
+    }
+
+    [windows addObject:newWindow];
+
+    // Remove the least recently used windows
+    while (windows.count > _capacity)
+    {
+        [windows removeObjectAtIndex:0];
+    }
+}
+
+- (void)removeContextsOfRoom:(NSString *)roomId
+{
+    for (MXEventContextWindow *window in [windows copy])
+    {
+        if ([window.roomId isEqualToString:roomId])
+        {
+            [windows removeObject:window];
+        }
+    }
+}
+
+- (void)removeAllContexts
+{
+    [windows removeAllObjects];
+}
+
+- (NSUInteger)count
+{
+    return windows.count;
+}
+
+
+#pragma mark - MXMemoryPressureHandler
+- (NSUInteger)handleMemoryPressure:(MXMemoryPressureLevel)level
+{
+    NSUInteger count = 0;
+
+    // Windows cost requests to the homeserver to be rebuilt
+    if (MXMemoryPressureLevelCritical == level)
+    {
+        count = windows.count;
+        [self removeAllContexts];
+    }
+
+    return count;
+}
+
+@end
@@ -0,0 +1,60 @@
+/*
+ Copyright 2016 OpenMarket Ltd
+
+ Licensed under the Apache License, Version 2.0 (the "License");
+ you may not use this file except in compliance with the License.
+ You may obtain a copy of the License at
+
+ http://www.apache.org/licenses/LICENSE-2.0
+
+ Unless required by applicable law or agreed to in writing, software
+ distributed under the License is distributed on an "AS IS" BASIS,
+ WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ See the License for the specific language governing permissions and
+ limitations under the License.
+ */
+
+#import <Foundation/Foundation.h>
+
+@class MXRoomState;
+
+/**
+ `MXEventSenderProfile` is the profile of the sender of an event as it was in the room
+ at the time of the event.
+
+ Instances are immutable. They are shared by the events of a sender as long as the room
+ members do not change.
+ */
+@interface MXEventSenderProfile : NSObject
+
+/**
+ Resolve the profile of a user in a room state.
+
+ @param userId the id of the user.
+ @param roomState the room state at the time of the event.
+ @return the newly created instance.
+ */
+- (instancetype)initWithUserId:(NSString*)userId roomState:(MXRoomState*)roomState;
+
+/**
+ The user id.
+ */
+@property (nonatomic, readonly) NSString *userId;
+
+/**
+ The display name of the member in the room. nil if the member has not set one.
+ */
+@property (nonatomic, readonly) NSString *displayname;
+
+/**
+ The name to display: the display name, disambiguated with the user id if another member
+ has the same one, or the user id (see [MXRoomState memberName:]).
+ */
+@property (nonatomic, readonly) NSString *disambiguatedName;
+
+/**
+ The url of the avatar of the member in the room.
+ */
+@property (nonatomic, readonly) NSString *avatarUrl;
+
+@end
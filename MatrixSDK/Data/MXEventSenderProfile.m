@@ -0,0 +1,43 @@
+/*
+ Copyright 2016 OpenMarket Ltd
+
+ Licensed under the Apache License, Version 2.0 (the "License");
+ you may not use this file except in compliance with the License.
+ You may obtain a copy of the License at
+
+ http://www.apache.org/licenses/LICENSE-2.0
+
+ Unless required by applicable law or agreed to in writing, software
+ distributed under the License is distributed on an "AS IS" BASIS,
+ WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ See the License for the specific language governing permissions and
+ limitations under the License.
+ */
+
+#import "MXEventSenderProfile.h"
+
+#import "MXRoomState.h"
+
+@implementation MXEventSenderProfile
+
+- (instancetype)initWithUserId:(NSString *)userId roomState:(MXRoomState *)roomState
+{
+    self = [super init];
+    if (self)
+    {
+        MXRoomMember *member = [roomState memberWithUserId:userId];
+
+        _userId = userId;
+        _displayname = member.displayname;
+        _avatarUrl = member.avatarUrl;
+        _disambiguatedName = [roomState memberName:userId];
+    }
+    return self;
+}
+
+- (NSString *)description
+{
+    return [NSString stringWithFormat:@"<MXEventSenderProfile: %p> %@ - %@", self, _userId, _disambiguatedName];
+}
+
+@end
@@ -20,6 +20,7 @@
 #import "MXJSONModels.h"
 #import "MXRoomState.h"
 #import "MXHTTPOperation.h"
+#import "MXMemoryPressureHandler.h"
 
 /**
  Prefix used to build fake invite event.
@@ -53,7 +54,7 @@ typedef void (^MXOnRoomEvent)(MXEvent *event, MXTimelineDirection direction, MXR
       with events on calls of [MXEventTimeline paginate] in backwards or forwards direction.
       Events are stored in a in-memory store (MXMemoryStore) (@TODO: To be confirmed once they will be implemented). So, they are not permanent.
  */
-@interface MXEventTimeline : NSObject
+@interface MXEventTimeline : NSObject <MXMemoryPressureHandler>
 
 /**
  The initial event id used to initialise the timeline.
@@ -134,12 +135,15 @@ typedef void (^MXOnRoomEvent)(MXEvent *event, MXTimelineDirection direction, MXR
  Reset the pagination timelime and start loading the context around its `initialEventId`.
  The retrieved (backwards and forwards) events will be sent to registered listeners.
 
+ If the event belongs to a context recently loaded, the data comes from
+ `[MXSession eventContextCache]` and no request is made.
+
  @param limit the maximum number of messages to get around the initial event.
 
  @param success A block object called when the operation succeeds.
  @param failure A block object called when the operation fails.
 
- @return a MXHTTPOperation instance.
+ @return a MXHTTPOperation instance. nil if the context has been found in the cache.
  */
 - (MXHTTPOperation*)resetPaginationAroundInitialEventWithLimit:(NSUInteger)limit
                                                        success:(void(^)())success
@@ -192,6 +196,17 @@ typedef void (^MXOnRoomEvent)(MXEvent *event, MXTimelineDirection direction, MXR
  */
 - (void)handleInvitedRoomSync:(MXInvitedRoomSync *)invitedRoomSync;
 
+/**
+ For live timeline, initialise the room data from a /rooms/{roomId}/initialSync response.
+
+ This is used to display a room just after joining it without waiting for the next /sync
+ response. When this response comes, its data is reconciled with the current one: if
+ they overlap, the timeline is not flushed and already known events are ignored.
+
+ @param roomInitialSync the response to the /initialSync request.
+ */
+- (void)handleRoomInitialSync:(MXRoomInitialSync*)roomInitialSync;
+
 
 #pragma mark - Events listeners
 /**
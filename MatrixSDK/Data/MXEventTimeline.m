@@ -20,11 +20,17 @@
 #import "MXMemoryStore.h"
 
 #import "MXError.h"
+#import "MXSDKOptions.h"
 
 #import "MXEventsEnumeratorOnArray.h"
 
 NSString *const kMXRoomInviteStateEventIdPrefix = @"invite-";
 
+/**
+ The number of live state changes between two snapshots of the room state in the store.
+ */
+#define MXEVENTTIMELINE_STATE_CHECKPOINT_INTERVAL 50
+
 @interface MXEventTimeline ()
 {
     // The list of event listeners (`MXEventListener`) of this timeline.
@@ -52,11 +58,36 @@ NSString *const kMXRoomInviteStateEventIdPrefix = @"invite-";
     // past timelines is managed locally.
     NSString *forwardsPaginationToken;
     BOOL hasReachedHomeServerForwardsPaginationEnd;
+
+    /**
+     The events of a cached context window that are beyond the requested limit. They are
+     provided by the next paginations before requesting the homeserver.
+     The closest events to the initial event come first.
+     */
+    NSMutableArray<MXEvent*> *cachedEventsBefore;
+    NSMutableArray<MXEvent*> *cachedEventsAfter;
     
     /**
      The current pending request.
      */
     MXHTTPOperation *httpOperation;
+
+    /**
+     YES when the room data comes from a fast join (/initialSync) and the next /sync
+     response for the room, which overlaps it, has not been received yet.
+     */
+    BOOL isWaitingForSyncReconciliation;
+
+    /**
+     The number of live state events received since the last state checkpoint.
+     */
+    NSUInteger stateEventsSinceCheckpoint;
+
+    /**
+     The number of state events back paginated from the homeserver since the last state
+     checkpoint.
+     */
+    NSUInteger backStateEventsSinceCheckpoint;
 }
 @end
 
@@ -138,6 +169,7 @@ NSString *const kMXRoomInviteStateEventIdPrefix = @"invite-";
         //  - did we end to paginate from the MXStore?
         //  - did we reach the top of the pagination in our requests to the home server?
         canPaginate = (0 < storeMessagesEnumerator.remaining)
+            || (0 < cachedEventsBefore.count)
             || ![store hasReachedHomeServerPaginationEndForRoom:_state.roomId];
     }
     else
@@ -149,7 +181,7 @@ NSString *const kMXRoomInviteStateEventIdPrefix = @"invite-";
         }
         else
         {
-            canPaginate = !hasReachedHomeServerForwardsPaginationEnd;
+            canPaginate = (0 < cachedEventsAfter.count) || !hasReachedHomeServerForwardsPaginationEnd;
         }
     }
 
@@ -160,6 +192,7 @@ NSString *const kMXRoomInviteStateEventIdPrefix = @"invite-";
 {
     // Reset the back state to the current room state
     backState = [[MXRoomState alloc] initBackStateWith:_state];
+    backStateEventsSinceCheckpoint = 0;
 
     // Reset store pagination
     storeMessagesEnumerator = [store messagesEnumeratorForRoom:_state.roomId];
@@ -175,35 +208,80 @@ NSString *const kMXRoomInviteStateEventIdPrefix = @"invite-";
 
     forwardsPaginationToken = nil;
     hasReachedHomeServerForwardsPaginationEnd = NO;
+    cachedEventsBefore = nil;
+    cachedEventsAfter = nil;
 
-    // Get the context around the initial event
-    return [room.mxSession.matrixRestClient contextOfEvent:_initialEventId inRoom:room.roomId limit:limit success:^(MXEventContext *eventContext) {
-
-        // And fill the timelime with received data
-        [self initialiseState:eventContext.state];
-
-        // Reset pagination state from here
-        [self resetPagination];
+    // Use the cached context if the event has been recently displayed
+    MXEventContext *cachedEventContext = [room.mxSession.eventContextCache contextOfEvent:_initialEventId inRoom:room.roomId];
+    if (cachedEventContext)
+    {
+        NSLog(@"[MXEventTimeline] resetPaginationAroundInitialEventWithLimit: Use cached context for %@", _initialEventId);
 
-        [self addEvent:eventContext.event direction:MXTimelineDirectionForwards fromStore:NO];
+        // The cached window may be larger than the requested one. Split the limit like the
+        // homeserver does and keep the other events for the next paginations
+        NSUInteger limitBefore = limit / 2;
+        NSUInteger limitAfter = limit - limitBefore;
 
-        for (MXEvent *event in eventContext.eventsBefore)
+        if (cachedEventContext.eventsBefore.count > limitBefore)
         {
-            [self addEvent:event direction:MXTimelineDirectionBackwards fromStore:NO];
+            cachedEventsBefore = [NSMutableArray arrayWithArray:[cachedEventContext.eventsBefore subarrayWithRange:NSMakeRange(limitBefore, cachedEventContext.eventsBefore.count - limitBefore)]];
+            cachedEventContext.eventsBefore = [cachedEventContext.eventsBefore subarrayWithRange:NSMakeRange(0, limitBefore)];
         }
-
-        for (MXEvent *event in eventContext.eventsAfter)
+        if (cachedEventContext.eventsAfter.count > limitAfter)
         {
-            [self addEvent:event direction:MXTimelineDirectionForwards fromStore:NO];
+            cachedEventsAfter = [NSMutableArray arrayWithArray:[cachedEventContext.eventsAfter subarrayWithRange:NSMakeRange(limitAfter, cachedEventContext.eventsAfter.count - limitAfter)]];
+            cachedEventContext.eventsAfter = [cachedEventContext.eventsAfter subarrayWithRange:NSMakeRange(0, limitAfter)];
         }
 
-        [store storePaginationTokenOfRoom:room.roomId andToken:eventContext.start];
-        forwardsPaginationToken = eventContext.end;
+        // Behave like the request: the caller gets the events after the method returns
+        dispatch_async(dispatch_get_main_queue(), ^{
+
+            [self initialiseWithEventContext:cachedEventContext];
+            success();
+        });
+        return nil;
+    }
+
+    // Get the context around the initial event
+    return [room.mxSession.matrixRestClient contextOfEvent:_initialEventId inRoom:room.roomId limit:limit success:^(MXEventContext *eventContext) {
+
+        [room.mxSession.eventContextCache storeContext:eventContext inRoom:room.roomId];
+
+        // And fill the timelime with received data
+        [self initialiseWithEventContext:eventContext];
 
         success();
     } failure:failure];
 }
 
+/**
+ Fill the timeline with the events around the initial event.
+
+ @param eventContext the context of the initial event.
+ */
+- (void)initialiseWithEventContext:(MXEventContext*)eventContext
+{
+    [self initialiseState:eventContext.state];
+
+    // Reset pagination state from here
+    [self resetPagination];
+
+    [self addEvent:eventContext.event direction:MXTimelineDirectionForwards fromStore:NO];
+
+    for (MXEvent *event in eventContext.eventsBefore)
+    {
+        [self addEvent:event direction:MXTimelineDirectionBackwards fromStore:NO];
+    }
+
+    for (MXEvent *event in eventContext.eventsAfter)
+    {
+        [self addEvent:event direction:MXTimelineDirectionForwards fromStore:NO];
+    }
+
+    [store storePaginationTokenOfRoom:room.roomId andToken:eventContext.start];
+    forwardsPaginationToken = eventContext.end;
+}
+
 
 - (MXHTTPOperation *)paginate:(NSUInteger)numItems direction:(MXTimelineDirection)direction onlyFromStore:(BOOL)onlyFromStore complete:(void (^)())complete failure:(void (^)(NSError *))failure
 {
@@ -215,6 +293,24 @@ NSString *const kMXRoomInviteStateEventIdPrefix = @"invite-";
     
     NSUInteger messagesFromStoreCount = 0;
 
+    // Provide first the events kept from a cached context window
+    NSMutableArray<MXEvent*> *cachedEvents = (direction == MXTimelineDirectionBackwards) ? cachedEventsBefore : cachedEventsAfter;
+    if (cachedEvents.count)
+    {
+        NSRange range = NSMakeRange(0, MIN(numItems, cachedEvents.count));
+
+        NSLog(@"[MXEventTimeline] paginate %tu messages in %@ (%tu are retrieved from the cached context)", numItems, _state.roomId, range.length);
+
+        for (MXEvent *event in [cachedEvents subarrayWithRange:range])
+        {
+            [self addEvent:event direction:direction fromStore:NO];
+        }
+        [cachedEvents removeObjectsInRange:range];
+
+        complete();
+        return nil;
+    }
+
     if (direction == MXTimelineDirectionBackwards)
     {
         // For back pagination, try to get messages from the store first
@@ -349,6 +445,9 @@ NSString *const kMXRoomInviteStateEventIdPrefix = @"invite-";
     // Is it an initial sync for this room?
     BOOL isRoomInitialSync = (self.state.membership == MXMembershipUnknown || self.state.membership == MXMembershipInvite);
 
+    // Did the room data get flushed because of a gap in the timeline?
+    BOOL hasFlushedMessages = NO;
+
     // Check whether the room was pending on an invitation.
     if (self.state.membership == MXMembershipInvite)
     {
@@ -357,14 +456,23 @@ NSString *const kMXRoomInviteStateEventIdPrefix = @"invite-";
         [store deleteRoom:self.state.roomId];
     }
 
+    // After a fast join, the first /sync response overlaps the data got from /initialSync.
+    // There is no gap if one of its events is already known.
+    BOOL isReconciledWithFastJoin = !isRoomInitialSync && isWaitingForSyncReconciliation && [self containsOneOfEvents:roomSync.timeline.events];
+
     // Build/Update first the room state corresponding to the 'start' of the timeline.
     // Note: We consider it is not required to clone the existing room state here, because no notification is posted for these events.
-    for (MXEvent *event in roomSync.state.events)
+    // When the response is reconciled with a fast join, this state is older than the current one, which is
+    // the /initialSync state updated by the known timeline events. It must not be applied.
+    if (!isReconciledWithFastJoin)
     {
-        // Report the room id in the event as it is skipped in /sync response
-        event.roomId = _state.roomId;
+        for (MXEvent *event in roomSync.state.events)
+        {
+            // Report the room id in the event as it is skipped in /sync response
+            event.roomId = _state.roomId;
 
-        [self handleStateEvent:event direction:MXTimelineDirectionForwards];
+            [self handleStateEvent:event direction:MXTimelineDirectionForwards];
+        }
     }
 
     // Update store with new room state when all state event have been processed
@@ -373,6 +481,14 @@ NSString *const kMXRoomInviteStateEventIdPrefix = @"invite-";
         [store storeStateForRoom:_state.roomId stateEvents:_state.stateEvents];
     }
 
+    // The state at the start of a new timeline chunk is the first checkpoint of this chunk
+    NSArray<MXEvent*> *timelineStartState;
+    if ((isRoomInitialSync || roomSync.timeline.limited) && roomSync.timeline.events.count
+        && [store respondsToSelector:@selector(storeStateCheckpointForRoom:stateEvents:beforeEvent:)])
+    {
+        timelineStartState = _state.stateEvents;
+    }
+
     // Handle now timeline.events, the room state is updated during this step too (Note: timeline events are in chronological order)
     if (isRoomInitialSync)
     {
@@ -396,8 +512,16 @@ NSString *const kMXRoomInviteStateEventIdPrefix = @"invite-";
         // Check whether some events have not been received from server.
         if (roomSync.timeline.limited)
         {
-            // Flush the existing messages for this room by keeping state events.
-            [store deleteAllMessagesInRoom:_state.roomId];
+            if (isReconciledWithFastJoin)
+            {
+                NSLog(@"[MXEventTimeline] handleJoinedRoomSync: /sync data reconciled with fast join data in %@", _state.roomId);
+            }
+            else
+            {
+                // Flush the existing messages for this room by keeping state events.
+                [store deleteAllMessagesInRoom:_state.roomId];
+                hasFlushedMessages = YES;
+            }
         }
 
         for (MXEvent *event in roomSync.timeline.events)
@@ -411,11 +535,18 @@ NSString *const kMXRoomInviteStateEventIdPrefix = @"invite-";
     }
 
     // In case of limited timeline, update token where to start back pagination
-    if (roomSync.timeline.limited)
+    // (the current token is still valid if the data has been reconciled with a fast join)
+    if (roomSync.timeline.limited && (isRoomInitialSync || hasFlushedMessages))
     {
         [store storePaginationTokenOfRoom:_state.roomId andToken:roomSync.timeline.prevBatch];
     }
 
+    if (timelineStartState && (isRoomInitialSync || hasFlushedMessages))
+    {
+        [store storeStateCheckpointForRoom:_state.roomId stateEvents:timelineStartState beforeEvent:roomSync.timeline.events.firstObject.eventId];
+        stateEventsSinceCheckpoint = 0;
+    }
+
     // Finalize initial sync
     if (isRoomInitialSync)
     {
@@ -424,13 +555,15 @@ NSString *const kMXRoomInviteStateEventIdPrefix = @"invite-";
                                                             object:room
                                                           userInfo:nil];
     }
-    else if (roomSync.timeline.limited)
+    else if (hasFlushedMessages)
     {
         // The room has been resync with a limited timeline - Post notification
         [[NSNotificationCenter defaultCenter] postNotificationName:kMXRoomDidFlushDataNotification
                                                             object:room
                                                           userInfo:nil];
     }
+
+    isWaitingForSyncReconciliation = NO;
 }
 
 - (void)handleInvitedRoomSync:(MXInvitedRoomSync *)invitedRoomSync
@@ -451,6 +584,28 @@ NSString *const kMXRoomInviteStateEventIdPrefix = @"invite-";
     }
 }
 
+- (void)handleRoomInitialSync:(MXRoomInitialSync *)roomInitialSync
+{
+    // Convert the /initialSync response into a /sync one.
+    // Note: /initialSync provides the current room state and not the state at the start of the timeline.
+    // As the timeline ends with the last events of the room, the state is the current one once the timeline
+    // state events have been processed.
+    MXRoomSync *roomSync = [[MXRoomSync alloc] init];
+
+    roomSync.state = [[MXRoomSyncState alloc] init];
+    roomSync.state.events = roomInitialSync.state;
+
+    roomSync.timeline = [[MXRoomSyncTimeline alloc] init];
+    roomSync.timeline.events = roomInitialSync.messages.chunk;
+    roomSync.timeline.prevBatch = roomInitialSync.messages.start;
+    roomSync.timeline.limited = YES;
+
+    [self handleJoinedRoomSync:roomSync];
+
+    // The next /sync response will contain data we already have
+    isWaitingForSyncReconciliation = YES;
+}
+
 - (void)handlePaginationResponse:(MXPaginationResponse*)paginatedResponse direction:(MXTimelineDirection)direction
 {
     // Check pagination end - @see SPEC-319 ticket
@@ -509,6 +664,17 @@ NSString *const kMXRoomInviteStateEventIdPrefix = @"invite-";
         return;
     }
 
+    // Snapshot the live state periodically so that the store can rebuild the state at
+    // any message without replaying it from the current state
+    NSArray<MXEvent*> *stateCheckpoint;
+    if (event.isState && _isLiveTimeline && direction == MXTimelineDirectionForwards && !fromStore
+        && ++stateEventsSinceCheckpoint >= MXEVENTTIMELINE_STATE_CHECKPOINT_INTERVAL
+        && [store respondsToSelector:@selector(storeStateCheckpointForRoom:stateEvents:beforeEvent:)])
+    {
+        stateCheckpoint = _state.stateEvents;
+        stateEventsSinceCheckpoint = 0;
+    }
+
     // State event updates the timeline room state
     if (event.isState)
     {
@@ -523,6 +689,32 @@ NSString *const kMXRoomInviteStateEventIdPrefix = @"invite-";
         }
     }
 
+    if (_isLiveTimeline && direction == MXTimelineDirectionBackwards)
+    {
+        if (fromStore)
+        {
+            // A checkpoint is the state before the event. Resync the back state on it: the
+            // replay of prev_contents drifts when they are missing or redacted
+            NSArray<MXEvent*> *checkpoint;
+            if ([store respondsToSelector:@selector(stateCheckpointOfRoom:beforeEvent:)])
+            {
+                checkpoint = [store stateCheckpointOfRoom:_state.roomId beforeEvent:event.eventId];
+            }
+            if (checkpoint)
+            {
+                backState = [[MXRoomState alloc] initBackStateWithRoomId:_state.roomId andMatrixSession:room.mxSession andStateEvents:checkpoint];
+            }
+        }
+        else if (event.isState
+                 && ++backStateEventsSinceCheckpoint >= MXEVENTTIMELINE_STATE_CHECKPOINT_INTERVAL
+                 && [store respondsToSelector:@selector(storeStateCheckpointForRoom:stateEvents:beforeEvent:)])
+        {
+            // Snapshot the history too
+            stateCheckpoint = backState.stateEventsSnapshot;
+            backStateEventsSinceCheckpoint = 0;
+        }
+    }
+
     // Events going forwards on the live timeline come from /sync.
     // They are assimilated to live events.
     if (_isLiveTimeline && direction == MXTimelineDirectionForwards)
@@ -546,6 +738,17 @@ NSString *const kMXRoomInviteStateEventIdPrefix = @"invite-";
     if (!fromStore)
     {
         [store storeEventForRoom:_state.roomId event:event direction:direction];
+
+        if (stateCheckpoint)
+        {
+            [store storeStateCheckpointForRoom:_state.roomId stateEvents:stateCheckpoint beforeEvent:event.eventId];
+        }
+    }
+
+    // Resolve the sender profile once for all renderings of the event
+    if ([MXSDKOptions sharedInstance].enableEventSenderProfileDecoration)
+    {
+        event.senderProfile = [[self stateOfEvent:event direction:direction] senderProfile:event.sender];
     }
 
     // Notify listeners
@@ -557,13 +760,18 @@ NSString *const kMXRoomInviteStateEventIdPrefix = @"invite-";
 {
     NSLog(@"[MXEventTimeline] handle an event redaction");
     
+    // Cached contexts may contain the redacted event
+    [room.mxSession.eventContextCache removeContextsOfRoom:_state.roomId];
+
     // Check whether the redacted event is stored in room messages
     MXEvent *redactedEvent = [store eventWithEventId:redactionEvent.redacts inRoom:_state.roomId];
     if (redactedEvent)
     {
         // Redact the stored event
+        MXEventSenderProfile *senderProfile = redactedEvent.senderProfile;
         redactedEvent = [redactedEvent prune];
         redactedEvent.redactedBecause = redactionEvent.JSONDictionary;
+        redactedEvent.senderProfile = senderProfile;
 
         // Store the updated event
         [store replaceEvent:redactedEvent inRoom:_state.roomId];
@@ -696,6 +904,37 @@ NSString *const kMXRoomInviteStateEventIdPrefix = @"invite-";
 }
 
 #pragma mark - State events handling
+/**
+ Get the room state at the time of an event that has just been added to the timeline.
+
+ @param event the event.
+ @param direction the direction the event has been added.
+ @return the room state before the event.
+ */
+- (MXRoomState*)stateOfEvent:(MXEvent*)event direction:(MXTimelineDirection)direction
+{
+    MXRoomState *roomState;
+
+    if (MXTimelineDirectionBackwards == direction)
+    {
+        roomState = backState;
+    }
+    else
+    {
+        if ([event isState])
+        {
+            // Provide the state of the room before this event
+            roomState = previousState;
+        }
+        else
+        {
+            roomState = _state;
+        }
+    }
+
+    return roomState;
+}
+
 - (void)cloneState:(MXTimelineDirection)direction
 {
     // create a new instance of the state
@@ -733,9 +972,11 @@ NSString *const kMXRoomInviteStateEventIdPrefix = @"invite-";
             MXRoomMember *roomMember = [_state memberWithUserId:event.sender];
             if (roomMember && MXMembershipJoin == roomMember.membership)
             {
-                [user updateWithRoomMemberEvent:event roomMember:roomMember inMatrixSession:room.mxSession];
-
-                [room.mxSession.store storeUser:user];
+                // Store the user only when his profile has changed
+                if ([user updateWithRoomMemberEvent:event roomMember:roomMember inMatrixSession:room.mxSession])
+                {
+                    [room.mxSession.store storeUser:user];
+                }
             }
         }
     }
@@ -769,24 +1010,7 @@ NSString *const kMXRoomInviteStateEventIdPrefix = @"invite-";
 
 - (void)notifyListeners:(MXEvent*)event direction:(MXTimelineDirection)direction
 {
-    MXRoomState * roomState;
-
-    if (MXTimelineDirectionBackwards == direction)
-    {
-        roomState = backState;
-    }
-    else
-    {
-        if ([event isState])
-        {
-            // Provide the state of the room before this event
-            roomState = previousState;
-        }
-        else
-        {
-            roomState = _state;
-        }
-    }
+    MXRoomState * roomState = [self stateOfEvent:event direction:direction];
 
     // Notify all listeners
     // The SDK client may remove a listener while calling them by enumeration
@@ -803,4 +1027,40 @@ NSString *const kMXRoomInviteStateEventIdPrefix = @"invite-";
     }
 }
 
+
+#pragma mark - MXMemoryPressureHandler
+- (NSUInteger)handleMemoryPressure:(MXMemoryPressureLevel)level
+{
+    NSUInteger count = [_state handleMemoryPressure:level] + [backState handleMemoryPressure:level];
+
+    // The previous state is only used while an event is being added
+    if (MXMemoryPressureLevelCritical == level && previousState)
+    {
+        previousState = nil;
+        count++;
+    }
+
+    return count;
+}
+
+
+#pragma mark - Fast join
+/**
+ Check whether one of the events is already in the store.
+
+ @param events the events to check.
+ @return YES if one of them is known.
+ */
+- (BOOL)containsOneOfEvents:(NSArray<MXEvent*>*)events
+{
+    for (MXEvent *event in events)
+    {
+        if (event.eventId && [store eventExistsWithEventId:event.eventId inRoom:_state.roomId])
+        {
+            return YES;
+        }
+    }
+    return NO;
+}
+
 @end
@@ -0,0 +1,71 @@
+/*
+ Copyright 2016 OpenMarket Ltd
+
+ Licensed under the Apache License, Version 2.0 (the "License");
+ you may not use this file except in compliance with the License.
+ You may obtain a copy of the License at
+
+ http://www.apache.org/licenses/LICENSE-2.0
+
+ Unless required by applicable law or agreed to in writing, software
+ distributed under the License is distributed on an "AS IS" BASIS,
+ WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ See the License for the specific language governing permissions and
+ limitations under the License.
+ */
+
+#import <Foundation/Foundation.h>
+
+/**
+ `MXMemberProfile` is the profile (display name and avatar) of a user in one or more rooms.
+
+ Profiles are immutable and shared: all room members of a user with the same profile
+ reference the same instance, whatever the number of rooms and sessions. A user who has
+ a specific display name or avatar in some rooms has another instance for them.
+
+ The global profile table keeps only weak references on profiles: a profile is released
+ as soon as no more room member uses it.
+ */
+@interface MXMemberProfile : NSObject
+
+/**
+ Get the shared profile of a user.
+
+ @param userId the id of the user.
+ @param displayname the display name of the user. Can be nil.
+ @param avatarUrl the avatar url of the user. Can be nil.
+ @return an already existing profile with the same values if any. Else, a new profile
+         which is added to the global table.
+ */
++ (MXMemberProfile*)profileWithUserId:(NSString*)userId displayname:(NSString*)displayname avatarUrl:(NSString*)avatarUrl;
+
+/**
+ The number of distinct profiles currently alive.
+ */
++ (NSUInteger)count;
+
+/**
+ The user id.
+ */
+@property (nonatomic, readonly) NSString *userId;
+
+/**
+ The display name.
+ */
+@property (nonatomic, readonly) NSString *displayname;
+
+/**
+ The avatar url.
+ */
+@property (nonatomic, readonly) NSString *avatarUrl;
+
+/**
+ Check whether the profile has some values.
+
+ @param displayname the display name to compare. Can be nil.
+ @param avatarUrl the avatar url to compare. Can be nil.
+ @return YES if both values are equal to the profile ones.
+ */
+- (BOOL)hasDisplayname:(NSString*)displayname avatarUrl:(NSString*)avatarUrl;
+
+@end
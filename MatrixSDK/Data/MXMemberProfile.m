@@ -0,0 +1,131 @@
+/*
+ Copyright 2016 OpenMarket Ltd
+
+ Licensed under the Apache License, Version 2.0 (the "License");
+ you may not use this file except in compliance with the License.
+ You may obtain a copy of the License at
+
+ http://www.apache.org/licenses/LICENSE-2.0
+
+ Unless required by applicable law or agreed to in writing, software
+ distributed under the License is distributed on an "AS IS" BASIS,
+ WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ See the License for the specific language governing permissions and
+ limitations under the License.
+ */
+
+#import "MXMemberProfile.h"
+
+/**
+ The global profile table.
+ The key is the user id. The value is the weak list of the profiles of the user. There is
+ generally one, plus one per room specific profile.
+ */
+static NSMutableDictionary<NSString*, NSPointerArray*> *profilesByUserId;
+
+@implementation MXMemberProfile
+
++ (void)initialize
+{
+    if (self == [MXMemberProfile class])
+    {
+        profilesByUserId = [NSMutableDictionary dictionary];
+    }
+}
+
++ (MXMemberProfile *)profileWithUserId:(NSString *)userId displayname:(NSString *)displayname avatarUrl:(NSString *)avatarUrl
+{
+    if (!userId)
+    {
+        return [[MXMemberProfile alloc] initWithUserId:userId displayname:displayname avatarUrl:avatarUrl];
+    }
+
+    @synchronized(profilesByUserId)
+    {
+        NSPointerArray *profiles = profilesByUserId[userId];
+        if (!profiles)
+        {
+            profiles = [NSPointerArray weakObjectsPointerArray];
+            profilesByUserId[userId] = profiles;
+        }
+        else
+        {
+            [self compactProfiles:profiles];
+        }
+
+        for (MXMemberProfile *profile in profiles)
+        {
+            if ([profile hasDisplayname:displayname avatarUrl:avatarUrl])
+            {
+                return profile;
+            }
+        }
+
+        MXMemberProfile *profile = [[MXMemberProfile alloc] initWithUserId:userId displayname:displayname avatarUrl:avatarUrl];
+        [profiles addPointer:(__bridge void *)profile];
+
+        return profile;
+    }
+}
+
++ (NSUInteger)count
+{
+    NSUInteger count = 0;
+
+    @synchronized(profilesByUserId)
+    {
+        for (NSString *userId in profilesByUserId.allKeys)
+        {
+            NSPointerArray *profiles = profilesByUserId[userId];
+            [self compactProfiles:profiles];
+
+            if (profiles.count)
+            {
+                count += profiles.count;
+            }
+            else
+            {
+                [profilesByUserId removeObjectForKey:userId];
+            }
+        }
+    }
+
+    return count;
+}
+
+/**
+ Remove the released profiles from a list.
+
+ @param profiles the weak list of profiles.
+ */
++ (void)compactProfiles:(NSPointerArray*)profiles
+{
+    // [NSPointerArray compact] does nothing if no NULL has been explicitly added
+    [profiles addPointer:NULL];
+    [profiles compact];
+}
+
+- (instancetype)initWithUserId:(NSString*)userId displayname:(NSString*)displayname avatarUrl:(NSString*)avatarUrl
+{
+    self = [super init];
+    if (self)
+    {
+        _userId = [userId copy];
+        _displayname = [displayname copy];
+        _avatarUrl = [avatarUrl copy];
+    }
+    return self;
+}
+
+- (BOOL)hasDisplayname:(NSString *)displayname avatarUrl:(NSString *)avatarUrl
+{
+    return ((_displayname == displayname || [_displayname isEqualToString:displayname])
+            && (_avatarUrl == avatarUrl || [_avatarUrl isEqualToString:avatarUrl]));
+}
+
+- (NSString *)description
+{
+    return [NSString stringWithFormat:@"%@: %@ (%@)", _userId, _displayname, _avatarUrl];
+}
+
+@end
@@ -0,0 +1,111 @@
+/*
+ Copyright 2016 OpenMarket Ltd
+
+ Licensed under the Apache License, Version 2.0 (the "License");
+ you may not use this file except in compliance with the License.
+ You may obtain a copy of the License at
+
+ http://www.apache.org/licenses/LICENSE-2.0
+
+ Unless required by applicable law or agreed to in writing, software
+ distributed under the License is distributed on an "AS IS" BASIS,
+ WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ See the License for the specific language governing permissions and
+ limitations under the License.
+ */
+
+#import <Foundation/Foundation.h>
+
+#import "MXRestClient.h"
+
+/**
+ `MXPublicRoomDirectory` browses the public room directory of a homeserver page by page.
+
+ Instead of downloading the whole directory, rooms are fetched by pages of `pageSize`
+ rooms, optionally filtered by the homeserver with `searchTerm`. Pages are cached for
+ `cacheLifetime` seconds so that reopening the directory is immediate. The cache keeps
+ at most the 50 most recent pages.
+
+ Rooms already fetched can be filtered locally with `roomsMatchingFilter:`.
+ */
+@interface MXPublicRoomDirectory : NSObject
+
+/**
+ Create a `MXPublicRoomDirectory` instance.
+
+ @param restClient the client to the homeserver.
+ @return the newly created instance.
+ */
+- (instancetype)initWithRestClient:(MXRestClient*)restClient;
+
+/**
+ Get the next page of public rooms.
+
+ @param success A block object called when the operation succeeds. It provides the rooms of
+                the new page. They have been appended to `rooms`.
+ @param failure A block object called when the operation fails.
+
+ If a page is already being fetched, the caller waits for it: the blocks are called with
+ its result. `reset` drops the waiting callers without calling them back.
+
+ @return a MXHTTPOperation instance. nil if the page comes from the cache (the success block
+         has been already called) or if a page is already being fetched.
+ */
+- (MXHTTPOperation*)paginate:(void (^)(NSArray<MXPublicRoom*> *rooms))success
+                     failure:(void (^)(NSError *error))failure;
+
+/**
+ Restart the pagination from the first page.
+ */
+- (void)reset;
+
+/**
+ Filter the rooms fetched so far.
+
+ A room matches if every word of the filter is the beginning of a word of its name, its
+ topic or one of its aliases. The comparison is case and diacritic insensitive.
+
+ @param filter the text to search for.
+ @return the matching rooms in the directory order.
+ */
+- (NSArray<MXPublicRoom*>*)roomsMatchingFilter:(NSString*)filter;
+
+/**
+ Empty the cache of pages.
+ */
+- (void)removeAllCachedPages;
+
+/**
+ The text to filter the directory on the homeserver side.
+ Changing it restarts the pagination.
+ */
+@property (nonatomic) NSString *searchTerm;
+
+/**
+ The number of rooms to request per page.
+ Default is 20.
+ */
+@property (nonatomic) NSUInteger pageSize;
+
+/**
+ The time in seconds during which a page is served from the cache.
+ Default is 300s. 0 disables the cache.
+ */
+@property (nonatomic) NSTimeInterval cacheLifetime;
+
+/**
+ The rooms fetched so far.
+ */
+@property (nonatomic, readonly) NSArray<MXPublicRoom*> *rooms;
+
+/**
+ Tell whether there are more rooms to fetch.
+ */
+@property (nonatomic, readonly) BOOL hasMoreRooms;
+
+/**
+ The estimate of the total number of rooms given by the homeserver. 0 if unknown.
+ */
+@property (nonatomic, readonly) NSUInteger totalRoomCountEstimate;
+
+@end
@@ -0,0 +1,374 @@
+/*
+ Copyright 2016 OpenMarket Ltd
+
+ Licensed under the Apache License, Version 2.0 (the "License");
+ you may not use this file except in compliance with the License.
+ You may obtain a copy of the License at
+
+ http://www.apache.org/licenses/LICENSE-2.0
+
+ Unless required by applicable law or agreed to in writing, software
+ distributed under the License is distributed on an "AS IS" BASIS,
+ WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ See the License for the specific language governing permissions and
+ limitations under the License.
+ */
+
+#import "MXPublicRoomDirectory.h"
+
+/**
+ The default number of rooms per page.
+ */
+#define MXPUBLICROOMDIRECTORY_DEFAULT_PAGE_SIZE 20
+
+/**
+ The default lifetime of cached pages in seconds.
+ */
+#define MXPUBLICROOMDIRECTORY_DEFAULT_CACHE_LIFETIME 300
+
+/**
+ The maximum number of cached pages. The oldest ones are evicted first.
+ */
+#define MXPUBLICROOMDIRECTORY_MAX_CACHED_PAGES 50
+
+#pragma mark - MXPublicRoomDirectoryCachedPage
+@interface MXPublicRoomDirectoryCachedPage : NSObject
+
+@property (nonatomic) MXPublicRoomsResponse *publicRoomsResponse;
+@property (nonatomic) NSDate *date;
+
+@end
+
+@implementation MXPublicRoomDirectoryCachedPage
+@end
+
+
+#pragma mark - MXPublicRoomDirectory
+@interface MXPublicRoomDirectory ()
+{
+    MXRestClient *restClient;
+
+    /**
+     The token to get the next page. nil to get the first one.
+     */
+    NSString *nextBatch;
+
+    /**
+     The request in progress.
+     */
+    MXHTTPOperation *pendingOperation;
+
+    /**
+     The callbacks of the callers waiting for the page being fetched.
+     */
+    NSMutableArray<void (^)(NSArray<MXPublicRoom*> *rooms)> *pendingSuccessBlocks;
+    NSMutableArray<void (^)(NSError *error)> *pendingFailureBlocks;
+
+    /**
+     Cached pages by (search term, page size, since token) key.
+     */
+    NSMutableDictionary<NSArray*, MXPublicRoomDirectoryCachedPage*> *cache;
+
+    /**
+     The rooms fetched so far.
+     */
+    NSMutableArray<MXPublicRoom*> *rooms;
+
+    /**
+     The local index: the indexes in `rooms` by word.
+     */
+    NSMutableDictionary<NSString*, NSMutableIndexSet*> *roomIndexesByWord;
+}
+
+@end
+
+@implementation MXPublicRoomDirectory
+
+- (instancetype)initWithRestClient:(MXRestClient *)restClient2
+{
+    self = [super init];
+    if (self)
+    {
+        restClient = restClient2;
+        cache = [NSMutableDictionary dictionary];
+        rooms = [NSMutableArray array];
+        roomIndexesByWord = [NSMutableDictionary dictionary];
+        pendingSuccessBlocks = [NSMutableArray array];
+        pendingFailureBlocks = [NSMutableArray array];
+
+        _pageSize = MXPUBLICROOMDIRECTORY_DEFAULT_PAGE_SIZE;
+        _cacheLifetime = MXPUBLICROOMDIRECTORY_DEFAULT_CACHE_LIFETIME;
+        _hasMoreRooms = YES;
+    }
+    return self;
+}
+
+- (MXHTTPOperation*)paginate:(void (^)(NSArray<MXPublicRoom*> *rooms))success
+                     failure:(void (^)(NSError *error))failure
+{
+    if (pendingOperation)
+    {
+        // Wait for the page being fetched
+        NSLog(@"[MXPublicRoomDirectory] paginate: a page is already being fetched. Wait for it");
+        [self addPendingSuccess:success failure:failure];
+        return nil;
+    }
+
+    if (!_hasMoreRooms)
+    {
+        if (success)
+        {
+            success(@[]);
+        }
+        return nil;
+    }
+
+    NSArray *key = @[_searchTerm ? _searchTerm : @"", @(_pageSize), nextBatch ? nextBatch : @""];
+
+    // Is the page in the cache?
+    MXPublicRoomDirectoryCachedPage *cachedPage = cache[key];
+    if (cachedPage && -cachedPage.date.timeIntervalSinceNow < _cacheLifetime)
+    {
+        [self addPage:cachedPage.publicRoomsResponse];
+
+        if (success)
+        {
+            success(cachedPage.publicRoomsResponse.chunk ? cachedPage.publicRoomsResponse.chunk : @[]);
+        }
+        return nil;
+    }
+    [cache removeObjectForKey:key];
+
+    [self addPendingSuccess:success failure:failure];
+
+    __weak typeof(self) weakSelf = self;
+    __block MXHTTPOperation *operation;
+
+    operation = [restClient publicRoomsWithLimit:_pageSize since:nextBatch searchTerm:_searchTerm success:^(MXPublicRoomsResponse *publicRoomsResponse) {
+
+        __strong __typeof(weakSelf)strongSelf = weakSelf;
+
+        // Ignore the response if the pagination has been reset meanwhile
+        if (strongSelf && strongSelf->pendingOperation == operation)
+        {
+            strongSelf->pendingOperation = nil;
+
+            if (strongSelf.cacheLifetime)
+            {
+                [strongSelf cachePage:publicRoomsResponse withKey:key];
+            }
+
+            [strongSelf addPage:publicRoomsResponse];
+
+            NSArray<void (^)(NSArray<MXPublicRoom*> *rooms)> *successBlocks = [strongSelf->pendingSuccessBlocks copy];
+            [strongSelf->pendingSuccessBlocks removeAllObjects];
+            [strongSelf->pendingFailureBlocks removeAllObjects];
+
+            for (void (^successBlock)(NSArray<MXPublicRoom*> *rooms) in successBlocks)
+            {
+                successBlock(publicRoomsResponse.chunk ? publicRoomsResponse.chunk : @[]);
+            }
+        }
+
+    } failure:^(NSError *error) {
+
+        __strong __typeof(weakSelf)strongSelf = weakSelf;
+        if (strongSelf && strongSelf->pendingOperation == operation)
+        {
+            strongSelf->pendingOperation = nil;
+
+            NSArray<void (^)(NSError *error)> *failureBlocks = [strongSelf->pendingFailureBlocks copy];
+            [strongSelf->pendingSuccessBlocks removeAllObjects];
+            [strongSelf->pendingFailureBlocks removeAllObjects];
+
+            for (void (^failureBlock)(NSError *error) in failureBlocks)
+            {
+                failureBlock(error);
+            }
+        }
+    }];
+
+    pendingOperation = operation;
+    return operation;
+}
+
+- (void)reset
+{
+    // Like a cancelled request, the waiting callers are not called back
+    [pendingOperation cancel];
+    pendingOperation = nil;
+    [pendingSuccessBlocks removeAllObjects];
+    [pendingFailureBlocks removeAllObjects];
+
+    nextBatch = nil;
+    _hasMoreRooms = YES;
+    _totalRoomCountEstimate = 0;
+
+    [rooms removeAllObjects];
+    [roomIndexesByWord removeAllObjects];
+}
+
+- (NSArray<MXPublicRoom *> *)roomsMatchingFilter:(NSString *)filter
+{
+    NSArray<NSString*> *filterWords = [self wordsOfString:filter];
+    if (!filterWords.count)
+    {
+        return self.rooms;
+    }
+
+    NSMutableIndexSet *matchingIndexes;
+    for (NSString *filterWord in filterWords)
+    {
+        // Indexes of the rooms with a word starting by this filter word
+        NSMutableIndexSet *indexes = [NSMutableIndexSet indexSet];
+        for (NSString *word in roomIndexesByWord)
+        {
+            if ([word hasPrefix:filterWord])
+            {
+                [indexes addIndexes:roomIndexesByWord[word]];
+            }
+        }
+
+        if (!matchingIndexes)
+        {
+            matchingIndexes = indexes;
+        }
+        else
+        {
+            // All filter words must match
+            NSMutableIndexSet *intersection = [NSMutableIndexSet indexSet];
+            [matchingIndexes enumerateIndexesUsingBlock:^(NSUInteger idx, BOOL *stop) {
+                if ([indexes containsIndex:idx])
+                {
+                    [intersection addIndex:idx];
+                }
+            }];
+            matchingIndexes = intersection;
+        }
+
+        if (!matchingIndexes.count)
+        {
+            break;
+        }
+    }
+
+    return [rooms objectsAtIndexes:matchingIndexes];
+}
+
+- (void)removeAllCachedPages
+{
+    [cache removeAllObjects];
+}
+
+- (void)setSearchTerm:(NSString *)searchTerm
+{
+    if (searchTerm != _searchTerm && ![searchTerm isEqualToString:_searchTerm])
+    {
+        _searchTerm = searchTerm;
+        [self reset];
+    }
+}
+
+- (NSArray<MXPublicRoom *> *)rooms
+{
+    return [rooms copy];
+}
+
+
+#pragma mark - Private methods
+- (void)addPendingSuccess:(void (^)(NSArray<MXPublicRoom*> *rooms))success failure:(void (^)(NSError *error))failure
+{
+    [pendingSuccessBlocks addObject:success ? [success copy] : ^(NSArray<MXPublicRoom*> *rooms) {}];
+    [pendingFailureBlocks addObject:failure ? [failure copy] : ^(NSError *error) {}];
+}
+
+- (void)cachePage:(MXPublicRoomsResponse*)publicRoomsResponse withKey:(NSArray*)key
+{
+    MXPublicRoomDirectoryCachedPage *cachedPage = [[MXPublicRoomDirectoryCachedPage alloc] init];
+    cachedPage.publicRoomsResponse = publicRoomsResponse;
+    cachedPage.date = [NSDate date];
+    cache[key] = cachedPage;
+
+    if (cache.count > MXPUBLICROOMDIRECTORY_MAX_CACHED_PAGES)
+    {
+        // Remove expired pages then the oldest ones
+        NSArray<NSArray*> *keys = [cache keysSortedByValueUsingComparator:^NSComparisonResult(MXPublicRoomDirectoryCachedPage *page1, MXPublicRoomDirectoryCachedPage *page2) {
+            return [page1.date compare:page2.date];
+        }];
+
+        for (NSArray *oldKey in keys)
+        {
+            if (cache.count <= MXPUBLICROOMDIRECTORY_MAX_CACHED_PAGES
+                && -cache[oldKey].date.timeIntervalSinceNow < _cacheLifetime)
+            {
+                break;
+            }
+            [cache removeObjectForKey:oldKey];
+        }
+    }
+}
+
+- (void)addPage:(MXPublicRoomsResponse*)publicRoomsResponse
+{
+    nextBatch = publicRoomsResponse.nextBatch;
+    _hasMoreRooms = (nextBatch != nil);
+
+    if (publicRoomsResponse.totalRoomCountEstimate)
+    {
+        _totalRoomCountEstimate = publicRoomsResponse.totalRoomCountEstimate;
+    }
+
+    for (MXPublicRoom *publicRoom in publicRoomsResponse.chunk)
+    {
+        NSUInteger index = rooms.count;
+        [rooms addObject:publicRoom];
+
+        // Index the words of the room
+        NSMutableArray<NSString*> *words = [NSMutableArray array];
+        [words addObjectsFromArray:[self wordsOfString:publicRoom.name]];
+        [words addObjectsFromArray:[self wordsOfString:publicRoom.topic]];
+        for (NSString *alias in publicRoom.aliases)
+        {
+            [words addObjectsFromArray:[self wordsOfString:alias]];
+        }
+
+        for (NSString *word in words)
+        {
+            NSMutableIndexSet *indexes = roomIndexesByWord[word];
+            if (!indexes)
+            {
+                indexes = [NSMutableIndexSet indexSet];
+                roomIndexesByWord[word] = indexes;
+            }
+            [indexes addIndex:index];
+        }
+    }
+}
+
+/**
+ Split a string into normalised words.
+
+ @param string the string to split.
+ @return the lowercased words without diacritics.
+ */
+- (NSArray<NSString*>*)wordsOfString:(NSString*)string
+{
+    if (!string.length)
+    {
+        return @[];
+    }
+
+    NSString *normalisedString = [string stringByFoldingWithOptions:NSCaseInsensitiveSearch | NSDiacriticInsensitiveSearch locale:nil];
+
+    NSMutableArray<NSString*> *words = [NSMutableArray array];
+    for (NSString *word in [normalisedString componentsSeparatedByCharactersInSet:[NSCharacterSet alphanumericCharacterSet].invertedSet])
+    {
+        if (word.length)
+        {
+            [words addObject:word];
+        }
+    }
+    return words;
+}
+
+@end
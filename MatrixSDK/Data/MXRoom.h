@@ -26,6 +26,7 @@
 #import "MXCall.h"
 #import "MXEventTimeline.h"
 #import "MXEventsEnumerator.h"
+#import "MXTypingController.h"
 
 @class MXRoom;
 @class MXSession;
@@ -98,6 +99,12 @@ FOUNDATION_EXPORT NSString *const kMXRoomDidUpdateUnreadNotification;
  */
 @property (nonatomic, readonly) NSArray *typingUsers;
 
+/**
+ The controller to report the typing of the user in this room.
+ Prefer it to [self sendTypingNotification:] as it limits the number of requests to the homeserver.
+ */
+@property (nonatomic, readonly) MXTypingController *typingController;
+
 /**
  The number of unread events wrote in the store which have their type listed in the MXSession.unreadEventType.
  
@@ -166,6 +173,15 @@ FOUNDATION_EXPORT NSString *const kMXRoomDidUpdateUnreadNotification;
  */
 - (void)handleInvitedRoomSync:(MXInvitedRoomSync *)invitedRoomSync;
 
+/**
+ Initialise the room data from a /rooms/{roomId}/initialSync response.
+
+ @see [MXEventTimeline handleRoomInitialSync:].
+
+ @param roomInitialSync the response to the /initialSync request.
+ */
+- (void)handleRoomInitialSync:(MXRoomInitialSync*)roomInitialSync;
+
 
 #pragma mark - Stored messages enumerator
 /**
@@ -201,6 +217,17 @@ FOUNDATION_EXPORT NSString *const kMXRoomDidUpdateUnreadNotification;
  */
 @property (nonatomic, readonly) NSUInteger storedMessagesCount;
 
+/**
+ Get the historical state of the room before a stored message.
+
+ The state is rebuilt from the closest state checkpoint of the store: it does not need to
+ replay state changes from the current state.
+
+ @param eventId the id of the stored message.
+ @return the room state, a back state (`isLive` is NO). nil if the store cannot rebuild it.
+ */
+- (MXRoomState*)stateBeforeStoredEvent:(NSString*)eventId;
+
 
 #pragma mark - Room operations
 /**
@@ -518,6 +545,8 @@ FOUNDATION_EXPORT NSString *const kMXRoomDidUpdateUnreadNotification;
 /**
  Inform the home server that the user is typing (or not) in this room.
 
+ @see `typingController` which manages the notifications for the app.
+
  @param typing Use YES if the user is currently typing.
  @param timeout the length of time until the user should be treated as no longer typing,
                 in milliseconds. Can be ommited (set to -1) if they are no longer typing.
@@ -27,6 +27,7 @@ NSString *const kMXRoomDidUpdateUnreadNotification = @"kMXRoomDidUpdateUnreadNot
 
 @interface MXRoom ()
 {
+    MXTypingController *typingController;
 }
 @end
 
@@ -90,12 +91,27 @@ NSString *const kMXRoomDidUpdateUnreadNotification = @"kMXRoomDidUpdateUnreadNot
     return self;
 }
 
+- (void)dealloc
+{
+    // Pending typing timers must not fire once the room is gone
+    [typingController close];
+}
+
 #pragma mark - Properties implementation
 - (MXRoomState *)state
 {
     return _liveTimeline.state;
 }
 
+- (MXTypingController *)typingController
+{
+    if (!typingController)
+    {
+        typingController = [[MXTypingController alloc] initWithRoom:self];
+    }
+    return typingController;
+}
+
 - (void)setPartialTextMessage:(NSString *)partialTextMessage
 {
     [mxSession.store storePartialTextMessageForRoom:self.roomId partialTextMessage:partialTextMessage];
@@ -117,6 +133,16 @@ NSString *const kMXRoomDidUpdateUnreadNotification = @"kMXRoomDidUpdateUnreadNot
     // Let the live timeline handle live events
     [_liveTimeline handleJoinedRoomSync:roomSync];
 
+    // Typing notifications are coalesced: find the last one
+    MXEvent *lastTypingEvent;
+    for (MXEvent *event in roomSync.ephemeral.events)
+    {
+        if (event.eventType == MXEventTypeTypingNotification)
+        {
+            lastTypingEvent = event;
+        }
+    }
+
     // Handle here ephemeral events (if any)
     for (MXEvent *event in roomSync.ephemeral.events)
     {
@@ -127,11 +153,21 @@ NSString *const kMXRoomDidUpdateUnreadNotification = @"kMXRoomDidUpdateUnreadNot
         if (event.eventType == MXEventTypeTypingNotification)
         {
             // Typing notifications events are not room messages nor room state events
-            // They are just volatile information
-            MXJSONModelSetArray(_typingUsers, event.content[@"user_ids"]);
+            // They are just volatile information.
+            // Only the last one of the batch matters and listeners are notified only on change
+            if (event == lastTypingEvent)
+            {
+                NSArray *typingUsers = _typingUsers;
+                MXJSONModelSetArray(typingUsers, event.content[@"user_ids"]);
+
+                if (![typingUsers isEqualToArray:_typingUsers])
+                {
+                    _typingUsers = typingUsers;
 
-            // Notify listeners
-            [_liveTimeline notifyListeners:event direction:MXTimelineDirectionForwards];
+                    // Notify listeners
+                    [_liveTimeline notifyListeners:event direction:MXTimelineDirectionForwards];
+                }
+            }
         }
         else if (event.eventType == MXEventTypeReceipt)
         {
@@ -158,6 +194,15 @@ NSString *const kMXRoomDidUpdateUnreadNotification = @"kMXRoomDidUpdateUnreadNot
     [_liveTimeline handleInvitedRoomSync:invitedRoomSync];
 }
 
+- (void)handleRoomInitialSync:(MXRoomInitialSync *)roomInitialSync
+{
+    // Let the live timeline handle the room state and messages
+    [_liveTimeline handleRoomInitialSync:roomInitialSync];
+
+    // Handle account data events (if any)
+    [self handleAccounDataEvents:roomInitialSync.accountData direction:MXTimelineDirectionForwards];
+}
+
 
 #pragma mark - Room private account data handling
 /**
@@ -228,6 +273,23 @@ NSString *const kMXRoomDidUpdateUnreadNotification = @"kMXRoomDidUpdateUnreadNot
     return storedMessagesCount;
 }
 
+- (MXRoomState *)stateBeforeStoredEvent:(NSString *)eventId
+{
+    if (![mxSession.store respondsToSelector:@selector(stateOfRoom:beforeEvent:)])
+    {
+        return nil;
+    }
+
+    NSArray<MXEvent*> *stateEvents = [mxSession.store stateOfRoom:self.roomId beforeEvent:eventId];
+    if (!stateEvents)
+    {
+        return nil;
+    }
+
+    // This is a state of the room history
+    return [[MXRoomState alloc] initBackStateWithRoomId:self.roomId andMatrixSession:mxSession andStateEvents:stateEvents];
+}
+
 
 #pragma mark - Room operations
 - (MXHTTPOperation*)sendEventOfType:(MXEventTypeString)eventTypeString
@@ -235,6 +297,12 @@ NSString *const kMXRoomDidUpdateUnreadNotification = @"kMXRoomDidUpdateUnreadNot
                             success:(void (^)(NSString *eventId))success
                             failure:(void (^)(NSError *error))failure
 {
+    // The user has finished to type this message
+    if ([eventTypeString isEqualToString:kMXEventTypeStringRoomMessage])
+    {
+        [typingController userStoppedTyping];
+    }
+
     return [mxSession.matrixRestClient sendEventToRoom:self.roomId eventType:eventTypeString content:content success:success failure:failure];
 }
 
@@ -251,6 +319,9 @@ NSString *const kMXRoomDidUpdateUnreadNotification = @"kMXRoomDidUpdateUnreadNot
                               success:(void (^)(NSString *eventId))success
                               failure:(void (^)(NSError *error))failure
 {
+    // The user has finished to type this message
+    [typingController userStoppedTyping];
+
     return [mxSession.matrixRestClient sendMessageToRoom:self.roomId msgType:msgType content:content success:success failure:failure];
 }
 
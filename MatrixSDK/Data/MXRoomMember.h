@@ -17,6 +17,7 @@
 #import <Foundation/Foundation.h>
 
 #import "MXEvent.h"
+#import "MXMemberProfile.h"
 
 /**
  `MXRoomMember` is the information about a user in a room.
@@ -38,6 +39,12 @@
   */
 @property (nonatomic) NSString *avatarUrl;
 
+/**
+ The shared profile of the user in this room.
+ `displayname` and `avatarUrl` come from it.
+ */
+@property (nonatomic, readonly) MXMemberProfile *profile;
+
 /**
  The membership state.
  */
@@ -46,9 +46,6 @@
         
         // Use MXRoomMemberEventContent to parse the JSON event content
         MXRoomMemberEventContent *roomMemberContent = [MXRoomMemberEventContent modelFromJSON:roomMemberEventContent];
-        _displayname = roomMemberContent.displayname;
-        // We ignore non mxc avatar url
-        _avatarUrl = ([roomMemberContent.avatarUrl hasPrefix:kMXContentUriScheme] ? roomMemberContent.avatarUrl : nil);
         _membership = [MXTools membership:roomMemberContent.membership];
         _thirdPartyInviteToken = roomMemberContent.thirdPartyInviteToken;
         _originalEvent = roomMemberEvent;
@@ -62,6 +59,12 @@
         {
             _userId = roomMemberEvent.sender;
         }
+
+        // Members of the user in other rooms with the same profile share it.
+        // We ignore non mxc avatar url
+        _profile = [MXMemberProfile profileWithUserId:_userId
+                                          displayname:roomMemberContent.displayname
+                                            avatarUrl:([roomMemberContent.avatarUrl hasPrefix:kMXContentUriScheme] ? roomMemberContent.avatarUrl : nil)];
         
         if (roomMemberEventContent == roomMemberEvent.content)
         {
@@ -90,4 +93,19 @@
     return self;
 }
 
+- (NSString *)displayname
+{
+    return _profile.displayname;
+}
+
+- (NSString *)avatarUrl
+{
+    return _profile.avatarUrl;
+}
+
+- (void)setAvatarUrl:(NSString *)avatarUrl
+{
+    _profile = [MXMemberProfile profileWithUserId:_userId displayname:_profile.displayname avatarUrl:avatarUrl];
+}
+
 @end
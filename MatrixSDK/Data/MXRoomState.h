@@ -20,11 +20,29 @@
 #import "MXJSONModels.h"
 #import "MXRoomMember.h"
 #import "MXRoomThirdPartyInvite.h"
+#import "MXEventSenderProfile.h"
 #import "MXRoomPowerLevels.h"
 #import "MXEnumConstants.h"
+#import "MXMemoryPressureHandler.h"
 
 @class MXSession;
 
+/**
+ Posted when the capabilities of members change in a live room state because of a new
+ power levels event.
+
+ The notification object is the `MXRoomState` instance. The `userInfo` dictionary
+ contains the ids of the users whose capabilities changed under the
+ `kMXRoomStateCapabilitiesUserIdsKey` key.
+ */
+FOUNDATION_EXPORT NSString *const kMXRoomStateCapabilitiesDidChangeNotification;
+
+/**
+ The key in the `kMXRoomStateCapabilitiesDidChangeNotification` userInfo. The value is an
+ array of user ids.
+ */
+FOUNDATION_EXPORT NSString *const kMXRoomStateCapabilitiesUserIdsKey;
+
 /**
  `MXRoomState` holds the state of a room at a given instant.
  
@@ -33,7 +51,7 @@
  If the current membership state is `invite`, the room state will contain only few information.
  Join the room with [MXRoom join] to get full information about the room.
  */
-@interface MXRoomState : NSObject <NSCopying>
+@interface MXRoomState : NSObject <NSCopying, MXMemoryPressureHandler>
 
 /**
  The room ID
@@ -51,6 +69,16 @@
  */
 @property (nonatomic, readonly) NSArray *stateEvents;
 
+/**
+ The state events whose `content` is the state of the room at this time.
+
+ This is `stateEvents` for a live state. For a back state, the events that define the state
+ by their `prev_content` are replaced by new events with this `prev_content` as `content`.
+ The result can be provided to `initBackStateWithRoomId:andMatrixSession:andStateEvents:`
+ or stored as a state checkpoint.
+ */
+@property (nonatomic, readonly) NSArray<MXEvent*> *stateEventsSnapshot;
+
 /**
  A copy of the list of room members.
  */
@@ -170,6 +198,19 @@ A copy of the list of third party invites (actually MXRoomThirdPartyInvite insta
  */
 - (id)initBackStateWith:(MXRoomState*)state;
 
+/**
+ Create a `MXRoomState` instance used as a back state of a room from the state events of the
+ room at a given time in the room history.
+
+ @param roomId the room id to the room.
+ @param matrixSession the session to the home server.
+ @param stateEvents the state events of the room at this time. Their content is the state.
+ @return The newly-initialized MXRoomState.
+ */
+- (id)initBackStateWithRoomId:(NSString*)roomId
+             andMatrixSession:(MXSession*)matrixSession
+               andStateEvents:(NSArray<MXEvent*>*)stateEvents;
+
 /**
  Process a state event in order to update the room state.
  
@@ -213,6 +254,15 @@ A copy of the list of third party invites (actually MXRoomThirdPartyInvite insta
  */
 - (NSString*)memberName:(NSString*)userId;
 
+/**
+ Return the profile of a member to decorate the events he sent.
+ Profiles are cached until a room member event changes the state.
+
+ @param userId the id of the member.
+ @return the profile. nil if userId is nil.
+ */
+- (MXEventSenderProfile*)senderProfile:(NSString*)userId;
+
 /**
  Return a display name for a member suitable to compare and sort members list
  */
@@ -226,6 +276,38 @@ A copy of the list of third party invites (actually MXRoomThirdPartyInvite insta
  */
 - (float)memberNormalizedPowerLevel:(NSString*)userId;
 
+
+# pragma mark - Capabilities
+/**
+ Get the actions a user can do in the room.
+
+ The power levels event is compiled into a table when it changes so that this is a
+ constant time lookup.
+
+ @param userId the id of the user.
+ @return a bitmask of MXRoomCapability values.
+ */
+- (MXRoomCapability)capabilitiesOfUser:(NSString*)userId;
+
+/**
+ Check whether a user can do some actions.
+
+ @param userId the id of the user.
+ @param capabilities a bitmask of MXRoomCapability values.
+ @return YES if the user can do all of them.
+ */
+- (BOOL)canUser:(NSString*)userId perform:(MXRoomCapability)capabilities;
+
+/**
+ Check whether a user can send an event of a given type.
+
+ @param userId the id of the user.
+ @param eventTypeString the type of the event.
+ @param isStateEvent YES for a state event, NO for a message.
+ @return YES if the power level of the user is enough.
+ */
+- (BOOL)canUser:(NSString*)userId sendEventOfType:(MXEventTypeString)eventTypeString asStateEvent:(BOOL)isStateEvent;
+
 /**
  Return the list of members with a given membership.
  
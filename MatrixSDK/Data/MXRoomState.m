@@ -22,6 +22,9 @@
 #import "MXTools.h"
 #import "MXCallManager.h"
 
+NSString *const kMXRoomStateCapabilitiesDidChangeNotification = @"kMXRoomStateCapabilitiesDidChangeNotification";
+NSString *const kMXRoomStateCapabilitiesUserIdsKey = @"kMXRoomStateCapabilitiesUserIdsKey";
+
 @interface MXRoomState ()
 {
     MXSession *mxSession;
@@ -49,6 +52,20 @@
      */
     NSInteger maxPowerLevel;
 
+    /**
+     The capability table compiled from `powerLevels`.
+     The users listed in the power levels have an entry in `capabilitiesByUserId` and
+     `powerLevelsByUserId`. Others have the default values.
+     */
+    NSDictionary<NSString*, NSNumber*> *capabilitiesByUserId;
+    NSDictionary<NSString*, NSNumber*> *powerLevelsByUserId;
+    MXRoomCapability defaultCapabilities;
+
+    /**
+     The minimum power level to send events by event type.
+     */
+    NSDictionary<NSString*, NSNumber*> *powerLevelsByEventType;
+
     /**
      Disambiguate members names in big rooms takes time. So, cache computed data.
      The key is the user id. The value, the member name to display.
@@ -56,6 +73,11 @@
      */
     NSMutableDictionary<NSString*, NSString*> *membersNamesCache;
 
+    /**
+     Cache for [self senderProfile:]. It is resetted with `membersNamesCache`.
+     */
+    NSMutableDictionary<NSString*, MXEventSenderProfile*> *senderProfilesCache;
+
     /**
      Cache for [self memberWithThirdPartyInviteToken].
      The key is the 3pid invite token.
@@ -66,6 +88,13 @@
      The cache for the conference user id.
      */
     NSString *conferenceUserId;
+
+    /**
+     In a back state, the state events whose content, and not their prev_content, is the
+     state of the room at this time of the history. They are the events of the state the
+     back state was created from until back pagination goes through them.
+     */
+    NSHashTable<MXEvent*> *eventsWithCurrentContent;
 }
 @end
 
@@ -89,7 +118,10 @@
         roomAliases = [NSMutableDictionary dictionary];
         thirdPartyInvites = [NSMutableDictionary dictionary];
         membersNamesCache = [NSMutableDictionary dictionary];
+        senderProfilesCache = [NSMutableDictionary dictionary];
         membersWithThirdPartyInviteTokenCache = [NSMutableDictionary dictionary];
+
+        [self compilePowerLevels];
     }
     return self;
 }
@@ -119,15 +151,50 @@
     self = [state copy];
     if (self)
     {
+        if (_isLive)
+        {
+            // At the beginning of pagination, the back room state must be the same
+            // as the current current room state.
+            // So, use the content of its state events. The events are shared with the
+            // store and with other states: they must not be modified.
+            NSArray<MXEvent*> *currentStateEvents = self.stateEvents;
+            eventsWithCurrentContent = [[NSHashTable alloc] initWithOptions:NSPointerFunctionsObjectPointerPersonality capacity:currentStateEvents.count];
+            for (MXEvent *event in currentStateEvents)
+            {
+                [eventsWithCurrentContent addObject:event];
+            }
+        }
+
         _isLive = NO;
+    }
+    return self;
+}
+
+- (id)initBackStateWithRoomId:(NSString*)roomId andMatrixSession:(MXSession*)matrixSession andStateEvents:(NSArray<MXEvent*>*)theStateEvents
+{
+    // Build the state forwards but without session so that this past state has no side
+    // effect on the session (conference calls...)
+    MXRoomState *state = [[MXRoomState alloc] initWithRoomId:roomId andMatrixSession:nil andDirection:YES];
+    for (MXEvent *event in theStateEvents)
+    {
+        [state handleStateEvent:event];
+    }
 
-        // At the beginning of pagination, the back room state must be the same
-        // as the current current room state.
-        // So, use the same state events content.
-        // @TODO: Find another way than modifying the event content.
-        for (MXEvent *event in stateEvents.allValues)
+    self = [self initBackStateWith:state];
+    if (self)
+    {
+        mxSession = matrixSession;
+
+        // Apply the identicons that could not be computed without session
+        if (![MXSDKOptions sharedInstance].disableIdenticonUseForUserAvatar)
         {
-            event.prevContent = event.content;
+            for (MXRoomMember *roomMember in members.allValues)
+            {
+                if (nil == roomMember.avatarUrl)
+                {
+                    roomMember.avatarUrl = [mxSession.matrixRestClient urlOfIdenticon:roomMember.userId];
+                }
+            }
         }
     }
     return self;
@@ -140,7 +207,7 @@
     NSDictionary *content;
     if (event)
     {
-        if (_isLive)
+        if (_isLive || [eventsWithCurrentContent containsObject:event])
         {
             content = event.content;
         }
@@ -177,6 +244,36 @@
     return state;
 }
 
+- (NSArray<MXEvent *> *)stateEventsSnapshot
+{
+    NSArray<MXEvent*> *currentStateEvents = self.stateEvents;
+    if (_isLive)
+    {
+        return currentStateEvents;
+    }
+
+    NSMutableArray<MXEvent*> *snapshot = [NSMutableArray arrayWithCapacity:currentStateEvents.count];
+    for (MXEvent *event in currentStateEvents)
+    {
+        if ([eventsWithCurrentContent containsObject:event])
+        {
+            [snapshot addObject:event];
+        }
+        else if (event.prevContent.count)
+        {
+            // The state comes from an older event we do not know. Describe it with the
+            // data we have
+            MXEvent *stateEvent = [[MXEvent alloc] init];
+            stateEvent.type = event.type;
+            stateEvent.roomId = event.roomId;
+            stateEvent.stateKey = event.stateKey;
+            stateEvent.content = event.prevContent;
+            [snapshot addObject:stateEvent];
+        }
+    }
+    return snapshot;
+}
+
 - (NSArray *)members
 {
     return [members allValues];
@@ -457,6 +554,9 @@
 #pragma mark - State events handling
 - (void)handleStateEvent:(MXEvent*)event
 {
+    // Back pagination goes through this event: the state is now its prev_content
+    [eventsWithCurrentContent removeObject:event];
+
     switch (event.eventType)
     {
         case MXEventTypeRoomMember:
@@ -488,6 +588,7 @@
 
             // Reset members names because the computation data basis has changed
             [membersNamesCache removeAllObjects];
+            [senderProfilesCache removeAllObjects];
 
             // In case of invite, process the provided but incomplete room state
             if (self.membership == MXMembershipInvite && event.inviteRoomState)
@@ -534,21 +635,38 @@
             }
             break;
         }
-        case MXEventTypeRoomPowerLevels:
+        case MXEventTypeRoomCreate:
         {
-            powerLevels = [MXRoomPowerLevels modelFromJSON:[self contentOfEvent:event]];
-            // Compute max power level
-            maxPowerLevel = powerLevels.usersDefault;
-            NSArray *array = powerLevels.users.allValues;
-            for (NSNumber *powerLevel in array)
+            stateEvents[event.type] = event;
+
+            // Without power levels event, the room creator has the power level 100
+            if (!powerLevels)
             {
-                NSInteger level = 0;
-                MXJSONModelSetInteger(level, powerLevel);
-                if (level > maxPowerLevel)
+                NSDictionary<NSString*, NSNumber*> *previousCapabilitiesByUserId = capabilitiesByUserId;
+                MXRoomCapability previousDefaultCapabilities = defaultCapabilities;
+
+                [self compilePowerLevels];
+
+                if (_isLive)
                 {
-                    maxPowerLevel = level;
+                    [self notifyCapabilitiesChangesFrom:previousCapabilitiesByUserId defaultCapabilities:previousDefaultCapabilities];
                 }
             }
+            break;
+        }
+        case MXEventTypeRoomPowerLevels:
+        {
+            NSDictionary<NSString*, NSNumber*> *previousCapabilitiesByUserId = capabilitiesByUserId;
+            MXRoomCapability previousDefaultCapabilities = defaultCapabilities;
+
+            powerLevels = [MXRoomPowerLevels modelFromJSON:[self contentOfEvent:event]];
+            [self compilePowerLevels];
+
+            // The capabilities before the first power levels event were the default ones
+            if (_isLive)
+            {
+                [self notifyCapabilitiesChangesFrom:previousCapabilitiesByUserId defaultCapabilities:previousDefaultCapabilities];
+            }
             
             // Do not break here to store the event into the stateEvents dictionary.
         }
@@ -622,6 +740,23 @@
     return displayName;
 }
 
+- (MXEventSenderProfile*)senderProfile:(NSString*)userId
+{
+    if (!userId)
+    {
+        return nil;
+    }
+
+    MXEventSenderProfile *senderProfile = senderProfilesCache[userId];
+    if (!senderProfile)
+    {
+        senderProfile = [[MXEventSenderProfile alloc] initWithUserId:userId roomState:self];
+        senderProfilesCache[userId] = senderProfile;
+    }
+
+    return senderProfile;
+}
+
 - (NSString*)memberSortedName:(NSString*)userId
 {
     // Get the user display name from the member list of the room
@@ -649,13 +784,36 @@
     // Ignore banned and left (kicked) members
     if (member.membership != MXMembershipLeave && member.membership != MXMembershipBan)
     {
-        float userPowerLevelFloat = [powerLevels powerLevelOfUserWithUserID:userId];
+        float userPowerLevelFloat = [self powerLevelOfUser:userId];
         powerLevel = maxPowerLevel ? userPowerLevelFloat / maxPowerLevel : 1;
     }
     
     return powerLevel;
 }
 
+- (MXRoomCapability)capabilitiesOfUser:(NSString *)userId
+{
+    NSNumber *capabilities = capabilitiesByUserId[userId];
+    return capabilities ? capabilities.unsignedIntegerValue : defaultCapabilities;
+}
+
+- (BOOL)canUser:(NSString *)userId perform:(MXRoomCapability)capabilities
+{
+    return ([self capabilitiesOfUser:userId] & capabilities) == capabilities;
+}
+
+- (BOOL)canUser:(NSString *)userId sendEventOfType:(MXEventTypeString)eventTypeString asStateEvent:(BOOL)isStateEvent
+{
+    NSNumber *minimumPowerLevel = powerLevelsByEventType[eventTypeString];
+    if (!minimumPowerLevel)
+    {
+        // Use the defaults precompiled in the capabilities
+        return [self canUser:userId perform:(isStateEvent ? MXRoomCapabilitySendStateEvent : MXRoomCapabilitySendMessage)];
+    }
+
+    return [self powerLevelOfUser:userId] >= minimumPowerLevel.integerValue;
+}
+
 - (NSArray<MXRoomMember*>*)membersWithMembership:(MXMembership)theMembership
 {
     NSMutableArray *membersWithMembership = [NSMutableArray array];
@@ -775,6 +933,129 @@
 }
 
 
+#pragma mark - Capabilities
+/**
+ Compile `powerLevels` into the capability table.
+ */
+- (void)compilePowerLevels
+{
+    // Without power levels event, use the default values
+    MXRoomPowerLevels *roomPowerLevels = powerLevels;
+    if (!roomPowerLevels)
+    {
+        roomPowerLevels = [[MXRoomPowerLevels alloc] init];
+
+        // and the room creator has the power level 100
+        MXEvent *createEvent = stateEvents[kMXEventTypeStringRoomCreate];
+        if (createEvent)
+        {
+            NSString *creator;
+            MXJSONModelSetString(creator, [self contentOfEvent:createEvent][@"creator"]);
+            if (!creator)
+            {
+                creator = createEvent.sender;
+            }
+
+            if (creator)
+            {
+                roomPowerLevels.users = @{creator: @(100)};
+            }
+        }
+    }
+
+    maxPowerLevel = roomPowerLevels.usersDefault;
+    defaultCapabilities = [roomPowerLevels capabilitiesForPowerLevel:roomPowerLevels.usersDefault];
+
+    NSMutableDictionary<NSString*, NSNumber*> *capabilities = [NSMutableDictionary dictionaryWithCapacity:roomPowerLevels.users.count];
+    NSMutableDictionary<NSString*, NSNumber*> *userPowerLevels = [NSMutableDictionary dictionaryWithCapacity:roomPowerLevels.users.count];
+    for (NSString *userId in roomPowerLevels.users)
+    {
+        NSInteger level = roomPowerLevels.usersDefault;
+        MXJSONModelSetInteger(level, roomPowerLevels.users[userId]);
+
+        userPowerLevels[userId] = @(level);
+        capabilities[userId] = @([roomPowerLevels capabilitiesForPowerLevel:level]);
+
+        // Compute max power level
+        if (level > maxPowerLevel)
+        {
+            maxPowerLevel = level;
+        }
+    }
+    capabilitiesByUserId = capabilities;
+    powerLevelsByUserId = userPowerLevels;
+
+    NSMutableDictionary<NSString*, NSNumber*> *eventTypePowerLevels = [NSMutableDictionary dictionaryWithCapacity:roomPowerLevels.events.count];
+    for (NSString *eventType in roomPowerLevels.events)
+    {
+        NSNumber *level;
+        MXJSONModelSetNumber(level, roomPowerLevels.events[eventType]);
+        if (level)
+        {
+            eventTypePowerLevels[eventType] = level;
+        }
+    }
+    powerLevelsByEventType = eventTypePowerLevels;
+}
+
+- (NSInteger)powerLevelOfUser:(NSString*)userId
+{
+    NSNumber *level = powerLevelsByUserId[userId];
+    return level ? level.integerValue : powerLevels.usersDefault;
+}
+
+/**
+ Post a `kMXRoomStateCapabilitiesDidChangeNotification` if capabilities have changed.
+
+ @param previousCapabilitiesByUserId the capabilities of users before the change.
+ @param previousDefaultCapabilities the default capabilities before the change.
+ */
+- (void)notifyCapabilitiesChangesFrom:(NSDictionary<NSString*, NSNumber*>*)previousCapabilitiesByUserId defaultCapabilities:(MXRoomCapability)previousDefaultCapabilities
+{
+    NSMutableSet<NSString*> *userIds = [NSMutableSet setWithArray:previousCapabilitiesByUserId.allKeys];
+    [userIds addObjectsFromArray:capabilitiesByUserId.allKeys];
+
+    // A change of the default capabilities affects the other members
+    if (previousDefaultCapabilities != defaultCapabilities)
+    {
+        [userIds addObjectsFromArray:members.allKeys];
+    }
+
+    NSMutableArray<NSString*> *changedUserIds = [NSMutableArray array];
+    for (NSString *userId in userIds)
+    {
+        NSNumber *previousCapabilities = previousCapabilitiesByUserId[userId];
+        MXRoomCapability before = previousCapabilities ? previousCapabilities.unsignedIntegerValue : previousDefaultCapabilities;
+
+        if (before != [self capabilitiesOfUser:userId])
+        {
+            [changedUserIds addObject:userId];
+        }
+    }
+
+    if (changedUserIds.count)
+    {
+        [[NSNotificationCenter defaultCenter] postNotificationName:kMXRoomStateCapabilitiesDidChangeNotification
+                                                            object:self
+                                                          userInfo:@{
+                                                                     kMXRoomStateCapabilitiesUserIdsKey: changedUserIds
+                                                                     }];
+    }
+}
+
+#pragma mark - MXMemoryPressureHandler
+- (NSUInteger)handleMemoryPressure:(MXMemoryPressureLevel)level
+{
+    // These caches are rebuilt on demand
+    NSUInteger count = membersNamesCache.count + senderProfilesCache.count;
+
+    [membersNamesCache removeAllObjects];
+    [senderProfilesCache removeAllObjects];
+
+    return count;
+}
+
+
 #pragma mark - NSCopying
 - (id)copyWithZone:(NSZone *)zone
 {
@@ -802,15 +1083,24 @@
     stateCopy->membership = membership;
 
     stateCopy->membersNamesCache = [[NSMutableDictionary allocWithZone:zone] initWithDictionary:membersNamesCache copyItems:YES];
+
+    // MXEventSenderProfile objects are immutable
+    stateCopy->senderProfilesCache = [[NSMutableDictionary allocWithZone:zone] initWithDictionary:senderProfilesCache];
     
     stateCopy->powerLevels = [powerLevels copy];
     stateCopy->maxPowerLevel = maxPowerLevel;
+    stateCopy->capabilitiesByUserId = capabilitiesByUserId;
+    stateCopy->powerLevelsByUserId = powerLevelsByUserId;
+    stateCopy->defaultCapabilities = defaultCapabilities;
+    stateCopy->powerLevelsByEventType = powerLevelsByEventType;
 
     if (conferenceUserId)
     {
         stateCopy->conferenceUserId = [conferenceUserId copyWithZone:zone];
     }
 
+    stateCopy->eventsWithCurrentContent = [eventsWithCurrentContent copyWithZone:zone];
+
     return stateCopy;
 }
 
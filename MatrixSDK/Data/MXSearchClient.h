@@ -0,0 +1,127 @@
+/*
+ Copyright 2016 OpenMarket Ltd
+
+ Licensed under the Apache License, Version 2.0 (the "License");
+ you may not use this file except in compliance with the License.
+ You may obtain a copy of the License at
+
+ http://www.apache.org/licenses/LICENSE-2.0
+
+ Unless required by applicable law or agreed to in writing, software
+ distributed under the License is distributed on an "AS IS" BASIS,
+ WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ See the License for the specific language governing permissions and
+ limitations under the License.
+ */
+
+#import <Foundation/Foundation.h>
+
+#import "MXJSONModels.h"
+#import "MXHTTPOperation.h"
+#import "MXMemoryPressureHandler.h"
+
+@class MXSession;
+
+/**
+ `MXSearchClient` sits on top of the /search API of `MXRestClient` for the UI.
+
+ - Only the last query is alive: starting a search with other parameters cancels the
+   pending requests of the previous one and its late responses are ignored. This fits
+   search-as-you-type where every key stroke supersedes the previous query.
+ - Responses are cached per (search parameters, batch) for `cacheLifetime` seconds.
+ - Identical requests in progress are shared.
+ - The next batch of results is prefetched while the user reads the current one.
+ */
+@interface MXSearchClient : NSObject <MXMemoryPressureHandler>
+
+/**
+ Create a `MXSearchClient` instance.
+
+ @param mxSession the session to use.
+ @return the newly created instance.
+ */
+- (instancetype)initWithMatrixSession:(MXSession*)mxSession;
+
+/**
+ Search a text in room messages.
+
+ @see [MXRestClient searchMessageText:inRooms:beforeLimit:afterLimit:nextBatch:success:failure:].
+
+ @param text the text to search for.
+ @param rooms a list of rooms to search in. nil means all rooms the user is in.
+ @param beforeLimit the number of events to get before the matching results.
+ @param afterLimit the number of events to get after the matching results.
+ @param nextBatch the token to pass for doing pagination from a previous response.
+
+ @param success A block object called when the operation succeeds.
+ @param failure A block object called when the operation fails.
+
+ @return a MXHTTPOperation instance. nil if the results come from the cache. In this case,
+         the success block has been already called. Cancelling it calls the failure block
+         with a NSURLErrorCancelled error. The shared request is cancelled when all its
+         callers have cancelled.
+ */
+- (MXHTTPOperation*)searchMessageText:(NSString*)text
+                              inRooms:(NSArray<NSString*>*)rooms
+                          beforeLimit:(NSUInteger)beforeLimit
+                           afterLimit:(NSUInteger)afterLimit
+                            nextBatch:(NSString*)nextBatch
+                              success:(void (^)(MXSearchRoomEventResults *roomEventResults))success
+                              failure:(void (^)(NSError *error))failure;
+
+/**
+ Search room events.
+
+ @param roomEventsParameters the "room_events" search criteria as defined by the Matrix search spec.
+ @param nextBatch the token to pass for doing pagination from a previous response.
+
+ @param success A block object called when the operation succeeds.
+ @param failure A block object called when the operation fails.
+
+ @return a MXHTTPOperation instance. nil if the results come from the cache. In this case,
+         the success block has been already called. Cancelling it calls the failure block
+         with a NSURLErrorCancelled error. The shared request is cancelled when all its
+         callers have cancelled.
+ */
+- (MXHTTPOperation*)searchRoomEvents:(NSDictionary*)roomEventsParameters
+                           nextBatch:(NSString*)nextBatch
+                             success:(void (^)(MXSearchRoomEventResults *roomEventResults))success
+                             failure:(void (^)(NSError *error))failure;
+
+/**
+ Cancel all pending requests.
+
+ It is called when a new query supersedes the previous one. The failure block of each
+ caller is called with a NSURLErrorCancelled error.
+ */
+- (void)cancelPendingSearches;
+
+/**
+ Empty the cache.
+ */
+- (void)removeAllCachedResults;
+
+/**
+ The time in seconds during which a response is served from the cache.
+ Default is 60s. 0 disables the cache.
+ */
+@property (nonatomic) NSTimeInterval cacheLifetime;
+
+/**
+ Tell whether the next batch of results is requested in advance.
+ Default is YES.
+ */
+@property (nonatomic) BOOL prefetchNextBatch;
+
+/**
+ Tell whether the context of the results (events before and after) is built from the
+ local store instead of being requested to the homeserver.
+
+ When YES and the store has the whole history of the searched rooms, the homeserver is
+ requested for results only. The context of the results is then built from the messages
+ stored locally. Else, the context is requested to the homeserver.
+ Default is NO.
+ */
+@property (nonatomic) BOOL resolveContextFromStore;
+
+@end
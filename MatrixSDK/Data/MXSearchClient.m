@@ -0,0 +1,604 @@
+/*
+ Copyright 2016 OpenMarket Ltd
+
+ Licensed under the Apache License, Version 2.0 (the "License");
+ you may not use this file except in compliance with the License.
+ You may obtain a copy of the License at
+
+ http://www.apache.org/licenses/LICENSE-2.0
+
+ Unless required by applicable law or agreed to in writing, software
+ distributed under the License is distributed on an "AS IS" BASIS,
+ WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ See the License for the specific language governing permissions and
+ limitations under the License.
+ */
+
+#import "MXSearchClient.h"
+
+#import "MXSession.h"
+#import "MXNoStore.h"
+
+/**
+ The default lifetime of cached responses in seconds.
+ */
+#define MXSEARCHCLIENT_DEFAULT_CACHE_LIFETIME 60
+
+/**
+ The max number of responses kept in the cache.
+ */
+#define MXSEARCHCLIENT_CACHE_CAPACITY 50
+
+@class MXSearchClientOperation;
+
+@interface MXSearchClient ()
+
+- (void)cancelSearchOperation:(MXSearchClientOperation*)searchOperation;
+
+@end
+
+
+#pragma mark - MXSearchClientOperation
+/**
+ The operation returned to a caller of a shared /search request.
+
+ Cancelling it stops only the callbacks of this caller. The request is cancelled when
+ all its callers have cancelled.
+ */
+@interface MXSearchClientOperation : MXHTTPOperation
+
+@property (nonatomic, weak) MXSearchClient *searchClient;
+@property (nonatomic) NSDictionary *key;
+@property (nonatomic, copy) void (^success)(MXSearchRoomEventResults *roomEventResults);
+@property (nonatomic, copy) void (^failure)(NSError *error);
+
+@end
+
+@implementation MXSearchClientOperation
+
+- (void)cancel
+{
+    [super cancel];
+
+    [_searchClient cancelSearchOperation:self];
+}
+
+@end
+
+
+#pragma mark - MXSearchClientRequest
+/**
+ A /search request in progress, shared by all callers asking for the same results.
+ */
+@interface MXSearchClientRequest : NSObject
+
+@property (nonatomic) MXHTTPOperation *operation;
+@property (nonatomic) NSMutableArray<MXSearchClientOperation*> *callers;
+
+@end
+
+@implementation MXSearchClientRequest
+
+- (instancetype)init
+{
+    self = [super init];
+    if (self)
+    {
+        _callers = [NSMutableArray array];
+    }
+    return self;
+}
+
+@end
+
+
+#pragma mark - MXSearchClientCachedResponse
+@interface MXSearchClientCachedResponse : NSObject
+
+@property (nonatomic) MXSearchRoomEventResults *roomEventResults;
+@property (nonatomic) NSDate *date;
+
+@end
+
+@implementation MXSearchClientCachedResponse
+@end
+
+
+#pragma mark - MXSearchClient
+@interface MXSearchClient ()
+{
+    MXSession *mxSession;
+
+    /**
+     The parameters of the current query.
+     */
+    NSDictionary *currentRoomEventsParameters;
+
+    /**
+     Requests in progress by (parameters, batch) key.
+     */
+    NSMutableDictionary<NSDictionary*, MXSearchClientRequest*> *pendingRequests;
+
+    /**
+     Cached responses by (parameters, batch) key.
+     */
+    NSMutableDictionary<NSDictionary*, MXSearchClientCachedResponse*> *cache;
+}
+
+@end
+
+@implementation MXSearchClient
+
+- (instancetype)initWithMatrixSession:(MXSession *)mxSession2
+{
+    self = [super init];
+    if (self)
+    {
+        mxSession = mxSession2;
+        pendingRequests = [NSMutableDictionary dictionary];
+        cache = [NSMutableDictionary dictionary];
+
+        _cacheLifetime = MXSEARCHCLIENT_DEFAULT_CACHE_LIFETIME;
+        _prefetchNextBatch = YES;
+    }
+    return self;
+}
+
+- (MXHTTPOperation*)searchMessageText:(NSString*)text
+                              inRooms:(NSArray<NSString*>*)rooms
+                          beforeLimit:(NSUInteger)beforeLimit
+                           afterLimit:(NSUInteger)afterLimit
+                            nextBatch:(NSString*)nextBatch
+                              success:(void (^)(MXSearchRoomEventResults *roomEventResults))success
+                              failure:(void (^)(NSError *error))failure
+{
+    // Same parameters as [MXRestClient searchMessageText:]
+    NSMutableDictionary *roomEventsParameters = [NSMutableDictionary dictionaryWithDictionary:
+                                                 @{
+                                                   @"search_term": text,
+                                                   @"order_by": @"recent",
+                                                   @"event_context": @{
+                                                           @"before_limit": @(beforeLimit),
+                                                           @"after_limit": @(afterLimit),
+                                                           @"include_profile": @(YES)
+                                                           }
+                                                   }];
+    if (rooms)
+    {
+        roomEventsParameters[@"filter"] = @{
+                                            @"rooms": rooms
+                                            };
+    }
+
+    return [self searchRoomEvents:roomEventsParameters nextBatch:nextBatch success:success failure:failure];
+}
+
+- (MXHTTPOperation*)searchRoomEvents:(NSDictionary*)roomEventsParameters
+                           nextBatch:(NSString*)nextBatch
+                             success:(void (^)(MXSearchRoomEventResults *roomEventResults))success
+                             failure:(void (^)(NSError *error))failure
+{
+    // A new query supersedes the previous one
+    if (![roomEventsParameters isEqualToDictionary:currentRoomEventsParameters])
+    {
+        [self cancelPendingSearches];
+        currentRoomEventsParameters = [roomEventsParameters copy];
+    }
+
+    NSDictionary *key = [self keyForRoomEventsParameters:roomEventsParameters nextBatch:nextBatch];
+
+    // Is it in the cache?
+    MXSearchRoomEventResults *roomEventResults = [self cachedResponseForKey:key];
+    if (roomEventResults)
+    {
+        if (success)
+        {
+            success(roomEventResults);
+        }
+
+        [self prefetchNextBatchOf:roomEventResults];
+        return nil;
+    }
+
+    // Is it already requested?
+    MXSearchClientRequest *request = pendingRequests[key];
+    if (!request)
+    {
+        request = [self startRequestForRoomEventsParameters:roomEventsParameters nextBatch:nextBatch];
+    }
+
+    MXSearchClientOperation *searchOperation = [[MXSearchClientOperation alloc] init];
+    searchOperation.searchClient = self;
+    searchOperation.key = key;
+    searchOperation.success = success;
+    searchOperation.failure = failure;
+    [request.callers addObject:searchOperation];
+
+    return searchOperation;
+}
+
+- (void)cancelPendingSearches
+{
+    NSArray<MXSearchClientRequest*> *requests = pendingRequests.allValues;
+    [pendingRequests removeAllObjects];
+
+    for (MXSearchClientRequest *request in requests)
+    {
+        [request.operation cancel];
+
+        // Do not leave callers waiting for a superseded query
+        for (MXSearchClientOperation *searchOperation in request.callers)
+        {
+            [self notifyCancellationToSearchOperation:searchOperation];
+        }
+        [request.callers removeAllObjects];
+    }
+}
+
+- (void)removeAllCachedResults
+{
+    [cache removeAllObjects];
+}
+
+- (void)cancelSearchOperation:(MXSearchClientOperation*)searchOperation
+{
+    MXSearchClientRequest *request = pendingRequests[searchOperation.key];
+    if (![request.callers containsObject:searchOperation])
+    {
+        // The request is already complete or cancelled
+        return;
+    }
+
+    [request.callers removeObject:searchOperation];
+    if (!request.callers.count)
+    {
+        [request.operation cancel];
+        [pendingRequests removeObjectForKey:searchOperation.key];
+    }
+
+    [self notifyCancellationToSearchOperation:searchOperation];
+}
+
+- (void)notifyCancellationToSearchOperation:(MXSearchClientOperation*)searchOperation
+{
+    // Like a cancelled HTTP request, the caller gets a cancellation error
+    if (searchOperation.failure)
+    {
+        void (^failure)(NSError *error) = searchOperation.failure;
+        dispatch_async(dispatch_get_main_queue(), ^{
+            failure([NSError errorWithDomain:NSURLErrorDomain code:NSURLErrorCancelled userInfo:nil]);
+        });
+    }
+}
+
+
+#pragma mark - MXMemoryPressureHandler
+- (NSUInteger)handleMemoryPressure:(MXMemoryPressureLevel)level
+{
+    NSUInteger count = 0;
+
+    // Results cost requests to the homeserver to be rebuilt
+    if (MXMemoryPressureLevelCritical == level)
+    {
+        count = cache.count;
+        [self removeAllCachedResults];
+    }
+
+    return count;
+}
+
+
+#pragma mark - Private methods
+- (NSDictionary*)keyForRoomEventsParameters:(NSDictionary*)roomEventsParameters nextBatch:(NSString*)nextBatch
+{
+    return @{
+             @"room_events": roomEventsParameters,
+             @"next_batch": nextBatch ? nextBatch : [NSNull null]
+             };
+}
+
+- (MXSearchClientRequest*)startRequestForRoomEventsParameters:(NSDictionary*)roomEventsParameters nextBatch:(NSString*)nextBatch
+{
+    NSDictionary *key = [self keyForRoomEventsParameters:roomEventsParameters nextBatch:nextBatch];
+
+    NSDictionary *requestedRoomEventsParameters = roomEventsParameters;
+    NSDictionary *eventContext = roomEventsParameters[@"event_context"];
+    BOOL resolveContextFromStore = _resolveContextFromStore && eventContext && [self canResolveContextFromStoreForRoomEventsParameters:roomEventsParameters];
+    if (resolveContextFromStore)
+    {
+        // Ask the homeserver for the results only
+        NSMutableDictionary *parameters = [NSMutableDictionary dictionaryWithDictionary:roomEventsParameters];
+        [parameters removeObjectForKey:@"event_context"];
+        requestedRoomEventsParameters = parameters;
+    }
+
+    MXSearchClientRequest *request = [[MXSearchClientRequest alloc] init];
+    pendingRequests[key] = request;
+
+    NSDictionary *parameters = @{
+                                 @"search_categories": @{
+                                         @"room_events": requestedRoomEventsParameters
+                                         }
+                                 };
+
+    __weak typeof(self) weakSelf = self;
+    __weak MXSearchClientRequest *weakRequest = request;
+
+    request.operation = [mxSession.matrixRestClient search:parameters nextBatch:nextBatch success:^(MXSearchRoomEventResults *roomEventResults) {
+
+        __strong __typeof(weakSelf)strongSelf = weakSelf;
+        __strong MXSearchClientRequest *request = weakRequest;
+
+        // Ignore responses of superseded queries
+        if (!strongSelf || !request || strongSelf->pendingRequests[key] != request)
+        {
+            return;
+        }
+        [strongSelf->pendingRequests removeObjectForKey:key];
+
+        if (resolveContextFromStore)
+        {
+            [strongSelf resolveContextOfResults:roomEventResults.results
+                              beforeLimit:[eventContext[@"before_limit"] unsignedIntegerValue]
+                               afterLimit:[eventContext[@"after_limit"] unsignedIntegerValue]];
+        }
+
+        [strongSelf cacheResponse:roomEventResults forKey:key];
+
+        for (MXSearchClientOperation *searchOperation in request.callers)
+        {
+            if (searchOperation.success)
+            {
+                searchOperation.success(roomEventResults);
+            }
+        }
+
+        // Get the next results while the user reads these ones
+        if (request.callers.count)
+        {
+            [strongSelf prefetchNextBatchOf:roomEventResults];
+        }
+
+    } failure:^(NSError *error) {
+
+        __strong __typeof(weakSelf)strongSelf = weakSelf;
+        __strong MXSearchClientRequest *request = weakRequest;
+
+        if (!strongSelf || !request || strongSelf->pendingRequests[key] != request)
+        {
+            return;
+        }
+        [strongSelf->pendingRequests removeObjectForKey:key];
+
+        for (MXSearchClientOperation *searchOperation in request.callers)
+        {
+            if (searchOperation.failure)
+            {
+                searchOperation.failure(error);
+            }
+        }
+    }];
+
+    return request;
+}
+
+- (void)prefetchNextBatchOf:(MXSearchRoomEventResults*)roomEventResults
+{
+    if (!_prefetchNextBatch || !_cacheLifetime || !roomEventResults.nextBatch || !currentRoomEventsParameters)
+    {
+        return;
+    }
+
+    NSDictionary *key = [self keyForRoomEventsParameters:currentRoomEventsParameters nextBatch:roomEventResults.nextBatch];
+    if (!pendingRequests[key] && ![self cachedResponseForKey:key])
+    {
+        NSLog(@"[MXSearchClient] Prefetch next batch %@", roomEventResults.nextBatch);
+        [self startRequestForRoomEventsParameters:currentRoomEventsParameters nextBatch:roomEventResults.nextBatch];
+    }
+}
+
+
+#pragma mark - Cache
+- (MXSearchRoomEventResults*)cachedResponseForKey:(NSDictionary*)key
+{
+    MXSearchClientCachedResponse *cachedResponse = cache[key];
+    if (cachedResponse)
+    {
+        if (-cachedResponse.date.timeIntervalSinceNow < _cacheLifetime)
+        {
+            return cachedResponse.roomEventResults;
+        }
+
+        // Expired
+        [cache removeObjectForKey:key];
+    }
+    return nil;
+}
+
+- (void)cacheResponse:(MXSearchRoomEventResults*)roomEventResults forKey:(NSDictionary*)key
+{
+    if (!_cacheLifetime)
+    {
+        return;
+    }
+
+    MXSearchClientCachedResponse *cachedResponse = [[MXSearchClientCachedResponse alloc] init];
+    cachedResponse.roomEventResults = roomEventResults;
+    cachedResponse.date = [NSDate date];
+    cache[key] = cachedResponse;
+
+    // Remove the oldest responses
+    while (cache.count > MXSEARCHCLIENT_CACHE_CAPACITY)
+    {
+        NSDictionary *oldestKey;
+        NSDate *oldestDate;
+        for (NSDictionary *cachedKey in cache)
+        {
+            NSDate *date = cache[cachedKey].date;
+            if (!oldestDate || [date compare:oldestDate] == NSOrderedAscending)
+            {
+                oldestKey = cachedKey;
+                oldestDate = date;
+            }
+        }
+        [cache removeObjectForKey:oldestKey];
+    }
+}
+
+
+#pragma mark - Local context
+/**
+ Check whether the store has the messages around all the results of a query.
+
+ This is the case when the store has the whole history of every room searched.
+
+ @param roomEventsParameters the "room_events" search criteria.
+ @return YES if the context of the results can be built from the store.
+ */
+- (BOOL)canResolveContextFromStoreForRoomEventsParameters:(NSDictionary*)roomEventsParameters
+{
+    // MXNoStore does not keep messages
+    if ([mxSession.store isKindOfClass:MXNoStore.class])
+    {
+        return NO;
+    }
+
+    NSArray<NSString*> *roomIds = roomEventsParameters[@"filter"][@"rooms"];
+    if (!roomIds)
+    {
+        NSMutableArray<NSString*> *sessionRoomIds = [NSMutableArray array];
+        for (MXRoom *room in mxSession.rooms)
+        {
+            [sessionRoomIds addObject:room.state.roomId];
+        }
+        roomIds = sessionRoomIds;
+    }
+
+    if (!roomIds.count)
+    {
+        return NO;
+    }
+
+    for (NSString *roomId in roomIds)
+    {
+        if (![mxSession.store hasReachedHomeServerPaginationEndForRoom:roomId])
+        {
+            return NO;
+        }
+    }
+
+    return YES;
+}
+
+/**
+ Build the context of results from the messages in the store.
+
+ The stored messages of each room are walked once for all the results of this room.
+ */
+- (void)resolveContextOfResults:(NSArray<MXSearchResult*>*)results beforeLimit:(NSUInteger)beforeLimit afterLimit:(NSUInteger)afterLimit
+{
+    // Group results by room
+    NSMutableDictionary<NSString*, NSMutableDictionary<NSString*, MXSearchResult*>*> *resultsByRoomId = [NSMutableDictionary dictionary];
+    for (MXSearchResult *result in results)
+    {
+        MXEvent *event = result.result;
+        if (!event.eventId || !event.roomId || ![mxSession.store eventWithEventId:event.eventId inRoom:event.roomId])
+        {
+            continue;
+        }
+
+        NSMutableDictionary<NSString*, MXSearchResult*> *roomResults = resultsByRoomId[event.roomId];
+        if (!roomResults)
+        {
+            roomResults = [NSMutableDictionary dictionary];
+            resultsByRoomId[event.roomId] = roomResults;
+        }
+        roomResults[event.eventId] = result;
+    }
+
+    for (NSString *roomId in resultsByRoomId)
+    {
+        NSMutableDictionary<NSString*, MXSearchResult*> *roomResults = resultsByRoomId[roomId];
+
+        NSMutableArray<MXSearchResult*> *resolvedResults = [NSMutableArray array];
+
+        // Events before the results already met that still miss events
+        NSMutableArray<NSMutableArray<MXEvent*>*> *incompleteEventsBefore = [NSMutableArray array];
+
+        // The closest events after the stored event being read, in chronological order
+        NSMutableArray<MXEvent*> *eventsAfter = [NSMutableArray array];
+
+        // Walk the stored messages of the room from the most recent one
+        id<MXEventsEnumerator> enumerator = [mxSession.store messagesEnumeratorForRoom:roomId];
+
+        MXEvent *storedEvent;
+        while ((roomResults.count || incompleteEventsBefore.count) && (storedEvent = enumerator.nextEvent))
+        {
+            for (NSMutableArray<MXEvent*> *eventsBefore in incompleteEventsBefore)
+            {
+                [eventsBefore addObject:storedEvent];
+            }
+            [incompleteEventsBefore filterUsingPredicate:[NSPredicate predicateWithBlock:^BOOL(NSArray<MXEvent*> *eventsBefore, NSDictionary *bindings) {
+                return eventsBefore.count < beforeLimit;
+            }]];
+
+            MXSearchResult *result = roomResults[storedEvent.eventId];
+            if (result)
+            {
+                [roomResults removeObjectForKey:storedEvent.eventId];
+
+                NSMutableArray<MXEvent*> *eventsBefore = [NSMutableArray array];
+                if (beforeLimit)
+                {
+                    [incompleteEventsBefore addObject:eventsBefore];
+                }
+
+                MXSearchEventContext *context = [[MXSearchEventContext alloc] init];
+                context.eventsBefore = eventsBefore;
+                context.eventsAfter = [eventsAfter copy];
+                result.context = context;
+
+                [resolvedResults addObject:result];
+            }
+
+            // Keep only the closest events
+            [eventsAfter insertObject:storedEvent atIndex:0];
+            if (eventsAfter.count > afterLimit)
+            {
+                [eventsAfter removeLastObject];
+            }
+        }
+
+        // Profiles of the senders at the time of the results. Fallback to the current ones
+        MXRoom *room = [mxSession roomWithRoomId:roomId];
+        for (MXSearchResult *result in resolvedResults)
+        {
+            MXEvent *event = result.result;
+
+            MXRoomState *roomState = [room stateBeforeStoredEvent:event.eventId];
+            if (!roomState)
+            {
+                roomState = room.state;
+            }
+
+            NSMutableDictionary<NSString*, MXSearchUserProfile*> *profileInfo = [NSMutableDictionary dictionary];
+            for (MXEvent *contextEvent in [[result.context.eventsBefore arrayByAddingObject:event] arrayByAddingObjectsFromArray:result.context.eventsAfter])
+            {
+                if (contextEvent.sender && !profileInfo[contextEvent.sender])
+                {
+                    MXRoomMember *member = [roomState memberWithUserId:contextEvent.sender];
+                    if (member)
+                    {
+                        MXSearchUserProfile *profile = [[MXSearchUserProfile alloc] init];
+                        profile.displayName = member.displayname;
+                        profile.avatarUrl = member.avatarUrl;
+                        profileInfo[contextEvent.sender] = profile;
+                    }
+                }
+            }
+            result.context.profileInfo = profileInfo;
+        }
+    }
+}
+
+@end
@@ -0,0 +1,134 @@
+/*
+ Copyright 2016 OpenMarket Ltd
+
+ Licensed under the Apache License, Version 2.0 (the "License");
+ you may not use this file except in compliance with the License.
+ You may obtain a copy of the License at
+
+ http://www.apache.org/licenses/LICENSE-2.0
+
+ Unless required by applicable law or agreed to in writing, software
+ distributed under the License is distributed on an "AS IS" BASIS,
+ WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ See the License for the specific language governing permissions and
+ limitations under the License.
+ */
+
+#import <Foundation/Foundation.h>
+
+#import "MXEventsEnumerator.h"
+#import "MXMemoryPressureHandler.h"
+
+@class MXSession;
+
+/**
+ `MXRetentionPolicy` defines how much history of a room is kept in the store.
+
+ The most recent messages are kept until one of the limits is reached. The most recent
+ message is always kept. A limit set to 0 is not applied.
+ */
+@interface MXRetentionPolicy : NSObject
+
+/**
+ The maximum number of messages to keep.
+ */
+@property (nonatomic) NSUInteger maxEvents;
+
+/**
+ The maximum age in seconds of the messages to keep.
+ */
+@property (nonatomic) NSTimeInterval maxAge;
+
+/**
+ The approximate maximum size in bytes of the messages to keep.
+ It is computed on their JSON representation.
+ */
+@property (nonatomic) NSUInteger maxBytes;
+
+/**
+ Find the oldest message to keep.
+
+ @param enumerator an enumerator on the messages of a room, from the most recent.
+ @return the oldest message to keep. nil if all messages can be kept.
+ */
+- (MXEvent*)oldestEventToKeepInEnumerator:(id<MXEventsEnumerator>)enumerator;
+
+@end
+
+
+/**
+ `MXStoreCompactor` removes the oldest messages of rooms from the store according to
+ retention policies.
+
+ The pagination token of each compacted room is updated so that the removed history can
+ still be paginated from the homeserver. The messages to remove are computed on a
+ background thread and a `MXFileStore` rewrites the room archives on its own thread.
+
+ Once a policy is set, the compaction runs automatically after a sync at most once every
+ `compactionInterval` seconds. If `compactsOnMemoryPressure` is enabled, it also runs on
+ critical memory pressure, whatever the interval.
+ */
+@interface MXStoreCompactor : NSObject <MXMemoryPressureHandler>
+
+/**
+ Create a `MXStoreCompactor` instance.
+
+ @param mxSession the session whose store must be compacted.
+ @return the newly created instance.
+ */
+- (instancetype)initWithMatrixSession:(MXSession*)mxSession;
+
+/**
+ The policy for rooms that do not have a specific one.
+ Default is nil: the history is kept entirely.
+ */
+@property (nonatomic) MXRetentionPolicy *defaultRetentionPolicy;
+
+/**
+ Set the policy of a room.
+
+ @param retentionPolicy the policy. nil to use `defaultRetentionPolicy`.
+ @param roomId the id of the room.
+ */
+- (void)setRetentionPolicy:(MXRetentionPolicy*)retentionPolicy forRoom:(NSString*)roomId;
+
+/**
+ Get the policy applied to a room.
+
+ @param roomId the id of the room.
+ @return the room policy or `defaultRetentionPolicy`.
+ */
+- (MXRetentionPolicy*)retentionPolicyForRoom:(NSString*)roomId;
+
+/**
+ The minimum time in seconds between two automatic compactions.
+ Default is 24h.
+ */
+@property (nonatomic) NSTimeInterval compactionInterval;
+
+/**
+ Compact the store on critical memory pressure.
+ The removed history will have to be paginated again from the homeserver.
+ Default is NO.
+ */
+@property (nonatomic) BOOL compactsOnMemoryPressure;
+
+/**
+ Apply the policies to all rooms of the store.
+
+ @param onComplete A block called when the compaction is complete. It provides the number
+                   of removed messages.
+ */
+- (void)compact:(void (^)(NSUInteger removedEventsCount))onComplete;
+
+/**
+ Tell whether a compaction is in progress.
+ */
+@property (nonatomic, readonly) BOOL isCompacting;
+
+/**
+ Stop the compaction in progress and the automatic compactions.
+ */
+- (void)close;
+
+@end
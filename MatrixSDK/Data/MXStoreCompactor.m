@@ -0,0 +1,358 @@
+/*
+ Copyright 2016 OpenMarket Ltd
+
+ Licensed under the Apache License, Version 2.0 (the "License");
+ you may not use this file except in compliance with the License.
+ You may obtain a copy of the License at
+
+ http://www.apache.org/licenses/LICENSE-2.0
+
+ Unless required by applicable law or agreed to in writing, software
+ distributed under the License is distributed on an "AS IS" BASIS,
+ WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ See the License for the specific language governing permissions and
+ limitations under the License.
+ */
+
+#import "MXStoreCompactor.h"
+
+#import "MXSession.h"
+
+/**
+ The default minimum time in seconds between two automatic compactions.
+ */
+#define MXSTORECOMPACTOR_DEFAULT_COMPACTION_INTERVAL (24 * 3600)
+
+#pragma mark - MXRetentionPolicy
+@implementation MXRetentionPolicy
+
+- (MXEvent *)oldestEventToKeepInEnumerator:(id<MXEventsEnumerator>)enumerator
+{
+    uint64_t minTs = 0;
+    if (_maxAge)
+    {
+        minTs = (uint64_t)(([[NSDate date] timeIntervalSince1970] - _maxAge) * 1000);
+    }
+
+    MXEvent *oldestEventToKeep;
+    NSUInteger count = 0, bytes = 0;
+
+    MXEvent *event;
+    while ((event = enumerator.nextEvent))
+    {
+        // Always keep the most recent message
+        if (count)
+        {
+            if (_maxEvents && count >= _maxEvents)
+            {
+                break;
+            }
+
+            if (minTs && event.originServerTs && event.originServerTs < minTs)
+            {
+                break;
+            }
+        }
+
+        if (_maxBytes)
+        {
+            bytes += [NSJSONSerialization dataWithJSONObject:event.JSONDictionary options:0 error:nil].length;
+            if (count && bytes > _maxBytes)
+            {
+                break;
+            }
+        }
+
+        oldestEventToKeep = event;
+        count++;
+    }
+
+    // All messages fit in the policy
+    if (!event)
+    {
+        return nil;
+    }
+
+    return oldestEventToKeep;
+}
+
+@end
+
+
+#pragma mark - MXStoreCompactor
+@interface MXStoreCompactor ()
+{
+    MXSession *mxSession;
+
+    /**
+     Retention policies by room id.
+     */
+    NSMutableDictionary<NSString*, MXRetentionPolicy*> *retentionPolicies;
+
+    /**
+     The rooms remaining to compact in the current compaction.
+     */
+    NSMutableArray<NSString*> *roomsToCompact;
+
+    /**
+     The number of messages removed by the current compaction.
+     */
+    NSUInteger removedEventsCount;
+
+    /**
+     The blocks to call at the end of the current compaction.
+     */
+    NSMutableArray<void (^)(NSUInteger)> *onCompleteBlocks;
+
+    /**
+     The request in progress.
+     */
+    MXHTTPOperation *pendingOperation;
+
+    /**
+     The queue where messages to remove are computed.
+     */
+    dispatch_queue_t processingQueue;
+
+    /**
+     The date of the last compaction start.
+     */
+    NSDate *lastCompactionDate;
+
+    /**
+     The observer of session syncs.
+     */
+    id sessionDidSyncObserver;
+}
+
+@end
+
+@implementation MXStoreCompactor
+
+- (instancetype)initWithMatrixSession:(MXSession *)mxSession2
+{
+    self = [super init];
+    if (self)
+    {
+        mxSession = mxSession2;
+        retentionPolicies = [NSMutableDictionary dictionary];
+        onCompleteBlocks = [NSMutableArray array];
+        processingQueue = dispatch_queue_create("MXStoreCompactor", DISPATCH_QUEUE_SERIAL);
+
+        _compactionInterval = MXSTORECOMPACTOR_DEFAULT_COMPACTION_INTERVAL;
+
+        __weak typeof(self) weakSelf = self;
+        sessionDidSyncObserver = [[NSNotificationCenter defaultCenter] addObserverForName:kMXSessionDidSyncNotification object:mxSession queue:[NSOperationQueue mainQueue] usingBlock:^(NSNotification *notif) {
+
+            __strong __typeof(weakSelf)strongSelf = weakSelf;
+            [strongSelf compactIfNeeded];
+        }];
+    }
+    return self;
+}
+
+- (void)setRetentionPolicy:(MXRetentionPolicy *)retentionPolicy forRoom:(NSString *)roomId
+{
+    if (retentionPolicy)
+    {
+        retentionPolicies[roomId] = retentionPolicy;
+    }
+    else
+    {
+        [retentionPolicies removeObjectForKey:roomId];
+    }
+}
+
+- (MXRetentionPolicy *)retentionPolicyForRoom:(NSString *)roomId
+{
+    MXRetentionPolicy *retentionPolicy = retentionPolicies[roomId];
+    if (!retentionPolicy)
+    {
+        retentionPolicy = _defaultRetentionPolicy;
+    }
+    return retentionPolicy;
+}
+
+- (void)compact:(void (^)(NSUInteger))onComplete
+{
+    if (onComplete)
+    {
+        [onCompleteBlocks addObject:onComplete];
+    }
+
+    if (_isCompacting)
+    {
+        // The blocks will be called at the end of the current compaction
+        return;
+    }
+
+    if (![mxSession.store respondsToSelector:@selector(rooms)]
+        || ![mxSession.store respondsToSelector:@selector(removeMessagesBeforeEvent:inRoom:paginationToken:)])
+    {
+        NSLog(@"[MXStoreCompactor] The store does not support compaction");
+        [self didComplete];
+        return;
+    }
+
+    NSLog(@"[MXStoreCompactor] Start compaction");
+
+    _isCompacting = YES;
+    lastCompactionDate = [NSDate date];
+    removedEventsCount = 0;
+    roomsToCompact = [NSMutableArray arrayWithArray:mxSession.store.rooms];
+
+    [self compactNextRoom];
+}
+
+- (void)close
+{
+    [[NSNotificationCenter defaultCenter] removeObserver:sessionDidSyncObserver];
+    sessionDidSyncObserver = nil;
+
+    [pendingOperation cancel];
+    pendingOperation = nil;
+
+    [roomsToCompact removeAllObjects];
+    [onCompleteBlocks removeAllObjects];
+    _isCompacting = NO;
+}
+
+
+#pragma mark - MXMemoryPressureHandler
+- (NSUInteger)handleMemoryPressure:(MXMemoryPressureLevel)level
+{
+    // The removed history can be paginated again from the homeserver.
+    // Messages are released asynchronously: they are not counted here
+    if (_compactsOnMemoryPressure && MXMemoryPressureLevelCritical == level
+        && !_isCompacting && (_defaultRetentionPolicy || retentionPolicies.count))
+    {
+        [self compact:nil];
+    }
+
+    return 0;
+}
+
+
+#pragma mark - Private methods
+- (void)compactIfNeeded
+{
+    if (!_isCompacting
+        && (_defaultRetentionPolicy || retentionPolicies.count)
+        && (!lastCompactionDate || -lastCompactionDate.timeIntervalSinceNow >= _compactionInterval))
+    {
+        [self compact:nil];
+    }
+}
+
+- (void)compactNextRoom
+{
+    if (!_isCompacting)
+    {
+        return;
+    }
+
+    NSString *roomId = roomsToCompact.firstObject;
+    if (!roomId)
+    {
+        NSLog(@"[MXStoreCompactor] Compaction done. %tu messages removed", removedEventsCount);
+
+        // Save the rewritten rooms
+        if ([mxSession.store respondsToSelector:@selector(commit)])
+        {
+            [mxSession.store commit];
+        }
+
+        _isCompacting = NO;
+        [self didComplete];
+        return;
+    }
+    [roomsToCompact removeObjectAtIndex:0];
+
+    MXRetentionPolicy *retentionPolicy = [self retentionPolicyForRoom:roomId];
+    if (!retentionPolicy)
+    {
+        [self compactNextRoom];
+        return;
+    }
+
+    // The enumerator works on a snapshot of the messages: it can be read from another thread
+    id<MXEventsEnumerator> enumerator = [mxSession.store messagesEnumeratorForRoom:roomId];
+
+    __weak typeof(self) weakSelf = self;
+    dispatch_async(processingQueue, ^{
+
+        MXEvent *oldestEventToKeep = [retentionPolicy oldestEventToKeepInEnumerator:enumerator];
+
+        dispatch_async(dispatch_get_main_queue(), ^{
+
+            __strong __typeof(weakSelf)strongSelf = weakSelf;
+            if (strongSelf)
+            {
+                if (oldestEventToKeep.eventId)
+                {
+                    [strongSelf compactRoom:roomId keepingEventsFrom:oldestEventToKeep.eventId];
+                }
+                else
+                {
+                    [strongSelf compactNextRoom];
+                }
+            }
+        });
+    });
+}
+
+/**
+ Remove the messages of a room older than an event.
+
+ @param roomId the id of the room.
+ @param eventId the id of the oldest event to keep.
+ */
+- (void)compactRoom:(NSString*)roomId keepingEventsFrom:(NSString*)eventId
+{
+    // Get the token to paginate back from this event on the homeserver.
+    // With no context, the start token is just before the event
+    __weak typeof(self) weakSelf = self;
+    pendingOperation = [mxSession.matrixRestClient contextOfEvent:eventId inRoom:roomId limit:0 success:^(MXEventContext *eventContext) {
+
+        __strong __typeof(weakSelf)strongSelf = weakSelf;
+        if (strongSelf && strongSelf->_isCompacting)
+        {
+            strongSelf->pendingOperation = nil;
+
+            if (eventContext.start)
+            {
+                NSUInteger count = [strongSelf->mxSession.store removeMessagesBeforeEvent:eventId inRoom:roomId paginationToken:eventContext.start];
+                strongSelf->removedEventsCount += count;
+
+                NSLog(@"[MXStoreCompactor] %tu messages removed from room %@", count, roomId);
+            }
+
+            [strongSelf compactNextRoom];
+        }
+
+    } failure:^(NSError *error) {
+
+        __strong __typeof(weakSelf)strongSelf = weakSelf;
+        if (strongSelf && strongSelf->_isCompacting)
+        {
+            strongSelf->pendingOperation = nil;
+
+            // Keep the history of this room until the next compaction
+            NSLog(@"[MXStoreCompactor] Cannot compact room %@: %@", roomId, error);
+            [strongSelf compactNextRoom];
+        }
+    }];
+}
+
+- (void)didComplete
+{
+    NSArray<void (^)(NSUInteger)> *blocks = [onCompleteBlocks copy];
+    [onCompleteBlocks removeAllObjects];
+
+    for (void (^onComplete)(NSUInteger) in blocks)
+    {
+        onComplete(removedEventsCount);
+    }
+}
+
+@end
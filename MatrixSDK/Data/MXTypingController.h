@@ -0,0 +1,82 @@
+/*
+ Copyright 2016 OpenMarket Ltd
+
+ Licensed under the Apache License, Version 2.0 (the "License");
+ you may not use this file except in compliance with the License.
+ You may obtain a copy of the License at
+
+ http://www.apache.org/licenses/LICENSE-2.0
+
+ Unless required by applicable law or agreed to in writing, software
+ distributed under the License is distributed on an "AS IS" BASIS,
+ WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ See the License for the specific language governing permissions and
+ limitations under the License.
+ */
+
+#import <Foundation/Foundation.h>
+
+@class MXRoom;
+
+/**
+ `MXTypingController` manages the typing notifications of the user in a room.
+
+ The app reports keystrokes with `userIsTyping`. The controller takes care of the requests
+ to the homeserver:
+ - a typing notification is sent when the user starts typing,
+ - it is renewed shortly before it expires on the homeserver while the user keeps typing,
+ - the notification is stopped when the user stops typing for `idleTimeout` seconds, when
+   `userStoppedTyping` is called or when a message is sent to the room,
+ - two requests are never sent within `minimumRequestInterval` seconds. Changes happening
+   in this interval are coalesced.
+ */
+@interface MXTypingController : NSObject
+
+/**
+ Create a `MXTypingController` instance.
+
+ @param room the room where the user types.
+ @return the newly created instance.
+ */
+- (instancetype)initWithRoom:(MXRoom*)room;
+
+/**
+ Report a keystroke from the user.
+ */
+- (void)userIsTyping;
+
+/**
+ Report that the user is no longer typing (text cleared, message sent...).
+ */
+- (void)userStoppedTyping;
+
+/**
+ Stop timers. Pending changes are not sent.
+ */
+- (void)close;
+
+/**
+ Tell whether the user is considered as typing.
+ */
+@property (nonatomic, readonly) BOOL isTyping;
+
+/**
+ The length of time in milliseconds during which the homeserver considers the user as
+ typing after a notification.
+ Default is 30000.
+ */
+@property (nonatomic) NSUInteger typingTimeout;
+
+/**
+ The time in seconds without keystroke after which the user is no longer typing.
+ Default is 10s.
+ */
+@property (nonatomic) NSTimeInterval idleTimeout;
+
+/**
+ The minimum time in seconds between two requests to the homeserver.
+ Default is 2s.
+ */
+@property (nonatomic) NSTimeInterval minimumRequestInterval;
+
+@end
@@ -0,0 +1,214 @@
+/*
+ Copyright 2016 OpenMarket Ltd
+
+ Licensed under the Apache License, Version 2.0 (the "License");
+ you may not use this file except in compliance with the License.
+ You may obtain a copy of the License at
+
+ http://www.apache.org/licenses/LICENSE-2.0
+
+ Unless required by applicable law or agreed to in writing, software
+ distributed under the License is distributed on an "AS IS" BASIS,
+ WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ See the License for the specific language governing permissions and
+ limitations under the License.
+ */
+
+#import "MXTypingController.h"
+
+#import "MXRoom.h"
+
+/**
+ The time in seconds before the expiration of the typing notification on the homeserver
+ when it is renewed.
+ */
+#define MXTYPINGCONTROLLER_RENEWAL_MARGIN 5
+
+
+#pragma mark - MXTypingControllerTimerTarget
+/**
+ NSTimer retains its target. This object forwards the timer fire to a weak target so that
+ pending timers do not keep the controller, and so the room, alive.
+ */
+@interface MXTypingControllerTimerTarget : NSObject
+
++ (NSTimer*)scheduledTimerWithTimeInterval:(NSTimeInterval)interval target:(id)target selector:(SEL)selector;
+
+@end
+
+@implementation MXTypingControllerTimerTarget
+{
+    __weak id target;
+    SEL selector;
+}
+
++ (NSTimer*)scheduledTimerWithTimeInterval:(NSTimeInterval)interval target:(id)target selector:(SEL)selector
+{
+    MXTypingControllerTimerTarget *timerTarget = [[MXTypingControllerTimerTarget alloc] init];
+    timerTarget->target = target;
+    timerTarget->selector = selector;
+
+    return [NSTimer scheduledTimerWithTimeInterval:interval target:timerTarget selector:@selector(timerDidFire:) userInfo:nil repeats:NO];
+}
+
+- (void)timerDidFire:(NSTimer*)timer
+{
+    id strongTarget = target;
+    if (strongTarget)
+    {
+#pragma clang diagnostic push
+#pragma clang diagnostic ignored "-Warc-performSelector-leaks"
+        [strongTarget performSelector:selector];
+#pragma clang diagnostic pop
+    }
+    else
+    {
+        [timer invalidate];
+    }
+}
+
+@end
+
+
+#pragma mark - MXTypingController
+@interface MXTypingController ()
+{
+    __weak MXRoom *room;
+
+    /**
+     The state known by the homeserver.
+     */
+    BOOL serverIsTyping;
+
+    /**
+     When the homeserver will consider that the user is no longer typing.
+     */
+    NSDate *serverTypingExpirationDate;
+
+    /**
+     The date of the last request.
+     */
+    NSDate *lastRequestDate;
+
+    /**
+     Timer to detect the end of typing.
+     */
+    NSTimer *idleTimer;
+
+    /**
+     Timer to renew the notification or to send a change delayed by the rate limit.
+     */
+    NSTimer *updateTimer;
+}
+
+@end
+
+@implementation MXTypingController
+
+- (instancetype)initWithRoom:(MXRoom *)room2
+{
+    self = [super init];
+    if (self)
+    {
+        room = room2;
+
+        _typingTimeout = 30000;
+        _idleTimeout = 10;
+        _minimumRequestInterval = 2;
+    }
+    return self;
+}
+
+- (void)dealloc
+{
+    [self close];
+}
+
+- (void)userIsTyping
+{
+    [idleTimer invalidate];
+    idleTimer = [MXTypingControllerTimerTarget scheduledTimerWithTimeInterval:_idleTimeout target:self selector:@selector(userStoppedTyping)];
+
+    if (!_isTyping)
+    {
+        _isTyping = YES;
+        [self update];
+    }
+}
+
+- (void)userStoppedTyping
+{
+    [idleTimer invalidate];
+    idleTimer = nil;
+
+    if (_isTyping)
+    {
+        _isTyping = NO;
+        [self update];
+    }
+}
+
+- (void)close
+{
+    [idleTimer invalidate];
+    idleTimer = nil;
+
+    [updateTimer invalidate];
+    updateTimer = nil;
+}
+
+
+#pragma mark - Private methods
+/**
+ Synchronise the homeserver with the current state, within the rate limit.
+ */
+- (void)update
+{
+    [updateTimer invalidate];
+    updateTimer = nil;
+
+    BOOL needsRequest;
+    if (_isTyping)
+    {
+        // Start or renew the notification
+        needsRequest = !serverIsTyping || serverTypingExpirationDate.timeIntervalSinceNow <= MXTYPINGCONTROLLER_RENEWAL_MARGIN;
+    }
+    else
+    {
+        needsRequest = serverIsTyping;
+    }
+
+    if (needsRequest)
+    {
+        NSTimeInterval delay = lastRequestDate ? _minimumRequestInterval + lastRequestDate.timeIntervalSinceNow : 0;
+        if (delay > 0)
+        {
+            // Too early. The state may change again before the delay
+            updateTimer = [MXTypingControllerTimerTarget scheduledTimerWithTimeInterval:delay target:self selector:@selector(update)];
+            return;
+        }
+
+        [self sendTypingNotification:_isTyping];
+    }
+
+    if (_isTyping)
+    {
+        // Schedule the renewal
+        NSTimeInterval renewalDelay = MAX(serverTypingExpirationDate.timeIntervalSinceNow - MXTYPINGCONTROLLER_RENEWAL_MARGIN, _minimumRequestInterval);
+        updateTimer = [MXTypingControllerTimerTarget scheduledTimerWithTimeInterval:renewalDelay target:self selector:@selector(update)];
+    }
+}
+
+- (void)sendTypingNotification:(BOOL)typing
+{
+    lastRequestDate = [NSDate date];
+    serverIsTyping = typing;
+    serverTypingExpirationDate = typing ? [NSDate dateWithTimeIntervalSinceNow:_typingTimeout / 1000.0] : nil;
+
+    NSString *roomId = room.roomId;
+    [room sendTypingNotification:typing timeout:(typing ? _typingTimeout : -1) success:nil failure:^(NSError *error) {
+        NSLog(@"[MXTypingController] Failed to send typing notification (%@) in room %@: %@", typing ? @"YES" : @"NO", roomId, error);
+    }];
+}
+
+@end
@@ -17,7 +17,6 @@
 #import <Foundation/Foundation.h>
 
 #import "MXJSONModels.h"
-#import <UIKit/UIKit.h>
 
 @class MXSession;
 @class MXEvent;
@@ -86,11 +85,14 @@
 /**
  Update the MXUser data with a m.room.member event.
  
+ Listeners are notified only if the display name or the avatar has changed.
+
  @param roomMemberEvent The event.
  @param roomMember The already decoded room member.
  @param mxSession the mxSession to the home server.
+ @return YES if the user data has changed and must be stored again.
  */
-- (void)updateWithRoomMemberEvent:(MXEvent*)roomMemberEvent roomMember:(MXRoomMember *)roomMember inMatrixSession:(MXSession*)mxSession;
+- (BOOL)updateWithRoomMemberEvent:(MXEvent*)roomMemberEvent roomMember:(MXRoomMember *)roomMember inMatrixSession:(MXSession*)mxSession;
 
 /**
  Update the MXUser data with a m.presence event.
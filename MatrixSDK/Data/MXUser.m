@@ -59,24 +59,32 @@
     return [NSString stringWithFormat:@"%@: %@ (%@) - Presence: %tu", _userId, _displayname, _avatarUrl, _presence];
 }
 
-- (void)updateWithRoomMemberEvent:(MXEvent*)roomMemberEvent roomMember:(MXRoomMember *)roomMember inMatrixSession:(MXSession *)mxSession
+- (BOOL)updateWithRoomMemberEvent:(MXEvent*)roomMemberEvent roomMember:(MXRoomMember *)roomMember inMatrixSession:(MXSession *)mxSession
 {
-    // Update the MXUser only if there is change
-    if ((NO == [_displayname isEqualToString:roomMember.displayname]
-            || NO == [_avatarUrl isEqualToString:roomMember.avatarUrl]))
+    // The user data shares the strings of the member profile
+    MXMemberProfile *memberProfile = roomMember.profile;
+    NSString *avatarUrl = memberProfile.avatarUrl;
+
+    // Handle here the case where the user has no defined avatar.
+    if (nil == avatarUrl && ![MXSDKOptions sharedInstance].disableIdenticonUseForUserAvatar)
     {
-        self.displayname = [roomMember.displayname copy];
-        self.avatarUrl = [roomMember.avatarUrl copy];
-        
-        // Handle here the case where the user has no defined avatar.
-        if (nil == self.avatarUrl && ![MXSDKOptions sharedInstance].disableIdenticonUseForUserAvatar)
-        {
-            // Force to use an identicon url
-            self.avatarUrl = [mxSession.matrixRestClient urlOfIdenticon:self.userId];
-        }
+        // Force to use an identicon url
+        avatarUrl = [mxSession.matrixRestClient urlOfIdenticon:self.userId];
+    }
 
-        [self notifyListeners:roomMemberEvent];
+    // Update the MXUser only if there is change
+    if ((_displayname == memberProfile.displayname || [_displayname isEqualToString:memberProfile.displayname])
+        && (_avatarUrl == avatarUrl || [_avatarUrl isEqualToString:avatarUrl]))
+    {
+        return NO;
     }
+
+    self.displayname = memberProfile.displayname;
+    self.avatarUrl = avatarUrl;
+
+    [self notifyListeners:roomMemberEvent];
+
+    return YES;
 }
 
 - (void)updateWithPresenceEvent:(MXEvent*)presenceEvent inMatrixSession:(MXSession *)mxSession
@@ -22,6 +22,11 @@
  
  This serialisation is done in the context of the multi-threading managed by [MXFileStore commit].
  @see [MXFileRoomStore encodeWithCoder] for more details.
+
+ Membership events, which represent most of the history of big rooms, are not archived
+ as MXEvent objects but in a columnar table (event id, user ids, timestamps and references
+ to a table of distinct contents). They are rebuilt as MXEvent only when they are read
+ (enumeration, lookup by event id...) after the room store has been decoded.
  */
 @interface MXFileRoomStore : MXMemoryRoomStore <NSCoding>
 
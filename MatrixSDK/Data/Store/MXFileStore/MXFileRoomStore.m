@@ -16,6 +16,410 @@
 
 #import "MXFileRoomStore.h"
 
+#import "MXEventContentPool.h"
+#import "MXSDKOptions.h"
+
+/**
+ Keys of the columnar table used to serialise membership events.
+ */
+static NSString *const kMXFileRoomStoreMemberEventsPositions = @"memberEventsPositions";
+static NSString *const kMXFileRoomStoreMemberEventsRoomId = @"memberEventsRoomId";
+static NSString *const kMXFileRoomStoreMemberEventsEventIds = @"memberEventsEventIds";
+static NSString *const kMXFileRoomStoreMemberEventsUserIds = @"memberEventsUserIds";
+static NSString *const kMXFileRoomStoreMemberEventsSenders = @"memberEventsSenders";
+static NSString *const kMXFileRoomStoreMemberEventsStateKeys = @"memberEventsStateKeys";
+static NSString *const kMXFileRoomStoreMemberEventsOriginServerTs = @"memberEventsOriginServerTs";
+static NSString *const kMXFileRoomStoreMemberEventsAgeLocalTs = @"memberEventsAgeLocalTs";
+static NSString *const kMXFileRoomStoreMemberEventsContents = @"memberEventsContents";
+static NSString *const kMXFileRoomStoreMemberEventsContentRefs = @"memberEventsContentRefs";
+static NSString *const kMXFileRoomStoreMemberEventsPrevContentRefs = @"memberEventsPrevContentRefs";
+
+/**
+ The reference used in the prev content column when a membership event has no prev content.
+ */
+static const uint32_t kMXFileRoomStoreNoContentRef = UINT32_MAX;
+
+/**
+ The row used in `MXFileRoomStoreMessages` for events that are not in the membership events table.
+ */
+static const uint32_t kMXFileRoomStoreNoRow = UINT32_MAX;
+
+
+#pragma mark - MXFileRoomStoreMemberEventsTable
+/**
+ The decoded columnar table of membership events.
+
+ It builds the MXEvent of a row the first time it is requested and keeps it so that
+ the same instance is always returned.
+ */
+@interface MXFileRoomStoreMemberEventsTable : NSObject
+{
+    @public
+    // The columns. They have one item per row
+    NSArray<NSString*> *eventIds;
+    const uint32_t *positions;
+}
+
+/**
+ Decode the table.
+
+ @param aDecoder the decoder of the room store.
+ @param messagesCount the total number of messages of the room store.
+ @return the table. nil if the data is corrupted.
+ */
+- (instancetype)initWithCoder:(NSCoder *)aDecoder messagesCount:(NSUInteger)messagesCount;
+
+/**
+ Get the event of a row, built on demand.
+ */
+- (MXEvent*)eventAtRow:(uint32_t)row;
+
+@end
+
+@implementation MXFileRoomStoreMemberEventsTable
+{
+    NSString *roomId;
+    NSArray<NSString*> *userIds;
+    NSArray<NSDictionary*> *contents;
+
+    // Keep the data objects alive as long as their bytes are used
+    NSArray<NSData*> *columnsData;
+    const uint32_t *senders;
+    const uint32_t *stateKeys;
+    const uint32_t *contentRefs;
+    const uint32_t *prevContentRefs;
+    const uint64_t *originServerTs;
+    const uint64_t *ageLocalTs;
+
+    // The events built so far. NULL for rows not built yet
+    NSPointerArray *events;
+}
+
+- (instancetype)initWithCoder:(NSCoder *)aDecoder messagesCount:(NSUInteger)messagesCount
+{
+    self = [super init];
+    if (self)
+    {
+        eventIds = [aDecoder decodeObjectForKey:kMXFileRoomStoreMemberEventsEventIds];
+        roomId = [aDecoder decodeObjectForKey:kMXFileRoomStoreMemberEventsRoomId];
+        userIds = [aDecoder decodeObjectForKey:kMXFileRoomStoreMemberEventsUserIds];
+        contents = [aDecoder decodeObjectForKey:kMXFileRoomStoreMemberEventsContents];
+
+        if (![eventIds isKindOfClass:NSArray.class] || ![roomId isKindOfClass:NSString.class]
+            || ![userIds isKindOfClass:NSArray.class] || ![contents isKindOfClass:NSArray.class])
+        {
+            return nil;
+        }
+
+        NSUInteger count = eventIds.count;
+
+        // Check the length of each column before reading its bytes
+        NSData *positionsData = [self columnWithCoder:aDecoder forKey:kMXFileRoomStoreMemberEventsPositions itemSize:sizeof(uint32_t) count:count];
+        NSData *sendersData = [self columnWithCoder:aDecoder forKey:kMXFileRoomStoreMemberEventsSenders itemSize:sizeof(uint32_t) count:count];
+        NSData *stateKeysData = [self columnWithCoder:aDecoder forKey:kMXFileRoomStoreMemberEventsStateKeys itemSize:sizeof(uint32_t) count:count];
+        NSData *contentRefsData = [self columnWithCoder:aDecoder forKey:kMXFileRoomStoreMemberEventsContentRefs itemSize:sizeof(uint32_t) count:count];
+        NSData *prevContentRefsData = [self columnWithCoder:aDecoder forKey:kMXFileRoomStoreMemberEventsPrevContentRefs itemSize:sizeof(uint32_t) count:count];
+        NSData *originServerTsData = [self columnWithCoder:aDecoder forKey:kMXFileRoomStoreMemberEventsOriginServerTs itemSize:sizeof(uint64_t) count:count];
+        NSData *ageLocalTsData = [self columnWithCoder:aDecoder forKey:kMXFileRoomStoreMemberEventsAgeLocalTs itemSize:sizeof(uint64_t) count:count];
+
+        if (!positionsData || !sendersData || !stateKeysData || !contentRefsData || !prevContentRefsData || !originServerTsData || !ageLocalTsData)
+        {
+            return nil;
+        }
+
+        columnsData = @[positionsData, sendersData, stateKeysData, contentRefsData, prevContentRefsData, originServerTsData, ageLocalTsData];
+        positions = positionsData.bytes;
+        senders = sendersData.bytes;
+        stateKeys = stateKeysData.bytes;
+        contentRefs = contentRefsData.bytes;
+        prevContentRefs = prevContentRefsData.bytes;
+        originServerTs = originServerTsData.bytes;
+        ageLocalTs = ageLocalTsData.bytes;
+
+        // Check the references
+        for (NSUInteger i = 0; i < count; i++)
+        {
+            if (positions[i] >= messagesCount || (i && positions[i] <= positions[i - 1])
+                || senders[i] >= userIds.count || stateKeys[i] >= userIds.count
+                || contentRefs[i] >= contents.count
+                || (prevContentRefs[i] != kMXFileRoomStoreNoContentRef && prevContentRefs[i] >= contents.count))
+            {
+                return nil;
+            }
+        }
+
+        // Share the contents with the other events
+        if ([MXSDKOptions sharedInstance].enableEventContentDeduplication)
+        {
+            NSMutableArray<NSDictionary*> *internedContents = [NSMutableArray arrayWithCapacity:contents.count];
+            for (NSDictionary *content in contents)
+            {
+                [internedContents addObject:[[MXEventContentPool sharedPool] internContent:content]];
+            }
+            contents = internedContents;
+        }
+
+        events = [NSPointerArray strongObjectsPointerArray];
+        events.count = count;
+    }
+    return self;
+}
+
+- (NSData*)columnWithCoder:(NSCoder *)aDecoder forKey:(NSString*)key itemSize:(NSUInteger)itemSize count:(NSUInteger)count
+{
+    NSData *column = [aDecoder decodeObjectForKey:key];
+    if (![column isKindOfClass:NSData.class] || column.length != itemSize * count)
+    {
+        return nil;
+    }
+    return column;
+}
+
+- (MXEvent *)eventAtRow:(uint32_t)row
+{
+    @synchronized(self)
+    {
+        MXEvent *event = (__bridge MXEvent*)[events pointerAtIndex:row];
+        if (!event)
+        {
+            event = [[MXEvent alloc] init];
+            event.eventId = eventIds[row];
+            event.type = kMXEventTypeStringRoomMember;
+            event.roomId = roomId;
+            event.sender = userIds[senders[row]];
+            event.stateKey = userIds[stateKeys[row]];
+            event.content = contents[contentRefs[row]];
+            if (prevContentRefs[row] != kMXFileRoomStoreNoContentRef)
+            {
+                event.prevContent = contents[prevContentRefs[row]];
+            }
+            event.originServerTs = originServerTs[row];
+            event.ageLocalTs = ageLocalTs[row];
+
+            [events replacePointerAtIndex:row withPointer:(__bridge void*)event];
+        }
+        return event;
+    }
+}
+
+@end
+
+
+#pragma mark - MXFileRoomStoreMessages
+/**
+ The messages of a decoded room store.
+
+ Membership events of the table are built only when they are read.
+ */
+@interface MXFileRoomStoreMessages : NSMutableArray
+
+- (instancetype)initWithTable:(MXFileRoomStoreMemberEventsTable*)table otherMessages:(NSArray<MXEvent*>*)otherMessages;
+
+@end
+
+@implementation MXFileRoomStoreMessages
+{
+    MXFileRoomStoreMemberEventsTable *table;
+
+    // The events. NULL for events of the table
+    NSPointerArray *events;
+
+    // The row in the table of each event. kMXFileRoomStoreNoRow for other events
+    NSMutableData *rows;
+}
+
+- (instancetype)initWithTable:(MXFileRoomStoreMemberEventsTable *)table2 otherMessages:(NSArray<MXEvent *> *)otherMessages
+{
+    self = [super init];
+    if (self)
+    {
+        table = table2;
+
+        NSUInteger count = otherMessages.count + table->eventIds.count;
+        events = [NSPointerArray strongObjectsPointerArray];
+        rows = [NSMutableData dataWithCapacity:count * sizeof(uint32_t)];
+
+        // Merge back membership events with other events at their original positions
+        uint32_t row = 0;
+        NSUInteger otherMessageIndex = 0;
+        for (NSUInteger position = 0; position < count; position++)
+        {
+            if (row < table->eventIds.count && table->positions[row] == position)
+            {
+                [events addPointer:NULL];
+                [rows appendBytes:&row length:sizeof(uint32_t)];
+                row++;
+            }
+            else
+            {
+                [events addPointer:(__bridge void*)otherMessages[otherMessageIndex++]];
+                [rows appendBytes:&kMXFileRoomStoreNoRow length:sizeof(uint32_t)];
+            }
+        }
+    }
+    return self;
+}
+
+- (NSUInteger)count
+{
+    return events.count;
+}
+
+- (id)objectAtIndex:(NSUInteger)index
+{
+    if (index >= events.count)
+    {
+        [NSException raise:NSRangeException format:@"[MXFileRoomStoreMessages] index %tu beyond bounds %tu", index, events.count];
+    }
+
+    MXEvent *event = (__bridge MXEvent*)[events pointerAtIndex:index];
+    if (!event)
+    {
+        event = [table eventAtRow:((const uint32_t*)rows.bytes)[index]];
+    }
+    return event;
+}
+
+- (void)insertObject:(id)anObject atIndex:(NSUInteger)index
+{
+    [events insertPointer:(__bridge void*)anObject atIndex:index];
+    [rows replaceBytesInRange:NSMakeRange(index * sizeof(uint32_t), 0) withBytes:&kMXFileRoomStoreNoRow length:sizeof(uint32_t)];
+}
+
+- (void)removeObjectAtIndex:(NSUInteger)index
+{
+    [events removePointerAtIndex:index];
+    [rows replaceBytesInRange:NSMakeRange(index * sizeof(uint32_t), sizeof(uint32_t)) withBytes:NULL length:0];
+}
+
+- (void)addObject:(id)anObject
+{
+    [self insertObject:anObject atIndex:events.count];
+}
+
+- (void)removeLastObject
+{
+    [self removeObjectAtIndex:events.count - 1];
+}
+
+- (void)replaceObjectAtIndex:(NSUInteger)index withObject:(id)anObject
+{
+    [events replacePointerAtIndex:index withPointer:(__bridge void*)anObject];
+    [rows replaceBytesInRange:NSMakeRange(index * sizeof(uint32_t), sizeof(uint32_t)) withBytes:&kMXFileRoomStoreNoRow];
+}
+
+- (void)removeObjectsInRange:(NSRange)range
+{
+    if (NSMaxRange(range) > events.count)
+    {
+        [NSException raise:NSRangeException format:@"[MXFileRoomStoreMessages] range %@ beyond bounds %tu", NSStringFromRange(range), events.count];
+    }
+
+    // Move the pointers once instead of once per removed message. Membership events
+    // not built yet stay NULL
+    NSPointerArray *keptEvents = [NSPointerArray strongObjectsPointerArray];
+    for (NSUInteger index = 0; index < events.count; index++)
+    {
+        if (!NSLocationInRange(index, range))
+        {
+            [keptEvents addPointer:[events pointerAtIndex:index]];
+        }
+    }
+    events = keptEvents;
+
+    [rows replaceBytesInRange:NSMakeRange(range.location * sizeof(uint32_t), range.length * sizeof(uint32_t)) withBytes:NULL length:0];
+}
+
+@end
+
+
+#pragma mark - MXFileRoomStoreMessagesByEventIds
+/**
+ The messagesByEventIds cache of a decoded room store.
+
+ Membership events of the table are built only when they are looked up.
+ */
+@interface MXFileRoomStoreMessagesByEventIds : NSMutableDictionary
+
+- (instancetype)initWithTable:(MXFileRoomStoreMemberEventsTable*)table;
+
+@end
+
+@implementation MXFileRoomStoreMessagesByEventIds
+{
+    MXFileRoomStoreMemberEventsTable *table;
+
+    // Events set explicitly
+    NSMutableDictionary<NSString*, MXEvent*> *events;
+
+    // Rows in the table of other events
+    NSMutableDictionary<NSString*, NSNumber*> *rowsByEventIds;
+}
+
+- (instancetype)initWithTable:(MXFileRoomStoreMemberEventsTable *)table2
+{
+    self = [super init];
+    if (self)
+    {
+        table = table2;
+        events = [NSMutableDictionary dictionary];
+
+        NSUInteger count = table->eventIds.count;
+        rowsByEventIds = [NSMutableDictionary dictionaryWithCapacity:count];
+        for (uint32_t row = 0; row < count; row++)
+        {
+            rowsByEventIds[table->eventIds[row]] = @(row);
+        }
+    }
+    return self;
+}
+
+- (NSUInteger)count
+{
+    return events.count + rowsByEventIds.count;
+}
+
+- (id)objectForKey:(id)aKey
+{
+    MXEvent *event = events[aKey];
+    if (!event)
+    {
+        NSNumber *row = rowsByEventIds[aKey];
+        if (row)
+        {
+            event = [table eventAtRow:row.unsignedIntValue];
+        }
+    }
+    return event;
+}
+
+- (NSEnumerator *)keyEnumerator
+{
+    return [[events.allKeys arrayByAddingObjectsFromArray:rowsByEventIds.allKeys] objectEnumerator];
+}
+
+- (void)setObject:(id)anObject forKey:(id<NSCopying>)aKey
+{
+    events[aKey] = anObject;
+    [rowsByEventIds removeObjectForKey:aKey];
+}
+
+- (void)removeObjectForKey:(id)aKey
+{
+    [events removeObjectForKey:aKey];
+    [rowsByEventIds removeObjectForKey:aKey];
+}
+
+- (void)removeAllObjects
+{
+    [events removeAllObjects];
+    [rowsByEventIds removeAllObjects];
+}
+
+@end
+
+
+#pragma mark - MXFileRoomStore
 @implementation MXFileRoomStore
 
 #pragma mark - NSCoding
@@ -24,7 +428,26 @@
     self = [self init];
     if (self)
     {
-        messages = [aDecoder decodeObjectForKey:@"messages"];
+        NSArray<MXEvent*> *decodedMessages = [aDecoder decodeObjectForKey:@"messages"];
+
+        if ([aDecoder containsValueForKey:kMXFileRoomStoreMemberEventsEventIds])
+        {
+            // Membership events are built only when they are read
+            MXFileRoomStoreMemberEventsTable *table = [[MXFileRoomStoreMemberEventsTable alloc] initWithCoder:aDecoder
+                                                                                                messagesCount:decodedMessages.count + [[aDecoder decodeObjectForKey:kMXFileRoomStoreMemberEventsEventIds] count]];
+            if (!table)
+            {
+                NSLog(@"[MXFileRoomStore] initWithCoder: Invalid membership events table");
+                return nil;
+            }
+
+            messages = [[MXMemoryRoomMessages alloc] initWithEventsStorage:[[MXFileRoomStoreMessages alloc] initWithTable:table otherMessages:decodedMessages]];
+            messagesByEventIds = [[MXFileRoomStoreMessagesByEventIds alloc] initWithTable:table];
+        }
+        else
+        {
+            messages = [[MXMemoryRoomMessages alloc] initWithEvents:decodedMessages];
+        }
 
         self.paginationToken = [aDecoder decodeObjectForKey:@"paginationToken"];
         
@@ -37,8 +460,14 @@
 
         outgoingMessages = [aDecoder decodeObjectForKey:@"outgoingMessages"];
 
-        // Rebuild the messagesByEventIds cache
-        for (MXEvent *event in messages)
+        NSDictionary *decodedStateCheckpoints = [aDecoder decodeObjectForKey:@"stateCheckpoints"];
+        if (decodedStateCheckpoints)
+        {
+            [stateCheckpoints setDictionary:decodedStateCheckpoints];
+        }
+
+        // Rebuild the messagesByEventIds cache for events that are not in the membership events table
+        for (MXEvent *event in decodedMessages)
         {
             if (event.eventId)
             {
@@ -54,11 +483,19 @@
     // The goal of the NSCoding implementation here is to store room data to the file system during a [MXFileStore commit].
 
     // Note this operation is  called from another thread.
-    // As the messages array continously grows, if some messages come while looping, they will not
-    // be serialised this time but they will be on the next [MXFileStore commit] that will be called for them.
+    // It works on an immutable snapshot of the messages. If some messages come
+    // while encoding, they will not be serialised this time but they will be on the next [MXFileStore commit]
+    // that will be called for them.
     // If messages come between [MXFileStore commit] and this method, more messages will be serialised. This is
     // not a problem.
-    [aCoder encodeObject:[messages mutableCopy] forKey:@"messages"];
+    // Membership events are serialised apart in a compact columnar table.
+    // In big rooms, they represent most of the history and they mostly share the same few contents.
+    NSArray<MXEvent*> *messagesSnapshot = self.messagesSnapshot;
+    NSMutableArray<MXEvent*> *otherMessages = [NSMutableArray arrayWithCapacity:messagesSnapshot.count];
+
+    [self encodeMemberEventsOf:messagesSnapshot otherMessages:otherMessages withCoder:aCoder];
+
+    [aCoder encodeObject:otherMessages forKey:@"messages"];
 
     if (self.paginationToken)
     {
@@ -81,7 +518,147 @@
         [aCoder encodeObject:self.partialTextMessage forKey:@"partialTextMessage"];
     }
 
-    [aCoder encodeObject:[outgoingMessages mutableCopy] forKey:@"outgoingMessages"];
+    [aCoder encodeObject:[self.outgoingMessages mutableCopy] forKey:@"outgoingMessages"];
+
+    // Consecutive checkpoints share most of their event instances. The archiver stores them once
+    NSDictionary *stateCheckpointsSnapshot;
+    @synchronized(self)
+    {
+        stateCheckpointsSnapshot = [stateCheckpoints copy];
+    }
+    if (stateCheckpointsSnapshot.count)
+    {
+        [aCoder encodeObject:stateCheckpointsSnapshot forKey:@"stateCheckpoints"];
+    }
+}
+
+
+#pragma mark - Membership events columnar table
+/**
+ Indicate whether a room event can be stored in the membership events table.
+
+ The table stores only the common fields of membership events. Other ones are
+ serialised as full MXEvent objects.
+
+ @param event the event to check.
+ @param roomId the room id shared by all events of the table.
+ @return YES if the event can be stored in the table.
+ */
+- (BOOL)isCompactableMemberEvent:(MXEvent*)event roomId:(NSString*)roomId
+{
+    return (event.eventType == MXEventTypeRoomMember
+            && event.eventId && event.sender && event.stateKey && event.content
+            && !event.redacts && !event.redactedBecause && !event.inviteRoomState
+            && [event.roomId isEqualToString:roomId]);
+}
+
+- (void)encodeMemberEventsOf:(NSArray<MXEvent*>*)allMessages otherMessages:(NSMutableArray<MXEvent*>*)otherMessages withCoder:(NSCoder *)aCoder
+{
+    NSString *roomId = allMessages.firstObject.roomId;
+
+    NSMutableData *positions = [NSMutableData data];
+    NSMutableArray<NSString*> *eventIds = [NSMutableArray array];
+
+    // User ids and contents are stored once and referenced by their index
+    NSMutableArray<NSString*> *userIds = [NSMutableArray array];
+    NSMutableDictionary<NSString*, NSNumber*> *userIdsRefs = [NSMutableDictionary dictionary];
+    NSMutableData *senders = [NSMutableData data];
+    NSMutableData *stateKeys = [NSMutableData data];
+
+    NSMutableArray<NSDictionary*> *contents = [NSMutableArray array];
+    NSMutableDictionary<NSNumber*, NSMutableArray<NSNumber*>*> *contentsRefsByHash = [NSMutableDictionary dictionary];
+    NSMutableData *contentRefs = [NSMutableData data];
+    NSMutableData *prevContentRefs = [NSMutableData data];
+
+    NSMutableData *originServerTs = [NSMutableData data];
+    NSMutableData *ageLocalTs = [NSMutableData data];
+
+    uint32_t (^refOfUserId)(NSString*) = ^uint32_t(NSString *userId) {
+        NSNumber *ref = userIdsRefs[userId];
+        if (!ref)
+        {
+            ref = @(userIds.count);
+            userIdsRefs[userId] = ref;
+            [userIds addObject:userId];
+        }
+        return ref.unsignedIntValue;
+    };
+
+    uint32_t (^refOfContent)(NSDictionary*) = ^uint32_t(NSDictionary *content) {
+        if (!content)
+        {
+            return kMXFileRoomStoreNoContentRef;
+        }
+
+        // [NSDictionary hash] is only the number of entries, use a hash of the full JSON tree
+        NSNumber *hash = @([MXEventContentPool hashOfJSON:content]);
+        NSMutableArray<NSNumber*> *refs = contentsRefsByHash[hash];
+        for (NSNumber *ref in refs)
+        {
+            NSDictionary *storedContent = contents[ref.unsignedIntValue];
+            if (storedContent == content || [MXEventContentPool isJSON:storedContent equalToJSON:content])
+            {
+                return ref.unsignedIntValue;
+            }
+        }
+
+        uint32_t ref = (uint32_t)contents.count;
+        [contents addObject:content];
+        if (!refs)
+        {
+            contentsRefsByHash[hash] = [NSMutableArray arrayWithObject:@(ref)];
+        }
+        else
+        {
+            [refs addObject:@(ref)];
+        }
+        return ref;
+    };
+
+    for (uint32_t position = 0; position < allMessages.count; position++)
+    {
+        MXEvent *event = allMessages[position];
+
+        if (roomId && [self isCompactableMemberEvent:event roomId:roomId])
+        {
+            [positions appendBytes:&position length:sizeof(uint32_t)];
+            [eventIds addObject:event.eventId];
+
+            uint32_t ref = refOfUserId(event.sender);
+            [senders appendBytes:&ref length:sizeof(uint32_t)];
+            ref = refOfUserId(event.stateKey);
+            [stateKeys appendBytes:&ref length:sizeof(uint32_t)];
+
+            ref = refOfContent(event.content);
+            [contentRefs appendBytes:&ref length:sizeof(uint32_t)];
+            ref = refOfContent(event.prevContent);
+            [prevContentRefs appendBytes:&ref length:sizeof(uint32_t)];
+
+            uint64_t ts = event.originServerTs;
+            [originServerTs appendBytes:&ts length:sizeof(uint64_t)];
+            ts = event.ageLocalTs;
+            [ageLocalTs appendBytes:&ts length:sizeof(uint64_t)];
+        }
+        else
+        {
+            [otherMessages addObject:event];
+        }
+    }
+
+    if (eventIds.count)
+    {
+        [aCoder encodeObject:positions forKey:kMXFileRoomStoreMemberEventsPositions];
+        [aCoder encodeObject:roomId forKey:kMXFileRoomStoreMemberEventsRoomId];
+        [aCoder encodeObject:eventIds forKey:kMXFileRoomStoreMemberEventsEventIds];
+        [aCoder encodeObject:userIds forKey:kMXFileRoomStoreMemberEventsUserIds];
+        [aCoder encodeObject:senders forKey:kMXFileRoomStoreMemberEventsSenders];
+        [aCoder encodeObject:stateKeys forKey:kMXFileRoomStoreMemberEventsStateKeys];
+        [aCoder encodeObject:contents forKey:kMXFileRoomStoreMemberEventsContents];
+        [aCoder encodeObject:contentRefs forKey:kMXFileRoomStoreMemberEventsContentRefs];
+        [aCoder encodeObject:prevContentRefs forKey:kMXFileRoomStoreMemberEventsPrevContentRefs];
+        [aCoder encodeObject:originServerTs forKey:kMXFileRoomStoreMemberEventsOriginServerTs];
+        [aCoder encodeObject:ageLocalTs forKey:kMXFileRoomStoreMemberEventsAgeLocalTs];
+    }
 }
 
 @end
@@ -15,6 +15,44 @@
  */
 
 #import "MXMemoryStore.h"
+#import "MXMemoryPressureHandler.h"
+
+/**
+ The ways a process can access a `MXFileStore`.
+ */
+typedef enum : NSUInteger
+{
+    /**
+     The process reads and writes the store. This is the default.
+     Only one process must open a store in this mode.
+     */
+    MXFileStoreAccessModeReadWrite,
+
+    /**
+     The process only reads the data saved by the process that opened the store in
+     read-write mode. It can be used by an app extension to display data from the app cache.
+     Changes made in memory are not saved. The data is reloaded each time the writer commits.
+     */
+    MXFileStoreAccessModeReadOnly
+
+} MXFileStoreAccessMode;
+
+/**
+ Posted when a store opened in read-only mode has reloaded the data committed by the writer
+ process.
+
+ Only the rooms modified by the writer since the last load are reloaded.
+
+ The notification object is the `MXFileStore` instance. The `userInfo` dictionary contains the
+ ids of the reloaded or removed rooms under `kMXFileStoreDidReloadNotificationRoomIdsKey`.
+ */
+FOUNDATION_EXPORT NSString *const kMXFileStoreDidReloadNotification;
+
+/**
+ The key in the `kMXFileStoreDidReloadNotification` user info for the ids of the rooms whose
+ data has been reloaded or removed.
+ */
+FOUNDATION_EXPORT NSString *const kMXFileStoreDidReloadNotificationRoomIdsKey;
 
 /**
  `MXFileStore` extends MXMemoryStore by adding permanent storage.
@@ -56,8 +94,30 @@
                         L usersGroup #1
                         L ...
                     L MXFileStore
+        L {Matrix user id}.lock : The lock file used to synchronise processes sharing the store
+
+ Several processes (an app and its extensions) can share the same store by setting the same
+ `appGroupIdentifier`. One of them opens it in read-write mode, the others in read-only mode:
+ - the writer takes an exclusive lock on the lock file while it writes files,
+ - readers take a shared lock while they read files so that they never see a partial commit,
+ - the writer posts a Darwin notification when a commit is complete so that readers
+   reload the data.
+ */
+@interface MXFileStore : MXMemoryStore <MXMemoryPressureHandler>
+
+/**
+ The identifier of the app group the store is shared with.
+ When set, the store is located in the shared container of the group instead of the app
+ caches folder. It must be set before opening the store.
+ Default is nil.
+ */
+@property (nonatomic) NSString *appGroupIdentifier;
+
+/**
+ The access mode of this process. It must be set before opening the store.
+ Default is MXFileStoreAccessModeReadWrite.
  */
-@interface MXFileStore : MXMemoryStore
+@property (nonatomic) MXFileStoreAccessMode accessMode;
 
 /**
  The disk space in bytes used by the store.
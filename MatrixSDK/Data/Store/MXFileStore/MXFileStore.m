@@ -14,15 +14,18 @@
  limitations under the License.
  */
 
-#import <UIKit/UIKit.h>
+#include <fcntl.h>
+#include <sys/file.h>
 
 #import "MXFileStore.h"
 
 #import "MXFileRoomStore.h"
 
 #import "MXFileStoreMetaData.h"
+#import "MXSDKOptions.h"
+#import "MXBackgroundModeHandler.h"
 
-NSUInteger const kMXFileVersion = 34;
+NSUInteger const kMXFileVersion = 35;
 
 NSString *const kMXFileStoreFolder = @"MXFileStore";
 NSString *const kMXFileStoreMedaDataFile = @"MXFileStore";
@@ -30,6 +33,11 @@ NSString *const kMXFileStoreUsersFolder = @"users";
 NSString *const kMXFileStoreBackupFolder = @"backup";
 
 NSString *const kMXFileStoreSavingMarker = @"savingMarker";
+NSString *const kMXFileStoreLockFileExtension = @"lock";
+NSString *const kMXFileStoreDidCommitDarwinNotificationPrefix = @"org.matrix.sdk.MXFileStore.didCommit";
+
+NSString *const kMXFileStoreDidReloadNotification = @"kMXFileStoreDidReloadNotification";
+NSString *const kMXFileStoreDidReloadNotificationRoomIdsKey = @"kMXFileStoreDidReloadNotificationRoomIdsKey";
 
 NSString *const kMXFileStoreRoomsFolder = @"rooms";
 NSString *const kMXFileStoreRoomMessagesFile = @"messages";
@@ -37,6 +45,11 @@ NSString *const kMXFileStoreRoomStateFile = @"state";
 NSString *const kMXFileStoreRoomAccountDataFile = @"accountData";
 NSString *const kMXFileStoreRoomReadReceiptsFile = @"readReceipts";
 
+/**
+ The time in microseconds to wait before trying again to lock files held by another process.
+ */
+#define MXFILESTORE_LOCK_RETRY_INTERVAL 10000
+
 @interface MXFileStore ()
 {
     // Meta data about the store. It is defined only if the passed MXCredentials contains all information.
@@ -74,6 +87,7 @@ NSString *const kMXFileStoreRoomReadReceiptsFile = @"readReceipts";
     // Cache used to preload room states while the store is opening.
     // It is filled on the separate thread so that the UI thread will not be blocked
     // when it will read rooms states.
+    // It can be emptied on memory pressure. It must be accessed with the lock on it.
     NSMutableDictionary<NSString*, NSArray*> *preloadedRoomsStates;
 
     // Same kind of cache for room account data.
@@ -87,9 +101,42 @@ NSString *const kMXFileStoreRoomReadReceiptsFile = @"readReceipts";
 
     // The evenst stream token that corresponds to the data being backed up.
     NSString *backupEventStreamToken;
+
+    // The descriptor of the lock file shared with other processes. -1 if the store is not shared.
+    int lockFileDescriptor;
+
+    // The number of pending lockFiles calls in this process.
+    NSUInteger lockFileCount;
+
+    // The name of the Darwin notification posted by the writer after each commit.
+    NSString *didCommitDarwinNotificationName;
+
+    // The modification dates of the rooms folders and users files loaded by a read-only store.
+    // The writer replaces files on every commit so that a reader reloads only what has changed.
+    // They are accessed only on the `dispatchQueue` thread.
+    NSMutableDictionary<NSString*, NSDate*> *loadedRoomsModificationDates;
+    NSMutableDictionary<NSString*, NSDate*> *loadedUsersModificationDates;
+
+    // Reload state for a read-only store.
+    BOOL isReloading;
+    BOOL needsReload;
 }
+
+- (void)reloadCommittedData;
+
 @end
 
+/**
+ Called when the writer process has committed data.
+ */
+static void MXFileStoreDidCommitCallback(CFNotificationCenterRef center, void *observer, CFStringRef name, const void *object, CFDictionaryRef userInfo)
+{
+    MXFileStore *fileStore = (__bridge MXFileStore*)observer;
+    dispatch_async(dispatch_get_main_queue(), ^{
+        [fileStore reloadCommittedData];
+    });
+}
+
 @implementation MXFileStore
 
 - (instancetype)init;
@@ -109,16 +156,42 @@ NSString *const kMXFileStoreRoomReadReceiptsFile = @"readReceipts";
         metaDataHasChanged = NO;
 
         dispatchQueue = dispatch_queue_create("MXFileStoreDispatchQueue", DISPATCH_QUEUE_SERIAL);
+
+        lockFileDescriptor = -1;
+        loadedRoomsModificationDates = [NSMutableDictionary dictionary];
+        loadedUsersModificationDates = [NSMutableDictionary dictionary];
+        _accessMode = MXFileStoreAccessModeReadWrite;
     }
     return self;
 }
 
+- (void)dealloc
+{
+    [self stopObservingCommits];
+    [self closeLockFile];
+}
+
 - (void)openWithCredentials:(MXCredentials*)someCredentials onComplete:(void (^)())onComplete failure:(void (^)(NSError *))failure
 {
     // Create the file path where data will be stored for the user id passed in credentials
     NSArray *cacheDirList = NSSearchPathForDirectoriesInDomains(NSCachesDirectory, NSUserDomainMask, YES);
     NSString *cachePath  = [cacheDirList objectAtIndex:0];
 
+    BOOL isShared = NO;
+    if (_appGroupIdentifier)
+    {
+        NSURL *containerURL = [[NSFileManager defaultManager] containerURLForSecurityApplicationGroupIdentifier:_appGroupIdentifier];
+        if (containerURL)
+        {
+            cachePath = containerURL.path;
+            isShared = YES;
+        }
+        else
+        {
+            NSLog(@"[MXFileStore] Warning: No shared container for app group %@. The store is not shared", _appGroupIdentifier);
+        }
+    }
+
     credentials = someCredentials;
     storePath = [[cachePath stringByAppendingPathComponent:kMXFileStoreFolder] stringByAppendingPathComponent:credentials.userId];
     storeRoomsPath = [storePath stringByAppendingPathComponent:kMXFileStoreRoomsFolder];
@@ -126,12 +199,21 @@ NSString *const kMXFileStoreRoomReadReceiptsFile = @"readReceipts";
 
     storeBackupPath = [storePath stringByAppendingPathComponent:kMXFileStoreBackupFolder];
 
+    if (isShared)
+    {
+        [self openLockFile];
+
+        didCommitDarwinNotificationName = [NSString stringWithFormat:@"%@.%@.%@", kMXFileStoreDidCommitDarwinNotificationPrefix, _appGroupIdentifier, credentials.userId];
+        if (_accessMode == MXFileStoreAccessModeReadOnly)
+        {
+            [self startObservingCommits];
+        }
+    }
+
     // Load the data even if the app goes in background
-    __block UIBackgroundTaskIdentifier backgroundTaskIdentifier = [[UIApplication sharedApplication] beginBackgroundTaskWithName:@"openWithCredentials" expirationHandler:^{
+    id<MXBackgroundTask> backgroundTask = [[MXSDKOptions sharedInstance].backgroundModeHandler startBackgroundTaskWithName:@"openWithCredentials" expirationHandler:^{
 
         NSLog(@"[MXFileStore] Background task is going to expire in openWithCredentials");
-        [[UIApplication sharedApplication] endBackgroundTask:backgroundTaskIdentifier];
-        backgroundTaskIdentifier = UIBackgroundTaskInvalid;
     }];
 
     /*
@@ -151,10 +233,25 @@ NSString *const kMXFileStoreRoomReadReceiptsFile = @"readReceipts";
 
         @autoreleasepool
         {
-            // Check the store and repair it if necessary
-            [self checkStorageValidity];
+            // Prevent other processes from writing (or reading if we repair the store)
+            [self lockFiles];
+
+            if (_accessMode == MXFileStoreAccessModeReadWrite)
+            {
+                // Check the store and repair it if necessary
+                [self checkStorageValidity];
 
-            [self loadMetaData];
+                [self loadMetaData];
+            }
+            else if ([[NSFileManager defaultManager] fileExistsAtPath:storeBackupPath])
+            {
+                // Only the writer can repair the store
+                NSLog(@"[MXFileStore] Warning: The last commit of the writer was interrupted. Data cannot be read");
+            }
+            else
+            {
+                [self loadMetaData];
+            }
 
             // Do some validations
 
@@ -196,11 +293,17 @@ NSString *const kMXFileStoreRoomReadReceiptsFile = @"readReceipts";
                 [self loadReceipts];
                 [self loadUsers];
 
+                if (_accessMode == MXFileStoreAccessModeReadOnly)
+                {
+                    [self storeLoadedFilesModificationDates];
+                }
+
                 NSLog(@"[MXFileStore] Data loaded from files in %.0fms", [[NSDate date] timeIntervalSinceDate:startDate] * 1000);
             }
             
             // Else, if credentials is valid, create and store it
-            if (nil == metaData && credentials.homeServer && credentials.userId && credentials.accessToken)
+            if (nil == metaData && _accessMode == MXFileStoreAccessModeReadWrite
+                && credentials.homeServer && credentials.userId && credentials.accessToken)
             {
                 metaData = [[MXFileStoreMetaData alloc] init];
                 metaData.homeServer = [credentials.homeServer copy];
@@ -210,12 +313,13 @@ NSString *const kMXFileStoreRoomReadReceiptsFile = @"readReceipts";
                 metaDataHasChanged = YES;
                 [self saveMetaData];
             }
+
+            [self unlockFiles];
         }
         
         dispatch_async(dispatch_get_main_queue(), ^{
 
-            [[UIApplication sharedApplication] endBackgroundTask:backgroundTaskIdentifier];
-            backgroundTaskIdentifier = UIBackgroundTaskInvalid;
+            [backgroundTask stop];
 
             onComplete();
         });
@@ -279,6 +383,28 @@ NSString *const kMXFileStoreRoomReadReceiptsFile = @"readReceipts";
     }
 }
 
+- (void)storeStateCheckpointForRoom:(NSString *)roomId stateEvents:(NSArray<MXEvent *> *)stateEvents beforeEvent:(NSString *)eventId
+{
+    [super storeStateCheckpointForRoom:roomId stateEvents:stateEvents beforeEvent:eventId];
+
+    if (NSNotFound == [roomsToCommitForMessages indexOfObject:roomId])
+    {
+        [roomsToCommitForMessages addObject:roomId];
+    }
+}
+
+- (NSUInteger)removeMessagesBeforeEvent:(NSString *)eventId inRoom:(NSString *)roomId paginationToken:(NSString *)paginationToken
+{
+    NSUInteger count = [super removeMessagesBeforeEvent:eventId inRoom:roomId paginationToken:paginationToken];
+
+    // The room archive will be rewritten without the removed messages on the next commit
+    if (count && NSNotFound == [roomsToCommitForMessages indexOfObject:roomId])
+    {
+        [roomsToCommitForMessages addObject:roomId];
+    }
+    return count;
+}
+
 - (void)deleteRoom:(NSString *)roomId
 {
     [super deleteRoom:roomId];
@@ -295,18 +421,46 @@ NSString *const kMXFileStoreRoomReadReceiptsFile = @"readReceipts";
 
     [super deleteAllData];
 
-    // Remove the MXFileStore and all its content
-    NSError *error;
-    [[NSFileManager defaultManager] removeItemAtPath:storePath error:&error];
+    // Files belong to the writer
+    if (_accessMode == MXFileStoreAccessModeReadWrite)
+    {
+        void (^deleteFiles)(void) = ^{
+
+            [self lockFiles];
+
+            // Remove the MXFileStore and all its content
+            NSError *error;
+            [[NSFileManager defaultManager] removeItemAtPath:storePath error:&error];
+
+            // And create folders back
+            [[NSFileManager defaultManager] createDirectoryAtPath:storePath withIntermediateDirectories:YES attributes:nil error:nil];
+            [[NSFileManager defaultManager] createDirectoryAtPath:storeRoomsPath withIntermediateDirectories:YES attributes:nil error:nil];
+            [[NSFileManager defaultManager] createDirectoryAtPath:storeUsersPath withIntermediateDirectories:YES attributes:nil error:nil];
+
+            [self unlockFiles];
+            [self postDidCommitDarwinNotification];
+        };
 
-    // And create folders back
-    [[NSFileManager defaultManager] createDirectoryAtPath:storePath withIntermediateDirectories:YES attributes:nil error:nil];
-    [[NSFileManager defaultManager] createDirectoryAtPath:storeRoomsPath withIntermediateDirectories:YES attributes:nil error:nil];
-    [[NSFileManager defaultManager] createDirectoryAtPath:storeUsersPath withIntermediateDirectories:YES attributes:nil error:nil];
+        if ([NSThread isMainThread])
+        {
+            // Readers may hold the lock: do not wait for them on the main thread.
+            // The queue is serial so that pending commits complete before and
+            // next loads start after.
+            dispatch_async(dispatchQueue, deleteFiles);
+        }
+        else
+        {
+            // We are on the `dispatchQueue` thread, loading the store
+            deleteFiles();
+        }
+    }
 
     // Reset data
     metaData = nil;
-    [roomStores removeAllObjects];
+    @synchronized(roomStores)
+    {
+        [roomStores removeAllObjects];
+    }
     self.eventStreamToken = nil;
 }
 
@@ -370,14 +524,45 @@ NSString *const kMXFileStoreRoomReadReceiptsFile = @"readReceipts";
     [super setEventStreamToken:eventStreamToken];
     if (metaData)
     {
+        // Keep the date of the stored token when it is just reloaded
+        if (![metaData.eventStreamToken isEqualToString:eventStreamToken])
+        {
+            metaData.eventStreamTokenDate = super.eventStreamTokenDate;
+        }
         metaData.eventStreamToken = eventStreamToken;
         metaDataHasChanged = YES;
     }
 }
 
+- (NSDate *)eventStreamTokenDate
+{
+    if (metaData)
+    {
+        return metaData.eventStreamTokenDate;
+    }
+    return super.eventStreamTokenDate;
+}
+
+- (void)setCatchUpTokenAge:(NSTimeInterval)catchUpTokenAge
+{
+    if (metaData)
+    {
+        metaData.catchUpTokenAge = catchUpTokenAge;
+        metaDataHasChanged = YES;
+    }
+}
+
+- (NSTimeInterval)catchUpTokenAge
+{
+    return metaData.catchUpTokenAge;
+}
+
 - (NSArray *)rooms
 {
-    return roomStores.allKeys;
+    @synchronized(roomStores)
+    {
+        return roomStores.allKeys;
+    }
 }
 
 - (void)storeStateForRoom:(NSString*)roomId stateEvents:(NSArray*)stateEvents
@@ -388,25 +573,21 @@ NSString *const kMXFileStoreRoomReadReceiptsFile = @"readReceipts";
 - (NSArray*)stateOfRoom:(NSString *)roomId
 {
     // First, try to get the state from the cache
-    NSArray *stateEvents = preloadedRoomsStates[roomId];
-
-    if (!stateEvents)
+    NSArray *stateEvents;
+    @synchronized(preloadedRoomsStates)
     {
-        stateEvents =[NSKeyedUnarchiver unarchiveObjectWithFile:[self stateFileForRoom:roomId forBackup:NO]];
+        stateEvents = preloadedRoomsStates[roomId];
 
-        if (NO == [NSThread isMainThread])
-        {
-            // If this method is called from the `dispatchQueue` thread, it means MXFileStore is preloading
-            // rooms states. So, fill the cache.
-            preloadedRoomsStates[roomId] = stateEvents;
-        }
-    }
-    else
-    {
         // The cache information is valid only once
         [preloadedRoomsStates removeObjectForKey:roomId];
     }
 
+    if (!stateEvents)
+    {
+        // Do not fill the cache: this method can be called from any thread
+        stateEvents = [self loadStateOfRoom:roomId];
+    }
+
     return stateEvents;
 }
 
@@ -418,26 +599,43 @@ NSString *const kMXFileStoreRoomReadReceiptsFile = @"readReceipts";
 - (MXRoomAccountData *)accountDataOfRoom:(NSString *)roomId
 {
     // First, try to get the data from the cache
-    MXRoomAccountData *roomUserdData = preloadedRoomAccountData[roomId];
+    MXRoomAccountData *roomUserdData;
+    @synchronized(preloadedRoomAccountData)
+    {
+        roomUserdData = preloadedRoomAccountData[roomId];
+
+        // The cache information is valid only once
+        [preloadedRoomAccountData removeObjectForKey:roomId];
+    }
 
     if (!roomUserdData)
     {
-        roomUserdData =[NSKeyedUnarchiver unarchiveObjectWithFile:[self accountDataFileForRoom:roomId forBackup:NO]];
+        // Do not fill the cache: this method can be called from any thread
+        roomUserdData = [self loadAccountDataOfRoom:roomId];
+    }
 
-        if (NO == [NSThread isMainThread])
-        {
-            // If this method is called from the `dispatchQueue` thread, it means MXFileStore is preloading
-            // data. So, fill the cache.
-            preloadedRoomAccountData[roomId] = roomUserdData;
-        }
+    return roomUserdData;
+}
+
+
+#pragma mark - MXMemoryPressureHandler
+- (NSUInteger)handleMemoryPressure:(MXMemoryPressureLevel)level
+{
+    // Preloaded data is read again from the files on demand
+    NSUInteger count = 0;
+
+    @synchronized(preloadedRoomsStates)
+    {
+        count += preloadedRoomsStates.count;
+        [preloadedRoomsStates removeAllObjects];
     }
-    else
+    @synchronized(preloadedRoomAccountData)
     {
-        // The cache information is valid only once
-        [preloadedRoomAccountData removeObjectForKey:roomId];
+        count += preloadedRoomAccountData.count;
+        [preloadedRoomAccountData removeAllObjects];
     }
 
-    return roomUserdData;
+    return count;
 }
 
 
@@ -464,26 +662,67 @@ NSString *const kMXFileStoreRoomReadReceiptsFile = @"readReceipts";
     return metaData.userAccountData;
 }
 
+- (void)asyncStatesAndAccountDataOfRooms:(NSArray<NSString *> *)roomIds onComplete:(void (^)(NSDictionary<NSString *,NSArray<MXEvent *> *> *, NSDictionary<NSString *,MXRoomAccountData *> *))onComplete
+{
+    // The data not committed yet is more recent than the files
+    NSMutableDictionary<NSString*, NSArray<MXEvent*>*> *states = [NSMutableDictionary dictionary];
+    NSMutableDictionary<NSString*, MXRoomAccountData*> *accountData = [NSMutableDictionary dictionary];
+    for (NSString *roomId in roomIds)
+    {
+        states[roomId] = roomsToCommitForState[roomId];
+        accountData[roomId] = roomsToCommitForAccountData[roomId];
+    }
+
+    // Read the other rooms on the store thread: the writes of the pending commits are then done.
+    // The preload caches are not used: they are valid only once
+    dispatch_async(dispatchQueue, ^(void){
+
+        [self lockFilesForReading];
+
+        for (NSString *roomId in roomIds)
+        {
+            @autoreleasepool
+            {
+                if (!states[roomId])
+                {
+                    states[roomId] = [NSKeyedUnarchiver unarchiveObjectWithFile:[self stateFileForRoom:roomId forBackup:NO]];
+                }
+                if (!accountData[roomId])
+                {
+                    accountData[roomId] = [NSKeyedUnarchiver unarchiveObjectWithFile:[self accountDataFileForRoom:roomId forBackup:NO]];
+                }
+            }
+        }
+
+        [self unlockFilesForReading];
+
+        dispatch_async(dispatch_get_main_queue(), ^(void){
+            onComplete(states, accountData);
+        });
+    });
+}
+
 - (void)commit
 {
-    // Save data only if metaData exists
-    if (metaData)
+    // Save data only if metaData exists. Readers never save
+    if (metaData && _accessMode == MXFileStoreAccessModeReadWrite)
     {
         NSDate *startDate = [NSDate date];
         // Commit the data even if the app goes in background
-        __block UIBackgroundTaskIdentifier backgroundTaskIdentifier = [[UIApplication sharedApplication] beginBackgroundTaskWithName:@"commit" expirationHandler:^{
+        id<MXBackgroundTask> backgroundTask = [[MXSDKOptions sharedInstance].backgroundModeHandler startBackgroundTaskWithName:@"commit" expirationHandler:^{
 
-            NSLog(@"[MXFileStore commit] Background task #%tu is going to expire after %.0fms - ending it",
-                  backgroundTaskIdentifier, [[NSDate date] timeIntervalSinceDate:startDate] * 1000);
-            [[UIApplication sharedApplication] endBackgroundTask:backgroundTaskIdentifier];
-            backgroundTaskIdentifier = UIBackgroundTaskInvalid;
+            NSLog(@"[MXFileStore commit] Background task is going to expire after %.0fms - ending it",
+                  [[NSDate date] timeIntervalSinceDate:startDate] * 1000);
         }];
 #if DEBUG
-        NSLog(@"[MXFileStore commit] Background task #%tu started", backgroundTaskIdentifier);
+        NSLog(@"[MXFileStore commit] Background task %p started", backgroundTask);
 #endif
         // Make sure the data will be backed up with the right events stream token
         dispatch_async(dispatchQueue, ^(void){
             backupEventStreamToken = self.eventStreamToken;
+
+            // Readers must not see a partial commit
+            [self lockFiles];
         });
 
         [self saveRoomsDeletion];
@@ -500,12 +739,14 @@ NSString *const kMXFileStoreRoomReadReceiptsFile = @"readReceipts";
             [[NSFileManager defaultManager] removeItemAtPath:storeBackupPath error:nil];
             backupEventStreamToken = nil;
 
+            [self unlockFiles];
+            [self postDidCommitDarwinNotification];
+
             // Release the background task
             dispatch_async(dispatch_get_main_queue(), ^(void){
-                NSLog(@"[MXFileStore commit] Background task #%tu is complete - lasted %.0fms",
-                      backgroundTaskIdentifier, [[NSDate date] timeIntervalSinceDate:startDate] * 1000);
-                [[UIApplication sharedApplication] endBackgroundTask:backgroundTaskIdentifier];
-                backgroundTaskIdentifier = UIBackgroundTaskInvalid;
+                NSLog(@"[MXFileStore commit] Background task %p is complete - lasted %.0fms",
+                      backgroundTask, [[NSDate date] timeIntervalSinceDate:startDate] * 1000);
+                [backgroundTask stop];
             });
         });
     }
@@ -517,20 +758,411 @@ NSString *const kMXFileStoreRoomReadReceiptsFile = @"readReceipts";
     // Once done, we are sure pending operations blocks are complete
     dispatch_sync(dispatchQueue, ^(void){
     });
+
+    [self stopObservingCommits];
+    [self closeLockFile];
+}
+
+
+#pragma mark - Processes synchronisation
+/**
+ Open the lock file shared by the processes using the store.
+ */
+- (void)openLockFile
+{
+    [self closeLockFile];
+
+    NSString *lockFile = [storePath stringByAppendingPathExtension:kMXFileStoreLockFileExtension];
+
+    // The lock file is outside storePath so that it survives [self deleteAllData]
+    [[NSFileManager defaultManager] createDirectoryAtPath:[storePath stringByDeletingLastPathComponent] withIntermediateDirectories:YES attributes:nil error:nil];
+
+    lockFileDescriptor = open(lockFile.fileSystemRepresentation, O_RDWR | O_CREAT, 0644);
+    if (lockFileDescriptor < 0)
+    {
+        NSLog(@"[MXFileStore] Warning: Cannot open the lock file. errno: %d", errno);
+    }
+}
+
+- (void)closeLockFile
+{
+    if (lockFileDescriptor >= 0)
+    {
+        close(lockFileDescriptor);
+        lockFileDescriptor = -1;
+    }
+}
+
+/**
+ Lock the store files against other processes.
+
+ The writer takes an exclusive lock, readers a shared one. Calls can be nested and made from
+ any thread of the process. This is a no-op if the store is not shared.
+
+ flock() is called in non-blocking mode and retried: a thread waiting for another process
+ must not prevent other threads of this process from releasing their lock.
+ */
+- (void)lockFiles
+{
+    int operation = ((_accessMode == MXFileStoreAccessModeReadWrite) ? LOCK_EX : LOCK_SH) | LOCK_NB;
+
+    while (YES)
+    {
+        @synchronized(self)
+        {
+            BOOL isLockedByAnotherProcess = NO;
+
+            if (lockFileCount == 0 && lockFileDescriptor >= 0 && flock(lockFileDescriptor, operation) != 0)
+            {
+                if (errno == EWOULDBLOCK)
+                {
+                    isLockedByAnotherProcess = YES;
+                }
+                else
+                {
+                    NSLog(@"[MXFileStore] Warning: Cannot lock files. errno: %d", errno);
+                }
+            }
+
+            if (!isLockedByAnotherProcess)
+            {
+                lockFileCount++;
+                return;
+            }
+        }
+
+        usleep(MXFILESTORE_LOCK_RETRY_INTERVAL);
+    }
+}
+
+- (void)unlockFiles
+{
+    @synchronized(self)
+    {
+        if (lockFileCount && --lockFileCount == 0 && lockFileDescriptor >= 0)
+        {
+            flock(lockFileDescriptor, LOCK_UN);
+        }
+    }
+}
+
+/**
+ Lock the store files for a lazy read.
+
+ Only readers need it: the writer is the only process to modify files. It must not wait
+ for readers from the main thread.
+ */
+- (void)lockFilesForReading
+{
+    if (_accessMode == MXFileStoreAccessModeReadOnly)
+    {
+        [self lockFiles];
+    }
+}
+
+- (void)unlockFilesForReading
+{
+    if (_accessMode == MXFileStoreAccessModeReadOnly)
+    {
+        [self unlockFiles];
+    }
+}
+
+- (void)postDidCommitDarwinNotification
+{
+    if (didCommitDarwinNotificationName)
+    {
+        CFNotificationCenterPostNotification(CFNotificationCenterGetDarwinNotifyCenter(), (__bridge CFStringRef)didCommitDarwinNotificationName, NULL, NULL, YES);
+    }
+}
+
+- (void)startObservingCommits
+{
+    [self stopObservingCommits];
+
+    CFNotificationCenterAddObserver(CFNotificationCenterGetDarwinNotifyCenter(), (__bridge const void *)self, MXFileStoreDidCommitCallback, (__bridge CFStringRef)didCommitDarwinNotificationName, NULL, CFNotificationSuspensionBehaviorDeliverImmediately);
+}
+
+- (void)stopObservingCommits
+{
+    CFNotificationCenterRemoveEveryObserver(CFNotificationCenterGetDarwinNotifyCenter(), (__bridge const void *)self);
+}
+
+/**
+ Reload the data committed by the writer process.
+
+ Only rooms and users files modified since the last load are read again. They are read on
+ the `dispatchQueue` thread then swapped on the main thread.
+ */
+- (void)reloadCommittedData
+{
+    if (isReloading)
+    {
+        // The writer may have committed after the files have been read
+        needsReload = YES;
+        return;
+    }
+
+    isReloading = YES;
+    needsReload = NO;
+
+    NSDate *startDate = [NSDate date];
+
+    dispatch_async(dispatchQueue, ^(void){
+
+        MXFileStoreMetaData *newMetaData;
+        NSMutableArray<NSString*> *removedRoomIds = [NSMutableArray array];
+        NSMutableDictionary<NSString*, MXFileRoomStore*> *newRoomStores = [NSMutableDictionary dictionary];
+        NSMutableDictionary<NSString*, NSArray*> *newRoomsStates = [NSMutableDictionary dictionary];
+        NSMutableDictionary<NSString*, MXRoomAccountData*> *newRoomsAccountData = [NSMutableDictionary dictionary];
+        NSMutableDictionary<NSString*, NSMutableDictionary*> *newReceipts = [NSMutableDictionary dictionary];
+        NSMutableDictionary<NSString*, MXUser*> *newUsers = [NSMutableDictionary dictionary];
+
+        @autoreleasepool
+        {
+            [self lockFiles];
+
+            // Do not read a store whose last commit was interrupted
+            if (![[NSFileManager defaultManager] fileExistsAtPath:storeBackupPath])
+            {
+                @try
+                {
+                    newMetaData = [NSKeyedUnarchiver unarchiveObjectWithFile:[self metaDataFileForBackup:NO]];
+                }
+                @catch (NSException *exception)
+                {
+                    NSLog(@"[MXFileStore] Warning: MXFileStore metadata has been corrupted");
+                }
+            }
+
+            if (newMetaData.version != kMXFileVersion
+                || NO == [newMetaData.userId isEqualToString:credentials.userId]
+                || NO == [newMetaData.accessToken isEqualToString:credentials.accessToken])
+            {
+                // The writer has reset the store
+                newMetaData = nil;
+            }
+
+            NSMutableDictionary<NSString*, NSDate*> *roomsModificationDates = [NSMutableDictionary dictionary];
+            NSMutableDictionary<NSString*, NSDate*> *usersModificationDates = [NSMutableDictionary dictionary];
+
+            if (newMetaData)
+            {
+                NSArray *roomIDArray = [[NSFileManager defaultManager] contentsOfDirectoryAtPath:storeRoomsPath error:nil];
+                for (NSString *roomId in roomIDArray)
+                {
+                    NSDate *modificationDate = [self modificationDateOfFileAtPath:[self folderForRoom:roomId forBackup:NO]];
+                    if (!modificationDate)
+                    {
+                        continue;
+                    }
+
+                    roomsModificationDates[roomId] = modificationDate;
+                    if ([modificationDate isEqualToDate:loadedRoomsModificationDates[roomId]])
+                    {
+                        continue;
+                    }
+
+                    MXFileRoomStore *roomStore;
+                    @try
+                    {
+                        roomStore = [NSKeyedUnarchiver unarchiveObjectWithFile:[self messagesFileForRoom:roomId forBackup:NO]];
+                    }
+                    @catch (NSException *exception)
+                    {
+                        NSLog(@"[MXFileStore] Warning: MXFileRoomStore file for room %@ has been corrupted", roomId);
+                    }
+
+                    if (roomStore)
+                    {
+                        newRoomStores[roomId] = roomStore;
+
+                        NSArray *stateEvents = [NSKeyedUnarchiver unarchiveObjectWithFile:[self stateFileForRoom:roomId forBackup:NO]];
+                        if (stateEvents)
+                        {
+                            newRoomsStates[roomId] = stateEvents;
+                        }
+
+                        MXRoomAccountData *roomAccountData = [NSKeyedUnarchiver unarchiveObjectWithFile:[self accountDataFileForRoom:roomId forBackup:NO]];
+                        if (roomAccountData)
+                        {
+                            newRoomsAccountData[roomId] = roomAccountData;
+                        }
+
+                        NSMutableDictionary *receiptsDict;
+                        @try
+                        {
+                            receiptsDict = [NSKeyedUnarchiver unarchiveObjectWithFile:[self readReceiptsFileForRoom:roomId forBackup:NO]];
+                        }
+                        @catch (NSException *exception)
+                        {
+                            NSLog(@"[MXFileStore] Warning: loadReceipts file for room %@ has been corrupted", roomId);
+                        }
+                        newReceipts[roomId] = receiptsDict ? receiptsDict : [NSMutableDictionary dictionary];
+                    }
+                    else
+                    {
+                        // Try again on the next commit
+                        [roomsModificationDates removeObjectForKey:roomId];
+                    }
+                }
+
+                NSArray *groups = [[NSFileManager defaultManager] contentsOfDirectoryAtPath:storeUsersPath error:nil];
+                for (NSString *group in groups)
+                {
+                    NSString *groupFile = [storeUsersPath stringByAppendingPathComponent:group];
+
+                    NSDate *modificationDate = [self modificationDateOfFileAtPath:groupFile];
+                    if (!modificationDate)
+                    {
+                        continue;
+                    }
+
+                    usersModificationDates[group] = modificationDate;
+                    if ([modificationDate isEqualToDate:loadedUsersModificationDates[group]])
+                    {
+                        continue;
+                    }
+
+                    @try
+                    {
+                        NSMutableDictionary <NSString*, MXUser*> *groupUsers = [NSKeyedUnarchiver unarchiveObjectWithFile:groupFile];
+                        if (groupUsers)
+                        {
+                            [newUsers addEntriesFromDictionary:groupUsers];
+                        }
+                    }
+                    @catch (NSException *exception)
+                    {
+                        NSLog(@"[MXFileStore] Warning: MXFileRoomStore file for users group %@ has been corrupted", group);
+                    }
+                }
+            }
+
+            [self unlockFiles];
+
+            for (NSString *roomId in loadedRoomsModificationDates)
+            {
+                if (!roomsModificationDates[roomId])
+                {
+                    [removedRoomIds addObject:roomId];
+                }
+            }
+
+            [loadedRoomsModificationDates setDictionary:roomsModificationDates];
+            [loadedUsersModificationDates setDictionary:usersModificationDates];
+        }
+
+        dispatch_async(dispatch_get_main_queue(), ^{
+
+            NSMutableArray<NSString*> *changedRoomIds = [NSMutableArray arrayWithArray:removedRoomIds];
+            [changedRoomIds addObjectsFromArray:newRoomStores.allKeys];
+
+            @synchronized(roomStores)
+            {
+                if (!newMetaData)
+                {
+                    [changedRoomIds setArray:roomStores.allKeys];
+                    [roomStores removeAllObjects];
+                }
+                [roomStores removeObjectsForKeys:removedRoomIds];
+                [roomStores addEntriesFromDictionary:newRoomStores];
+            }
+            @synchronized(receiptsByRoomId)
+            {
+                if (!newMetaData)
+                {
+                    [receiptsByRoomId removeAllObjects];
+                }
+                [receiptsByRoomId removeObjectsForKeys:removedRoomIds];
+                [receiptsByRoomId addEntriesFromDictionary:newReceipts];
+            }
+            @synchronized(users)
+            {
+                if (!newMetaData)
+                {
+                    [users removeAllObjects];
+                }
+                [users addEntriesFromDictionary:newUsers];
+            }
+            @synchronized(preloadedRoomsStates)
+            {
+                [preloadedRoomsStates removeObjectsForKeys:changedRoomIds];
+                [preloadedRoomsStates addEntriesFromDictionary:newRoomsStates];
+            }
+            @synchronized(preloadedRoomAccountData)
+            {
+                [preloadedRoomAccountData removeObjectsForKeys:changedRoomIds];
+                [preloadedRoomAccountData addEntriesFromDictionary:newRoomsAccountData];
+            }
+            [roomsToCommitForState removeAllObjects];
+            [roomsToCommitForAccountData removeAllObjects];
+
+            metaData = newMetaData;
+            self.eventStreamToken = newMetaData.eventStreamToken;
+
+            isReloading = NO;
+
+            NSLog(@"[MXFileStore] Reloaded data of %tu rooms committed by the writer in %.0fms", changedRoomIds.count, [[NSDate date] timeIntervalSinceDate:startDate] * 1000);
+
+            [[NSNotificationCenter defaultCenter] postNotificationName:kMXFileStoreDidReloadNotification
+                                                                object:self
+                                                              userInfo:@{
+                                                                         kMXFileStoreDidReloadNotificationRoomIdsKey: changedRoomIds
+                                                                         }];
+
+            if (needsReload)
+            {
+                [self reloadCommittedData];
+            }
+        });
+    });
+}
+
+/**
+ Store the modification dates of the files loaded by a read-only store.
+
+ This operation must be called on the `dispatchQueue` thread.
+ */
+- (void)storeLoadedFilesModificationDates
+{
+    [loadedRoomsModificationDates removeAllObjects];
+    for (NSString *roomId in roomStores)
+    {
+        NSDate *modificationDate = [self modificationDateOfFileAtPath:[self folderForRoom:roomId forBackup:NO]];
+        if (modificationDate)
+        {
+            loadedRoomsModificationDates[roomId] = modificationDate;
+        }
+    }
+
+    [loadedUsersModificationDates removeAllObjects];
+    NSArray *groups = [[NSFileManager defaultManager] contentsOfDirectoryAtPath:storeUsersPath error:nil];
+    for (NSString *group in groups)
+    {
+        NSDate *modificationDate = [self modificationDateOfFileAtPath:[storeUsersPath stringByAppendingPathComponent:group]];
+        if (modificationDate)
+        {
+            loadedUsersModificationDates[group] = modificationDate;
+        }
+    }
 }
 
 
 #pragma mark - Protected operations
 - (MXMemoryRoomStore*)getOrCreateRoomStore:(NSString*)roomId
 {
-    MXFileRoomStore *roomStore = roomStores[roomId];
-    if (nil == roomStore)
+    @synchronized(roomStores)
     {
-        // MXFileStore requires MXFileRoomStore objets
-        roomStore = [[MXFileRoomStore alloc] init];
-        roomStores[roomId] = roomStore;
+        MXFileRoomStore *roomStore = roomStores[roomId];
+        if (nil == roomStore)
+        {
+            // MXFileStore requires MXFileRoomStore objets
+            roomStore = [[MXFileRoomStore alloc] init];
+            roomStores[roomId] = roomStore;
+        }
+        return roomStore;
     }
-    return roomStore;
 }
 
 
@@ -746,7 +1378,7 @@ NSString *const kMXFileStoreRoomReadReceiptsFile = @"readReceipts";
             // Save rooms where there was changes
             for (NSString *roomId in roomsToCommit)
             {
-                MXFileRoomStore *roomStore = roomStores[roomId];
+                MXFileRoomStore *roomStore = (MXFileRoomStore*)[self roomStoreForRoom:roomId];
                 if (roomStore)
                 {
                     NSString *file = [self messagesFileForRoom:roomId forBackup:NO];
@@ -785,12 +1417,31 @@ NSString *const kMXFileStoreRoomReadReceiptsFile = @"readReceipts";
 
     for (NSString *roomId in roomStores)
     {
-        preloadedRoomsStates[roomId] = [self stateOfRoom:roomId];
+        NSArray *stateEvents = [self loadStateOfRoom:roomId];
+        if (stateEvents)
+        {
+            @synchronized(preloadedRoomsStates)
+            {
+                preloadedRoomsStates[roomId] = stateEvents;
+            }
+        }
     }
 
     NSLog(@"[MXFileStore] Loaded room states of %tu rooms in %.0fms", roomStores.allKeys.count, [[NSDate date] timeIntervalSinceDate:startDate] * 1000);
 }
 
+/**
+ Read the state of a room from its file, without using the preload cache.
+ */
+- (NSArray*)loadStateOfRoom:(NSString*)roomId
+{
+    [self lockFilesForReading];
+    NSArray *stateEvents = [NSKeyedUnarchiver unarchiveObjectWithFile:[self stateFileForRoom:roomId forBackup:NO]];
+    [self unlockFilesForReading];
+
+    return stateEvents;
+}
+
 - (void)saveRoomsState
 {
     if (roomsToCommitForState.count)
@@ -843,12 +1494,31 @@ NSString *const kMXFileStoreRoomReadReceiptsFile = @"readReceipts";
 
     for (NSString *roomId in roomStores)
     {
-        preloadedRoomAccountData[roomId] = [self accountDataOfRoom:roomId];
+        MXRoomAccountData *roomAccountData = [self loadAccountDataOfRoom:roomId];
+        if (roomAccountData)
+        {
+            @synchronized(preloadedRoomAccountData)
+            {
+                preloadedRoomAccountData[roomId] = roomAccountData;
+            }
+        }
     }
 
     NSLog(@"[MXFileStore] Loaded rooms account data of %tu rooms in %.0fms", roomStores.allKeys.count, [[NSDate date] timeIntervalSinceDate:startDate] * 1000);
 }
 
+/**
+ Read the account data of a room from its file, without using the preload cache.
+ */
+- (MXRoomAccountData*)loadAccountDataOfRoom:(NSString*)roomId
+{
+    [self lockFilesForReading];
+    MXRoomAccountData *roomAccountData = [NSKeyedUnarchiver unarchiveObjectWithFile:[self accountDataFileForRoom:roomId forBackup:NO]];
+    [self unlockFilesForReading];
+
+    return roomAccountData;
+}
+
 - (void)saveRoomsAccountData
 {
     if (roomsToCommitForAccountData.count)
@@ -1212,7 +1882,7 @@ NSString *const kMXFileStoreRoomReadReceiptsFile = @"readReceipts";
             // Save rooms where there was changes
             for (NSString *roomId in roomsToCommit)
             {
-                NSMutableDictionary* receiptsByUserId = receiptsByRoomId[roomId];
+                NSMutableDictionary* receiptsByUserId = [self receiptsByUserIdInRoom:roomId create:NO];
                 if (receiptsByUserId)
                 {
                     @synchronized (receiptsByUserId)
@@ -1243,6 +1913,17 @@ NSString *const kMXFileStoreRoomReadReceiptsFile = @"readReceipts";
 
 
 #pragma mark - Tools
+/**
+ Get the last modification date of a file or a folder.
+
+ @param path the file or folder path.
+ @return the modification date. nil if the file does not exist.
+ */
+- (NSDate*)modificationDateOfFileAtPath:(NSString*)path
+{
+    return [[NSFileManager defaultManager] attributesOfItemAtPath:path error:nil].fileModificationDate;
+}
+
 /**
  List recursevely files in a folder
  
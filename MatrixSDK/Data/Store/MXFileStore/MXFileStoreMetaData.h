@@ -39,6 +39,16 @@
  */
 @property (nonatomic) NSString *eventStreamToken;
 
+/**
+ The date when eventStreamToken was last changed.
+ */
+@property (nonatomic) NSDate *eventStreamTokenDate;
+
+/**
+ The age of the events stream token from which the session catches up. 0 if not adapted.
+ */
+@property (nonatomic) NSTimeInterval catchUpTokenAge;
+
 /**
  The current version of the store.
  */
@@ -28,6 +28,8 @@
         _userId = dict[@"userId"];
         _accessToken = dict[@"accessToken"];
         _eventStreamToken = dict[@"eventStreamToken"];
+        _eventStreamTokenDate = dict[@"eventStreamTokenDate"];
+        _catchUpTokenAge = [dict[@"catchUpTokenAge"] doubleValue];
         _userAccountData = dict[@"userAccountData"];
 
         NSNumber *version = dict[@"version"];
@@ -38,7 +40,7 @@
 
 -(void)encodeWithCoder:(NSCoder *)aCoder
 {
-    // All properties are mandatory except eventStreamToken
+    // All properties are mandatory except eventStreamToken, its date and catchUpTokenAge
     NSMutableDictionary *dict =[NSMutableDictionary dictionaryWithDictionary:
                                 @{
                                   @"homeServer": _homeServer,
@@ -51,6 +53,14 @@
     {
         dict[@"eventStreamToken"] = _eventStreamToken;
     }
+    if (_eventStreamTokenDate)
+    {
+        dict[@"eventStreamTokenDate"] = _eventStreamTokenDate;
+    }
+    if (_catchUpTokenAge)
+    {
+        dict[@"catchUpTokenAge"] = @(_catchUpTokenAge);
+    }
     if (_userAccountData)
     {
         dict[@"userAccountData"] = _userAccountData;
@@ -68,6 +78,8 @@
     metaData->_accessToken = [_accessToken copyWithZone:zone];
     metaData->_version = _version;
     metaData->_eventStreamToken = [_eventStreamToken copyWithZone:zone];
+    metaData->_eventStreamTokenDate = _eventStreamTokenDate;
+    metaData->_catchUpTokenAge = _catchUpTokenAge;
     metaData->_userAccountData = [_userAccountData copyWithZone:zone];
 
     return metaData;
@@ -0,0 +1,116 @@
+/*
+ Copyright 2016 OpenMarket Ltd
+
+ Licensed under the Apache License, Version 2.0 (the "License");
+ you may not use this file except in compliance with the License.
+ You may obtain a copy of the License at
+
+ http://www.apache.org/licenses/LICENSE-2.0
+
+ Unless required by applicable law or agreed to in writing, software
+ distributed under the License is distributed on an "AS IS" BASIS,
+ WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ See the License for the specific language governing permissions and
+ limitations under the License.
+ */
+
+#import <Foundation/Foundation.h>
+
+#import "MXEvent.h"
+
+/**
+ `MXMemoryRoomMessages` is the versioned storage of the messages of a room.
+
+ The order is chronological: the message at index 0 is the oldest one.
+
+ Messages received forwards (live) and backwards (pagination) are appended to two arrays
+ of the current generation. Existing messages never move in a generation so that a
+ snapshot is just a reference to the generation and the lengths of both arrays: it is
+ created in O(1) and it is not affected by messages added later.
+
+ A replaced message (a redaction for example) is replaced in place: existing snapshots
+ see the new message. Removing the oldest messages starts a new generation that shares
+ the array of forward messages with the previous one so that existing snapshots are not
+ affected and nothing is copied.
+
+ A single thread must write. Snapshots can be read from any thread.
+ */
+@interface MXMemoryRoomMessages : NSObject
+
+/**
+ Create a storage with initial messages.
+
+ @param events the messages in chronological order.
+ @return the newly created instance.
+ */
+- (instancetype)initWithEvents:(NSArray<MXEvent*>*)events;
+
+/**
+ Create a storage using an existing mutable array as the storage of the initial messages.
+
+ The array is not copied: it can be an NSMutableArray subclass that builds the
+ messages on demand. Only `addObject:`, `replaceObjectAtIndex:withObject:` and
+ `removeObjectsInRange:` are called on it afterwards.
+
+ @param events the messages in chronological order.
+ @return the newly created instance.
+ */
+- (instancetype)initWithEventsStorage:(NSMutableArray<MXEvent*>*)events;
+
+/**
+ The number of messages.
+ */
+@property (nonatomic, readonly) NSUInteger count;
+
+/**
+ Add a message after the most recent one.
+
+ @param event the message.
+ */
+- (void)appendEvent:(MXEvent*)event;
+
+/**
+ Add a message before the oldest one.
+
+ @param event the message.
+ */
+- (void)prependEvent:(MXEvent*)event;
+
+/**
+ Replace a message, in existing snapshots too.
+
+ @param index the index of the message to replace.
+ @param event the new message.
+ */
+- (void)replaceEventAtIndex:(NSUInteger)index withEvent:(MXEvent*)event;
+
+/**
+ Remove the oldest messages.
+
+ @param index the index of the oldest message to keep.
+ */
+- (void)removeEventsBeforeIndex:(NSUInteger)index;
+
+/**
+ Remove all messages.
+ */
+- (void)removeAllEvents;
+
+/**
+ Get the index of a message.
+
+ The search starts from the most recent message.
+
+ @param event the message instance.
+ @return its index. NSNotFound if it is not stored.
+ */
+- (NSUInteger)indexOfEvent:(MXEvent*)event;
+
+/**
+ Get an immutable snapshot of the messages in O(1).
+
+ @return the messages in chronological order.
+ */
+- (NSArray<MXEvent*>*)snapshot;
+
+@end
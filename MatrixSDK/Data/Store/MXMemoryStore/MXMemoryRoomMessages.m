@@ -0,0 +1,335 @@
+/*
+ Copyright 2016 OpenMarket Ltd
+
+ Licensed under the Apache License, Version 2.0 (the "License");
+ you may not use this file except in compliance with the License.
+ You may obtain a copy of the License at
+
+ http://www.apache.org/licenses/LICENSE-2.0
+
+ Unless required by applicable law or agreed to in writing, software
+ distributed under the License is distributed on an "AS IS" BASIS,
+ WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ See the License for the specific language governing permissions and
+ limitations under the License.
+ */
+
+#import "MXMemoryRoomMessages.h"
+
+#pragma mark - MXMemoryRoomMessagesGeneration
+/**
+ A generation of messages. Messages are only added at both ends. They never move.
+
+ A generation can share its `forwardEvents` array with the previous one. The arrays must
+ be accessed with `lock`, which is shared by these generations: they can grow while
+ snapshots read them.
+ */
+@interface MXMemoryRoomMessagesGeneration : NSObject
+{
+    @public
+    // Messages added backwards. The order is antichronological: the last item is the oldest message.
+    NSMutableArray<MXEvent*> *backwardEvents;
+
+    // Messages added forwards. The order is chronological: the last item is the most recent message.
+    NSMutableArray<MXEvent*> *forwardEvents;
+
+    // The number of the oldest items of `forwardEvents` that are not part of this generation.
+    NSUInteger forwardStart;
+
+    NSObject *lock;
+}
+
+@end
+
+@implementation MXMemoryRoomMessagesGeneration
+
+- (instancetype)initWithEvents:(NSArray<MXEvent*>*)events
+{
+    return [self initWithEventsStorage:events ? [NSMutableArray arrayWithArray:events] : [NSMutableArray array]];
+}
+
+- (instancetype)initWithEventsStorage:(NSMutableArray<MXEvent*>*)events
+{
+    return [self initWithBackwardEvents:[NSMutableArray array] forwardEvents:events forwardStart:0 lock:[[NSObject alloc] init]];
+}
+
+- (instancetype)initWithBackwardEvents:(NSMutableArray<MXEvent*>*)backwardEvents2 forwardEvents:(NSMutableArray<MXEvent*>*)forwardEvents2 forwardStart:(NSUInteger)forwardStart2 lock:(NSObject*)lock2
+{
+    self = [super init];
+    if (self)
+    {
+        backwardEvents = backwardEvents2;
+        forwardEvents = forwardEvents2;
+        forwardStart = forwardStart2;
+        lock = lock2;
+    }
+    return self;
+}
+
+@end
+
+
+#pragma mark - MXMemoryRoomMessagesSnapshot
+/**
+ An immutable array on the messages of a generation at a given time.
+ */
+@interface MXMemoryRoomMessagesSnapshot : NSArray
+{
+    MXMemoryRoomMessagesGeneration *generation;
+
+    // The lengths of the generation arrays when the snapshot was taken
+    NSUInteger backwardCount;
+    NSUInteger forwardCount;
+}
+
+- (instancetype)initWithGeneration:(MXMemoryRoomMessagesGeneration*)generation backwardCount:(NSUInteger)backwardCount forwardCount:(NSUInteger)forwardCount;
+
+@end
+
+@implementation MXMemoryRoomMessagesSnapshot
+
+- (instancetype)initWithGeneration:(MXMemoryRoomMessagesGeneration *)generation2 backwardCount:(NSUInteger)backwardCount2 forwardCount:(NSUInteger)forwardCount2
+{
+    self = [super init];
+    if (self)
+    {
+        generation = generation2;
+        backwardCount = backwardCount2;
+        forwardCount = forwardCount2;
+    }
+    return self;
+}
+
+- (NSUInteger)count
+{
+    return backwardCount + forwardCount;
+}
+
+- (id)objectAtIndex:(NSUInteger)index
+{
+    if (index >= backwardCount + forwardCount)
+    {
+        [NSException raise:NSRangeException format:@"[MXMemoryRoomMessagesSnapshot] index %tu beyond bounds %tu", index, backwardCount + forwardCount];
+    }
+
+    @synchronized(generation->lock)
+    {
+        if (index < backwardCount)
+        {
+            return generation->backwardEvents[backwardCount - 1 - index];
+        }
+        return generation->forwardEvents[generation->forwardStart + index - backwardCount];
+    }
+}
+
+- (void)getObjects:(id __unsafe_unretained [])objects range:(NSRange)range
+{
+    if (NSMaxRange(range) > backwardCount + forwardCount)
+    {
+        [NSException raise:NSRangeException format:@"[MXMemoryRoomMessagesSnapshot] range %@ beyond bounds %tu", NSStringFromRange(range), backwardCount + forwardCount];
+    }
+
+    // Read the whole range with a single lock
+    @synchronized(generation->lock)
+    {
+        for (NSUInteger i = 0; i < range.length; i++)
+        {
+            NSUInteger index = range.location + i;
+            if (index < backwardCount)
+            {
+                objects[i] = generation->backwardEvents[backwardCount - 1 - index];
+            }
+            else
+            {
+                objects[i] = generation->forwardEvents[generation->forwardStart + index - backwardCount];
+            }
+        }
+    }
+}
+
+- (id)copyWithZone:(NSZone *)zone
+{
+    // The snapshot is immutable
+    return self;
+}
+
+- (Class)classForCoder
+{
+    return [NSArray class];
+}
+
+@end
+
+
+#pragma mark - MXMemoryRoomMessages
+@interface MXMemoryRoomMessages ()
+{
+    MXMemoryRoomMessagesGeneration *generation;
+
+    // The generations that share the forward array of the current one, while they are used
+    NSHashTable<MXMemoryRoomMessagesGeneration*> *sharingGenerations;
+}
+
+@end
+
+@implementation MXMemoryRoomMessages
+
+- (instancetype)init
+{
+    return [self initWithEvents:nil];
+}
+
+- (instancetype)initWithEvents:(NSArray<MXEvent *> *)events
+{
+    self = [super init];
+    if (self)
+    {
+        [self setGeneration:[[MXMemoryRoomMessagesGeneration alloc] initWithEvents:events] sharingForwardEvents:NO];
+    }
+    return self;
+}
+
+- (instancetype)initWithEventsStorage:(NSMutableArray<MXEvent *> *)events
+{
+    self = [super init];
+    if (self)
+    {
+        [self setGeneration:[[MXMemoryRoomMessagesGeneration alloc] initWithEventsStorage:events] sharingForwardEvents:NO];
+    }
+    return self;
+}
+
+- (NSUInteger)count
+{
+    // Only the writer thread calls it: the counts cannot change meanwhile
+    return generation->backwardEvents.count + generation->forwardEvents.count - generation->forwardStart;
+}
+
+- (void)appendEvent:(MXEvent *)event
+{
+    @synchronized(generation->lock)
+    {
+        [generation->forwardEvents addObject:event];
+    }
+}
+
+- (void)prependEvent:(MXEvent *)event
+{
+    @synchronized(generation->lock)
+    {
+        [generation->backwardEvents addObject:event];
+    }
+}
+
+- (void)replaceEventAtIndex:(NSUInteger)index withEvent:(MXEvent *)event
+{
+    // The message does not move: replace it in the array that holds it
+    @synchronized(generation->lock)
+    {
+        NSUInteger backwardCount = generation->backwardEvents.count;
+        if (index < backwardCount)
+        {
+            [generation->backwardEvents replaceObjectAtIndex:backwardCount - 1 - index withObject:event];
+        }
+        else
+        {
+            [generation->forwardEvents replaceObjectAtIndex:generation->forwardStart + index - backwardCount withObject:event];
+        }
+    }
+}
+
+- (void)removeEventsBeforeIndex:(NSUInteger)index
+{
+    // Existing snapshots still read the removed messages. The new generation shares
+    // the forward array and starts further in it
+    NSUInteger backwardCount = generation->backwardEvents.count;
+    MXMemoryRoomMessagesGeneration *newGeneration;
+    if (index < backwardCount)
+    {
+        NSMutableArray<MXEvent*> *backwardEvents = [NSMutableArray arrayWithArray:[generation->backwardEvents subarrayWithRange:NSMakeRange(0, backwardCount - index)]];
+
+        newGeneration = [[MXMemoryRoomMessagesGeneration alloc] initWithBackwardEvents:backwardEvents
+                                                                        forwardEvents:generation->forwardEvents
+                                                                         forwardStart:generation->forwardStart
+                                                                                 lock:generation->lock];
+    }
+    else
+    {
+        newGeneration = [[MXMemoryRoomMessagesGeneration alloc] initWithBackwardEvents:[NSMutableArray array]
+                                                                        forwardEvents:generation->forwardEvents
+                                                                         forwardStart:generation->forwardStart + index - backwardCount
+                                                                                 lock:generation->lock];
+    }
+
+    [self setGeneration:newGeneration sharingForwardEvents:YES];
+
+    // Release the removed messages that no snapshot uses anymore
+    NSArray<MXMemoryRoomMessagesGeneration*> *generations = sharingGenerations.allObjects;
+    NSUInteger releasableCount = generation->forwardStart;
+    for (MXMemoryRoomMessagesGeneration *sharingGeneration in generations)
+    {
+        releasableCount = MIN(releasableCount, sharingGeneration->forwardStart);
+    }
+
+    if (releasableCount)
+    {
+        @synchronized(generation->lock)
+        {
+            [generation->forwardEvents removeObjectsInRange:NSMakeRange(0, releasableCount)];
+            for (MXMemoryRoomMessagesGeneration *sharingGeneration in generations)
+            {
+                sharingGeneration->forwardStart -= releasableCount;
+            }
+        }
+    }
+}
+
+- (void)setGeneration:(MXMemoryRoomMessagesGeneration*)newGeneration sharingForwardEvents:(BOOL)sharingForwardEvents
+{
+    if (!sharingForwardEvents || !sharingGenerations)
+    {
+        sharingGenerations = [NSHashTable weakObjectsHashTable];
+    }
+
+    generation = newGeneration;
+    [sharingGenerations addObject:generation];
+}
+
+- (void)removeAllEvents
+{
+    [self setGeneration:[[MXMemoryRoomMessagesGeneration alloc] initWithEvents:nil] sharingForwardEvents:NO];
+}
+
+- (NSUInteger)indexOfEvent:(MXEvent *)event
+{
+    // Recent messages are more likely to be searched. They are at the end of forwardEvents
+    NSUInteger backwardCount = generation->backwardEvents.count;
+    NSUInteger forwardStart = generation->forwardStart;
+    NSIndexSet *forwardIndexes = [NSIndexSet indexSetWithIndexesInRange:NSMakeRange(forwardStart, generation->forwardEvents.count - forwardStart)];
+    NSUInteger index = [generation->forwardEvents indexOfObjectAtIndexes:forwardIndexes options:NSEnumerationReverse passingTest:^BOOL(MXEvent *obj, NSUInteger idx, BOOL *stop) {
+        return obj == event;
+    }];
+
+    if (index != NSNotFound)
+    {
+        return backwardCount + index - forwardStart;
+    }
+
+    index = [generation->backwardEvents indexOfObjectIdenticalTo:event];
+    if (index != NSNotFound)
+    {
+        return backwardCount - 1 - index;
+    }
+
+    return NSNotFound;
+}
+
+- (NSArray<MXEvent *> *)snapshot
+{
+    // Only the writer thread changes the counts
+    return [[MXMemoryRoomMessagesSnapshot alloc] initWithGeneration:generation
+                                                      backwardCount:generation->backwardEvents.count
+                                                       forwardCount:generation->forwardEvents.count - generation->forwardStart];
+}
+
+@end
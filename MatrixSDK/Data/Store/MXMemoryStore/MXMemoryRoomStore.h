@@ -17,13 +17,25 @@
 #import <Foundation/Foundation.h>
 
 #import "MXStore.h"
+#import "MXMemoryRoomMessages.h"
 
+/**
+ `MXMemoryRoomStore` stores the data of a room in memory.
+
+ Concurrency model:
+ - there is a single writer, the thread that processes the /sync responses (the main thread).
+ - readers can be on any thread. They get immutable snapshots of the messages (see
+   `messagesSnapshot`) that are taken in O(1) from the versioned storage of the messages.
+   Other accesses are protected by a lock per room held only for the time of the access.
+   The scalar properties (pagination token, counts...) are atomic.
+ */
 @interface MXMemoryRoomStore : NSObject
 {
     @protected
     // The events downloaded so far.
     // The order is chronological: the first item is the oldest message.
-    NSMutableArray<MXEvent*> *messages;
+    // It must be accessed with the lock on self.
+    MXMemoryRoomMessages *messages;
 
     // A cache to quickly retrieve an event by its event id.
     // This significanly improves [MXMemoryStore eventWithEventId:] and [MXMemoryStore eventExistsWithEventId:]
@@ -32,6 +44,11 @@
 
     // The events that are being sent.
     NSMutableArray<MXEvent*> *outgoingMessages;
+
+    // Periodic snapshots of the room state: the state events of the room before a message,
+    // by message event id.
+    // It must be accessed with the lock on self.
+    NSMutableDictionary<NSString*, NSArray<MXEvent*>*> *stateCheckpoints;
 }
 
 /**
@@ -60,31 +77,77 @@
 /**
  The current pagination token of the room.
  */
-@property (nonatomic) NSString *paginationToken;
+@property (atomic) NSString *paginationToken;
 
 /**
  The current number of unread messages that match the push notification rules.
  It is based on the notificationCount field in /sync response.
  */
-@property (nonatomic) NSUInteger notificationCount;
+@property (atomic) NSUInteger notificationCount;
 
 /**
  The current number of highlighted unread messages (subset of notifications).
  It is based on the notificationCount field in /sync response.
  */
-@property (nonatomic) NSUInteger highlightCount;
+@property (atomic) NSUInteger highlightCount;
 
 /**
  The flag indicating that the SDK has reached the end of pagination
  in its pagination requests to the home server.
  */
-@property (nonatomic) BOOL hasReachedHomeServerPaginationEnd;
+@property (atomic) BOOL hasReachedHomeServerPaginationEnd;
 
 /**
  Reset the current messages array.
  */
 - (void)removeAllMessages;
 
+/**
+ Remove the messages older than an event.
+
+ @param eventId the id of the oldest event to keep.
+ @return the number of removed messages. 0 if the event is unknown.
+ */
+- (NSUInteger)removeMessagesBeforeEvent:(NSString*)eventId;
+
+/**
+ Store a snapshot of the room state.
+
+ Only the most recent checkpoints are kept.
+
+ @param stateEvents the state events of the room before the message.
+ @param eventId the id of the stored message.
+ */
+- (void)storeStateCheckpoint:(NSArray<MXEvent*>*)stateEvents beforeEvent:(NSString*)eventId;
+
+/**
+ Get the state checkpoint stored before a message.
+
+ @param eventId the id of the stored message.
+ @return the state events of the checkpoint. nil if there is no checkpoint before this message.
+ */
+- (NSArray<MXEvent*>*)stateCheckpointBeforeEvent:(NSString*)eventId;
+
+/**
+ Rebuild the room state before a message.
+
+ The state events of the closest checkpoint before the message are updated with the state
+ events stored between them. Checkpoints too far from the message are not used.
+
+ @param eventId the id of the stored message.
+ @return the state events. nil if there is no checkpoint before the message.
+ */
+- (NSArray<MXEvent*>*)stateBeforeEvent:(NSString*)eventId;
+
+/**
+ An immutable snapshot of the messages of the room downloaded so far.
+ The order is chronological: the first item is the oldest message.
+
+ It is safe to use from any thread. It is taken in O(1) and it is not affected by messages
+ stored later.
+ */
+@property (nonatomic, readonly) NSArray<MXEvent*> *messagesSnapshot;
+
 /**
  The enumerator on all messages of the room downloaded so far.
  */
@@ -115,7 +178,7 @@
 /**
  The text message partially typed by the user but not yet sent in the room.
  */
-@property (nonatomic) NSString *partialTextMessage;
+@property (atomic) NSString *partialTextMessage;
 
 /**
  Store into the store an outgoing message event being sent in the room.
@@ -19,79 +19,247 @@
 #import "MXEventsEnumeratorOnArray.h"
 #import "MXEventsByTypesEnumeratorOnArray.h"
 
-@interface MXMemoryRoomStore ()
-{
-}
+/**
+ The maximum number of state checkpoints kept per room.
+ */
+#define MXMEMORYROOMSTORE_MAX_STATE_CHECKPOINTS 20
 
-@end
+/**
+ The maximum number of messages walked back from a message to find a state checkpoint.
+ */
+#define MXMEMORYROOMSTORE_MAX_STATE_CHECKPOINT_DISTANCE 1000
 
 @implementation MXMemoryRoomStore
-@synthesize outgoingMessages;
 
 - (instancetype)init
 {
     self = [super init];
     if (self)
     {
-        messages = [NSMutableArray array];
+        messages = [[MXMemoryRoomMessages alloc] init];
         messagesByEventIds = [NSMutableDictionary dictionary];
         outgoingMessages = [NSMutableArray array];;
+        stateCheckpoints = [NSMutableDictionary dictionary];
     }
     return self;
 }
 
 - (void)storeEvent:(MXEvent *)event direction:(MXTimelineDirection)direction
 {
-    if (MXTimelineDirectionForwards == direction)
+    @synchronized(self)
     {
-        [messages addObject:event];
+        if (MXTimelineDirectionForwards == direction)
+        {
+            [messages appendEvent:event];
+        }
+        else
+        {
+            [messages prependEvent:event];
+        }
+
+        if (event.eventId)
+        {
+            messagesByEventIds[event.eventId] = event;
+        }
     }
-    else
+}
+
+- (void)replaceEvent:(MXEvent*)event
+{
+    @synchronized(self)
     {
-        [messages insertObject:event atIndex:0];
+        MXEvent *storedEvent = event.eventId ? messagesByEventIds[event.eventId] : nil;
+        NSUInteger index = storedEvent ? [messages indexOfEvent:storedEvent] : NSNotFound;
+        if (index != NSNotFound)
+        {
+            [messages replaceEventAtIndex:index withEvent:event];
+            messagesByEventIds[event.eventId] = event;
+        }
     }
+}
 
-    if (event.eventId)
+- (MXEvent *)eventWithEventId:(NSString *)eventId
+{
+    @synchronized(self)
     {
-        messagesByEventIds[event.eventId] = event;
+        return messagesByEventIds[eventId];
     }
 }
 
-- (void)replaceEvent:(MXEvent*)event
+- (void)removeAllMessages
+{
+    @synchronized(self)
+    {
+        [messages removeAllEvents];
+        [messagesByEventIds removeAllObjects];
+        [stateCheckpoints removeAllObjects];
+    }
+}
+
+- (NSUInteger)removeMessagesBeforeEvent:(NSString*)eventId
 {
-    NSUInteger index = messages.count;
-    while (index--)
+    @synchronized(self)
     {
-        MXEvent *anEvent = [messages objectAtIndex:index];
-        if ([anEvent.eventId isEqualToString:event.eventId])
+        MXEvent *event = messagesByEventIds[eventId];
+        NSUInteger index = event ? [messages indexOfEvent:event] : NSNotFound;
+        if (index == NSNotFound || index == 0)
         {
-            [messages replaceObjectAtIndex:index withObject:event];
+            return 0;
+        }
 
-            messagesByEventIds[event.eventId] = event;
-            break;
+        for (MXEvent *removedEvent in [messages.snapshot subarrayWithRange:NSMakeRange(0, index)])
+        {
+            if (removedEvent.eventId)
+            {
+                [messagesByEventIds removeObjectForKey:removedEvent.eventId];
+                [stateCheckpoints removeObjectForKey:removedEvent.eventId];
+            }
         }
+        [messages removeEventsBeforeIndex:index];
+
+        return index;
     }
 }
 
-- (MXEvent *)eventWithEventId:(NSString *)eventId
+- (void)storeStateCheckpoint:(NSArray<MXEvent *> *)stateEvents beforeEvent:(NSString *)eventId
 {
-    return messagesByEventIds[eventId];
+    @synchronized(self)
+    {
+        if (!messagesByEventIds[eventId])
+        {
+            return;
+        }
+
+        stateCheckpoints[eventId] = [stateEvents copy];
+
+        if (stateCheckpoints.count > MXMEMORYROOMSTORE_MAX_STATE_CHECKPOINTS)
+        {
+            [self removeStateCheckpointInSmallestGap];
+        }
+    }
 }
 
-- (void)removeAllMessages
+/**
+ Remove a checkpoint so that the remaining ones stay spread over the whole stored history.
+
+ The oldest and the most recent checkpoints are kept. The removed one is the checkpoint
+ whose neighbours are the closest.
+ */
+- (void)removeStateCheckpointInSmallestGap
+{
+    NSMutableArray<NSString*> *checkpointEventIds = [NSMutableArray arrayWithCapacity:stateCheckpoints.count];
+    NSMutableArray<NSNumber*> *checkpointIndexes = [NSMutableArray arrayWithCapacity:stateCheckpoints.count];
+
+    NSUInteger index = 0;
+    for (MXEvent *message in messages.snapshot)
+    {
+        if (message.eventId && stateCheckpoints[message.eventId])
+        {
+            [checkpointEventIds addObject:message.eventId];
+            [checkpointIndexes addObject:@(index)];
+        }
+        index++;
+    }
+
+    NSString *removedEventId;
+    NSUInteger smallestGap = NSUIntegerMax;
+    for (NSUInteger i = 1; i + 1 < checkpointIndexes.count; i++)
+    {
+        NSUInteger gap = checkpointIndexes[i + 1].unsignedIntegerValue - checkpointIndexes[i - 1].unsignedIntegerValue;
+        if (gap < smallestGap)
+        {
+            smallestGap = gap;
+            removedEventId = checkpointEventIds[i];
+        }
+    }
+
+    if (removedEventId)
+    {
+        [stateCheckpoints removeObjectForKey:removedEventId];
+    }
+}
+
+- (NSArray<MXEvent *> *)stateCheckpointBeforeEvent:(NSString *)eventId
+{
+    @synchronized(self)
+    {
+        return stateCheckpoints[eventId];
+    }
+}
+
+- (NSArray<MXEvent *> *)stateBeforeEvent:(NSString *)eventId
+{
+    NSArray<MXEvent*> *checkpoint;
+    NSMutableArray<MXEvent*> *stateEventsSinceCheckpoint = [NSMutableArray array];
+
+    @synchronized(self)
+    {
+        checkpoint = stateCheckpoints[eventId];
+        if (checkpoint)
+        {
+            return checkpoint;
+        }
+
+        MXEvent *event = messagesByEventIds[eventId];
+        NSUInteger index = event ? [messages indexOfEvent:event] : NSNotFound;
+        if (index == NSNotFound || !stateCheckpoints.count)
+        {
+            return nil;
+        }
+
+        // Go back to the closest checkpoint and collect state changes on the way.
+        // The walk is bounded: the state is not worth rebuilding from too far
+        NSArray<MXEvent*> *messagesSnapshot = messages.snapshot;
+        NSUInteger minIndex = index > MXMEMORYROOMSTORE_MAX_STATE_CHECKPOINT_DISTANCE ? index - MXMEMORYROOMSTORE_MAX_STATE_CHECKPOINT_DISTANCE : 0;
+        NSUInteger i = index;
+        while (i-- > minIndex)
+        {
+            MXEvent *message = messagesSnapshot[i];
+            if (message.isState)
+            {
+                [stateEventsSinceCheckpoint addObject:message];
+            }
+
+            checkpoint = message.eventId ? stateCheckpoints[message.eventId] : nil;
+            if (checkpoint)
+            {
+                break;
+            }
+        }
+    }
+
+    if (!checkpoint)
+    {
+        return nil;
+    }
+
+    // Apply the changes in chronological order
+    NSMutableDictionary<NSArray*, MXEvent*> *stateEventsByKey = [NSMutableDictionary dictionaryWithCapacity:checkpoint.count];
+    for (MXEvent *stateEvent in [checkpoint arrayByAddingObjectsFromArray:stateEventsSinceCheckpoint.reverseObjectEnumerator.allObjects])
+    {
+        stateEventsByKey[@[stateEvent.type ? stateEvent.type : @"", stateEvent.stateKey ? stateEvent.stateKey : @""]] = stateEvent;
+    }
+
+    return stateEventsByKey.allValues;
+}
+
+- (NSArray<MXEvent *> *)messagesSnapshot
 {
-    [messages removeAllObjects];
-    [messagesByEventIds removeAllObjects];
+    @synchronized(self)
+    {
+        return messages.snapshot;
+    }
 }
 
 - (id<MXEventsEnumerator>)messagesEnumerator
 {
-    return [[MXEventsEnumeratorOnArray alloc] initWithMessages:messages];
+    // The snapshot is immutable: the enumerator does not need to copy it again
+    return [[MXEventsEnumeratorOnArray alloc] initWithMessages:self.messagesSnapshot];
 }
 
 - (id<MXEventsEnumerator>)enumeratorForMessagesWithTypeIn:(NSArray*)types ignoreMemberProfileChanges:(BOOL)ignoreProfileChanges
 {
-    return [[MXEventsByTypesEnumeratorOnArray alloc] initWithMessages:messages andTypesIn:types ignoreMemberProfileChanges:ignoreProfileChanges];
+    return [[MXEventsByTypesEnumeratorOnArray alloc] initWithMessages:self.messagesSnapshot andTypesIn:types ignoreMemberProfileChanges:ignoreProfileChanges];
 }
 
 - (NSArray*)eventsAfter:(NSString *)eventId except:(NSString*)userId withTypeIn:(NSSet*)types
@@ -100,10 +268,12 @@
 
     if (eventId)
     {
+        NSArray<MXEvent*> *messagesSnapshot = self.messagesSnapshot;
+
         // Check messages from the most recent
-        for (NSInteger i = messages.count - 1; i >= 0 ; i--)
+        for (NSInteger i = messagesSnapshot.count - 1; i >= 0 ; i--)
         {
-            MXEvent *event = messages[i];
+            MXEvent *event = messagesSnapshot[i];
 
             if (NO == [event.eventId isEqualToString:eventId])
             {
@@ -126,30 +296,55 @@
 
 - (void)storeOutgoingMessage:(MXEvent*)outgoingMessage
 {
-    [outgoingMessages addObject:outgoingMessage];
+    @synchronized(self)
+    {
+        [outgoingMessages addObject:outgoingMessage];
+    }
 }
 
 - (void)removeAllOutgoingMessages
 {
-    [outgoingMessages removeAllObjects];
+    @synchronized(self)
+    {
+        [outgoingMessages removeAllObjects];
+    }
 }
 
 - (void)removeOutgoingMessage:(NSString*)outgoingMessageEventId
 {
-    for (NSUInteger i = 0; i < outgoingMessages.count; i++)
+    @synchronized(self)
     {
-        MXEvent *outgoingMessage = outgoingMessages[i];
-        if ([outgoingMessage.eventId isEqualToString:outgoingMessageEventId])
+        for (NSUInteger i = 0; i < outgoingMessages.count; i++)
         {
-            [outgoingMessages removeObjectAtIndex:i];
-            break;
+            MXEvent *outgoingMessage = outgoingMessages[i];
+            if ([outgoingMessage.eventId isEqualToString:outgoingMessageEventId])
+            {
+                [outgoingMessages removeObjectAtIndex:i];
+                break;
+            }
         }
     }
 }
 
+- (NSArray<MXEvent *> *)outgoingMessages
+{
+    @synchronized(self)
+    {
+        return [outgoingMessages copy];
+    }
+}
+
+- (void)setOutgoingMessages:(NSArray<MXEvent *> *)theOutgoingMessages
+{
+    @synchronized(self)
+    {
+        outgoingMessages = [NSMutableArray arrayWithArray:theOutgoingMessages];
+    }
+}
+
 - (NSString *)description
 {
-    return [NSString stringWithFormat:@"%tu messages - paginationToken: %@ - hasReachedHomeServerPaginationEnd: %d", messages.count, _paginationToken, _hasReachedHomeServerPaginationEnd];
+    return [NSString stringWithFormat:@"%tu messages - paginationToken: %@ - hasReachedHomeServerPaginationEnd: %d", self.messagesSnapshot.count, self.paginationToken, self.hasReachedHomeServerPaginationEnd];
 }
 
 @end
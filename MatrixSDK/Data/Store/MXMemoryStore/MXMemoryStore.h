@@ -20,6 +20,14 @@
 
 /**
  `MXMemoryStore` is an implementation of the `MXStore` interface that stores events in memory.
+
+ The store has a single writer, the thread that processes the /sync responses (the main
+ thread), but its read methods can be called from any thread (search, notifications
+ computation, UI prefetch...):
+ - messages are read from immutable snapshots published by each room store,
+ - the collections of rooms, receipts and users are protected by their own lock, held only
+   for the time of an access.
+ Subclasses must respect this model when they access the protected ivars.
  */
 @interface MXMemoryStore : NSObject <MXStore>
 {
@@ -47,4 +55,23 @@
  */
 - (MXMemoryRoomStore*)getOrCreateRoomStore:(NSString*)roomId;
 
+/**
+ Retrieve a MXMemoryRoomStore type object.
+
+ @param roomId the id for the MXMemoryRoomStore object.
+ @return the MXMemoryRoomStore instance. nil if it does not exist.
+ */
+- (MXMemoryRoomStore*)roomStoreForRoom:(NSString*)roomId;
+
+/**
+ Retrieve the read receipts of a room.
+
+ The returned dictionary must be accessed with a lock on it.
+
+ @param roomId the id of the room.
+ @param create YES to create the dictionary if it does not exist.
+ @return the receipts by user id.
+ */
+- (NSMutableDictionary*)receiptsByUserIdInRoom:(NSString*)roomId create:(BOOL)create;
+
 @end
@@ -17,17 +17,19 @@
 #import "MXMemoryStore.h"
 
 #import "MXMemoryRoomStore.h"
+#import "MXEventsEnumeratorOnArray.h"
 
 @interface MXMemoryStore()
 {
     NSString *eventStreamToken;
+    NSDate *eventStreamTokenDate;
 }
 @end
 
 
 @implementation MXMemoryStore
 
-@synthesize eventStreamToken, userAccountData;
+@synthesize eventStreamToken, eventStreamTokenDate, catchUpTokenAge, userAccountData;
 
 - (instancetype)init
 {
@@ -70,7 +72,7 @@
 
 - (MXEvent *)eventWithEventId:(NSString *)eventId inRoom:(NSString *)roomId
 {
-    MXMemoryRoomStore *roomStore = [self getOrCreateRoomStore:roomId];
+    MXMemoryRoomStore *roomStore = [self roomStoreForRoom:roomId];
     return [roomStore eventWithEventId:eventId];
 }
 
@@ -84,14 +86,42 @@
     roomStore.hasReachedHomeServerPaginationEnd = NO;
 }
 
+- (NSUInteger)removeMessagesBeforeEvent:(NSString *)eventId inRoom:(NSString *)roomId paginationToken:(NSString *)paginationToken
+{
+    MXMemoryRoomStore *roomStore = [self roomStoreForRoom:roomId];
+    NSUInteger count = [roomStore removeMessagesBeforeEvent:eventId];
+    if (count)
+    {
+        // The removed messages are back on the homeserver side
+        roomStore.paginationToken = paginationToken;
+        roomStore.hasReachedHomeServerPaginationEnd = NO;
+    }
+    return count;
+}
+
+- (void)storeStateCheckpointForRoom:(NSString *)roomId stateEvents:(NSArray<MXEvent *> *)stateEvents beforeEvent:(NSString *)eventId
+{
+    [[self roomStoreForRoom:roomId] storeStateCheckpoint:stateEvents beforeEvent:eventId];
+}
+
+- (NSArray<MXEvent *> *)stateCheckpointOfRoom:(NSString *)roomId beforeEvent:(NSString *)eventId
+{
+    return [[self roomStoreForRoom:roomId] stateCheckpointBeforeEvent:eventId];
+}
+
+- (NSArray<MXEvent *> *)stateOfRoom:(NSString *)roomId beforeEvent:(NSString *)eventId
+{
+    return [[self roomStoreForRoom:roomId] stateBeforeEvent:eventId];
+}
+
 - (void)deleteRoom:(NSString *)roomId
 {
-    if (roomStores[roomId])
+    @synchronized(roomStores)
     {
         [roomStores removeObjectForKey:roomId];
     }
-    
-    if (receiptsByRoomId[roomId])
+
+    @synchronized(receiptsByRoomId)
     {
         [receiptsByRoomId removeObjectForKey:roomId];
     }
@@ -99,7 +129,10 @@
 
 - (void)deleteAllData
 {
-    [roomStores removeAllObjects];
+    @synchronized(roomStores)
+    {
+        [roomStores removeAllObjects];
+    }
 }
 
 - (void)storePaginationTokenOfRoom:(NSString*)roomId andToken:(NSString*)token
@@ -110,7 +143,7 @@
 
 - (NSString*)paginationTokenOfRoom:(NSString*)roomId
 {
-    MXMemoryRoomStore *roomStore = [self getOrCreateRoomStore:roomId];
+    MXMemoryRoomStore *roomStore = [self roomStoreForRoom:roomId];
     return roomStore.paginationToken;
 }
 
@@ -122,7 +155,7 @@
 
 - (NSUInteger)notificationCountOfRoom:(NSString*)roomId
 {
-    MXMemoryRoomStore *roomStore = [self getOrCreateRoomStore:roomId];
+    MXMemoryRoomStore *roomStore = [self roomStoreForRoom:roomId];
     return roomStore.notificationCount;
 }
 
@@ -134,7 +167,7 @@
 
 - (NSUInteger)highlightCountOfRoom:(NSString*)roomId
 {
-    MXMemoryRoomStore *roomStore = [self getOrCreateRoomStore:roomId];
+    MXMemoryRoomStore *roomStore = [self roomStoreForRoom:roomId];
     return roomStore.highlightCount;
 }
 
@@ -146,20 +179,28 @@
 
 - (BOOL)hasReachedHomeServerPaginationEndForRoom:(NSString*)roomId
 {
-    MXMemoryRoomStore *roomStore = [self getOrCreateRoomStore:roomId];
+    MXMemoryRoomStore *roomStore = [self roomStoreForRoom:roomId];
     return roomStore.hasReachedHomeServerPaginationEnd;
 }
 
 
 - (id<MXEventsEnumerator>)messagesEnumeratorForRoom:(NSString *)roomId
 {
-    MXMemoryRoomStore *roomStore = [self getOrCreateRoomStore:roomId];
+    MXMemoryRoomStore *roomStore = [self roomStoreForRoom:roomId];
+    if (!roomStore)
+    {
+        return [[MXEventsEnumeratorOnArray alloc] initWithMessages:@[]];
+    }
     return roomStore.messagesEnumerator;
 }
 
 - (id<MXEventsEnumerator>)messagesEnumeratorForRoom:(NSString *)roomId withTypeIn:(NSArray *)types ignoreMemberProfileChanges:(BOOL)ignoreProfileChanges
 {
-    MXMemoryRoomStore *roomStore = [self getOrCreateRoomStore:roomId];
+    MXMemoryRoomStore *roomStore = [self roomStoreForRoom:roomId];
+    if (!roomStore)
+    {
+        return [[MXEventsEnumeratorOnArray alloc] initWithMessages:@[]];
+    }
     return [roomStore enumeratorForMessagesWithTypeIn:types ignoreMemberProfileChanges:ignoreProfileChanges];
 }
 
@@ -171,7 +212,7 @@
 
 - (NSString *)partialTextMessageOfRoom:(NSString *)roomId
 {
-    MXMemoryRoomStore *roomStore = [self getOrCreateRoomStore:roomId];
+    MXMemoryRoomStore *roomStore = [self roomStoreForRoom:roomId];
     return roomStore.partialTextMessage;
 }
 
@@ -179,19 +220,18 @@
 {
     NSMutableArray* receipts = [[NSMutableArray alloc] init];
     
-    NSMutableDictionary* receiptsByUserId = [receiptsByRoomId objectForKey:roomId];
+    NSMutableDictionary* receiptsByUserId = [self receiptsByUserIdInRoom:roomId create:NO];
     
     if (receiptsByUserId)
     {
-        NSArray* userIds = [[receiptsByUserId allKeys] copy];
-        
-        for(NSString* userId in userIds)
+        @synchronized (receiptsByUserId)
         {
-            MXReceiptData* receipt = [receiptsByUserId objectForKey:userId];
-            
-            if (receipt && [receipt.eventId isEqualToString:eventId])
+            for (MXReceiptData* receipt in receiptsByUserId.allValues)
             {
-                [receipts addObject:receipt];
+                if ([receipt.eventId isEqualToString:eventId])
+                {
+                    [receipts addObject:receipt];
+                }
             }
         }
     }
@@ -212,24 +252,18 @@
 
 - (BOOL)storeReceipt:(MXReceiptData*)receipt inRoom:(NSString*)roomId
 {
-    NSMutableDictionary* receiptsByUserId = [receiptsByRoomId objectForKey:roomId];
-    
-    if (!receiptsByUserId)
-    {
-        receiptsByUserId = [[NSMutableDictionary alloc] init];
-        [receiptsByRoomId setObject:receiptsByUserId forKey:roomId];
-    }
-    
-    MXReceiptData* curReceipt = [receiptsByUserId objectForKey:receipt.userId];
-    
-    // not yet defined or a new event
-    if (!curReceipt || (![receipt.eventId isEqualToString:curReceipt.eventId] && (receipt.ts > curReceipt.ts)))
+    NSMutableDictionary* receiptsByUserId = [self receiptsByUserIdInRoom:roomId create:YES];
+
+    @synchronized (receiptsByUserId)
     {
-        @synchronized (receiptsByUserId)
+        MXReceiptData* curReceipt = [receiptsByUserId objectForKey:receipt.userId];
+
+        // not yet defined or a new event
+        if (!curReceipt || (![receipt.eventId isEqualToString:curReceipt.eventId] && (receipt.ts > curReceipt.ts)))
         {
             [receiptsByUserId setObject:receipt forKey:receipt.userId];
+            return true;
         }
-        return true;
     }
     
     return false;
@@ -237,15 +271,18 @@
 
 - (MXReceiptData *)getReceiptInRoom:(NSString*)roomId forUserId:(NSString*)userId
 {
-    MXMemoryRoomStore* store = [roomStores valueForKey:roomId];
-    NSMutableDictionary* receipsByUserId = [receiptsByRoomId objectForKey:roomId];
+    MXMemoryRoomStore* store = [self roomStoreForRoom:roomId];
+    NSMutableDictionary* receipsByUserId = [self receiptsByUserIdInRoom:roomId create:NO];
     
     if (store && receipsByUserId)
     {
-        MXReceiptData* data = [receipsByUserId objectForKey:userId];
-        if (data)
+        @synchronized (receipsByUserId)
         {
-            return [data copy];
+            MXReceiptData* data = [receipsByUserId objectForKey:userId];
+            if (data)
+            {
+                return [data copy];
+            }
         }
     }
     
@@ -254,13 +291,17 @@
 
 - (NSUInteger)localUnreadEventCount:(NSString*)roomId withTypeIn:(NSArray*)types
 {
-    MXMemoryRoomStore* store = [roomStores valueForKey:roomId];
-    NSMutableDictionary* receipsByUserId = [receiptsByRoomId objectForKey:roomId];
+    MXMemoryRoomStore* store = [self roomStoreForRoom:roomId];
+    NSMutableDictionary* receipsByUserId = [self receiptsByUserIdInRoom:roomId create:NO];
     NSUInteger count = 0;
     
     if (store && receipsByUserId)
     {
-        MXReceiptData* data = [receipsByUserId objectForKey:credentials.userId];
+        MXReceiptData* data;
+        @synchronized (receipsByUserId)
+        {
+            data = [receipsByUserId objectForKey:credentials.userId];
+        }
         
         if (data)
         {
@@ -286,26 +327,44 @@
     return NO;
 }
 
+- (void)setEventStreamToken:(NSString *)eventStreamToken2
+{
+    eventStreamToken = eventStreamToken2;
+    eventStreamTokenDate = eventStreamToken2 ? [NSDate date] : nil;
+}
+
 - (NSArray *)rooms
 {
-    return roomStores.allKeys;
+    @synchronized(roomStores)
+    {
+        return roomStores.allKeys;
+    }
 }
 
 
 #pragma mark - Matrix users
 - (void)storeUser:(MXUser *)user
 {
-    users[user.userId] = user;
+    @synchronized(users)
+    {
+        users[user.userId] = user;
+    }
 }
 
 - (NSArray<MXUser *> *)users
 {
-    return users.allValues;
+    @synchronized(users)
+    {
+        return users.allValues;
+    }
 }
 
 - (MXUser *)userWithUserId:(NSString *)userId
 {
-    return users[userId];
+    @synchronized(users)
+    {
+        return users[userId];
+    }
 }
 
 
@@ -330,7 +389,7 @@
 
 - (NSArray<MXEvent*>*)outgoingMessagesInRoom:(NSString*)roomId
 {
-    MXMemoryRoomStore *roomStore = [self getOrCreateRoomStore:roomId];
+    MXMemoryRoomStore *roomStore = [self roomStoreForRoom:roomId];
     return roomStore.outgoingMessages;
 }
 
@@ -338,13 +397,38 @@
 #pragma mark - Protected operations
 - (MXMemoryRoomStore*)getOrCreateRoomStore:(NSString*)roomId
 {
-    MXMemoryRoomStore *roomStore = roomStores[roomId];
-    if (nil == roomStore)
+    @synchronized(roomStores)
+    {
+        MXMemoryRoomStore *roomStore = roomStores[roomId];
+        if (nil == roomStore)
+        {
+            roomStore = [[MXMemoryRoomStore alloc] init];
+            roomStores[roomId] = roomStore;
+        }
+        return roomStore;
+    }
+}
+
+- (MXMemoryRoomStore*)roomStoreForRoom:(NSString*)roomId
+{
+    @synchronized(roomStores)
     {
-        roomStore = [[MXMemoryRoomStore alloc] init];
-        roomStores[roomId] = roomStore;
+        return roomStores[roomId];
+    }
+}
+
+- (NSMutableDictionary*)receiptsByUserIdInRoom:(NSString*)roomId create:(BOOL)create
+{
+    @synchronized(receiptsByRoomId)
+    {
+        NSMutableDictionary *receiptsByUserId = receiptsByRoomId[roomId];
+        if (!receiptsByUserId && create)
+        {
+            receiptsByUserId = [NSMutableDictionary dictionary];
+            receiptsByRoomId[roomId] = receiptsByUserId;
+        }
+        return receiptsByUserId;
     }
-    return roomStore;
 }
 
 @end
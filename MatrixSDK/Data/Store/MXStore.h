@@ -310,6 +310,69 @@
 */
 - (MXRoomAccountData*)accountDataOfRoom:(NSString*)roomId;
 
+/**
+ Get the states and the user data of rooms asynchronously.
+
+ Stores that read them from a slow storage implement it in order not to block the main
+ thread. The result must include the data stored so far, even if it is not committed yet.
+
+ @param roomIds the ids of the rooms.
+ @param onComplete the block called on the main thread with the state events and the user
+                   data of the rooms by room id.
+ */
+- (void)asyncStatesAndAccountDataOfRooms:(NSArray<NSString*>*)roomIds
+                              onComplete:(void (^)(NSDictionary<NSString*, NSArray<MXEvent*>*> *states, NSDictionary<NSString*, MXRoomAccountData*> *accountData))onComplete;
+
+
+#pragma mark - Room state checkpoints
+/**
+ Store a snapshot of the state of a room.
+
+ Snapshots are taken periodically so that the state of the room at a stored message can be
+ rebuilt without replaying all state changes from the current state.
+
+ @param roomId the id of the room.
+ @param stateEvents the state events of the room before the message.
+ @param eventId the id of a stored message.
+ */
+- (void)storeStateCheckpointForRoom:(NSString*)roomId stateEvents:(NSArray<MXEvent*>*)stateEvents beforeEvent:(NSString*)eventId;
+
+/**
+ Get the snapshot of the state of a room stored before a message.
+
+ @param roomId the id of the room.
+ @param eventId the id of a stored message.
+ @return the state events. nil if no snapshot was stored before this message.
+ */
+- (NSArray<MXEvent*>*)stateCheckpointOfRoom:(NSString*)roomId beforeEvent:(NSString*)eventId;
+
+/**
+ Get the state of a room before a stored message.
+
+ It is rebuilt from the closest snapshot before the message and the state events stored
+ since.
+
+ @param roomId the id of the room.
+ @param eventId the id of a stored message.
+ @return the state events. nil if the state cannot be rebuilt.
+ */
+- (NSArray<MXEvent*>*)stateOfRoom:(NSString*)roomId beforeEvent:(NSString*)eventId;
+
+
+#pragma mark - History retention
+/**
+ Remove the messages of a room that are older than an event.
+
+ The pagination token of the room is replaced so that the removed messages can be
+ paginated again from the homeserver.
+
+ @param eventId the id of the oldest event to keep.
+ @param roomId the id of the room.
+ @param paginationToken the token to paginate back from the event on the homeserver.
+ @return the number of removed messages.
+ */
+- (NSUInteger)removeMessagesBeforeEvent:(NSString*)eventId inRoom:(NSString*)roomId paginationToken:(NSString*)paginationToken;
+
 
 #pragma mark - Outgoing events
 /**
@@ -348,4 +411,16 @@
  */
 @property (nonatomic) NSDictionary *userAccountData;
 
+/**
+ The date when `eventStreamToken` was last changed, ie the date of the last server sync.
+ The session uses it to detect a stale token.
+ */
+@property (nonatomic, readonly) NSDate *eventStreamTokenDate;
+
+/**
+ The age of the events stream token from which the session catches up, as adapted by the
+ session to the size of the /sync responses. 0 if it has not been adapted.
+ */
+@property (nonatomic) NSTimeInterval catchUpTokenAge;
+
 @end
\ No newline at end of file
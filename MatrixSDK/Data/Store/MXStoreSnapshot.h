@@ -0,0 +1,71 @@
+/*
+ Copyright 2016 OpenMarket Ltd
+
+ Licensed under the Apache License, Version 2.0 (the "License");
+ you may not use this file except in compliance with the License.
+ You may obtain a copy of the License at
+
+ http://www.apache.org/licenses/LICENSE-2.0
+
+ Unless required by applicable law or agreed to in writing, software
+ distributed under the License is distributed on an "AS IS" BASIS,
+ WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ See the License for the specific language governing permissions and
+ limitations under the License.
+ */
+
+#import <Foundation/Foundation.h>
+
+#import "MXStore.h"
+
+/**
+ The error domain of `MXStoreSnapshot` errors.
+ */
+FOUNDATION_EXPORT NSString *const kMXStoreSnapshotErrorDomain;
+
+/**
+ `MXStoreSnapshot` exports the content of a `MXStore` to a single file and imports it into
+ another store.
+
+ A snapshot contains the events stream token, the user account data, the users and, for
+ each room, its state, messages, pagination data, unread counts, account data, receipts
+ and outgoing messages. It is a keyed archive of the SDK model objects.
+
+ Importing a snapshot is much faster than an initial sync: it can be used to provision a
+ new device, to reproduce the data of an account or as fixture for the benchmarks.
+
+ The data is read from and written to the store on the main thread, which is the store
+ writer thread: an export is a consistent view of the store, including the data not
+ committed yet. Room states and account data are read without blocking the main thread
+ when the store supports `[MXStore asyncStatesAndAccountDataOfRooms:onComplete:]`.
+ The file is written and read on a background thread.
+ */
+@interface MXStoreSnapshot : NSObject
+
+/**
+ Export the content of a store into a file.
+
+ @param store the store to export. It must be open.
+ @param file the path of the file to create. An existing file is overwritten.
+ @param success A block object called when the operation succeeds.
+ @param failure A block object called when the operation fails.
+ */
++ (void)exportStore:(id<MXStore>)store toFile:(NSString*)file
+            success:(void (^)())success
+            failure:(void (^)(NSError *error))failure;
+
+/**
+ Import a snapshot file into a store.
+
+ The store must be open and empty. The imported data is committed.
+
+ @param file the path of the snapshot file.
+ @param store the store to fill.
+ @param success A block object called when the operation succeeds.
+ @param failure A block object called when the operation fails.
+ */
++ (void)importFile:(NSString*)file intoStore:(id<MXStore>)store
+           success:(void (^)())success
+           failure:(void (^)(NSError *error))failure;
+
+@end
@@ -0,0 +1,364 @@
+/*
+ Copyright 2016 OpenMarket Ltd
+
+ Licensed under the Apache License, Version 2.0 (the "License");
+ you may not use this file except in compliance with the License.
+ You may obtain a copy of the License at
+
+ http://www.apache.org/licenses/LICENSE-2.0
+
+ Unless required by applicable law or agreed to in writing, software
+ distributed under the License is distributed on an "AS IS" BASIS,
+ WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ See the License for the specific language governing permissions and
+ limitations under the License.
+ */
+
+#import "MXStoreSnapshot.h"
+
+#import "MXReceiptData.h"
+#import "MXRoomAccountData.h"
+
+NSString *const kMXStoreSnapshotErrorDomain = @"kMXStoreSnapshotErrorDomain";
+
+/**
+ The version of the snapshot format.
+ */
+#define MXSTORESNAPSHOT_VERSION 1
+
+/**
+ Snapshot keys.
+ */
+static NSString *const kMXStoreSnapshotVersionKey = @"version";
+static NSString *const kMXStoreSnapshotEventStreamTokenKey = @"eventStreamToken";
+static NSString *const kMXStoreSnapshotUserAccountDataKey = @"userAccountData";
+static NSString *const kMXStoreSnapshotUsersKey = @"users";
+static NSString *const kMXStoreSnapshotRoomsKey = @"rooms";
+
+/**
+ Room keys.
+ */
+static NSString *const kMXStoreSnapshotRoomStateKey = @"state";
+static NSString *const kMXStoreSnapshotRoomMessagesKey = @"messages";
+static NSString *const kMXStoreSnapshotRoomPaginationTokenKey = @"paginationToken";
+static NSString *const kMXStoreSnapshotRoomHasReachedHomeServerPaginationEndKey = @"hasReachedHomeServerPaginationEnd";
+static NSString *const kMXStoreSnapshotRoomNotificationCountKey = @"notificationCount";
+static NSString *const kMXStoreSnapshotRoomHighlightCountKey = @"highlightCount";
+static NSString *const kMXStoreSnapshotRoomPartialTextMessageKey = @"partialTextMessage";
+static NSString *const kMXStoreSnapshotRoomAccountDataKey = @"accountData";
+static NSString *const kMXStoreSnapshotRoomReceiptsKey = @"receipts";
+static NSString *const kMXStoreSnapshotRoomOutgoingMessagesKey = @"outgoingMessages";
+
+
+@implementation MXStoreSnapshot
+
++ (void)exportStore:(id<MXStore>)store toFile:(NSString *)file success:(void (^)())success failure:(void (^)(NSError *))failure
+{
+    NSDate *startDate = [NSDate date];
+
+    [MXStoreSnapshot snapshotOfStore:store onComplete:^(NSDictionary *snapshot) {
+
+        NSLog(@"[MXStoreSnapshot] Exported %tu rooms in %.0fms", [snapshot[kMXStoreSnapshotRoomsKey] count], [[NSDate date] timeIntervalSinceDate:startDate] * 1000);
+
+        dispatch_async(dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_DEFAULT, 0), ^{
+
+            BOOL saved = [NSKeyedArchiver archiveRootObject:snapshot toFile:file];
+
+            dispatch_async(dispatch_get_main_queue(), ^{
+
+                if (saved)
+                {
+                    NSLog(@"[MXStoreSnapshot] Snapshot saved to %@ in %.0fms", file, [[NSDate date] timeIntervalSinceDate:startDate] * 1000);
+                    if (success)
+                    {
+                        success();
+                    }
+                }
+                else if (failure)
+                {
+                    failure([NSError errorWithDomain:kMXStoreSnapshotErrorDomain code:0 userInfo:@{
+                                                                                                 NSLocalizedDescriptionKey: [NSString stringWithFormat:@"Cannot write the snapshot to %@", file]
+                                                                                                 }]);
+                }
+            });
+        });
+    }];
+}
+
++ (void)importFile:(NSString *)file intoStore:(id<MXStore>)store success:(void (^)())success failure:(void (^)(NSError *))failure
+{
+    NSDate *startDate = [NSDate date];
+
+    dispatch_async(dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_DEFAULT, 0), ^{
+
+        NSDictionary *snapshot;
+        @try
+        {
+            snapshot = [NSKeyedUnarchiver unarchiveObjectWithFile:file];
+        }
+        @catch (NSException *exception)
+        {
+            NSLog(@"[MXStoreSnapshot] Warning: the snapshot %@ is corrupted", file);
+        }
+
+        dispatch_async(dispatch_get_main_queue(), ^{
+
+            if (![snapshot isKindOfClass:NSDictionary.class] || [snapshot[kMXStoreSnapshotVersionKey] unsignedIntegerValue] != MXSTORESNAPSHOT_VERSION)
+            {
+                if (failure)
+                {
+                    failure([NSError errorWithDomain:kMXStoreSnapshotErrorDomain code:0 userInfo:@{
+                                                                                                 NSLocalizedDescriptionKey: [NSString stringWithFormat:@"Invalid snapshot file %@", file]
+                                                                                                 }]);
+                }
+                return;
+            }
+
+            [MXStoreSnapshot loadSnapshot:snapshot intoStore:store];
+
+            NSLog(@"[MXStoreSnapshot] Imported %tu rooms from %@ in %.0fms", [snapshot[kMXStoreSnapshotRoomsKey] count], file, [[NSDate date] timeIntervalSinceDate:startDate] * 1000);
+
+            if (success)
+            {
+                success();
+            }
+        });
+    });
+}
+
+
+#pragma mark - Private methods
+/**
+ Build the snapshot of a store.
+
+ The data in memory is read at once on the main thread. The states and the account data
+ of rooms are read without blocking it if the store supports it.
+
+ @param store the store to export.
+ @param onComplete the block called on the main thread with the snapshot.
+ */
++ (void)snapshotOfStore:(id<MXStore>)store onComplete:(void (^)(NSDictionary *snapshot))onComplete
+{
+    NSMutableDictionary *snapshot = [NSMutableDictionary dictionary];
+    snapshot[kMXStoreSnapshotVersionKey] = @(MXSTORESNAPSHOT_VERSION);
+
+    if (store.eventStreamToken)
+    {
+        snapshot[kMXStoreSnapshotEventStreamTokenKey] = store.eventStreamToken;
+    }
+    if ([store respondsToSelector:@selector(userAccountData)] && store.userAccountData)
+    {
+        snapshot[kMXStoreSnapshotUserAccountDataKey] = store.userAccountData;
+    }
+
+    NSArray<MXUser*> *users = store.users ?: @[];
+    snapshot[kMXStoreSnapshotUsersKey] = users;
+    NSArray<NSString*> *knownUserIds = [users valueForKey:@"userId"];
+
+    NSMutableDictionary<NSString*, NSMutableDictionary*> *rooms = [NSMutableDictionary dictionary];
+    NSArray<NSString*> *roomIds = [store respondsToSelector:@selector(rooms)] ? store.rooms : @[];
+    for (NSString *roomId in roomIds)
+    {
+        @autoreleasepool
+        {
+            NSMutableDictionary *room = [NSMutableDictionary dictionary];
+
+            id<MXEventsEnumerator> enumerator = [store messagesEnumeratorForRoom:roomId];
+            NSArray<MXEvent*> *messages = [enumerator nextEventsBatch:enumerator.remaining] ?: @[];
+            room[kMXStoreSnapshotRoomMessagesKey] = messages;
+
+            NSString *paginationToken = [store paginationTokenOfRoom:roomId];
+            if (paginationToken)
+            {
+                room[kMXStoreSnapshotRoomPaginationTokenKey] = paginationToken;
+            }
+            room[kMXStoreSnapshotRoomHasReachedHomeServerPaginationEndKey] = @([store hasReachedHomeServerPaginationEndForRoom:roomId]);
+            room[kMXStoreSnapshotRoomNotificationCountKey] = @([store notificationCountOfRoom:roomId]);
+            room[kMXStoreSnapshotRoomHighlightCountKey] = @([store highlightCountOfRoom:roomId]);
+
+            NSString *partialTextMessage = [store partialTextMessageOfRoom:roomId];
+            if (partialTextMessage)
+            {
+                room[kMXStoreSnapshotRoomPartialTextMessageKey] = partialTextMessage;
+            }
+
+            // The store cannot list the receipts of a room: look for the receipts of
+            // the users who may have one
+            NSMutableSet<NSString*> *userIds = [NSMutableSet setWithArray:knownUserIds];
+            for (MXEvent *event in messages)
+            {
+                if (event.sender)
+                {
+                    [userIds addObject:event.sender];
+                }
+            }
+            room[kMXStoreSnapshotRoomReceiptsKey] = [MXStoreSnapshot receiptsInRoom:roomId ofUsers:userIds inStore:store];
+
+            if ([store respondsToSelector:@selector(outgoingMessagesInRoom:)])
+            {
+                NSArray<MXEvent*> *outgoingMessages = [store outgoingMessagesInRoom:roomId];
+                if (outgoingMessages.count)
+                {
+                    room[kMXStoreSnapshotRoomOutgoingMessagesKey] = outgoingMessages;
+                }
+            }
+
+            rooms[roomId] = room;
+        }
+    }
+    snapshot[kMXStoreSnapshotRoomsKey] = rooms;
+
+    if ([store respondsToSelector:@selector(asyncStatesAndAccountDataOfRooms:onComplete:)])
+    {
+        [store asyncStatesAndAccountDataOfRooms:roomIds onComplete:^(NSDictionary<NSString *,NSArray<MXEvent *> *> *states, NSDictionary<NSString *,MXRoomAccountData *> *accountData) {
+
+            [MXStoreSnapshot addStates:states andAccountData:accountData toRooms:rooms ofStore:store];
+            onComplete(snapshot);
+        }];
+    }
+    else
+    {
+        NSMutableDictionary<NSString*, NSArray<MXEvent*>*> *states = [NSMutableDictionary dictionary];
+        NSMutableDictionary<NSString*, MXRoomAccountData*> *accountData = [NSMutableDictionary dictionary];
+        for (NSString *roomId in roomIds)
+        {
+            if ([store respondsToSelector:@selector(stateOfRoom:)])
+            {
+                states[roomId] = [store stateOfRoom:roomId];
+            }
+            if ([store respondsToSelector:@selector(accountDataOfRoom:)])
+            {
+                accountData[roomId] = [store accountDataOfRoom:roomId];
+            }
+        }
+
+        [MXStoreSnapshot addStates:states andAccountData:accountData toRooms:rooms ofStore:store];
+        onComplete(snapshot);
+    }
+}
+
+/**
+ Complete the rooms of a snapshot with their states and account data.
+
+ The receipts of the room members are added too.
+ */
++ (void)addStates:(NSDictionary<NSString*, NSArray<MXEvent*>*>*)states andAccountData:(NSDictionary<NSString*, MXRoomAccountData*>*)accountData toRooms:(NSDictionary<NSString*, NSMutableDictionary*>*)rooms ofStore:(id<MXStore>)store
+{
+    for (NSString *roomId in rooms)
+    {
+        NSMutableDictionary *room = rooms[roomId];
+
+        NSArray<MXEvent*> *stateEvents = states[roomId];
+        if (stateEvents)
+        {
+            room[kMXStoreSnapshotRoomStateKey] = stateEvents;
+
+            NSMutableSet<NSString*> *memberIds = [NSMutableSet set];
+            for (MXEvent *event in stateEvents)
+            {
+                if (event.eventType == MXEventTypeRoomMember && event.stateKey)
+                {
+                    [memberIds addObject:event.stateKey];
+                }
+            }
+
+            NSArray<MXReceiptData*> *receipts = room[kMXStoreSnapshotRoomReceiptsKey];
+            [memberIds minusSet:[NSSet setWithArray:[receipts valueForKey:@"userId"]]];
+            if (memberIds.count)
+            {
+                room[kMXStoreSnapshotRoomReceiptsKey] = [receipts arrayByAddingObjectsFromArray:[MXStoreSnapshot receiptsInRoom:roomId ofUsers:memberIds inStore:store]];
+            }
+        }
+
+        if (accountData[roomId])
+        {
+            room[kMXStoreSnapshotRoomAccountDataKey] = accountData[roomId];
+        }
+    }
+}
+
++ (NSArray<MXReceiptData*>*)receiptsInRoom:(NSString*)roomId ofUsers:(NSSet<NSString*>*)userIds inStore:(id<MXStore>)store
+{
+    NSMutableArray<MXReceiptData*> *receipts = [NSMutableArray array];
+    for (NSString *userId in userIds)
+    {
+        MXReceiptData *receipt = [store getReceiptInRoom:roomId forUserId:userId];
+        if (receipt)
+        {
+            [receipts addObject:receipt];
+        }
+    }
+    return receipts;
+}
+
++ (void)loadSnapshot:(NSDictionary*)snapshot intoStore:(id<MXStore>)store
+{
+    NSDictionary<NSString*, NSDictionary*> *rooms = snapshot[kMXStoreSnapshotRoomsKey];
+    for (NSString *roomId in rooms)
+    {
+        @autoreleasepool
+        {
+            NSDictionary *room = rooms[roomId];
+
+            NSArray<MXEvent*> *stateEvents = room[kMXStoreSnapshotRoomStateKey];
+            if (stateEvents && [store respondsToSelector:@selector(storeStateForRoom:stateEvents:)])
+            {
+                [store storeStateForRoom:roomId stateEvents:stateEvents];
+            }
+
+            for (MXEvent *event in room[kMXStoreSnapshotRoomMessagesKey])
+            {
+                [store storeEventForRoom:roomId event:event direction:MXTimelineDirectionForwards];
+            }
+
+            [store storePaginationTokenOfRoom:roomId andToken:room[kMXStoreSnapshotRoomPaginationTokenKey]];
+            [store storeHasReachedHomeServerPaginationEndForRoom:roomId andValue:[room[kMXStoreSnapshotRoomHasReachedHomeServerPaginationEndKey] boolValue]];
+            [store storeNotificationCountOfRoom:roomId count:[room[kMXStoreSnapshotRoomNotificationCountKey] unsignedIntegerValue]];
+            [store storeHighlightCountOfRoom:roomId count:[room[kMXStoreSnapshotRoomHighlightCountKey] unsignedIntegerValue]];
+
+            NSString *partialTextMessage = room[kMXStoreSnapshotRoomPartialTextMessageKey];
+            if (partialTextMessage)
+            {
+                [store storePartialTextMessageForRoom:roomId partialTextMessage:partialTextMessage];
+            }
+
+            MXRoomAccountData *accountData = room[kMXStoreSnapshotRoomAccountDataKey];
+            if (accountData && [store respondsToSelector:@selector(storeAccountDataForRoom:userData:)])
+            {
+                [store storeAccountDataForRoom:roomId userData:accountData];
+            }
+
+            for (MXReceiptData *receipt in room[kMXStoreSnapshotRoomReceiptsKey])
+            {
+                [store storeReceipt:receipt inRoom:roomId];
+            }
+
+            if ([store respondsToSelector:@selector(storeOutgoingMessageForRoom:outgoingMessage:)])
+            {
+                for (MXEvent *outgoingMessage in room[kMXStoreSnapshotRoomOutgoingMessagesKey])
+                {
+                    [store storeOutgoingMessageForRoom:roomId outgoingMessage:outgoingMessage];
+                }
+            }
+        }
+    }
+
+    for (MXUser *user in snapshot[kMXStoreSnapshotUsersKey])
+    {
+        [store storeUser:user];
+    }
+
+    if ([store respondsToSelector:@selector(setUserAccountData:)] && snapshot[kMXStoreSnapshotUserAccountDataKey])
+    {
+        store.userAccountData = snapshot[kMXStoreSnapshotUserAccountDataKey];
+    }
+
+    store.eventStreamToken = snapshot[kMXStoreSnapshotEventStreamTokenKey];
+
+    if ([store respondsToSelector:@selector(commit)])
+    {
+        [store commit];
+    }
+}
+
+@end
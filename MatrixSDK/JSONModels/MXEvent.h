@@ -16,6 +16,8 @@
 
 #import "MXJSONModel.h"
 
+@class MXEventSenderProfile;
+
 /**
  Types of Matrix events
  
@@ -212,6 +214,14 @@ FOUNDATION_EXPORT uint64_t const kMXUndefinedTimestamp;
  */
 @property (nonatomic) NSArray<MXEvent *> *inviteRoomState;
 
+/**
+ The profile of the sender in the room at the time of the event.
+
+ It is set by `MXEventTimeline` when the event is added to a timeline if
+ `[MXSDKOptions enableEventSenderProfileDecoration]` is YES. It is not stored.
+ */
+@property (nonatomic) MXEventSenderProfile *senderProfile;
+
 /**
  The enum version of the event type.
  */
@@ -17,6 +17,8 @@
 #import "MXEvent.h"
 
 #import "MXTools.h"
+#import "MXSDKOptions.h"
+#import "MXEventContentPool.h"
 
 #pragma mark - Constants definitions
 
@@ -160,6 +162,21 @@ uint64_t const kMXUndefinedTimestamp = (uint64_t)-1;
     // Clean JSON data by removing all null values
     _content = [MXJSONModel removeNullValuesInJSON:_content];
     _prevContent = [MXJSONModel removeNullValuesInJSON:_prevContent];
+
+    [self internContents];
+}
+
+/**
+ Share the content dictionaries with other events having the same ones, if enabled.
+ */
+- (void)internContents
+{
+    if ([MXSDKOptions sharedInstance].enableEventContentDeduplication)
+    {
+        MXEventContentPool *pool = [MXEventContentPool sharedPool];
+        _content = [pool internContent:_content];
+        _prevContent = [pool internContent:_prevContent];
+    }
 }
 
 - (MXEventType)eventType
@@ -492,6 +509,8 @@ uint64_t const kMXUndefinedTimestamp = (uint64_t)-1;
         _redacts = [aDecoder decodeObjectForKey:@"redacts"];
         _redactedBecause = [aDecoder decodeObjectForKey:@"redactedBecause"];
         _inviteRoomState = [aDecoder decodeObjectForKey:@"inviteRoomState"];
+
+        [self internContents];
     }
     return self;
 }
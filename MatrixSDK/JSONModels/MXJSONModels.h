@@ -87,6 +87,33 @@ FOUNDATION_EXPORT NSString *const kMX3PIDMediumMSISDN;
 
 @end
 
+/**
+ `MXPublicRoomsResponse` represents a page of the public room directory.
+ */
+@interface MXPublicRoomsResponse : MXJSONModel
+
+    /**
+     The public rooms of the page.
+     */
+    @property (nonatomic) NSArray<MXPublicRoom*> *chunk;
+
+    /**
+     The token to get the next page. nil if there are no more rooms.
+     */
+    @property (nonatomic) NSString *nextBatch;
+
+    /**
+     The token to get the previous page. nil if this is the first page.
+     */
+    @property (nonatomic) NSString *prevBatch;
+
+    /**
+     An estimate of the total number of public rooms, if the server has an estimate.
+     */
+    @property (nonatomic) NSUInteger totalRoomCountEstimate;
+
+@end
+
 
 /**
  Login flow types
@@ -494,6 +521,13 @@ typedef enum : NSUInteger
      */
     @property (nonatomic) NSString *scope;
 
+    /**
+     The hash of the JSON content the rule has been built from.
+     Two rules with the same id and the same content hash are identical on the home server.
+     It is nil once the rule has been changed locally.
+     */
+    @property (nonatomic, readonly) NSString *contentHash;
+
     /**
      Override [MXJSONModel modelsFromJSON] by adding scope and kind to all decoded `MXPushRule` objects.
 
@@ -678,6 +712,18 @@ FOUNDATION_EXPORT NSString *const kMXPushRuleScopeStringDevice;
      */
     @property (nonatomic) MXPushRulesSet *global;
 
+    /**
+     The hash of the JSON content sent by the home server.
+     It is computed on first access, and it is nil once the rules have been changed locally.
+     */
+    @property (nonatomic, readonly) NSString *contentHash;
+
+    /**
+     Forget the JSON content and its hash after a local change of the rules.
+     The next rules sent by the home server are then never considered as unchanged.
+     */
+    - (void)invalidateContentHash;
+
 @end
 
 
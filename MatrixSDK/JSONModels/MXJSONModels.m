@@ -67,6 +67,24 @@
 }
 @end
 
+@implementation MXPublicRoomsResponse
+
++ (id)modelFromJSON:(NSDictionary *)JSONDictionary
+{
+    MXPublicRoomsResponse *publicRoomsResponse = [[MXPublicRoomsResponse alloc] init];
+    if (publicRoomsResponse)
+    {
+        MXJSONModelSetMXJSONModelArray(publicRoomsResponse.chunk, MXPublicRoom, JSONDictionary[@"chunk"]);
+        MXJSONModelSetString(publicRoomsResponse.nextBatch, JSONDictionary[@"next_batch"]);
+        MXJSONModelSetString(publicRoomsResponse.prevBatch, JSONDictionary[@"prev_batch"]);
+        MXJSONModelSetUInteger(publicRoomsResponse.totalRoomCountEstimate, JSONDictionary[@"total_room_count_estimate"]);
+    }
+
+    return publicRoomsResponse;
+}
+
+@end
+
 
 NSString *const kMXLoginFlowTypePassword = @"m.login.password";
 NSString *const kMXLoginFlowTypeOAuth2 = @"m.login.oauth2";
@@ -440,6 +458,17 @@ NSString *const kMXPushRuleConditionStringRoomMemberCount       = @"room_member_
     return pushRules;
 }
 
+- (void)setEnabled:(BOOL)enabled
+{
+    if (enabled != _enabled)
+    {
+        _enabled = enabled;
+
+        // The rule no more matches the JSON content it has been built from
+        _contentHash = nil;
+    }
+}
+
 + (id)modelFromJSON:(NSDictionary *)JSONDictionary
 {
     MXPushRule *pushRule = [[MXPushRule alloc] init];
@@ -451,6 +480,8 @@ NSString *const kMXPushRuleConditionStringRoomMemberCount       = @"room_member_
         MXJSONModelSetString(pushRule.pattern, JSONDictionary[@"pattern"]);
         MXJSONModelSetMXJSONModelArray(pushRule.conditions, MXPushRuleCondition, JSONDictionary[@"conditions"]);
 
+        pushRule->_contentHash = [MXTools contentHashOfJSON:JSONDictionary];
+
         // Decode actions
         NSMutableArray *actions = [NSMutableArray array];
         for (NSObject *rawAction in JSONDictionary[@"actions"])
@@ -613,6 +644,7 @@ NSString *const kMXPushRuleConditionStringRoomMemberCount       = @"room_member_
 }
 @end
 @implementation MXPushRulesResponse
+@synthesize contentHash = _contentHash;
 
 NSString *const kMXPushRuleScopeStringGlobal = @"global";
 NSString *const kMXPushRuleScopeStringDevice = @"device";
@@ -640,6 +672,21 @@ NSString *const kMXPushRuleScopeStringDevice = @"device";
     return JSONDictionary;
 }
 
+- (NSString *)contentHash
+{
+    if (!_contentHash && JSONDictionary)
+    {
+        _contentHash = [MXTools contentHashOfJSON:JSONDictionary];
+    }
+    return _contentHash;
+}
+
+- (void)invalidateContentHash
+{
+    JSONDictionary = nil;
+    _contentHash = nil;
+}
+
 @end
 
 
@@ -1211,9 +1258,36 @@ NSString *const kMXPushRuleScopeStringDevice = @"device";
     NSUInteger ttl = 0;
     if (-1 != _ttlExpirationLocalTs)
     {
-        ttl = (NSUInteger)(_ttlExpirationLocalTs / 1000 - (uint64_t)[[NSDate date] timeIntervalSince1970]);
+        uint64_t now = (uint64_t)[[NSDate date] timeIntervalSince1970];
+        if (_ttlExpirationLocalTs / 1000 > now)
+        {
+            ttl = (NSUInteger)(_ttlExpirationLocalTs / 1000 - now);
+        }
     }
     return ttl;
 }
 
+
+#pragma mark - NSCoding
+- (instancetype)initWithCoder:(NSCoder *)aDecoder
+{
+    self = [super init];
+    if (self)
+    {
+        _username = [aDecoder decodeObjectForKey:@"username"];
+        _password = [aDecoder decodeObjectForKey:@"password"];
+        _uris = [aDecoder decodeObjectForKey:@"uris"];
+        _ttlExpirationLocalTs = [((NSNumber*)[aDecoder decodeObjectForKey:@"ttlExpirationLocalTs"]) unsignedLongLongValue];
+    }
+    return self;
+}
+
+- (void)encodeWithCoder:(NSCoder *)aCoder
+{
+    [aCoder encodeObject:_username forKey:@"username"];
+    [aCoder encodeObject:_password forKey:@"password"];
+    [aCoder encodeObject:_uris forKey:@"uris"];
+    [aCoder encodeObject:@(_ttlExpirationLocalTs) forKey:@"ttlExpirationLocalTs"];
+}
+
 @end
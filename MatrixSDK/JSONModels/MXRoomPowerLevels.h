@@ -18,6 +18,46 @@
 
 #import "MXEvent.h"
 
+/**
+ The actions a room member can do according to his power level.
+ The values can be combined as a bitmask.
+ */
+typedef enum : NSUInteger
+{
+    MXRoomCapabilityNone = 0,
+
+    /**
+     Invite users.
+     */
+    MXRoomCapabilityInvite = 1 << 0,
+
+    /**
+     Kick members.
+     */
+    MXRoomCapabilityKick = 1 << 1,
+
+    /**
+     Ban users.
+     */
+    MXRoomCapabilityBan = 1 << 2,
+
+    /**
+     Redact events of other members.
+     */
+    MXRoomCapabilityRedact = 1 << 3,
+
+    /**
+     Send events with a type not listed in `events` as messages.
+     */
+    MXRoomCapabilitySendMessage = 1 << 4,
+
+    /**
+     Send events with a type not listed in `events` as state events.
+     */
+    MXRoomCapabilitySendStateEvent = 1 << 5
+
+} MXRoomCapability;
+
 /**
  `MXRoomPowerLevels` represents the content of a m.room.power_levels event.
 
@@ -51,16 +91,19 @@
 #pragma mark - minimum power level for actions
 /**
  The minimum power level to ban someone.
+ Default is 50.
  */
 @property (nonatomic) NSInteger ban;
 
 /**
  The minimum power level to kick someone.
+ Default is 50.
  */
 @property (nonatomic) NSInteger kick;
 
 /**
  The minimum power level to redact an event.
+ Default is 50.
  */
 @property (nonatomic) NSInteger redact;
 
@@ -107,4 +150,14 @@
  */
 - (NSInteger)minimumPowerLevelForSendingEventAsStateEvent:(MXEventTypeString)eventTypeString;
 
+
+#pragma mark - Capabilities
+/**
+ Get the actions allowed by a power level.
+
+ @param powerLevel the power level.
+ @return a bitmask of MXRoomCapability values.
+ */
+- (MXRoomCapability)capabilitiesForPowerLevel:(NSInteger)powerLevel;
+
 @end
@@ -90,6 +90,11 @@
         // If the room contains no power_levels event, the state_default is 0. The events_default is 0 in either of these cases.
         _eventsDefault = 0;
         _stateDefault = 0;
+
+        // ban, kick and redact levels are 50 when they are not specified
+        _ban = 50;
+        _kick = 50;
+        _redact = 50;
     }
     return self;
 }
@@ -148,6 +153,38 @@
     return minimumPowerLevel;
 }
 
+- (MXRoomCapability)capabilitiesForPowerLevel:(NSInteger)powerLevel
+{
+    MXRoomCapability capabilities = MXRoomCapabilityNone;
+
+    if (powerLevel >= _invite)
+    {
+        capabilities |= MXRoomCapabilityInvite;
+    }
+    if (powerLevel >= _kick)
+    {
+        capabilities |= MXRoomCapabilityKick;
+    }
+    if (powerLevel >= _ban)
+    {
+        capabilities |= MXRoomCapabilityBan;
+    }
+    if (powerLevel >= _redact)
+    {
+        capabilities |= MXRoomCapabilityRedact;
+    }
+    if (powerLevel >= _eventsDefault)
+    {
+        capabilities |= MXRoomCapabilitySendMessage;
+    }
+    if (powerLevel >= _stateDefault)
+    {
+        capabilities |= MXRoomCapabilitySendStateEvent;
+    }
+
+    return capabilities;
+}
+
 - (NSDictionary *)JSONDictionary
 {
     NSMutableDictionary *JSONDictionary = [NSMutableDictionary dictionary];
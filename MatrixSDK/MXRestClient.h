@@ -15,7 +15,7 @@
  */
 
 #import <Foundation/Foundation.h>
-#import <UIKit/UIKit.h>
+#import <CoreGraphics/CoreGraphics.h>
 
 #import "MXHTTPClient.h"
 #import "MXEvent.h"
@@ -1261,6 +1261,14 @@ typedef enum : NSUInteger
                            success:(void (^)(MXSyncResponse *syncResponse))success
                            failure:(void (^)(NSError *error))failure;
 
+/**
+ Open a connection to the home server in advance so that the next /sync request does not
+ pay the DNS, TCP and TLS setup.
+
+ Nothing is done if the connection is probably still open.
+ */
+- (void)prewarmConnection;
+
 
 #pragma mark - Directory operations
 /**
@@ -1274,6 +1282,25 @@ typedef enum : NSUInteger
 - (MXHTTPOperation*)publicRooms:(void (^)(NSArray *rooms))success
                         failure:(void (^)(NSError *error))failure;
 
+/**
+ Get a page of the list of public rooms hosted by the home server.
+
+ @param limit the max number of rooms to return. 0 means no limit.
+ @param since the pagination token returned in a previous response. nil for the first page.
+ @param searchTerm a text to filter rooms on the server side (name, topic, aliases). Can be nil.
+
+ @param success A block object called when the operation succeeds. It provides the page of
+                public rooms.
+ @param failure A block object called when the operation fails.
+
+ @return a MXHTTPOperation instance.
+ */
+- (MXHTTPOperation*)publicRoomsWithLimit:(NSUInteger)limit
+                                   since:(NSString*)since
+                              searchTerm:(NSString*)searchTerm
+                                 success:(void (^)(MXPublicRoomsResponse *publicRoomsResponse))success
+                                 failure:(void (^)(NSError *error))failure;
+
 /**
  Get the room ID corresponding to this room alias
 
@@ -16,6 +16,10 @@
 
 #import "MXRestClient.h"
 
+#if TARGET_OS_IPHONE
+#import <UIKit/UIKit.h>
+#endif
+
 #import "MXJSONModel.h"
 #import "MXTools.h"
 #import "MXError.h"
@@ -2449,6 +2453,12 @@ MXAuthAction;
     return operation;
 }
 
+- (void)prewarmConnection
+{
+    // Use the cheapest request of the client-server API
+    [httpClient prewarmConnectionWithPath:@"/_matrix/client/versions"];
+}
+
 
 #pragma mark - read receipts
 - (MXHTTPOperation*)sendReadReceipts:(NSString*)roomId
@@ -2517,6 +2527,64 @@ MXAuthAction;
                                  }];
 }
 
+- (MXHTTPOperation*)publicRoomsWithLimit:(NSUInteger)limit
+                                   since:(NSString*)since
+                              searchTerm:(NSString*)searchTerm
+                                 success:(void (^)(MXPublicRoomsResponse *publicRoomsResponse))success
+                                 failure:(void (^)(NSError *error))failure
+{
+    NSMutableDictionary *parameters = [NSMutableDictionary dictionary];
+    if (limit)
+    {
+        parameters[@"limit"] = @(limit);
+    }
+    if (since)
+    {
+        parameters[@"since"] = since;
+    }
+
+    // The filter is only supported by the POST version of the API, which requires
+    // an access token. Use GET when possible.
+    NSString *httpMethod = @"GET";
+    if (searchTerm.length)
+    {
+        httpMethod = @"POST";
+        parameters[@"filter"] = @{
+                                  @"generic_search_term": searchTerm
+                                  };
+    }
+
+    return [httpClient requestWithMethod:httpMethod
+                                    path:[NSString stringWithFormat:@"%@/publicRooms", apiPathPrefix]
+                              parameters:parameters
+                                 success:^(NSDictionary *JSONResponse) {
+                                     if (success)
+                                     {
+                                         @autoreleasepool
+                                         {
+                                             // Create the page from JSON on processing queue
+                                             dispatch_async(processingQueue, ^{
+
+                                                 MXPublicRoomsResponse *publicRoomsResponse = [MXPublicRoomsResponse modelFromJSON:JSONResponse];
+
+                                                 dispatch_async(dispatch_get_main_queue(), ^{
+
+                                                     success(publicRoomsResponse);
+
+                                                 });
+
+                                             });
+                                         }
+                                     }
+                                 }
+                                 failure:^(NSError *error) {
+                                     if (failure)
+                                     {
+                                         failure(error);
+                                     }
+                                 }];
+}
+
 - (MXHTTPOperation*)roomIDForRoomAlias:(NSString*)roomAlias
                                success:(void (^)(NSString *roomId))success
                                failure:(void (^)(NSError *error))failure
@@ -2614,7 +2682,12 @@ MXAuthAction;
     if ([mxcContentURI hasPrefix:kMXContentUriScheme])
     {
         // Convert first the provided size in pixels
+#if TARGET_OS_IPHONE
         CGFloat scale = [[UIScreen mainScreen] scale];
+#else
+        // There is no screen in a headless process: sizes are in pixels
+        CGFloat scale = 1;
+#endif
         CGSize sizeInPixels = CGSizeMake(viewSize.width * scale, viewSize.height * scale);
         
         // Replace the "mxc://" scheme by the absolute http location for the content thumbnail
@@ -14,6 +14,9 @@
  limitations under the License.
  */
 
+@protocol MXJSONResponseParser;
+@protocol MXBackgroundModeHandler;
+
 @interface MXSDKOptions : NSObject
 
 + (MXSDKOptions *)sharedInstance;
@@ -26,4 +29,41 @@
  */
 @property (nonatomic) BOOL disableIdenticonUseForUserAvatar;
 
+/**
+ Share identical event contents between MXEvent instances.
+
+ When enabled, `content` and `prev_content` dictionaries of events are deduplicated
+ through `MXEventContentPool` when events are parsed and when they are loaded from
+ the store. This reduces memory usage in big rooms where a lot of events have the
+ same content (membership changes, power levels...). NO by default.
+ */
+@property (nonatomic) BOOL enableEventContentDeduplication;
+
+/**
+ Resolve the profile of the sender of events when they are added to a timeline.
+
+ When enabled, `MXEventTimeline` sets `[MXEvent senderProfile]` from the room state at the
+ time of the event: the live state for new events, the back state for paginated ones.
+ Rendering an event then does not need to look up the room state. NO by default.
+ */
+@property (nonatomic) BOOL enableEventSenderProfileDecoration;
+
+/**
+ The parser used by MXHTTPClient instances to convert homeserver responses into JSON
+ objects (see `MXJSONResponseParser`).
+
+ It is applied to the MXHTTPClient instances created after it has been set.
+ nil by default, which means `NSJSONSerialization`.
+ */
+@property (nonatomic) id<MXJSONResponseParser> JSONResponseParser;
+
+/**
+ The handler used to start background tasks so that pending requests and store commits
+ complete when the app goes in background (see `MXBackgroundModeHandler`).
+
+ `MXUIKitBackgroundModeHandler` by default on iOS. Set it to nil when the SDK runs in a
+ process without `UIApplication`, like a daemon. nil by default on other platforms.
+ */
+@property (nonatomic) id<MXBackgroundModeHandler> backgroundModeHandler;
+
 @end
\ No newline at end of file
@@ -14,10 +14,10 @@
  limitations under the License.
  */
 
-#import <UIKit/UIKit.h>
-
 #import "MXSDKOptions.h"
 
+#import "MXUIKitBackgroundModeHandler.h"
+
 static MXSDKOptions *sharedOnceInstance = nil;
 
 @implementation MXSDKOptions
@@ -29,4 +29,16 @@ static MXSDKOptions *sharedOnceInstance = nil;
     return sharedOnceInstance;
 }
 
+- (instancetype)init
+{
+    self = [super init];
+    if (self)
+    {
+#if TARGET_OS_IPHONE
+        _backgroundModeHandler = [[MXUIKitBackgroundModeHandler alloc] init];
+#endif
+    }
+    return self;
+}
+
 @end
\ No newline at end of file
@@ -24,6 +24,11 @@
 #import "MXStore.h"
 #import "MXNotificationCenter.h"
 #import "MXCallManager.h"
+#import "MXEventContextCache.h"
+#import "MXSearchClient.h"
+#import "MXStoreCompactor.h"
+#import "MXMemoryPressureHandler.h"
+#import "MXSyncScheduler.h"
 
 /**
  `MXSessionState` represents the states in the life cycle of a MXSession instance.
@@ -141,6 +146,10 @@ FOUNDATION_EXPORT NSString *const kMXSessionDidLeaveRoomNotification;
 
 /**
  Posted when MXSession has performed a server sync.
+
+ The passed userInfo dictionary contains:
+ - `kMXSessionNotificationTimeToFirstByteKey` the time-to-first-byte of the /sync request
+ when it has been received.
  */
 FOUNDATION_EXPORT NSString *const kMXSessionDidSyncNotification;
 
@@ -167,6 +176,12 @@ FOUNDATION_EXPORT NSString *const kMXSessionNotificationRoomIdKey;
  */
 FOUNDATION_EXPORT NSString *const kMXSessionNotificationEventKey;
 
+/**
+ The key in notification userInfo dictionary representating the time-to-first-byte in
+ milliseconds of a request (NSNumber).
+ */
+FOUNDATION_EXPORT NSString *const kMXSessionNotificationTimeToFirstByteKey;
+
 /**
  Posted when MXSession has detected a change in the `ignoredUsers` property.
  
@@ -233,6 +248,37 @@ FOUNDATION_EXPORT NSString *const kMXSessionNoRoomTag;
  */
 @property (nonatomic, readonly) MXCallManager *callManager;
 
+/**
+ The cache of the event contexts used to open timelines on past events.
+ @see [MXRoom timelineOnEvent:].
+ */
+@property (nonatomic, readonly) MXEventContextCache *eventContextCache;
+
+/**
+ The client to use for searches from the UI.
+ It caches results and cancels superseded queries.
+ */
+@property (nonatomic, readonly) MXSearchClient *searchClient;
+
+/**
+ The module that applies history retention policies to the store.
+ */
+@property (nonatomic, readonly) MXStoreCompactor *storeCompactor;
+
+/**
+ Tell whether the current server sync is catching up with a stale events stream token.
+
+ In this mode, the /sync request fetches only the last messages of each room and no
+ presence so that the rooms list and the unread counts are quickly up to date. Rooms
+ with a gap are flushed as usual and back paginated when they are opened.
+ */
+@property (nonatomic, readonly) BOOL isCatchingUp;
+
+/**
+ The module that adapts the /sync long polling to the network conditions.
+ */
+@property (nonatomic, readonly) MXSyncScheduler *syncScheduler;
+
 
 #pragma mark - Class methods
 
@@ -338,8 +384,8 @@ typedef void (^MXOnBackgroundSyncFail)(NSError *error);
  This method prevents the /sync from being paused so that the session continues to receive
  and process Matrix events.
 
- Note that the events stream continues on a UIBackgroundTask which can be terminated
- by the system at anytime.
+ Note that the events stream continues on a background task (see `MXSDKOptions.backgroundModeHandler`)
+ which can be terminated by the system at anytime.
  */
 - (void)retainPreventPause;
 
@@ -353,6 +399,37 @@ typedef void (^MXOnBackgroundSyncFail)(NSError *error);
 - (void)releasePreventPause;
 
 
+#pragma mark - Memory pressure
+/**
+ Register an object that can release memory on memory pressure.
+
+ The session already registers its own subsystems: rooms, store, notification center,
+ event context cache, search client and store compactor.
+ The session keeps a weak reference on the handler.
+
+ @param handler the object to register.
+ */
+- (void)registerMemoryPressureHandler:(id<MXMemoryPressureHandler>)handler;
+
+/**
+ Unregister a memory pressure handler.
+
+ @param handler the object to unregister.
+ */
+- (void)unregisterMemoryPressureHandler:(id<MXMemoryPressureHandler>)handler;
+
+/**
+ Ask all subsystems to release memory.
+
+ The session calls it when the system reports memory pressure. It can be called directly to
+ force a trim, in tests for example.
+
+ @param level the memory pressure level.
+ @return the number of released objects.
+ */
+- (NSUInteger)handleMemoryPressure:(MXMemoryPressureLevel)level;
+
+
 #pragma mark - Options
 /*
  Define the Matrix storage component to use.
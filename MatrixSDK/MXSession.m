@@ -39,16 +39,48 @@ NSString *const kMXSessionDidSyncNotification = @"kMXSessionDidSyncNotification"
 NSString *const kMXSessionInvitedRoomsDidChangeNotification = @"kMXSessionInvitedRoomsDidChangeNotification";
 NSString *const kMXSessionNotificationRoomIdKey = @"roomId";
 NSString *const kMXSessionNotificationEventKey = @"event";
+NSString *const kMXSessionNotificationTimeToFirstByteKey = @"timeToFirstByte";
 NSString *const kMXSessionIgnoredUsersDidChangeNotification = @"kMXSessionIgnoredUsersDidChangeNotification";
 NSString *const kMXSessionDidCorruptDataNotification = @"kMXSessionDidCorruptDataNotification";
 NSString *const kMXSessionNoRoomTag = @"m.recent";  // Use the same value as matrix-react-sdk
 
 /**
- Default timeouts used by the events streams.
+ Default client timeout used by the events streams.
+ The server timeout of long polling requests is provided by `syncScheduler`.
  */
-#define SERVER_TIMEOUT_MS 30000
 #define CLIENT_TIMEOUT_MS 120000
 
+/**
+ The number of messages to fetch when joining a room without waiting for /sync.
+ */
+#define FAST_JOIN_MESSAGES_LIMIT 20
+
+/**
+ The number of event context windows kept in `eventContextCache`.
+ */
+#define EVENT_CONTEXT_CACHE_CAPACITY 20
+
+/**
+ The default age of the events stream token from which a server sync catches up with
+ small /sync responses. The session adapts it to the size of the responses.
+ */
+#define CATCHUP_TOKEN_AGE_S (24 * 3600)
+
+/**
+ The minimum token age to consider when adapting the catch-up token age.
+ */
+#define CATCHUP_MIN_TOKEN_AGE_S 3600
+
+/**
+ The number of rooms with a gap from which a /sync response is considered too large.
+ */
+#define CATCHUP_LIMITED_ROOMS_COUNT 20
+
+/**
+ The number of messages per room to fetch when catching up.
+ */
+#define CATCHUP_MESSAGES_LIMIT 5
+
 
 // Block called when MSSession resume is complete
 typedef void (^MXOnResumeDone)();
@@ -83,6 +115,11 @@ typedef void (^MXOnResumeDone)();
      */
     NSInteger syncMessagesLimit;
 
+    /**
+     The age of the events stream token from which the session catches up.
+     */
+    NSTimeInterval catchUpTokenAge;
+
     /** 
      The block to call when MSSession resume is complete.
      */
@@ -117,7 +154,22 @@ typedef void (^MXOnResumeDone)();
      The background task used when the session continue to run the events stream when
      the app goes in background.
      */
-    UIBackgroundTaskIdentifier backgroundTaskIdentifier;
+    id<MXBackgroundTask> backgroundTask;
+
+    /**
+     The registered memory pressure handlers.
+     */
+    NSHashTable<id<MXMemoryPressureHandler>> *memoryPressureHandlers;
+
+    /**
+     The source of system memory pressure events.
+     */
+    dispatch_source_t memoryPressureSource;
+
+    /**
+     The observer of network reachability changes.
+     */
+    id networkReachabilityObserver;
 }
 
 /**
@@ -140,11 +192,23 @@ typedef void (^MXOnResumeDone)();
         oneToOneRooms = [NSMutableDictionary dictionary];
         globalEventListeners = [NSMutableArray array];
         syncMessagesLimit = -1;
+        catchUpTokenAge = CATCHUP_TOKEN_AGE_S;
         _notificationCenter = [[MXNotificationCenter alloc] initWithMatrixSession:self];
         accountData = [[MXAccountData alloc] init];
         peekingRooms = [NSMutableArray array];
+        _eventContextCache = [[MXEventContextCache alloc] initWithCapacity:EVENT_CONTEXT_CACHE_CAPACITY];
+        _searchClient = [[MXSearchClient alloc] initWithMatrixSession:self];
+        _storeCompactor = [[MXStoreCompactor alloc] initWithMatrixSession:self];
+        _syncScheduler = [[MXSyncScheduler alloc] init];
         _preventPauseCount = 0;
-        backgroundTaskIdentifier = UIBackgroundTaskInvalid;
+
+        memoryPressureHandlers = [NSHashTable weakObjectsHashTable];
+        [self registerMemoryPressureHandler:_notificationCenter];
+        [self registerMemoryPressureHandler:_eventContextCache];
+        [self registerMemoryPressureHandler:_searchClient];
+        [self registerMemoryPressureHandler:_storeCompactor];
+        [self startObservingMemoryPressure];
+        [self startObservingNetworkReachability];
 
         _acknowledgableEventTypes = @[kMXEventTypeStringRoomName,
                                       kMXEventTypeStringRoomTopic,
@@ -197,6 +261,11 @@ typedef void (^MXOnResumeDone)();
 
     _store = store;
 
+    if ([_store conformsToProtocol:@protocol(MXMemoryPressureHandler)])
+    {
+        [self registerMemoryPressureHandler:(id<MXMemoryPressureHandler>)_store];
+    }
+
     // Validate the permanent implementation
     if (_store.isPermanent)
     {
@@ -216,6 +285,12 @@ typedef void (^MXOnResumeDone)();
             return;
         }
 
+        // Restore the catch-up token age adapted by previous sessions
+        if ([_store respondsToSelector:@selector(catchUpTokenAge)] && _store.catchUpTokenAge)
+        {
+            catchUpTokenAge = _store.catchUpTokenAge;
+        }
+
         // Can we start on data from the MXStore?
         if (_store.isPermanent && _store.eventStreamToken && 0 < _store.rooms.count)
         {
@@ -363,17 +438,17 @@ typedef void (^MXOnResumeDone)();
     {
         NSLog(@"[MXSession pause] Prevent the session from being paused. preventPauseCount: %tu", _preventPauseCount);
 
-        if (backgroundTaskIdentifier == UIBackgroundTaskInvalid)
+        if (!backgroundTask)
         {
-            backgroundTaskIdentifier = [[UIApplication sharedApplication] beginBackgroundTaskWithName:@"MXSessionBackgroundTask" expirationHandler:^{
+            backgroundTask = [[MXSDKOptions sharedInstance].backgroundModeHandler startBackgroundTaskWithName:@"MXSessionBackgroundTask" expirationHandler:^{
 
-                NSLog(@"[MXSession pause] Background task #%tu is going to expire - ending it", backgroundTaskIdentifier);
+                NSLog(@"[MXSession pause] Background task %p is going to expire - ending it", backgroundTask);
 
                 // We cannot continue to run in background. Pause the session for real
                 self.preventPauseCount = 0;
             }];
 
-            NSLog(@"[MXSession pause] Created background task #%tu", backgroundTaskIdentifier);
+            NSLog(@"[MXSession pause] Created background task %p", backgroundTask);
         }
 
         [self setState:MXSessionStatePauseRequested];
@@ -406,12 +481,12 @@ typedef void (^MXOnResumeDone)();
     NSLog(@"[MXSession] resume the event stream from state %tu", _state);
 
     // Reset pause preventing mechanism if any
-    if (backgroundTaskIdentifier != UIBackgroundTaskInvalid)
+    if (backgroundTask)
     {
-        NSLog(@"[MXSession resume] Stop background task #%tu", backgroundTaskIdentifier);
+        NSLog(@"[MXSession resume] Stop background task %p", backgroundTask);
 
-        [[UIApplication sharedApplication] endBackgroundTask:backgroundTaskIdentifier];
-        backgroundTaskIdentifier = UIBackgroundTaskInvalid;
+        [backgroundTask stop];
+        backgroundTask = nil;
     }
 
     // Check whether no request is already in progress
@@ -425,6 +500,10 @@ typedef void (^MXOnResumeDone)();
         
         if (!eventStreamRequest)
         {
+            // The first requests after a resume (/sync, read receipts, pagination of the
+            // displayed room...) will share the pre-warmed connections
+            [matrixRestClient prewarmConnection];
+
             // Relaunch live events stream (long polling)
             [self serverSyncWithServerTimeout:0 success:nil failure:nil clientTimeout:CLIENT_TIMEOUT_MS setPresence:nil];
         }
@@ -524,6 +603,28 @@ typedef void (^MXOnResumeDone)();
     [_notificationCenter removeAllListeners];
     _notificationCenter = nil;
 
+    // Stop searches
+    [_searchClient cancelPendingSearches];
+    [_searchClient removeAllCachedResults];
+
+    // Stop store compaction
+    [_storeCompactor close];
+
+    // Stop observing network reachability
+    if (networkReachabilityObserver)
+    {
+        [[NSNotificationCenter defaultCenter] removeObserver:networkReachabilityObserver];
+        networkReachabilityObserver = nil;
+    }
+
+    // Stop memory pressure handling
+    if (memoryPressureSource)
+    {
+        dispatch_source_cancel(memoryPressureSource);
+        memoryPressureSource = nil;
+    }
+    [memoryPressureHandlers removeAllObjects];
+
     // Stop calls
     if (_callManager)
     {
@@ -532,10 +633,10 @@ typedef void (^MXOnResumeDone)();
     }
 
     // Stop background task
-    if (backgroundTaskIdentifier != UIBackgroundTaskInvalid)
+    if (backgroundTask)
     {
-        [[UIApplication sharedApplication] endBackgroundTask:backgroundTaskIdentifier];
-        backgroundTaskIdentifier = UIBackgroundTaskInvalid;
+        [backgroundTask stop];
+        backgroundTask = nil;
     }
 
     _myUser = nil;
@@ -568,12 +669,12 @@ typedef void (^MXOnResumeDone)();
     if (_preventPauseCount == 0)
     {
         // The background task can be released
-        if (backgroundTaskIdentifier != UIBackgroundTaskInvalid)
+        if (backgroundTask)
         {
-            NSLog(@"[MXSession pause] Stop background task #%tu", backgroundTaskIdentifier);
+            NSLog(@"[MXSession pause] Stop background task %p", backgroundTask);
 
-            [[UIApplication sharedApplication] endBackgroundTask:backgroundTaskIdentifier];
-            backgroundTaskIdentifier = UIBackgroundTaskInvalid;
+            [backgroundTask stop];
+            backgroundTask = nil;
         }
 
         // And the session can be paused for real if it was not resumed before
@@ -586,6 +687,60 @@ typedef void (^MXOnResumeDone)();
 }
 
 
+#pragma mark - Memory pressure
+- (void)registerMemoryPressureHandler:(id<MXMemoryPressureHandler>)handler
+{
+    if (handler)
+    {
+        [memoryPressureHandlers addObject:handler];
+    }
+}
+
+- (void)unregisterMemoryPressureHandler:(id<MXMemoryPressureHandler>)handler
+{
+    [memoryPressureHandlers removeObject:handler];
+}
+
+- (NSUInteger)handleMemoryPressure:(MXMemoryPressureLevel)level
+{
+    NSDate *startDate = [NSDate date];
+    NSUInteger count = 0;
+
+    // Rooms are owned by the session
+    for (MXRoom *room in rooms.allValues)
+    {
+        count += [room.liveTimeline handleMemoryPressure:level];
+    }
+
+    for (id<MXMemoryPressureHandler> handler in memoryPressureHandlers.allObjects)
+    {
+        count += [handler handleMemoryPressure:level];
+    }
+
+    NSLog(@"[MXSession] handleMemoryPressure: level %tu. %tu objects released in %.0fms", level, count, [[NSDate date] timeIntervalSinceDate:startDate] * 1000);
+
+    return count;
+}
+
+- (void)startObservingMemoryPressure
+{
+    memoryPressureSource = dispatch_source_create(DISPATCH_SOURCE_TYPE_MEMORYPRESSURE, 0, DISPATCH_MEMORYPRESSURE_WARN | DISPATCH_MEMORYPRESSURE_CRITICAL, dispatch_get_main_queue());
+
+    __weak typeof(self) weakSelf = self;
+    dispatch_source_set_event_handler(memoryPressureSource, ^{
+
+        __strong __typeof(weakSelf)strongSelf = weakSelf;
+        if (strongSelf && strongSelf->memoryPressureSource)
+        {
+            unsigned long pressure = dispatch_source_get_data(strongSelf->memoryPressureSource);
+            [strongSelf handleMemoryPressure:(pressure & DISPATCH_MEMORYPRESSURE_CRITICAL) ? MXMemoryPressureLevelCritical : MXMemoryPressureLevelModerate];
+        }
+    });
+
+    dispatch_resume(memoryPressureSource);
+}
+
+
 #pragma mark - Server sync
 
 - (void)serverSyncWithServerTimeout:(NSUInteger)serverTimeout
@@ -597,12 +752,30 @@ typedef void (^MXOnResumeDone)();
     NSDate *startDate = [NSDate date];
     NSLog(@"[MXSession] Do a server sync");
 
+    // Detect a stale events stream token
+    NSTimeInterval tokenAge = 0;
+    if (_store.eventStreamToken && [_store respondsToSelector:@selector(eventStreamTokenDate)] && _store.eventStreamTokenDate)
+    {
+        tokenAge = -[_store.eventStreamTokenDate timeIntervalSinceNow];
+    }
+    _isCatchingUp = (tokenAge >= catchUpTokenAge);
+
     NSString *inlineFilter;
-    if (-1 != syncMessagesLimit)
+    if (_isCatchingUp)
+    {
+        // Get the room list and the unread counts first: fetch only the last messages of each room, no presence.
+        // Rooms with a gap will be back paginated when they are opened.
+        NSInteger limit = (-1 != syncMessagesLimit) ? MIN(syncMessagesLimit, CATCHUP_MESSAGES_LIMIT) : CATCHUP_MESSAGES_LIMIT;
+        inlineFilter = [NSString stringWithFormat:@"{\"presence\":{\"types\":[]},\"room\":{\"timeline\":{\"limit\":%tu}}}", limit];
+
+        NSLog(@"[MXSession] Catch up with an events stream token of %.0fs", tokenAge);
+    }
+    else if (-1 != syncMessagesLimit)
     {
         // If requested by the app, use a limit for /sync.
         inlineFilter = [NSString stringWithFormat:@"{\"room\":{\"timeline\":{\"limit\":%tu}}}", syncMessagesLimit];
     }
+    BOOL isCatchingUp = _isCatchingUp;
 
     eventStreamRequest = [matrixRestClient syncFromToken:_store.eventStreamToken serverTimeout:serverTimeout clientTimeout:clientTimeout setPresence:setPresence filter:inlineFilter success:^(MXSyncResponse *syncResponse) {
         
@@ -612,10 +785,21 @@ typedef void (^MXOnResumeDone)();
             return;
         }
         
-        NSLog(@"[MXSession] Received %tu joined rooms, %tu invited rooms, %tu left rooms in %.0fms", syncResponse.rooms.join.count, syncResponse.rooms.invite.count, syncResponse.rooms.leave.count, [[NSDate date] timeIntervalSinceDate:startDate] * 1000);
-        
+        NSUInteger timeToFirstByte = eventStreamRequest.timeToFirstByte;
+        [_syncScheduler didSucceedWithTimeToFirstByte:timeToFirstByte serverTimeout:serverTimeout];
+
+        NSLog(@"[MXSession] Received %tu joined rooms, %tu invited rooms, %tu left rooms in %.0fms (time to first byte: %tums)", syncResponse.rooms.join.count, syncResponse.rooms.invite.count, syncResponse.rooms.leave.count, [[NSDate date] timeIntervalSinceDate:startDate] * 1000, timeToFirstByte);
+
+        [self adaptCatchUpTokenAgeToSyncResponse:syncResponse tokenAge:tokenAge isCatchingUp:isCatchingUp];
+
         // Check whether this is the initial sync
         BOOL isInitialSync = !_store.eventStreamToken;
+
+        // Dispatch call signalling events first so that incoming calls do not ring late
+        if (_callManager && !isInitialSync)
+        {
+            [self handleCallEventsInAdvance:syncResponse];
+        }
         
         // Handle first joined rooms
         for (NSString *roomId in syncResponse.rooms.join)
@@ -731,6 +915,9 @@ typedef void (^MXOnResumeDone)();
         {
             [self handleAccountData:syncResponse.accountData];
         }
+
+        // All call events of this sync have gone through the normal flow
+        [_callManager forgetCallEventsHandledInAdvance];
         
         // Update live event stream token
         _store.eventStreamToken = syncResponse.nextBatch;
@@ -797,12 +984,12 @@ typedef void (^MXOnResumeDone)();
         }
         
         // Pursue live events listening (long polling)
-        [self serverSyncWithServerTimeout:SERVER_TIMEOUT_MS success:nil failure:nil clientTimeout:CLIENT_TIMEOUT_MS setPresence:nil];
+        [self serverSyncWithServerTimeout:_syncScheduler.serverTimeout success:nil failure:nil clientTimeout:CLIENT_TIMEOUT_MS setPresence:nil];
         
         // Broadcast that a server sync has been processed.
         [[NSNotificationCenter defaultCenter] postNotificationName:kMXSessionDidSyncNotification
                                                             object:self
-                                                          userInfo:nil];
+                                                          userInfo:timeToFirstByte ? @{kMXSessionNotificationTimeToFirstByteKey: @(timeToFirstByte)} : nil];
         
         if (success)
         {
@@ -832,6 +1019,11 @@ typedef void (^MXOnResumeDone)();
             }
         }
         
+        if ((int32_t)error.code != kCFURLErrorCancelled)
+        {
+            [_syncScheduler didFail];
+        }
+
         // Handle failure during catch up first
         if (onBackgroundSyncFail)
         {
@@ -885,7 +1077,7 @@ typedef void (^MXOnResumeDone)();
                                                                   userInfo:nil];
                 
                 // Switch back to the long poll management
-                [self serverSyncWithServerTimeout:SERVER_TIMEOUT_MS success:nil failure:nil clientTimeout:CLIENT_TIMEOUT_MS setPresence:nil];
+                [self serverSyncWithServerTimeout:_syncScheduler.serverTimeout success:nil failure:nil clientTimeout:CLIENT_TIMEOUT_MS setPresence:nil];
             }
             else
             {
@@ -902,6 +1094,9 @@ typedef void (^MXOnResumeDone)();
                     // Relaunch the request in a random near futur.
                     // Random time it used to avoid all Matrix clients to retry all in the same time
                     // if there is server side issue like server restart
+                    // Meanwhile, open a connection so that the retry does not pay its setup.
+                    [matrixRestClient prewarmConnection];
+
                     dispatch_time_t delayTime = dispatch_time(DISPATCH_TIME_NOW, [MXHTTPClient jitterTimeForRetry] * NSEC_PER_MSEC);
                     dispatch_after(delayTime, dispatch_get_main_queue(), ^(void) {
                         
@@ -934,6 +1129,122 @@ typedef void (^MXOnResumeDone)();
     }];
 }
 
+- (void)startObservingNetworkReachability
+{
+    __weak typeof(self) weakSelf = self;
+    networkReachabilityObserver = [[NSNotificationCenter defaultCenter] addObserverForName:AFNetworkingReachabilityDidChangeNotification object:nil queue:[NSOperationQueue mainQueue] usingBlock:^(NSNotification *note) {
+
+        __strong __typeof(weakSelf)strongSelf = weakSelf;
+
+        // The pending long poll may be stuck on the previous network: prepare a connection
+        // on the new one for the next requests
+        if (strongSelf && strongSelf.state == MXSessionStateRunning && [AFNetworkReachabilityManager sharedManager].isReachable)
+        {
+            [strongSelf.matrixRestClient prewarmConnection];
+        }
+    }];
+}
+
+/**
+ Adapt the age of the events stream token from which the session catches up.
+
+ A full response with many gaps means that the token was already stale: catch up earlier
+ next time. A catch-up response with few gaps means that a full sync would have been fine:
+ catch up later next time, up to the default age.
+
+ @param syncResponse the /sync response.
+ @param tokenAge the age of the events stream token used for the request.
+ @param isCatchingUp YES if the request was a catch-up one.
+ */
+- (void)adaptCatchUpTokenAgeToSyncResponse:(MXSyncResponse*)syncResponse tokenAge:(NSTimeInterval)tokenAge isCatchingUp:(BOOL)isCatchingUp
+{
+    if (tokenAge < CATCHUP_MIN_TOKEN_AGE_S)
+    {
+        return;
+    }
+
+    NSUInteger limitedRoomsCount = 0;
+    for (MXRoomSync *roomSync in syncResponse.rooms.join.allValues)
+    {
+        if (roomSync.timeline.limited)
+        {
+            limitedRoomsCount++;
+        }
+    }
+
+    NSTimeInterval newCatchUpTokenAge = catchUpTokenAge;
+    if (!isCatchingUp && limitedRoomsCount >= CATCHUP_LIMITED_ROOMS_COUNT)
+    {
+        newCatchUpTokenAge = tokenAge;
+    }
+    else if (isCatchingUp && limitedRoomsCount < CATCHUP_LIMITED_ROOMS_COUNT)
+    {
+        newCatchUpTokenAge = MIN(2 * catchUpTokenAge, CATCHUP_TOKEN_AGE_S);
+    }
+
+    if (newCatchUpTokenAge != catchUpTokenAge)
+    {
+        NSLog(@"[MXSession] %tu rooms with a gap: catch up from a token age of %.0fs", limitedRoomsCount, newCatchUpTokenAge);
+        catchUpTokenAge = newCatchUpTokenAge;
+
+        if ([_store respondsToSelector:@selector(setCatchUpTokenAge:)])
+        {
+            _store.catchUpTokenAge = catchUpTokenAge;
+        }
+    }
+}
+
+- (void)handleCallEventsInAdvance:(MXSyncResponse*)syncResponse
+{
+    NSMutableArray<MXEvent*> *callEvents;
+
+    for (NSString *roomId in syncResponse.rooms.join)
+    {
+        // Only known rooms are concerned. MXCall needs the room to be set up
+        if (![self roomWithRoomId:roomId])
+        {
+            continue;
+        }
+
+        MXRoomSync *roomSync = syncResponse.rooms.join[roomId];
+        for (MXEvent *event in roomSync.timeline.events)
+        {
+            switch (event.eventType)
+            {
+                case MXEventTypeCallInvite:
+                case MXEventTypeCallCandidates:
+                case MXEventTypeCallAnswer:
+                case MXEventTypeCallHangup:
+                {
+                    // Events already received (overlapping syncs) must not be handled again
+                    if (event.eventId && [_store eventExistsWithEventId:event.eventId inRoom:roomId])
+                    {
+                        break;
+                    }
+
+                    // Report the room id in the event as it is skipped in /sync response
+                    event.roomId = roomId;
+
+                    if (!callEvents)
+                    {
+                        callEvents = [NSMutableArray array];
+                    }
+                    [callEvents addObject:event];
+                    break;
+                }
+                default:
+                    break;
+            }
+        }
+    }
+
+    if (callEvents)
+    {
+        NSLog(@"[MXSession] handleCallEventsInAdvance: %tu call events", callEvents.count);
+        [_callManager handleCallEventsInAdvance:callEvents];
+    }
+}
+
 - (void)handlePresenceEvent:(MXEvent *)event direction:(MXTimelineDirection)direction
 {
     // Update MXUser with presence data
@@ -960,10 +1271,13 @@ typedef void (^MXOnResumeDone)();
             if ([event[@"type"] isEqualToString:kMXAccountDataPushRules])
             {
                 // Handle push rules
-                MXPushRulesResponse *pushRules = [MXPushRulesResponse modelFromJSON:event[@"content"]];
+                // Compare content hashes to build models only when the rules have changed
+                NSString *contentHash = [MXTools contentHashOfJSON:event[@"content"]];
 
-                if (![_notificationCenter.rules.JSONDictionary isEqualToDictionary:event[@"content"]])
+                if (![_notificationCenter.rules.contentHash isEqualToString:contentHash])
                 {
+                    // The notification center applies the diff rule by rule
+                    MXPushRulesResponse *pushRules = [MXPushRulesResponse modelFromJSON:event[@"content"]];
                     [_notificationCenter handlePushRulesResponse:pushRules];
 
                     // Report the change
@@ -1112,11 +1426,45 @@ typedef void (^MXOnResumeDone)();
                     [[NSNotificationCenter defaultCenter] removeObserver:initialSyncObserver];
                 }
             }];
+
+            // Do not wait for the long poll /sync request to return the room data:
+            // race it with a direct request
+            [self fastJoinRoom:room];
         }
     }
 
 }
 
+/**
+ Fetch the state and the last messages of a room the user has just joined.
+
+ The data is applied as the room initial sync, unless /sync has been faster.
+
+ @param room the joined room.
+ */
+- (void)fastJoinRoom:(MXRoom*)room
+{
+    NSInteger limit = (-1 != syncMessagesLimit) ? syncMessagesLimit : FAST_JOIN_MESSAGES_LIMIT;
+
+    NSDate *startDate = [NSDate date];
+    [matrixRestClient initialSyncOfRoom:room.roomId withLimit:limit success:^(MXRoomInitialSync *roomInitialSync) {
+
+        // Check the room is still managed by this session and that /sync did not return it before
+        if ([self roomWithRoomId:room.roomId] == room
+            && room.state.membership != MXMembershipJoin
+            && [roomInitialSync.membership isEqualToString:kMXMembershipStringJoin])
+        {
+            NSLog(@"[MXSession] fastJoinRoom: %@ data received in %.0fms", room.roomId, [[NSDate date] timeIntervalSinceDate:startDate] * 1000);
+
+            [room handleRoomInitialSync:roomInitialSync];
+        }
+
+    } failure:^(NSError *error) {
+        // The room data will come with the next /sync response
+        NSLog(@"[MXSession] fastJoinRoom: Cannot get %@ data. Error: %@", room.roomId, error);
+    }];
+}
+
 - (MXHTTPOperation*)joinRoom:(NSString*)roomIdOrAlias
                      success:(void (^)(MXRoom *room))success
                      failure:(void (^)(NSError *error))failure
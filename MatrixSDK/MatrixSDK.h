@@ -14,7 +14,7 @@
  limitations under the License.
  */
 
-#import <UIKit/UIKit.h>
+#import <Foundation/Foundation.h>
 
 /**
  The Matrix iOS SDK version.
@@ -24,12 +24,14 @@ FOUNDATION_EXPORT NSString *MatrixSDKVersion;
 #import <MatrixSDK/MXRestClient.h>
 #import <MatrixSDK/MXSession.h>
 #import <MatrixSDK/MXError.h>
+#import <MatrixSDK/MXPublicRoomDirectory.h>
 
 #import <MatrixSDK/MXStore.h>
 #import <MatrixSDK/MXNoStore.h>
 #import <MatrixSDK/MXMemoryStore.h>
 #import <MatrixSDK/MXFileStore.h>
 #import <MatrixSDK/MXCoreDataStore.h>
+#import <MatrixSDK/MXStoreSnapshot.h>
 
 #import <MatrixSDK/MXEventsEnumeratorOnArray.h>
 #import <MatrixSDK/MXEventsByTypesEnumeratorOnArray.h>
@@ -39,3 +41,4 @@ FOUNDATION_EXPORT NSString *MatrixSDKVersion;
 #import "MXTools.h"
 
 #import "MXSDKOptions.h"
+#import "MXBackgroundModeHandler.h"
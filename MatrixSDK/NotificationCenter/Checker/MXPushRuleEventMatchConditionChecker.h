@@ -17,10 +17,19 @@
 #import <Foundation/Foundation.h>
 
 #import "MXPushRuleConditionChecker.h"
+#import "MXMemoryPressureHandler.h"
 
 /**
  `MXPushRuleEventMatchConditionChecker` checks conditions of type "event_match" (kMXPushRuleConditionStringEventMatch).
  */
-@interface MXPushRuleEventMatchConditionChecker : NSObject <MXPushRuleConditionChecker>
+@interface MXPushRuleEventMatchConditionChecker : NSObject <MXPushRuleConditionChecker, MXMemoryPressureHandler>
+
+/**
+ Release the regular expression compiled for a pattern.
+ It will be compiled again if a condition uses this pattern.
+
+ @param pattern the glob pattern of an event_match condition.
+ */
+- (void)removeRegexForPattern:(NSString*)pattern;
 
 @end
@@ -83,4 +83,18 @@
     return res;
 }
 
+- (void)removeRegexForPattern:(NSString*)pattern
+{
+    [regExByPatternDict removeObjectForKey:pattern];
+}
+
+- (NSUInteger)handleMemoryPressure:(MXMemoryPressureLevel)level
+{
+    // The regexs are compiled again on demand
+    NSUInteger count = regExByPatternDict.count;
+    [regExByPatternDict removeAllObjects];
+
+    return count;
+}
+
 @end
@@ -20,6 +20,7 @@
 #import "MXJSONModels.h"
 #import "MXPushRuleConditionChecker.h"
 #import "MXHTTPOperation.h"
+#import "MXMemoryPressureHandler.h"
 
 
 @class MXSession;
@@ -85,7 +86,7 @@ extern NSString *const kMXNotificationCenterAllOtherRoomMessagesRuleID;
     - notify the SDK client when a push rule is satified by a live event
     - allow to set push rules @TODO
  */
-@interface MXNotificationCenter : NSObject
+@interface MXNotificationCenter : NSObject <MXMemoryPressureHandler>
 {
 @protected
     /**
@@ -129,6 +130,9 @@ extern NSString *const kMXNotificationCenterAllOtherRoomMessagesRuleID;
 /**
  Handle an update of the push rules.
 
+ The update is applied rule by rule: the current `MXPushRule` objects whose content has not
+ changed are kept, with the data built to check them.
+
  @param pushRules the new push rules.
  */
 - (void)handlePushRulesResponse:(MXPushRulesResponse*)pushRules;
@@ -60,6 +60,13 @@ NSString *const kMXNotificationCenterAllOtherRoomMessagesRuleID = @".m.rule.mess
      Keep the reference on the event_match condition as it can reuse to check Content, Room and Sender rules.
     */
     MXPushRuleEventMatchConditionChecker *eventMatchConditionChecker;
+
+    /**
+     The event_match conditions equivalent to content, room and sender rules.
+     They are built on demand and released when their rule is removed or modified.
+     The keys are the `MXPushRule` objects.
+     */
+    NSMapTable<MXPushRule*, MXPushRuleCondition*> *equivalentConditions;
 }
 @end
 
@@ -74,6 +81,9 @@ NSString *const kMXNotificationCenterAllOtherRoomMessagesRuleID = @".m.rule.mess
         mxSession = mxSession2;
         notificationListeners = [NSMutableArray array];
 
+        equivalentConditions = [NSMapTable mapTableWithKeyOptions:NSPointerFunctionsStrongMemory | NSPointerFunctionsObjectPointerPersonality
+                                                     valueOptions:NSPointerFunctionsStrongMemory];
+
         conditionCheckers = [NSMutableDictionary dictionary];
 
         // Define condition checkers for default Matrix conditions
@@ -127,13 +137,31 @@ NSString *const kMXNotificationCenterAllOtherRoomMessagesRuleID = @".m.rule.mess
 
     @synchronized(self)
     {
-        flatRules = [NSMutableArray array];
-
-        // Add rules by their priority
+        // Index the current rules to keep the ones that have not changed
+        NSMutableDictionary<NSString*, MXPushRule*> *currentRules = [NSMutableDictionary dictionaryWithCapacity:flatRules.count];
+        for (MXPushRule *rule in flatRules)
+        {
+            currentRules[[self keyOfRule:rule]] = rule;
+        }
 
         // @TODO: manage device rules
 
         // Global rules
+        pushRules.global.override = [self mergeRules:pushRules.global.override withCurrentRules:currentRules];
+        pushRules.global.content = [self mergeRules:pushRules.global.content withCurrentRules:currentRules];
+        pushRules.global.room = [self mergeRules:pushRules.global.room withCurrentRules:currentRules];
+        pushRules.global.sender = [self mergeRules:pushRules.global.sender withCurrentRules:currentRules];
+        pushRules.global.underride = [self mergeRules:pushRules.global.underride withCurrentRules:currentRules];
+
+        // The remaining current rules have been removed or modified
+        for (MXPushRule *rule in currentRules.allValues)
+        {
+            [self forgetRule:rule];
+        }
+
+        flatRules = [NSMutableArray array];
+
+        // Add rules by their priority
         [flatRules addObjectsFromArray:pushRules.global.override];
         [flatRules addObjectsFromArray:pushRules.global.content];
         [flatRules addObjectsFromArray:pushRules.global.room];
@@ -206,46 +234,12 @@ NSString *const kMXNotificationCenterAllOtherRoomMessagesRuleID = @".m.rule.mess
                     }
                         
                     case MXPushRuleKindContent:
-                    {
-                        // Content rules are rules on the "content.body" field
-                        // Tranlate this into a fake condition
-                        MXPushRuleCondition *equivalentCondition = [[MXPushRuleCondition alloc] init];
-                        equivalentCondition.kindType = MXPushRuleConditionTypeEventMatch;
-                        equivalentCondition.parameters = @{
-                                                           @"key": @"content.body",
-                                                           @"pattern": rule.pattern
-                                                           };
-                        
-                        conditionsOk = [eventMatchConditionChecker isCondition:equivalentCondition satisfiedBy:event withJsonDict:JSONDictionary];
-                        break;
-                    }
-                        
                     case MXPushRuleKindRoom:
-                    {
-                        // Room rules are rules on the "room_id" field
-                        // Translate this into a fake condition
-                        MXPushRuleCondition *equivalentCondition = [[MXPushRuleCondition alloc] init];
-                        equivalentCondition.kindType = MXPushRuleConditionTypeEventMatch;
-                        equivalentCondition.parameters = @{
-                                                           @"key": @"room_id",
-                                                           @"pattern": rule.ruleId
-                                                           };
-                        
-                        conditionsOk = [eventMatchConditionChecker isCondition:equivalentCondition satisfiedBy:event withJsonDict:JSONDictionary];
-                        break;
-                    }
-                        
                     case MXPushRuleKindSender:
                     {
-                        // Sender rules are rules on the "user_id" field
-                        // Translate this into a fake condition
-                        MXPushRuleCondition *equivalentCondition = [[MXPushRuleCondition alloc] init];
-                        equivalentCondition.kindType = MXPushRuleConditionTypeEventMatch;
-                        equivalentCondition.parameters = @{
-                                                           @"key": @"user_id",
-                                                           @"pattern": rule.ruleId
-                                                           };
-                        
+                        // These rules are checked with their equivalent event_match condition
+                        MXPushRuleCondition *equivalentCondition = [self equivalentConditionOfRule:rule];
+
                         conditionsOk = [eventMatchConditionChecker isCondition:equivalentCondition satisfiedBy:event withJsonDict:JSONDictionary];
                         break;
                     }
@@ -332,6 +326,7 @@ NSString *const kMXNotificationCenterAllOtherRoomMessagesRuleID = @".m.rule.mess
                     if ([rule.ruleId isEqualToString:pushRule.ruleId])
                     {
                         [flatRules removeObjectAtIndex:index];
+                        [self forgetRule:rule];
                         
                         NSMutableArray *updatedArray;
                         switch (rule.kind)
@@ -376,6 +371,9 @@ NSString *const kMXNotificationCenterAllOtherRoomMessagesRuleID = @".m.rule.mess
                         break;
                     }
                 }
+
+                // The rules no more match the last content sent by the home server
+                [_rules invalidateContentHash];
             }
 
             [[NSNotificationCenter defaultCenter] postNotificationName:kMXNotificationCenterDidUpdateRules object:self userInfo:nil];
@@ -407,10 +405,14 @@ NSString *const kMXNotificationCenterAllOtherRoomMessagesRuleID = @".m.rule.mess
                     
                     if ([rule.ruleId isEqualToString:pushRule.ruleId])
                     {
+                        // This resets the rule content hash
                         rule.enabled = enable;
                         break;
                     }
                 }
+
+                // The rules no more match the last content sent by the home server
+                [_rules invalidateContentHash];
             }
             
             [[NSNotificationCenter defaultCenter] postNotificationName:kMXNotificationCenterDidUpdateRules object:self userInfo:nil];
@@ -507,6 +509,7 @@ NSString *const kMXNotificationCenterAllOtherRoomMessagesRuleID = @".m.rule.mess
     [mxSession.matrixRestClient addPushRule:ruleId scope:kMXPushRuleScopeStringGlobal kind:kind actions:actions pattern:pattern conditions:conditions success:^{
         
         // Refresh locally rules
+        // Only the new rule is built, the other ones are kept as they are
         [self refreshRules:^{
             [[NSNotificationCenter defaultCenter] postNotificationName:kMXNotificationCenterDidUpdateRules object:self userInfo:nil];
         } failure:^(NSError *error) {
@@ -521,7 +524,127 @@ NSString *const kMXNotificationCenterAllOtherRoomMessagesRuleID = @".m.rule.mess
 }
 
 
+#pragma mark - MXMemoryPressureHandler
+- (NSUInteger)handleMemoryPressure:(MXMemoryPressureLevel)level
+{
+    NSUInteger count = 0;
+
+    // Condition checkers may have caches
+    for (id<MXPushRuleConditionChecker> checker in conditionCheckers.allValues)
+    {
+        if ([checker conformsToProtocol:@protocol(MXMemoryPressureHandler)])
+        {
+            count += [(id<MXMemoryPressureHandler>)checker handleMemoryPressure:level];
+        }
+    }
+
+    return count;
+}
+
+
 #pragma mark - Private methods
+// The key identifying a rule among all rules
+- (NSString*)keyOfRule:(MXPushRule*)rule
+{
+    return [NSString stringWithFormat:@"%@/%@/%@", rule.scope, @(rule.kind), rule.ruleId];
+}
+
+// Build the list of rules of a kind from the new rules.
+// The current rules that have not changed are kept and removed from currentRules.
+- (NSArray<MXPushRule*>*)mergeRules:(NSArray<MXPushRule*>*)rules withCurrentRules:(NSMutableDictionary<NSString*, MXPushRule*>*)currentRules
+{
+    NSMutableArray<MXPushRule*> *mergedRules = [NSMutableArray arrayWithCapacity:rules.count];
+
+    for (MXPushRule *rule in rules)
+    {
+        NSString *key = [self keyOfRule:rule];
+        MXPushRule *currentRule = currentRules[key];
+
+        if (currentRule && [currentRule.contentHash isEqualToString:rule.contentHash])
+        {
+            // Keep the current rule and what has been built for it
+            [mergedRules addObject:currentRule];
+            [currentRules removeObjectForKey:key];
+        }
+        else
+        {
+            [mergedRules addObject:rule];
+        }
+    }
+
+    return mergedRules;
+}
+
+// Get the event_match condition equivalent to a content, room or sender rule
+- (MXPushRuleCondition*)equivalentConditionOfRule:(MXPushRule*)rule
+{
+    MXPushRuleCondition *equivalentCondition = [equivalentConditions objectForKey:rule];
+    if (!equivalentCondition)
+    {
+        NSString *key;
+        NSString *pattern;
+
+        switch (rule.kind)
+        {
+            case MXPushRuleKindContent:
+                // Content rules are rules on the "content.body" field
+                key = @"content.body";
+                pattern = rule.pattern;
+                break;
+
+            case MXPushRuleKindRoom:
+                // Room rules are rules on the "room_id" field
+                key = @"room_id";
+                pattern = rule.ruleId;
+                break;
+
+            case MXPushRuleKindSender:
+                // Sender rules are rules on the "user_id" field
+                key = @"user_id";
+                pattern = rule.ruleId;
+                break;
+
+            default:
+                return nil;
+        }
+
+        equivalentCondition = [[MXPushRuleCondition alloc] init];
+        equivalentCondition.kindType = MXPushRuleConditionTypeEventMatch;
+        equivalentCondition.parameters = @{
+                                           @"key": key,
+                                           @"pattern": pattern
+                                           };
+
+        [equivalentConditions setObject:equivalentCondition forKey:rule];
+    }
+
+    return equivalentCondition;
+}
+
+// Release what has been built for a rule that has been removed or modified
+- (void)forgetRule:(MXPushRule*)rule
+{
+    NSMutableArray<MXPushRuleCondition*> *conditions = [NSMutableArray arrayWithArray:rule.conditions];
+
+    MXPushRuleCondition *equivalentCondition = [equivalentConditions objectForKey:rule];
+    if (equivalentCondition)
+    {
+        [conditions addObject:equivalentCondition];
+        [equivalentConditions removeObjectForKey:rule];
+    }
+
+    // Drop the compiled regexes of the rule patterns.
+    // They are compiled again on demand if another rule uses the same pattern.
+    for (MXPushRuleCondition *condition in conditions)
+    {
+        NSString *pattern = condition.parameters[@"pattern"];
+        if (condition.kindType == MXPushRuleConditionTypeEventMatch && pattern)
+        {
+            [eventMatchConditionChecker removeRegexForPattern:pattern];
+        }
+    }
+}
+
 // Check if the event should be notified to the listeners
 - (void)shouldNotify:(MXEvent*)event roomState:(MXRoomState*)roomState
 {
@@ -0,0 +1,58 @@
+/*
+ Copyright 2016 OpenMarket Ltd
+
+ Licensed under the Apache License, Version 2.0 (the "License");
+ you may not use this file except in compliance with the License.
+ You may obtain a copy of the License at
+
+ http://www.apache.org/licenses/LICENSE-2.0
+
+ Unless required by applicable law or agreed to in writing, software
+ distributed under the License is distributed on an "AS IS" BASIS,
+ WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ See the License for the specific language governing permissions and
+ limitations under the License.
+ */
+
+#import <Foundation/Foundation.h>
+
+/**
+ `MXBackgroundTask` is a running background task started by a `MXBackgroundModeHandler`.
+ */
+@protocol MXBackgroundTask <NSObject>
+
+/**
+ The name of the task, for debugging purpose.
+ */
+@property (nonatomic, readonly) NSString *name;
+
+/**
+ Stop the task.
+
+ It can be called several times.
+ */
+- (void)stop;
+
+@end
+
+/**
+ `MXBackgroundModeHandler` abstracts the way the SDK asks the system for time to finish
+ an operation (a request, a store commit...) when the app goes in background.
+
+ On iOS, the default handler uses `UIApplication` background tasks (see `MXUIKitBackgroundModeHandler`).
+ Processes without `UIApplication`, like daemons, can set `[MXSDKOptions sharedInstance].backgroundModeHandler`
+ to nil: they are never suspended and no background task is started.
+ */
+@protocol MXBackgroundModeHandler <NSObject>
+
+/**
+ Start a background task.
+
+ @param name the name of the task, for debugging purpose.
+ @param expirationHandler the block called on the main thread when the system is going to
+ suspend the app. The task is stopped after this call.
+ @return the running task. nil if it cannot be started.
+ */
+- (id<MXBackgroundTask>)startBackgroundTaskWithName:(NSString*)name expirationHandler:(void (^)())expirationHandler;
+
+@end
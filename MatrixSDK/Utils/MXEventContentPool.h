@@ -0,0 +1,109 @@
+/*
+ Copyright 2016 OpenMarket Ltd
+
+ Licensed under the Apache License, Version 2.0 (the "License");
+ you may not use this file except in compliance with the License.
+ You may obtain a copy of the License at
+
+ http://www.apache.org/licenses/LICENSE-2.0
+
+ Unless required by applicable law or agreed to in writing, software
+ distributed under the License is distributed on an "AS IS" BASIS,
+ WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ See the License for the specific language governing permissions and
+ limitations under the License.
+ */
+
+#import <Foundation/Foundation.h>
+
+/**
+ `MXEventContentPool` shares identical event content dictionaries between events.
+
+ Big rooms contain a lot of events with the same `content` or `prev_content`
+ (membership events with the same displayname and avatar, power levels snapshots...).
+ The pool hashes the JSON tree of each content and returns an already known
+ instance when an equal one has been interned before.
+
+ The pool keeps only weak references on the shared dictionaries: a content is
+ released as soon as no more event uses it.
+
+ The pool is used by MXEvent when `[MXSDKOptions enableEventContentDeduplication]` is YES.
+ */
+@interface MXEventContentPool : NSObject
+
+/**
+ The pool used by the SDK.
+ */
++ (MXEventContentPool *)sharedPool;
+
+/**
+ Get the shared instance of a content.
+
+ Contents are compared with `isJSON:equalToJSON:`: a boolean value is never shared
+ with a number value.
+
+ @param content the JSON dictionary to deduplicate.
+ @return an already interned dictionary equal to `content` if any. Else, a deep immutable
+         copy of `content` which is then interned.
+ */
+- (NSDictionary*)internContent:(NSDictionary*)content;
+
+/**
+ Forget all interned contents and reset statistics.
+ */
+- (void)reset;
+
+/**
+ Compute a hash of a JSON tree.
+
+ Unlike [NSDictionary hash] which only returns the number of entries, this hash
+ takes into account all keys and values of the tree.
+
+ @param JSONObject a JSON object (NSDictionary, NSArray, NSString, NSNumber or NSNull).
+ @return the hash value.
+ */
++ (NSUInteger)hashOfJSON:(id)JSONObject;
+
+/**
+ Compare two JSON trees.
+
+ Unlike [NSDictionary isEqualToDictionary:], JSON booleans are not equal to numbers:
+ `true` and `1` are different values.
+
+ @param JSONObject a JSON object.
+ @param otherJSONObject another JSON object.
+ @return YES if both trees have the same keys and values with the same JSON types.
+ */
++ (BOOL)isJSON:(id)JSONObject equalToJSON:(id)otherJSONObject;
+
+/**
+ Estimate the memory used by a JSON tree.
+
+ @param JSONObject a JSON object.
+ @return an estimation of the number of bytes used by the tree objects.
+ */
++ (NSUInteger)estimatedSizeOfJSON:(id)JSONObject;
+
+#pragma mark - Statistics
+/**
+ The number of contents passed to `internContent:`.
+ */
+@property (nonatomic, readonly) NSUInteger lookupsCount;
+
+/**
+ The number of contents which have been replaced by an already interned instance.
+ */
+@property (nonatomic, readonly) NSUInteger hitsCount;
+
+/**
+ An estimation of the number of bytes saved by sharing contents.
+ It is the sum of the estimated sizes of the contents replaced by an interned instance.
+ */
+@property (nonatomic, readonly) NSUInteger savedBytesCount;
+
+/**
+ The number of distinct contents currently alive in the pool.
+ */
+@property (nonatomic, readonly) NSUInteger count;
+
+@end
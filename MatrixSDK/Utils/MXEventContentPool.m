@@ -0,0 +1,307 @@
+/*
+ Copyright 2016 OpenMarket Ltd
+
+ Licensed under the Apache License, Version 2.0 (the "License");
+ you may not use this file except in compliance with the License.
+ You may obtain a copy of the License at
+
+ http://www.apache.org/licenses/LICENSE-2.0
+
+ Unless required by applicable law or agreed to in writing, software
+ distributed under the License is distributed on an "AS IS" BASIS,
+ WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ See the License for the specific language governing permissions and
+ limitations under the License.
+ */
+
+#import "MXEventContentPool.h"
+
+#import <malloc/malloc.h>
+
+/**
+ The number of interns after which buckets with released contents are purged.
+ */
+#define MXEVENTCONTENTPOOL_PURGE_INTERVAL 1000
+
+@interface MXEventContentPool ()
+{
+    /**
+     Interned contents, grouped by their JSON hash.
+     Each bucket is a weak hash table of the dictionaries sharing the same hash.
+     */
+    NSMutableDictionary<NSNumber*, NSHashTable<NSDictionary*>*> *buckets;
+
+    /**
+     Number of interns since the last purge.
+     */
+    NSUInteger internsSinceLastPurge;
+}
+
+@end
+
+@implementation MXEventContentPool
+
++ (MXEventContentPool *)sharedPool
+{
+    static MXEventContentPool *sharedPool = nil;
+    static dispatch_once_t onceToken;
+    dispatch_once(&onceToken, ^{ sharedPool = [[self alloc] init]; });
+    return sharedPool;
+}
+
+- (instancetype)init
+{
+    self = [super init];
+    if (self)
+    {
+        buckets = [NSMutableDictionary dictionary];
+    }
+    return self;
+}
+
+- (NSDictionary *)internContent:(NSDictionary *)content
+{
+    if (!content.count)
+    {
+        return content;
+    }
+
+    // Compute the hash out of the lock
+    NSNumber *hash = @([MXEventContentPool hashOfJSON:content]);
+
+    @synchronized(self)
+    {
+        _lookupsCount++;
+
+        NSHashTable<NSDictionary*> *bucket = buckets[hash];
+        if (bucket)
+        {
+            for (NSDictionary *internedContent in bucket)
+            {
+                if (internedContent == content || [MXEventContentPool isJSON:internedContent equalToJSON:content])
+                {
+                    if (internedContent != content)
+                    {
+                        _hitsCount++;
+                        _savedBytesCount += [MXEventContentPool estimatedSizeOfJSON:content];
+                    }
+                    return internedContent;
+                }
+            }
+        }
+        else
+        {
+            bucket = [NSHashTable weakObjectsHashTable];
+            buckets[hash] = bucket;
+        }
+
+        // Intern an immutable version of the content so that it can be safely shared.
+        // Nested containers may be mutable too: copy the whole tree.
+        NSDictionary *internedContent = [MXEventContentPool immutableCopyOfJSON:content];
+        [bucket addObject:internedContent];
+
+        if (++internsSinceLastPurge >= MXEVENTCONTENTPOOL_PURGE_INTERVAL)
+        {
+            [self purge];
+        }
+
+        return internedContent;
+    }
+}
+
+- (void)reset
+{
+    @synchronized(self)
+    {
+        [buckets removeAllObjects];
+        internsSinceLastPurge = 0;
+        _lookupsCount = 0;
+        _hitsCount = 0;
+        _savedBytesCount = 0;
+    }
+}
+
+- (NSUInteger)count
+{
+    NSUInteger count = 0;
+    @synchronized(self)
+    {
+        for (NSHashTable *bucket in buckets.allValues)
+        {
+            count += bucket.allObjects.count;
+        }
+    }
+    return count;
+}
+
++ (NSUInteger)hashOfJSON:(id)JSONObject
+{
+    NSUInteger hash;
+
+    if ([JSONObject isKindOfClass:[NSDictionary class]])
+    {
+        // The hash must not depend on the enumeration order of keys
+        hash = 0x9e3779b9;
+        NSDictionary *dictionary = JSONObject;
+        for (NSString *key in dictionary)
+        {
+            hash ^= (key.hash * 31) + [MXEventContentPool hashOfJSON:dictionary[key]];
+        }
+        hash += dictionary.count;
+    }
+    else if ([JSONObject isKindOfClass:[NSArray class]])
+    {
+        hash = 0x7f4a7c15;
+        for (id item in (NSArray*)JSONObject)
+        {
+            hash = (hash * 31) + [MXEventContentPool hashOfJSON:item];
+        }
+    }
+    else if ([MXEventContentPool isJSONBoolean:JSONObject])
+    {
+        // [NSNumber hash] does not make the difference between true and 1
+        hash = [JSONObject hash] ^ 0x5bd1e995;
+    }
+    else
+    {
+        hash = [JSONObject hash];
+    }
+
+    return hash;
+}
+
++ (BOOL)isJSON:(id)JSONObject equalToJSON:(id)otherJSONObject
+{
+    if (JSONObject == otherJSONObject)
+    {
+        return YES;
+    }
+
+    if ([JSONObject isKindOfClass:[NSDictionary class]])
+    {
+        NSDictionary *dictionary = JSONObject;
+        NSDictionary *otherDictionary = otherJSONObject;
+
+        if (![otherJSONObject isKindOfClass:[NSDictionary class]] || dictionary.count != otherDictionary.count)
+        {
+            return NO;
+        }
+
+        for (NSString *key in dictionary)
+        {
+            id otherValue = otherDictionary[key];
+            if (!otherValue || ![MXEventContentPool isJSON:dictionary[key] equalToJSON:otherValue])
+            {
+                return NO;
+            }
+        }
+        return YES;
+    }
+    else if ([JSONObject isKindOfClass:[NSArray class]])
+    {
+        NSArray *array = JSONObject;
+        NSArray *otherArray = otherJSONObject;
+
+        if (![otherJSONObject isKindOfClass:[NSArray class]] || array.count != otherArray.count)
+        {
+            return NO;
+        }
+
+        for (NSUInteger i = 0; i < array.count; i++)
+        {
+            if (![MXEventContentPool isJSON:array[i] equalToJSON:otherArray[i]])
+            {
+                return NO;
+            }
+        }
+        return YES;
+    }
+    else if ([JSONObject isKindOfClass:[NSNumber class]])
+    {
+        return [otherJSONObject isKindOfClass:[NSNumber class]]
+        && [MXEventContentPool isJSONBoolean:JSONObject] == [MXEventContentPool isJSONBoolean:otherJSONObject]
+        && [JSONObject isEqualToNumber:otherJSONObject];
+    }
+
+    return [JSONObject isEqual:otherJSONObject];
+}
+
++ (NSUInteger)estimatedSizeOfJSON:(id)JSONObject
+{
+    NSUInteger size = malloc_size((__bridge const void *)JSONObject);
+
+    if ([JSONObject isKindOfClass:[NSDictionary class]])
+    {
+        NSDictionary *dictionary = JSONObject;
+        for (NSString *key in dictionary)
+        {
+            size += [MXEventContentPool estimatedSizeOfJSON:key] + [MXEventContentPool estimatedSizeOfJSON:dictionary[key]];
+        }
+    }
+    else if ([JSONObject isKindOfClass:[NSArray class]])
+    {
+        for (id item in (NSArray*)JSONObject)
+        {
+            size += [MXEventContentPool estimatedSizeOfJSON:item];
+        }
+    }
+
+    return size;
+}
+
+
+#pragma mark - Private methods
++ (BOOL)isJSONBoolean:(id)JSONObject
+{
+    // NSJSONSerialization decodes JSON booleans as the kCFBooleanTrue and kCFBooleanFalse singletons
+    return [JSONObject isKindOfClass:[NSNumber class]]
+    && CFGetTypeID((__bridge CFTypeRef)JSONObject) == CFBooleanGetTypeID();
+}
+
++ (id)immutableCopyOfJSON:(id)JSONObject
+{
+    id copy;
+
+    if ([JSONObject isKindOfClass:[NSDictionary class]])
+    {
+        NSDictionary *dictionary = JSONObject;
+        NSMutableDictionary *dictionaryCopy = [NSMutableDictionary dictionaryWithCapacity:dictionary.count];
+        for (NSString *key in dictionary)
+        {
+            dictionaryCopy[key] = [MXEventContentPool immutableCopyOfJSON:dictionary[key]];
+        }
+        copy = [dictionaryCopy copy];
+    }
+    else if ([JSONObject isKindOfClass:[NSArray class]])
+    {
+        NSArray *array = JSONObject;
+        NSMutableArray *arrayCopy = [NSMutableArray arrayWithCapacity:array.count];
+        for (id item in array)
+        {
+            [arrayCopy addObject:[MXEventContentPool immutableCopyOfJSON:item]];
+        }
+        copy = [arrayCopy copy];
+    }
+    else
+    {
+        // Strings may be mutable too
+        copy = [JSONObject copy];
+    }
+
+    return copy;
+}
+
+- (void)purge
+{
+    // Must be called with the lock held
+    for (NSNumber *hash in buckets.allKeys)
+    {
+        if (buckets[hash].allObjects.count == 0)
+        {
+            [buckets removeObjectForKey:hash];
+        }
+    }
+    internsSinceLastPurge = 0;
+}
+
+@end
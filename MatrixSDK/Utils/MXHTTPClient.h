@@ -32,6 +32,29 @@ extern NSString * const MXHTTPClientErrorResponseDataKey;
  */
 typedef BOOL (^MXHTTPClientOnUnrecognizedCertificate)(NSData *certificate);
 
+/**
+ `MXJSONResponseParser` is the interface of the parser used to convert the body of
+ HTTP responses into JSON objects.
+
+ By default, MXHTTPClient uses `NSJSONSerialization`. The SDK does not provide another
+ parser but apps can plug their own by setting `[MXSDKOptions sharedInstance].JSONResponseParser`
+ or `[MXHTTPClient responseParser]`.
+ */
+@protocol MXJSONResponseParser <NSObject>
+
+/**
+ Parse JSON data.
+
+ This method is called from an AFNetworking thread. It must be thread safe.
+
+ @param data the response body.
+ @param error the parsing error if any.
+ @return the JSON object (`NSDictionary` or `NSArray`) or nil in case of error.
+ */
+- (id)JSONObjectWithData:(NSData*)data error:(NSError**)error;
+
+@end
+
 /**
  `MXHTTPClient` is an abstraction layer for making requests to a HTTP server.
 
@@ -53,6 +76,12 @@ typedef BOOL (^MXHTTPClientOnUnrecognizedCertificate)(NSData *certificate);
  */
 @property (nonatomic, readonly) NSData* allowedCertificate;
 
+/**
+ The parser used to convert response bodies into JSON objects.
+ Default is `[MXSDKOptions sharedInstance].JSONResponseParser`. nil means NSJSONSerialization.
+ */
+@property (nonatomic) id<MXJSONResponseParser> responseParser;
+
 
 #pragma mark - Public methods
 /**
@@ -139,6 +168,17 @@ typedef BOOL (^MXHTTPClientOnUnrecognizedCertificate)(NSData *certificate);
                           success:(void (^)(NSDictionary *JSONResponse))success
                           failure:(void (^)(NSError *error))failure;
 
+/**
+ Open a connection to the server in advance so that the next requests do not pay the
+ DNS, TCP and TLS setup.
+
+ Nothing is done if a response has been received recently: the connection is probably
+ still open.
+
+ @param path the relative path of a cheap GET request on the server.
+ */
+- (void)prewarmConnectionWithPath:(NSString*)path;
+
 /**
  Return a random time to retry a request.
  
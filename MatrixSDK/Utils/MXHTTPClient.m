@@ -16,6 +16,9 @@
 
 #import "MXHTTPClient.h"
 #import "MXError.h"
+#import "MXSDKOptions.h"
+#import "MXBackgroundModeHandler.h"
+#import "MXJSONResponseSerializer.h"
 
 #import <AFNetworking/AFNetworking.h>
 
@@ -35,12 +38,24 @@
  */
 #define MXHTTPCLIENT_RETRY_JITTER_MS 3000
 
+/**
+ The time in seconds during which a connection to the server is considered still open
+ after the last response.
+ */
+#define MXHTTPCLIENT_CONNECTION_IDLE_S 30
+
+/**
+ The timeout in seconds of a connection pre-warming request.
+ */
+#define MXHTTPCLIENT_PREWARM_TIMEOUT_S 10
+
 /**
  `MXHTTPClientErrorResponseDataKey`
  The corresponding value is an `NSDictionary` containing the response data of the operation associated with an error.
  */
 NSString * const MXHTTPClientErrorResponseDataKey = @"com.matrixsdk.httpclient.error.response.data";
 
+
 @interface MXHTTPClient ()
 {
     /**
@@ -69,15 +84,27 @@ NSString * const MXHTTPClientErrorResponseDataKey = @"com.matrixsdk.httpclient.e
     MXHTTPClientOnUnrecognizedCertificate onUnrecognizedCertificateBlock;
 
     /**
-     The current background task id if any.
+     The current background task if any.
      */
-    UIBackgroundTaskIdentifier backgroundTaskIdentifier;
+    id<MXBackgroundTask> backgroundTask;
 
     /**
      Flag to indicate that the underlying NSURLSession has been invalidated.
      In this state, we can not use anymore NSURLSession else it crashes.
      */
     BOOL invalidatedSession;
+
+    /**
+     The dates when the running tasks received their response headers.
+     The access must be protected by a lock on the map table: responses are received on
+     an AFNetworking thread.
+     */
+    NSMapTable<NSURLSessionTask*, NSDate*> *responseDates;
+
+    /**
+     The date of the last received response.
+     */
+    NSDate *lastResponseDate;
 }
 @end
 
@@ -111,13 +138,16 @@ NSString * const MXHTTPClientErrorResponseDataKey = @"com.matrixsdk.httpclient.e
         }
         
         onUnrecognizedCertificateBlock = onUnrecognizedCertBlock;
-        backgroundTaskIdentifier = UIBackgroundTaskInvalid;
-        
+
         // Send requests parameters in JSON format by default
         self.requestParametersInJSON = YES;
 
+        // Use the JSON parser provided by the app, if any
+        self.responseParser = [MXSDKOptions sharedInstance].JSONResponseParser;
+
         [self setUpNetworkReachibility];
         [self setUpSSLCertificatesHandler];
+        [self setUpResponseTracking];
 
         // Track potential expected session invalidation (seen on iOS10 beta)
         [httpManager setSessionDidBecomeInvalidBlock:^(NSURLSession * _Nonnull session, NSError * _Nonnull error) {
@@ -133,7 +163,7 @@ NSString * const MXHTTPClientErrorResponseDataKey = @"com.matrixsdk.httpclient.e
 {
     [self cancel];
 
-    if (backgroundTaskIdentifier != UIBackgroundTaskInvalid)
+    if (backgroundTask)
     {
         [self cleanupBackgroundTask];
     }
@@ -226,6 +256,8 @@ NSString * const MXHTTPClientErrorResponseDataKey = @"com.matrixsdk.httpclient.e
 
     __weak typeof(self) weakSelf = self;
 
+    NSDate *requestDate = [NSDate date];
+
     mxHTTPOperation.numberOfTries++;
     mxHTTPOperation.operation = [httpManager dataTaskWithRequest:request uploadProgress:^(NSProgress * _Nonnull theUploadProgress) {
 
@@ -243,6 +275,12 @@ NSString * const MXHTTPClientErrorResponseDataKey = @"com.matrixsdk.httpclient.e
         __strong __typeof(weakSelf)strongSelf = weakSelf;
         if (strongSelf)
         {
+            NSDate *responseDate = [strongSelf popResponseDateOfTask:mxHTTPOperation.operation];
+            if (responseDate)
+            {
+                mxHTTPOperation.timeToFirstByte = [responseDate timeIntervalSinceDate:requestDate] * 1000;
+            }
+
             mxHTTPOperation.operation = nil;
 
             if (!error)
@@ -471,6 +509,33 @@ NSString * const MXHTTPClientErrorResponseDataKey = @"com.matrixsdk.httpclient.e
     [mxHTTPOperation.operation resume];
 }
 
+- (void)prewarmConnectionWithPath:(NSString *)path
+{
+    @synchronized(responseDates)
+    {
+        if (lastResponseDate && -[lastResponseDate timeIntervalSinceNow] < MXHTTPCLIENT_CONNECTION_IDLE_S)
+        {
+            // The connection is probably still open
+            return;
+        }
+    }
+
+    NSLog(@"[MXHTTPClient] Pre-warm a connection to %@", httpManager.baseURL.host);
+
+    __block MXHTTPOperation *operation;
+    operation = [self requestWithMethod:@"GET" path:path parameters:nil timeout:MXHTTPCLIENT_PREWARM_TIMEOUT_S success:^(NSDictionary *JSONResponse) {
+
+        NSLog(@"[MXHTTPClient] Connection pre-warmed in %tums", operation.timeToFirstByte);
+        operation = nil;
+
+    } failure:^(NSError *error) {
+        operation = nil;
+    }];
+
+    // The request is useless if it fails, do not retry it
+    operation.maxNumberOfTries = 1;
+}
+
 + (NSUInteger)jitterTimeForRetry
 {
     NSUInteger jitter = arc4random_uniform(MXHTTPCLIENT_RETRY_JITTER_MS);
@@ -492,6 +557,21 @@ NSString * const MXHTTPClientErrorResponseDataKey = @"com.matrixsdk.httpclient.e
     }
 }
 
+- (void)setResponseParser:(id<MXJSONResponseParser>)responseParser
+{
+    _responseParser = responseParser;
+    if (_responseParser)
+    {
+        MXJSONResponseSerializer *responseSerializer = [MXJSONResponseSerializer serializer];
+        responseSerializer.parser = _responseParser;
+        httpManager.responseSerializer = responseSerializer;
+    }
+    else
+    {
+        httpManager.responseSerializer = [AFJSONResponseSerializer serializer];
+    }
+}
+
 
 #pragma - Background task
 /**
@@ -504,12 +584,11 @@ NSString * const MXHTTPClientErrorResponseDataKey = @"com.matrixsdk.httpclient.e
 - (void)startBackgroundTask
 {
     // Create the bg task if it does not exist yet
-    if (backgroundTaskIdentifier == UIBackgroundTaskInvalid)
+    if (!backgroundTask)
     {
-        UIApplication *application = [UIApplication sharedApplication];
         __weak __typeof(self)weakSelf = self;
 
-        backgroundTaskIdentifier = [application beginBackgroundTaskWithExpirationHandler:^{
+        backgroundTask = [[MXSDKOptions sharedInstance].backgroundModeHandler startBackgroundTaskWithName:@"MXHTTPClient" expirationHandler:^{
 
             __strong __typeof(weakSelf)strongSelf = weakSelf;
             if (strongSelf)
@@ -534,10 +613,10 @@ NSString * const MXHTTPClientErrorResponseDataKey = @"com.matrixsdk.httpclient.e
  */
 - (void)cleanupBackgroundTask
 {
-    if (backgroundTaskIdentifier != UIBackgroundTaskInvalid && httpManager.tasks.count == 0)
+    if (backgroundTask && httpManager.tasks.count == 0)
     {
-        [[UIApplication sharedApplication] endBackgroundTask:backgroundTaskIdentifier];
-        backgroundTaskIdentifier = UIBackgroundTaskInvalid;
+        [backgroundTask stop];
+        backgroundTask = nil;
     }
 }
 
@@ -596,6 +675,44 @@ NSString * const MXHTTPClientErrorResponseDataKey = @"com.matrixsdk.httpclient.e
     [reachabilityObservers removeObject:observer];
 }
 
+- (void)setUpResponseTracking
+{
+    responseDates = [NSMapTable weakToStrongObjectsMapTable];
+
+    __weak __typeof(self)weakSelf = self;
+
+    // This block is called from an AFNetworking thread
+    [httpManager setDataTaskDidReceiveResponseBlock:^NSURLSessionResponseDisposition(NSURLSession * _Nonnull session, NSURLSessionDataTask * _Nonnull dataTask, NSURLResponse * _Nonnull response) {
+
+        __strong __typeof(weakSelf)strongSelf = weakSelf;
+        if (strongSelf)
+        {
+            NSDate *responseDate = [NSDate date];
+            @synchronized(strongSelf->responseDates)
+            {
+                [strongSelf->responseDates setObject:responseDate forKey:dataTask];
+                strongSelf->lastResponseDate = responseDate;
+            }
+        }
+
+        return NSURLSessionResponseAllow;
+    }];
+}
+
+- (NSDate*)popResponseDateOfTask:(NSURLSessionTask*)task
+{
+    NSDate *responseDate;
+    if (task)
+    {
+        @synchronized(responseDates)
+        {
+            responseDate = [responseDates objectForKey:task];
+            [responseDates removeObjectForKey:task];
+        }
+    }
+    return responseDate;
+}
+
 - (void)setUpSSLCertificatesHandler
 {
     __weak __typeof(self)weakSelf = self;
@@ -54,6 +54,13 @@
  */
 @property (nonatomic) NSUInteger maxRetriesTime;
 
+/**
+ The time in milliseconds between the sending of the last try and the reception of the
+ response headers (DNS, connection setup and server processing included).
+ 0 until a response is received.
+ */
+@property (nonatomic) NSUInteger timeToFirstByte;
+
 /**
  Cancel the HTTP request.
  */
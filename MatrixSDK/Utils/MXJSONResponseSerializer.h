@@ -0,0 +1,35 @@
+/*
+ Copyright 2016 OpenMarket Ltd
+
+ Licensed under the Apache License, Version 2.0 (the "License");
+ you may not use this file except in compliance with the License.
+ You may obtain a copy of the License at
+
+ http://www.apache.org/licenses/LICENSE-2.0
+
+ Unless required by applicable law or agreed to in writing, software
+ distributed under the License is distributed on an "AS IS" BASIS,
+ WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ See the License for the specific language governing permissions and
+ limitations under the License.
+ */
+
+#import <AFNetworking/AFNetworking.h>
+
+#import "MXHTTPClient.h"
+
+/**
+ `MXJSONResponseSerializer` is an AFNetworking JSON response serializer that delegates
+ the parsing of the response body to a `MXJSONResponseParser`.
+
+ Apart from the parser, it behaves like `AFJSONResponseSerializer`: same response
+ validation, same handling of empty bodies and same errors.
+ */
+@interface MXJSONResponseSerializer : AFJSONResponseSerializer
+
+/**
+ The parser of response bodies.
+ */
+@property (nonatomic) id<MXJSONResponseParser> parser;
+
+@end
@@ -0,0 +1,68 @@
+/*
+ Copyright 2016 OpenMarket Ltd
+
+ Licensed under the Apache License, Version 2.0 (the "License");
+ you may not use this file except in compliance with the License.
+ You may obtain a copy of the License at
+
+ http://www.apache.org/licenses/LICENSE-2.0
+
+ Unless required by applicable law or agreed to in writing, software
+ distributed under the License is distributed on an "AS IS" BASIS,
+ WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ See the License for the specific language governing permissions and
+ limitations under the License.
+ */
+
+#import "MXJSONResponseSerializer.h"
+
+@implementation MXJSONResponseSerializer
+
+- (id)responseObjectForResponse:(NSURLResponse *)response data:(NSData *)data error:(NSError *__autoreleasing *)error
+{
+    if (![self validateResponse:(NSHTTPURLResponse *)response data:data error:error])
+    {
+        // Like AFJSONResponseSerializer, try to parse the body of HTTP errors because
+        // it may contain a Matrix error. Do not try when the content type is not JSON.
+        if (!error || [self isError:*error orUnderlyingErrorWithCode:NSURLErrorCannotDecodeContentData])
+        {
+            return nil;
+        }
+    }
+
+    // Some servers return a single space for HEAD requests, ignore it
+    if (!data.length || (data.length == 1 && ((const char*)data.bytes)[0] == ' '))
+    {
+        return nil;
+    }
+
+    NSError *parsingError;
+    id responseObject = [_parser JSONObjectWithData:data error:&parsingError];
+
+    if (error && parsingError)
+    {
+        // Report the parsing error with the validation error as underlying error
+        if (*error && !parsingError.userInfo[NSUnderlyingErrorKey])
+        {
+            NSMutableDictionary *userInfo = [NSMutableDictionary dictionaryWithDictionary:parsingError.userInfo];
+            userInfo[NSUnderlyingErrorKey] = *error;
+            parsingError = [NSError errorWithDomain:parsingError.domain code:parsingError.code userInfo:userInfo];
+        }
+        *error = parsingError;
+    }
+
+    return responseObject;
+}
+
+- (BOOL)isError:(NSError*)error orUnderlyingErrorWithCode:(NSInteger)code
+{
+    if ([error.domain isEqualToString:AFURLResponseSerializationErrorDomain] && error.code == code)
+    {
+        return YES;
+    }
+
+    NSError *underlyingError = error.userInfo[NSUnderlyingErrorKey];
+    return underlyingError && [self isError:underlyingError orUnderlyingErrorWithCode:code];
+}
+
+@end
@@ -18,6 +18,12 @@
 
 #import "MatrixSDK.h"
 
+#if TARGET_OS_IPHONE
+#import <UIKit/UIKit.h>
+#else
+#include <sys/sysctl.h>
+#endif
+
 // stderr so it can be restored
 int stderrSave = 0;
 
@@ -141,8 +147,17 @@ static void handleUncaughtException(NSException *exception)
     }
 
     // Build the crash log
+#if TARGET_OS_IPHONE
     NSString *model = [[UIDevice currentDevice] model];
     NSString *version = [[UIDevice currentDevice] systemVersion];
+#else
+    // No UIDevice in a headless process
+    char hwModel[256] = {0};
+    size_t hwModelSize = sizeof(hwModel) - 1;
+    sysctlbyname("hw.model", hwModel, &hwModelSize, NULL, 0);
+    NSString *model = [NSString stringWithUTF8String:hwModel];
+    NSString *version = [[NSProcessInfo processInfo] operatingSystemVersionString];
+#endif
     NSArray  *backtrace = [exception callStackSymbols];
     NSString *description = [NSString stringWithFormat:@"%tu - %@\n%@\nApplication: %@ (%@)\nApplication version: %@\nMatrix SDK version: %@\nBuild: %@\n%@ %@\n\nMain thread: %@\n%@\n",
                              [[NSDate date] timeIntervalSince1970],
@@ -0,0 +1,54 @@
+/*
+ Copyright 2016 OpenMarket Ltd
+
+ Licensed under the Apache License, Version 2.0 (the "License");
+ you may not use this file except in compliance with the License.
+ You may obtain a copy of the License at
+
+ http://www.apache.org/licenses/LICENSE-2.0
+
+ Unless required by applicable law or agreed to in writing, software
+ distributed under the License is distributed on an "AS IS" BASIS,
+ WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ See the License for the specific language governing permissions and
+ limitations under the License.
+ */
+
+#import <Foundation/Foundation.h>
+
+/**
+ Memory pressure levels.
+ */
+typedef enum : NSUInteger
+{
+    /**
+     The system is low on memory. Caches that are cheap to rebuild should be released.
+     */
+    MXMemoryPressureLevelModerate,
+
+    /**
+     The system is about to terminate apps. Everything that can be rebuilt should be released.
+     */
+    MXMemoryPressureLevelCritical
+
+} MXMemoryPressureLevel;
+
+/**
+ A `MXMemoryPressureHandler` object releases memory when the system asks for it.
+
+ Handlers are registered to a `MXSession` (see [MXSession registerMemoryPressureHandler:]).
+ They must release only data they can rebuild later.
+ */
+@protocol MXMemoryPressureHandler <NSObject>
+
+/**
+ Release memory.
+
+ It is called on the main thread.
+
+ @param level the memory pressure level.
+ @return the number of released objects (cache entries, room states...).
+ */
+- (NSUInteger)handleMemoryPressure:(MXMemoryPressureLevel)level;
+
+@end
@@ -0,0 +1,65 @@
+/*
+ Copyright 2016 OpenMarket Ltd
+
+ Licensed under the Apache License, Version 2.0 (the "License");
+ you may not use this file except in compliance with the License.
+ You may obtain a copy of the License at
+
+ http://www.apache.org/licenses/LICENSE-2.0
+
+ Unless required by applicable law or agreed to in writing, software
+ distributed under the License is distributed on an "AS IS" BASIS,
+ WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ See the License for the specific language governing permissions and
+ limitations under the License.
+ */
+
+#import <Foundation/Foundation.h>
+
+/**
+ `MXSyncScheduler` computes the parameters of the /sync long polling requests.
+
+ The server timeout depends on the network type and on the failure rate of the last
+ requests: cellular networks and flaky connections often drop idle connections before
+ the end of a long poll, so that shorter long polls fail less.
+
+ The scheduler also keeps the time-to-first-byte statistics of the /sync requests.
+ */
+@interface MXSyncScheduler : NSObject
+
+/**
+ The server timeout in milliseconds to use for the next long polling request.
+ */
+@property (nonatomic, readonly) NSUInteger serverTimeout;
+
+/**
+ The smoothed failure rate of the last requests, between 0 and 1.
+ */
+@property (nonatomic, readonly) float failureRate;
+
+/**
+ The time-to-first-byte in milliseconds of the last successful /sync request.
+ */
+@property (nonatomic, readonly) NSUInteger lastTimeToFirstByte;
+
+/**
+ The smoothed time-to-first-byte in milliseconds of the /sync requests that did not wait
+ on server side (server timeout of 0).
+ 0 if there was no such request.
+ */
+@property (nonatomic, readonly) NSUInteger averageTimeToFirstByte;
+
+/**
+ Report a successful /sync request.
+
+ @param timeToFirstByte the time-to-first-byte in milliseconds of the request.
+ @param serverTimeout the server timeout in milliseconds used by the request.
+ */
+- (void)didSucceedWithTimeToFirstByte:(NSUInteger)timeToFirstByte serverTimeout:(NSUInteger)serverTimeout;
+
+/**
+ Report a failed /sync request.
+ */
+- (void)didFail;
+
+@end
@@ -0,0 +1,77 @@
+/*
+ Copyright 2016 OpenMarket Ltd
+
+ Licensed under the Apache License, Version 2.0 (the "License");
+ you may not use this file except in compliance with the License.
+ You may obtain a copy of the License at
+
+ http://www.apache.org/licenses/LICENSE-2.0
+
+ Unless required by applicable law or agreed to in writing, software
+ distributed under the License is distributed on an "AS IS" BASIS,
+ WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ See the License for the specific language governing permissions and
+ limitations under the License.
+ */
+
+#import "MXSyncScheduler.h"
+
+#import <AFNetworking/AFNetworking.h>
+
+#pragma mark - Constants definitions
+/**
+ The server timeouts in milliseconds of long polling requests by network type.
+ */
+#define MXSYNCSCHEDULER_WIFI_SERVER_TIMEOUT_MS 30000
+#define MXSYNCSCHEDULER_WWAN_SERVER_TIMEOUT_MS 20000
+
+/**
+ The minimum server timeout in milliseconds.
+ */
+#define MXSYNCSCHEDULER_MIN_SERVER_TIMEOUT_MS 5000
+
+/**
+ The weight of the last request in the smoothed statistics.
+ */
+#define MXSYNCSCHEDULER_SMOOTHING_FACTOR 0.2
+
+
+@implementation MXSyncScheduler
+
+- (NSUInteger)serverTimeout
+{
+    AFNetworkReachabilityManager *networkReachabilityManager = [AFNetworkReachabilityManager sharedManager];
+
+    NSUInteger serverTimeout = networkReachabilityManager.isReachableViaWWAN ? MXSYNCSCHEDULER_WWAN_SERVER_TIMEOUT_MS : MXSYNCSCHEDULER_WIFI_SERVER_TIMEOUT_MS;
+
+    // Shorten the long polls when requests fail
+    serverTimeout = round(serverTimeout * (1 - _failureRate));
+
+    return MAX(serverTimeout, MXSYNCSCHEDULER_MIN_SERVER_TIMEOUT_MS);
+}
+
+- (void)didSucceedWithTimeToFirstByte:(NSUInteger)timeToFirstByte serverTimeout:(NSUInteger)serverTimeout
+{
+    _failureRate *= (1 - MXSYNCSCHEDULER_SMOOTHING_FACTOR);
+    _lastTimeToFirstByte = timeToFirstByte;
+
+    // The time-to-first-byte of a long poll is mainly the time spent waiting for events
+    if (serverTimeout == 0 && timeToFirstByte)
+    {
+        if (_averageTimeToFirstByte)
+        {
+            _averageTimeToFirstByte = (1 - MXSYNCSCHEDULER_SMOOTHING_FACTOR) * _averageTimeToFirstByte + MXSYNCSCHEDULER_SMOOTHING_FACTOR * timeToFirstByte;
+        }
+        else
+        {
+            _averageTimeToFirstByte = timeToFirstByte;
+        }
+    }
+}
+
+- (void)didFail
+{
+    _failureRate = (1 - MXSYNCSCHEDULER_SMOOTHING_FACTOR) * _failureRate + MXSYNCSCHEDULER_SMOOTHING_FACTOR;
+}
+
+@end
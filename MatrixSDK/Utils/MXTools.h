@@ -111,4 +111,17 @@ FOUNDATION_EXPORT NSString *const kMXToolsRegexStringForMatrixEventIdentifier;
  */
 + (NSString*)permalinkToEvent:(NSString*)eventId inRoom:(NSString*)roomIdOrAlias;
 
+
+#pragma mark - Content hash
+/**
+ Compute a hash of a JSON object content.
+
+ The hash does not depend on the order of dictionary keys: two JSON objects with the same
+ content have the same hash.
+
+ @param JSONObject a JSON object made of dictionaries, arrays, strings, numbers and null.
+ @return the SHA-256 hash of the content as an hexadecimal string.
+ */
++ (NSString*)contentHashOfJSON:(id)JSONObject;
+
 @end
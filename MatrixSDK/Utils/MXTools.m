@@ -15,6 +15,8 @@
  */
 #import "MXTools.h"
 
+#import <CommonCrypto/CommonDigest.h>
+
 #import "MXEnumConstants.h"
 
 #pragma mark - Constant definition
@@ -223,4 +225,79 @@ static NSRegularExpression *isMatrixEventIdentifierRegex;
 
 }
 
+
+#pragma mark - Content hash
++ (NSString *)contentHashOfJSON:(id)JSONObject
+{
+    CC_SHA256_CTX context;
+    CC_SHA256_Init(&context);
+
+    [MXTools updateHashContext:&context withJSON:JSONObject];
+
+    unsigned char digest[CC_SHA256_DIGEST_LENGTH];
+    CC_SHA256_Final(digest, &context);
+
+    NSMutableString *contentHash = [NSMutableString stringWithCapacity:CC_SHA256_DIGEST_LENGTH * 2];
+    for (NSUInteger i = 0; i < CC_SHA256_DIGEST_LENGTH; i++)
+    {
+        [contentHash appendFormat:@"%02x", digest[i]];
+    }
+
+    return contentHash;
+}
+
++ (void)updateHashContext:(CC_SHA256_CTX*)context withJSON:(id)JSONObject
+{
+    // Each value is prefixed by its type and, for containers and strings, by its length
+    // so that different contents cannot produce the same stream
+    if ([JSONObject isKindOfClass:NSDictionary.class])
+    {
+        NSDictionary *dictionary = JSONObject;
+        [MXTools updateHashContext:context withTag:'d' andString:[NSString stringWithFormat:@"%tu", dictionary.count]];
+
+        for (NSString *key in [dictionary.allKeys sortedArrayUsingSelector:@selector(compare:)])
+        {
+            [MXTools updateHashContext:context withJSON:key];
+            [MXTools updateHashContext:context withJSON:dictionary[key]];
+        }
+    }
+    else if ([JSONObject isKindOfClass:NSArray.class])
+    {
+        NSArray *array = JSONObject;
+        [MXTools updateHashContext:context withTag:'a' andString:[NSString stringWithFormat:@"%tu", array.count]];
+
+        for (id item in array)
+        {
+            [MXTools updateHashContext:context withJSON:item];
+        }
+    }
+    else if ([JSONObject isKindOfClass:NSString.class])
+    {
+        [MXTools updateHashContext:context withTag:'s' andString:JSONObject];
+    }
+    else if ([JSONObject isKindOfClass:NSNumber.class] && CFGetTypeID((__bridge CFTypeRef)JSONObject) == CFBooleanGetTypeID())
+    {
+        // JSON booleans are NSNumbers too but true and 1 must not have the same hash
+        [MXTools updateHashContext:context withTag:'b' andString:[JSONObject boolValue] ? @"true" : @"false"];
+    }
+    else if ([JSONObject isKindOfClass:NSNumber.class])
+    {
+        [MXTools updateHashContext:context withTag:'n' andString:[JSONObject stringValue]];
+    }
+    else
+    {
+        [MXTools updateHashContext:context withTag:'0' andString:nil];
+    }
+}
+
++ (void)updateHashContext:(CC_SHA256_CTX*)context withTag:(char)tag andString:(NSString*)string
+{
+    NSData *data = [string dataUsingEncoding:NSUTF8StringEncoding];
+    uint64_t length = data.length;
+
+    CC_SHA256_Update(context, &tag, 1);
+    CC_SHA256_Update(context, &length, sizeof(length));
+    CC_SHA256_Update(context, data.bytes, (CC_LONG)data.length);
+}
+
 @end
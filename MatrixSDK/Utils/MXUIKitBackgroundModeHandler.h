@@ -0,0 +1,33 @@
+/*
+ Copyright 2016 OpenMarket Ltd
+
+ Licensed under the Apache License, Version 2.0 (the "License");
+ you may not use this file except in compliance with the License.
+ You may obtain a copy of the License at
+
+ http://www.apache.org/licenses/LICENSE-2.0
+
+ Unless required by applicable law or agreed to in writing, software
+ distributed under the License is distributed on an "AS IS" BASIS,
+ WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ See the License for the specific language governing permissions and
+ limitations under the License.
+ */
+
+#import <Foundation/Foundation.h>
+
+#import "MXBackgroundModeHandler.h"
+
+#if TARGET_OS_IPHONE
+
+/**
+ `MXUIKitBackgroundModeHandler` is the `MXBackgroundModeHandler` based on `UIApplication`
+ background tasks. This is the default handler.
+
+ A task is also stopped when it is released.
+ */
+@interface MXUIKitBackgroundModeHandler : NSObject <MXBackgroundModeHandler>
+
+@end
+
+#endif // TARGET_OS_IPHONE
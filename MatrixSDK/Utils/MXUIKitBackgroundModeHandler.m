@@ -0,0 +1,95 @@
+/*
+ Copyright 2016 OpenMarket Ltd
+
+ Licensed under the Apache License, Version 2.0 (the "License");
+ you may not use this file except in compliance with the License.
+ You may obtain a copy of the License at
+
+ http://www.apache.org/licenses/LICENSE-2.0
+
+ Unless required by applicable law or agreed to in writing, software
+ distributed under the License is distributed on an "AS IS" BASIS,
+ WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ See the License for the specific language governing permissions and
+ limitations under the License.
+ */
+
+#import "MXUIKitBackgroundModeHandler.h"
+
+#if TARGET_OS_IPHONE
+
+#import <UIKit/UIKit.h>
+
+#pragma mark - MXUIKitBackgroundTask
+@interface MXUIKitBackgroundTask : NSObject <MXBackgroundTask>
+{
+    UIBackgroundTaskIdentifier identifier;
+}
+
+- (instancetype)initWithName:(NSString*)name expirationHandler:(void (^)())expirationHandler;
+
+@end
+
+@implementation MXUIKitBackgroundTask
+@synthesize name;
+
+- (instancetype)initWithName:(NSString *)name2 expirationHandler:(void (^)())expirationHandler
+{
+    self = [super init];
+    if (self)
+    {
+        name = name2;
+
+        __weak typeof(self) weakSelf = self;
+        identifier = [[UIApplication sharedApplication] beginBackgroundTaskWithName:name expirationHandler:^{
+
+            __strong __typeof(weakSelf)strongSelf = weakSelf;
+
+            NSLog(@"[MXUIKitBackgroundTask] Background task %@ is going to expire", strongSelf.name);
+
+            if (expirationHandler)
+            {
+                expirationHandler();
+            }
+
+            // The system requires the task to be ended now
+            [strongSelf stop];
+        }];
+
+        if (identifier == UIBackgroundTaskInvalid)
+        {
+            NSLog(@"[MXUIKitBackgroundTask] Cannot start background task %@", name);
+            return nil;
+        }
+    }
+    return self;
+}
+
+- (void)stop
+{
+    if (identifier != UIBackgroundTaskInvalid)
+    {
+        [[UIApplication sharedApplication] endBackgroundTask:identifier];
+        identifier = UIBackgroundTaskInvalid;
+    }
+}
+
+- (void)dealloc
+{
+    [self stop];
+}
+
+@end
+
+
+#pragma mark - MXUIKitBackgroundModeHandler
+@implementation MXUIKitBackgroundModeHandler
+
+- (id<MXBackgroundTask>)startBackgroundTaskWithName:(NSString *)name expirationHandler:(void (^)())expirationHandler
+{
+    return [[MXUIKitBackgroundTask alloc] initWithName:name expirationHandler:expirationHandler];
+}
+
+@end
+
+#endif // TARGET_OS_IPHONE
@@ -14,7 +14,10 @@
  limitations under the License.
  */
 
+#import <Foundation/Foundation.h>
+#if TARGET_OS_IPHONE
 #import <UIKit/UIKit.h>
+#endif
 #import <AVFoundation/AVCaptureDevice.h>
 
 @protocol MXCallStackCallDelegate;
@@ -122,6 +125,7 @@
  */
 @property (nonatomic) id<MXCallStackCallDelegate> delegate;
 
+#if TARGET_OS_IPHONE
 /**
  The UIView that receives frames from the user's camera.
  */
@@ -137,6 +141,7 @@
  on the other peer device.
  */
 @property (nonatomic) UIDeviceOrientation selfOrientation;
+#endif // TARGET_OS_IPHONE
 
 /**
  Mute state of the outbound audio.
@@ -15,7 +15,9 @@
  */
 
 #import <Foundation/Foundation.h>
+#if TARGET_OS_IPHONE
 #import <UIKit/UIKit.h>
+#endif
 
 #import "MXEvent.h"
 #import "MXCallStackCall.h"
@@ -148,6 +150,7 @@ extern NSString *const kMXCallStateDidChange;
  */
 @property (readonly, nonatomic) NSString *callerId;
 
+#if TARGET_OS_IPHONE
 /**
  The UIView that receives frames from the user's camera.
  */
@@ -163,6 +166,7 @@ extern NSString *const kMXCallStateDidChange;
  on the other peer device.
  */
 @property (nonatomic) UIDeviceOrientation selfOrientation;
+#endif // TARGET_OS_IPHONE
 
 /**
  Mute state of the audio.
@@ -191,6 +195,20 @@ extern NSString *const kMXCallStateDidChange;
  */
 @property (nonatomic, readonly) NSUInteger duration;
 
+/**
+ The time in milliseconds spent to set up the call.
+ 
+ It is measured from the creation of the call object (the user placed the call or the
+ invite has been received) to the connection. 0 if the call has not been connected.
+ */
+@property (nonatomic, readonly) NSUInteger setupDuration;
+
+/**
+ The time in milliseconds between the creation of the call and the sending of the first
+ local ICE candidate. 0 if no candidate has been sent yet.
+ */
+@property (nonatomic, readonly) NSUInteger firstICECandidateDelay;
+
 /**
  The delegate.
  */
@@ -22,6 +22,17 @@
 #pragma mark - Constants definitions
 NSString *const kMXCallStateDidChange = @"kMXCallStateDidChange";
 
+/**
+ The initial time window in seconds used to batch local ICE candidates once the first
+ one has been sent.
+ */
+#define MXCALL_ICE_CANDIDATES_BATCH_MIN_WINDOW 0.02
+
+/**
+ The max time window in seconds used to batch local ICE candidates.
+ */
+#define MXCALL_ICE_CANDIDATES_BATCH_MAX_WINDOW 0.5
+
 @interface MXCall ()
 {
     /**
@@ -63,6 +74,23 @@ NSString *const kMXCallStateDidChange = @"kMXCallStateDidChange";
      Timer for sending local ICE candidates.
      */
     NSTimer *localIceGatheringTimer;
+
+    /**
+     The current time window used to batch local ICE candidates.
+     0 until the first candidate is sent.
+     */
+    NSTimeInterval localICECandidatesBatchWindow;
+
+    /**
+     YES once the invite or the answer has been sent. Local ICE candidates are held until
+     then: the peer would ignore candidates received before them.
+     */
+    BOOL canSendLocalICECandidates;
+
+    /**
+     The date when the call object has been created. Used to compute setup metrics.
+     */
+    NSDate *callCreationDate;
 }
 
 @end
@@ -94,6 +122,7 @@ NSString *const kMXCallStateDidChange = @"kMXCallStateDidChange";
         _isConferenceCall = (2 < _room.state.joinedMembers.count);
 
         localICECandidates = [NSMutableArray array];
+        callCreationDate = [NSDate date];
 
         // Prevent the session from being paused so that the client can send call matrix
         // events to the other peer to establish the call  even if the app goes in background
@@ -273,6 +302,10 @@ NSString *const kMXCallStateDidChange = @"kMXCallStateDidChange";
 
                 [self setState:MXCallStateInviteSent reason:nil];
 
+                // Send the candidates gathered meanwhile
+                canSendLocalICECandidates = YES;
+                [self trickleLocalIceCandidates];
+
             } failure:^(NSError *error) {
                 NSLog(@"[MXCall] callWithVideo: ERROR: Cannot send m.call.invite event. Error: %@", error);
                 [self didEncounterError:error];
@@ -323,6 +356,10 @@ NSString *const kMXCallStateDidChange = @"kMXCallStateDidChange";
                                       };
             [_callSignalingRoom sendEventOfType:kMXEventTypeStringCallAnswer content:content success:^(NSString *eventId) {
 
+                // Send the candidates gathered meanwhile
+                canSendLocalICECandidates = YES;
+                [self trickleLocalIceCandidates];
+
                 // @TODO: This is false
                 [self setState:MXCallStateConnected reason:nil];
                 
@@ -369,6 +406,9 @@ NSString *const kMXCallStateDidChange = @"kMXCallStateDidChange";
     {
         // Set the start point
         callConnectedDate = [NSDate date];
+
+        _setupDuration = [callConnectedDate timeIntervalSinceDate:callCreationDate] * 1000;
+        NSLog(@"[MXCall] Call %@ connected. Setup duration: %tums. First ICE candidate sent after %tums", _callId, _setupDuration, _firstICECandidateDelay);
     }
     else if (MXCallStateEnded == state)
     {
@@ -401,6 +441,7 @@ NSString *const kMXCallStateDidChange = @"kMXCallStateDidChange";
     [[NSNotificationCenter defaultCenter] postNotificationName:kMXCallStateDidChange object:self userInfo:nil];
 }
 
+#if TARGET_OS_IPHONE
 - (void)setSelfVideoView:(UIView *)selfVideoView
 {
     if (selfVideoView != _selfVideoView)
@@ -431,6 +472,7 @@ NSString *const kMXCallStateDidChange = @"kMXCallStateDidChange";
         callStackCall.selfOrientation = selfOrientation;
     }
 }
+#endif // TARGET_OS_IPHONE
 
 - (BOOL)audioMuted
 {
@@ -504,10 +546,34 @@ NSString *const kMXCallStateDidChange = @"kMXCallStateDidChange";
                                     }
      ];
 
-    // Send candidates every 100ms max. This value gives enough time to the underlaying call stack
-    // to gather several ICE candidates
-    [localIceGatheringTimer invalidate];
-    localIceGatheringTimer = [NSTimer scheduledTimerWithTimeInterval:0.1 target:self selector:@selector(sendLocalIceCandidates) userInfo:self repeats:NO];
+    [self trickleLocalIceCandidates];
+}
+
+/**
+ Send the pending local ICE candidates: the first one immediately, then by batches.
+ */
+- (void)trickleLocalIceCandidates
+{
+    if (!canSendLocalICECandidates || !localICECandidates.count)
+    {
+        return;
+    }
+
+    if (0 == localICECandidatesBatchWindow)
+    {
+        // Send the first candidates immediately so that the peer can start connectivity checks
+        [self sendLocalIceCandidates];
+        localICECandidatesBatchWindow = MXCALL_ICE_CANDIDATES_BATCH_MIN_WINDOW;
+    }
+    else if (!localIceGatheringTimer)
+    {
+        // Then, batch the next candidates. The window grows for each batch because the underlaying
+        // call stack gathers candidates more slowly once host candidates have been found.
+        // The timer is not restarted on new candidates so that the sending delay is bounded.
+        localIceGatheringTimer = [NSTimer scheduledTimerWithTimeInterval:localICECandidatesBatchWindow target:self selector:@selector(sendLocalIceCandidates) userInfo:self repeats:NO];
+
+        localICECandidatesBatchWindow = MIN(localICECandidatesBatchWindow * 2, MXCALL_ICE_CANDIDATES_BATCH_MAX_WINDOW);
+    }
 }
 
 - (void)sendLocalIceCandidates
@@ -516,12 +582,17 @@ NSString *const kMXCallStateDidChange = @"kMXCallStateDidChange";
 
     if (localICECandidates.count)
     {
+        if (!_firstICECandidateDelay)
+        {
+            _firstICECandidateDelay = [[NSDate date] timeIntervalSinceDate:callCreationDate] * 1000;
+        }
+
         NSLog(@"MXCall] onICECandidate: Send %tu candidates", localICECandidates.count);
 
         NSDictionary *content = @{
                                   @"version": @(0),
                                   @"call_id": _callId,
-                                  @"candidates": localICECandidates
+                                  @"candidates": [localICECandidates copy]
                                   };
 
         [_callSignalingRoom sendEventOfType:kMXEventTypeStringCallCandidates content:content success:nil failure:^(NSError *error) {
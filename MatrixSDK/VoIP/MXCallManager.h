@@ -91,6 +91,26 @@ extern NSString *const kMXCallManagerConferenceFinished;
                 success:(void (^)(MXCall *call))success
                 failure:(void (^)(NSError *error))failure;
 
+/**
+ Handle call signalling events before the bulk processing of a server sync response.
+
+ Call events are then dispatched to the calls without waiting for their room to be
+ processed, which reduces the ringing delay when catching up. The events are ignored
+ when they come later through the normal room events flow.
+
+ @param events the call events (m.call.*) of the sync response, in chronological order per room.
+ */
+- (void)handleCallEventsInAdvance:(NSArray<MXEvent*>*)events;
+
+/**
+ Forget the events passed to `handleCallEventsInAdvance:`.
+
+ It must be called at the end of the processing of the server sync response. Events
+ that did not come through the normal flow (in a left room for example) are then not
+ ignored if they are received again.
+ */
+- (void)forgetCallEventsHandledInAdvance;
+
 /**
  Make the call manager forget a call.
  
@@ -117,6 +137,9 @@ extern NSString *const kMXCallManagerConferenceFinished;
 /**
  The list of TURN/STUN servers advertised by the user's homeserver.
  Can be nil. In this case, use `fallbackSTUNServer`.
+
+ The credentials are cached in the Keychain until their TTL expires so that they are
+ available for the first call after an app restart.
  */
 @property (nonatomic, readonly) MXTurnServerResponse *turnServers;
 
@@ -16,6 +16,8 @@
 
 #import "MXCallManager.h"
 
+#import <Security/Security.h>
+
 #import "MXSession.h"
 
 #import "MXTools.h"
@@ -28,6 +30,14 @@ NSString *const kMXCallManagerConferenceFinished= @"kMXCallManagerConferenceFini
 // Use Google STUN server as fallback
 NSString *const kMXCallManagerFallbackSTUNServer = @"stun:stun.l.google.com:19302";
 
+// The Keychain service under which TURN server credentials are cached, by user id
+NSString *const kMXCallManagerTURNServersKeychainService = @"org.matrix.sdk.MXCallManager.turnServers";
+
+/**
+ The minimum remaining validity in seconds of cached TURN server credentials to be reused.
+ */
+#define MXCALLMANAGER_TURN_SERVERS_MIN_TTL 60
+
 @interface MXCallManager ()
 {
     /**
@@ -44,6 +54,11 @@ NSString *const kMXCallManagerFallbackSTUNServer = @"stun:stun.l.google.com:1930
      Timer to periodically refresh the TURN server config.
      */
     NSTimer *refreshTURNServerTimer;
+
+    /**
+     Ids of the call events handled by `handleCallEventsInAdvance:` in the current server sync.
+     */
+    NSMutableSet<NSString*> *eventIdsHandledInAdvance;
 }
 @end
 
@@ -57,6 +72,7 @@ NSString *const kMXCallManagerFallbackSTUNServer = @"stun:stun.l.google.com:1930
     {
         _mxSession = mxSession;
         calls = [NSMutableArray array];
+        eventIdsHandledInAdvance = [NSMutableSet set];
         _fallbackSTUNServer = kMXCallManagerFallbackSTUNServer;
         _inviteLifetime = 30000;
 
@@ -73,30 +89,27 @@ NSString *const kMXCallManagerFallbackSTUNServer = @"stun:stun.l.google.com:1930
 
             if (MXTimelineDirectionForwards == direction)
             {
-                switch (event.eventType)
+                // Ignore events already handled by the sync fast lane
+                if (event.eventId && [eventIdsHandledInAdvance containsObject:event.eventId])
                 {
-                    case MXEventTypeCallInvite:
-                        [self handleCallInvite:event];
-                        break;
-
-                    case MXEventTypeCallAnswer:
-                        [self handleCallAnswer:event];
-                        break;
-
-                    case MXEventTypeCallHangup:
-                        [self handleCallHangup:event];
-                        break;
-
-                    case MXEventTypeCallCandidates:
-                        [self handleCallCandidates:event];
-                        break;
-                    default:
-                        break;
+                    [eventIdsHandledInAdvance removeObject:event.eventId];
+                    return;
                 }
+
+                [self handleCallEvent:event];
             }
         }];
 
-        [self refreshTURNServer];
+        // Use the TURN servers credentials of a previous session if they are still valid.
+        // Else, fetch them now so that they are available for the first call
+        if ([self loadCachedTURNServers])
+        {
+            [self scheduleTURNServerRefresh];
+        }
+        else
+        {
+            [self refreshTURNServer];
+        }
     }
     return self;
 }
@@ -225,6 +238,24 @@ NSString *const kMXCallManagerFallbackSTUNServer = @"stun:stun.l.google.com:1930
     }
 }
 
+- (void)handleCallEventsInAdvance:(NSArray<MXEvent *> *)events
+{
+    for (MXEvent *event in events)
+    {
+        if (event.eventId)
+        {
+            [eventIdsHandledInAdvance addObject:event.eventId];
+        }
+
+        [self handleCallEvent:event];
+    }
+}
+
+- (void)forgetCallEventsHandledInAdvance
+{
+    [eventIdsHandledInAdvance removeAllObjects];
+}
+
 - (void)removeCall:(MXCall *)call
 {
     [calls removeObject:call];
@@ -232,6 +263,30 @@ NSString *const kMXCallManagerFallbackSTUNServer = @"stun:stun.l.google.com:1930
 
 
 #pragma mark - Private methods
+- (void)handleCallEvent:(MXEvent*)event
+{
+    switch (event.eventType)
+    {
+        case MXEventTypeCallInvite:
+            [self handleCallInvite:event];
+            break;
+
+        case MXEventTypeCallAnswer:
+            [self handleCallAnswer:event];
+            break;
+
+        case MXEventTypeCallHangup:
+            [self handleCallHangup:event];
+            break;
+
+        case MXEventTypeCallCandidates:
+            [self handleCallCandidates:event];
+            break;
+        default:
+            break;
+    }
+}
+
 - (void)refreshTURNServer
 {
     [_mxSession.matrixRestClient turnServer:^(MXTurnServerResponse *turnServerResponse) {
@@ -244,20 +299,16 @@ NSString *const kMXCallManagerFallbackSTUNServer = @"stun:stun.l.google.com:1930
             if (turnServerResponse.uris)
             {
                 _turnServers = turnServerResponse;
+                [self saveTURNServers];
 
                 // Re-new when we're about to reach the TTL
-                refreshTURNServerTimer = [[NSTimer alloc] initWithFireDate:[NSDate dateWithTimeIntervalSinceNow:turnServerResponse.ttl * 0.9]
-                                                                  interval:0
-                                                                    target:self
-                                                                  selector:@selector(refreshTURNServer)
-                                                                  userInfo:nil
-                                                                   repeats:NO];
-                [[NSRunLoop mainRunLoop] addTimer:refreshTURNServerTimer forMode:NSDefaultRunLoopMode];
+                [self scheduleTURNServerRefresh];
             }
             else
             {
                 NSLog(@"No TURN server: using fallback STUN server: %@", _fallbackSTUNServer);
                 _turnServers = nil;
+                [self saveTURNServers];
             }
         }
 
@@ -271,6 +322,107 @@ NSString *const kMXCallManagerFallbackSTUNServer = @"stun:stun.l.google.com:1930
     }];
 }
 
+- (void)scheduleTURNServerRefresh
+{
+    [refreshTURNServerTimer invalidate];
+
+    // Re-new when we're about to reach the TTL
+    refreshTURNServerTimer = [[NSTimer alloc] initWithFireDate:[NSDate dateWithTimeIntervalSinceNow:_turnServers.ttl * 0.9]
+                                                      interval:0
+                                                        target:self
+                                                      selector:@selector(refreshTURNServer)
+                                                      userInfo:nil
+                                                       repeats:NO];
+    [[NSRunLoop mainRunLoop] addTimer:refreshTURNServerTimer forMode:NSDefaultRunLoopMode];
+}
+
+- (NSDictionary*)TURNServersKeychainQuery
+{
+    NSString *userId = _mxSession.matrixRestClient.credentials.userId;
+    if (!userId)
+    {
+        return nil;
+    }
+
+    return @{
+             (__bridge id)kSecClass: (__bridge id)kSecClassGenericPassword,
+             (__bridge id)kSecAttrService: kMXCallManagerTURNServersKeychainService,
+             (__bridge id)kSecAttrAccount: userId
+             };
+}
+
+- (BOOL)loadCachedTURNServers
+{
+    NSDictionary *query = [self TURNServersKeychainQuery];
+    if (!query)
+    {
+        return NO;
+    }
+
+    NSMutableDictionary *searchQuery = [NSMutableDictionary dictionaryWithDictionary:query];
+    searchQuery[(__bridge id)kSecReturnData] = @(YES);
+    searchQuery[(__bridge id)kSecMatchLimit] = (__bridge id)kSecMatchLimitOne;
+
+    CFTypeRef result = NULL;
+    OSStatus status = SecItemCopyMatching((__bridge CFDictionaryRef)searchQuery, &result);
+    if (errSecSuccess != status)
+    {
+        if (errSecItemNotFound != status)
+        {
+            NSLog(@"[MXCallManager] loadCachedTURNServers: Cannot read the Keychain. Status: %d", (int)status);
+        }
+        return NO;
+    }
+
+    NSData *data = (__bridge_transfer NSData*)result;
+
+    // The archive contains the absolute expiration date of the credentials
+    MXTurnServerResponse *turnServers;
+    @try
+    {
+        turnServers = [NSKeyedUnarchiver unarchiveObjectWithData:data];
+    }
+    @catch (NSException *exception)
+    {
+        NSLog(@"[MXCallManager] loadCachedTURNServers: Cannot decode the cache: %@", exception);
+    }
+
+    if (turnServers.uris && turnServers.ttl > MXCALLMANAGER_TURN_SERVERS_MIN_TTL)
+    {
+        NSLog(@"[MXCallManager] loadCachedTURNServers: Use cached TURN servers. TTL:%tu URIs: %@", turnServers.ttl, turnServers.uris);
+        _turnServers = turnServers;
+        return YES;
+    }
+    return NO;
+}
+
+- (void)saveTURNServers
+{
+    NSDictionary *query = [self TURNServersKeychainQuery];
+    if (!query)
+    {
+        return;
+    }
+
+    // Replace the previous credentials
+    SecItemDelete((__bridge CFDictionaryRef)query);
+
+    if (_turnServers)
+    {
+        NSMutableDictionary *item = [NSMutableDictionary dictionaryWithDictionary:query];
+        item[(__bridge id)kSecValueData] = [NSKeyedArchiver archivedDataWithRootObject:_turnServers];
+
+        // The credentials must be available when the app is launched in background for a call
+        item[(__bridge id)kSecAttrAccessible] = (__bridge id)kSecAttrAccessibleAfterFirstUnlock;
+
+        OSStatus status = SecItemAdd((__bridge CFDictionaryRef)item, NULL);
+        if (errSecSuccess != status)
+        {
+            NSLog(@"[MXCallManager] saveTURNServers: Cannot write the Keychain. Status: %d", (int)status);
+        }
+    }
+}
+
 - (void)handleCallInvite:(MXEvent*)event
 {
     MXCallInviteEventContent *content = [MXCallInviteEventContent modelFromJSON:event.content];
@@ -0,0 +1,325 @@
+/*
+ Copyright 2016 OpenMarket Ltd
+
+ Licensed under the Apache License, Version 2.0 (the "License");
+ you may not use this file except in compliance with the License.
+ You may obtain a copy of the License at
+
+ http://www.apache.org/licenses/LICENSE-2.0
+
+ Unless required by applicable law or agreed to in writing, software
+ distributed under the License is distributed on an "AS IS" BASIS,
+ WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ See the License for the specific language governing permissions and
+ limitations under the License.
+ */
+
+#import <UIKit/UIKit.h>
+#import <XCTest/XCTest.h>
+
+#import "MXSession.h"
+#import "MXFileStore.h"
+#import "MXHTTPClient.h"
+#import "MXSDKOptions.h"
+#import "MXBackgroundModeHandler.h"
+
+#import "MatrixSDKTestsData.h"
+
+#pragma mark - Fake background mode handler
+@interface MXBackgroundModeHandlerTestsTask : NSObject <MXBackgroundTask>
+
+@property (nonatomic) NSString *name;
+@property (nonatomic, copy) void (^expirationHandler)();
+@property (nonatomic) BOOL isStopped;
+
+@end
+
+@implementation MXBackgroundModeHandlerTestsTask
+
+- (void)stop
+{
+    _isStopped = YES;
+}
+
+@end
+
+@interface MXBackgroundModeHandlerTestsHandler : NSObject <MXBackgroundModeHandler>
+
+@property (nonatomic) NSMutableArray<MXBackgroundModeHandlerTestsTask*> *tasks;
+
+@end
+
+@implementation MXBackgroundModeHandlerTestsHandler
+
+- (instancetype)init
+{
+    self = [super init];
+    if (self)
+    {
+        _tasks = [NSMutableArray array];
+    }
+    return self;
+}
+
+- (id<MXBackgroundTask>)startBackgroundTaskWithName:(NSString *)name expirationHandler:(void (^)())expirationHandler
+{
+    MXBackgroundModeHandlerTestsTask *task = [[MXBackgroundModeHandlerTestsTask alloc] init];
+    task.name = name;
+    task.expirationHandler = expirationHandler;
+    [_tasks addObject:task];
+    return task;
+}
+
+- (NSArray<MXBackgroundModeHandlerTestsTask*>*)tasksWithName:(NSString*)name
+{
+    return [_tasks filteredArrayUsingPredicate:[NSPredicate predicateWithFormat:@"name == %@", name]];
+}
+
+@end
+
+
+#pragma mark - Fake rest client
+/**
+ A MXRestClient that never sends /sync requests.
+ */
+@interface MXBackgroundModeHandlerTestsRestClient : MXRestClient
+@end
+
+@implementation MXBackgroundModeHandlerTestsRestClient
+
+- (MXHTTPOperation *)syncFromToken:(NSString*)token
+                     serverTimeout:(NSUInteger)serverTimeout
+                     clientTimeout:(NSUInteger)clientTimeout
+                       setPresence:(NSString*)setPresence
+                            filter:(NSString*)filterId
+                           success:(void (^)(MXSyncResponse *syncResponse))success
+                           failure:(void (^)(NSError *error))failure
+{
+    return [[MXHTTPOperation alloc] init];
+}
+
+- (void)prewarmConnection
+{
+}
+
+@end
+
+
+#pragma mark - Tests
+@interface MXBackgroundModeHandlerTests : XCTestCase
+{
+    id<MXBackgroundModeHandler> defaultBackgroundModeHandler;
+    MXBackgroundModeHandlerTestsHandler *backgroundModeHandler;
+
+    MXCredentials *credentials;
+    MXSession *mxSession;
+}
+
+@end
+
+@implementation MXBackgroundModeHandlerTests
+
+- (void)setUp
+{
+    [super setUp];
+
+    defaultBackgroundModeHandler = [MXSDKOptions sharedInstance].backgroundModeHandler;
+    backgroundModeHandler = [[MXBackgroundModeHandlerTestsHandler alloc] init];
+    [MXSDKOptions sharedInstance].backgroundModeHandler = backgroundModeHandler;
+
+    credentials = [[MXCredentials alloc] initWithHomeServer:@"https://matrix.org" userId:@"@alice:matrix.org" accessToken:@"token"];
+}
+
+- (void)tearDown
+{
+    [mxSession close];
+    mxSession = nil;
+
+    [MXSDKOptions sharedInstance].backgroundModeHandler = defaultBackgroundModeHandler;
+
+    [super tearDown];
+}
+
+- (MXSession*)sessionWithFakeRestClient
+{
+    MXRestClient *restClient = [[MXBackgroundModeHandlerTestsRestClient alloc] initWithCredentials:credentials andOnUnrecognizedCertificateBlock:nil];
+    return [[MXSession alloc] initWithMatrixRestClient:restClient];
+}
+
+- (void)testSessionPauseAndResume
+{
+    mxSession = [self sessionWithFakeRestClient];
+
+    [mxSession retainPreventPause];
+    [mxSession pause];
+
+    NSArray<MXBackgroundModeHandlerTestsTask*> *tasks = [backgroundModeHandler tasksWithName:@"MXSessionBackgroundTask"];
+    XCTAssertEqual(tasks.count, 1, @"A session prevented from pausing must run in background");
+    XCTAssertFalse(tasks[0].isStopped);
+    XCTAssertEqual(mxSession.state, MXSessionStatePauseRequested);
+
+    // Pausing again does not start another task
+    [mxSession pause];
+    XCTAssertEqual([backgroundModeHandler tasksWithName:@"MXSessionBackgroundTask"].count, 1);
+
+    [mxSession resume:nil];
+    XCTAssert(tasks[0].isStopped, @"The task must be stopped on resume");
+}
+
+- (void)testSessionReleasePreventPause
+{
+    mxSession = [self sessionWithFakeRestClient];
+
+    [mxSession retainPreventPause];
+    [mxSession pause];
+
+    MXBackgroundModeHandlerTestsTask *task = [backgroundModeHandler tasksWithName:@"MXSessionBackgroundTask"].firstObject;
+    XCTAssertNotNil(task);
+
+    [mxSession releasePreventPause];
+    XCTAssert(task.isStopped, @"The task must be stopped when nobody prevents the pause anymore");
+}
+
+- (void)testSessionBackgroundTaskExpiration
+{
+    mxSession = [self sessionWithFakeRestClient];
+
+    [mxSession retainPreventPause];
+    [mxSession pause];
+
+    MXBackgroundModeHandlerTestsTask *task = [backgroundModeHandler tasksWithName:@"MXSessionBackgroundTask"].firstObject;
+    task.expirationHandler();
+
+    XCTAssert(task.isStopped, @"The session must release its task when the system is going to suspend the app");
+
+    // The pause is no more prevented
+    [mxSession pause];
+    XCTAssertEqual([backgroundModeHandler tasksWithName:@"MXSessionBackgroundTask"].count, 1);
+}
+
+- (void)testSessionClose
+{
+    mxSession = [self sessionWithFakeRestClient];
+
+    [mxSession retainPreventPause];
+    [mxSession pause];
+
+    MXBackgroundModeHandlerTestsTask *task = [backgroundModeHandler tasksWithName:@"MXSessionBackgroundTask"].firstObject;
+
+    [mxSession close];
+    mxSession = nil;
+
+    XCTAssert(task.isStopped, @"The task must be stopped when the session is closed");
+}
+
+- (void)testHTTPClientRequest
+{
+    MXHTTPClient *httpClient = [[MXHTTPClient alloc] initWithBaseURL:[NSString stringWithFormat:@"%@%@", kMXTestsHomeServerURL, kMXAPIPrefixPathR0]
+                                   andOnUnrecognizedCertificateBlock:nil];
+
+    XCTestExpectation *expectation = [self expectationWithDescription:@"asyncTest"];
+
+    [httpClient requestWithMethod:@"GET" path:@"publicRooms" parameters:nil success:^(NSDictionary *JSONResponse) {
+
+        NSArray<MXBackgroundModeHandlerTestsTask*> *tasks = [backgroundModeHandler tasksWithName:@"MXHTTPClient"];
+        XCTAssertEqual(tasks.count, 1, @"A request must run in background");
+
+        // The task is stopped once the request is complete
+        dispatch_after(dispatch_time(DISPATCH_TIME_NOW, (int64_t)(0.1 * NSEC_PER_SEC)), dispatch_get_main_queue(), ^{
+            XCTAssert(tasks.firstObject.isStopped);
+            [expectation fulfill];
+        });
+
+    } failure:^(NSError *error) {
+        XCTFail(@"The request should not fail - NSError: %@", error);
+        [expectation fulfill];
+    }];
+
+    [self waitForExpectationsWithTimeout:10 handler:nil];
+}
+
+- (void)testHTTPClientRequestWithNoHandler
+{
+    [MXSDKOptions sharedInstance].backgroundModeHandler = nil;
+
+    MXHTTPClient *httpClient = [[MXHTTPClient alloc] initWithBaseURL:[NSString stringWithFormat:@"%@%@", kMXTestsHomeServerURL, kMXAPIPrefixPathR0]
+                                   andOnUnrecognizedCertificateBlock:nil];
+
+    XCTestExpectation *expectation = [self expectationWithDescription:@"asyncTest"];
+
+    [httpClient requestWithMethod:@"GET" path:@"publicRooms" parameters:nil success:^(NSDictionary *JSONResponse) {
+
+        XCTAssertEqual(backgroundModeHandler.tasks.count, 0);
+        [expectation fulfill];
+
+    } failure:^(NSError *error) {
+        XCTFail(@"The request should not fail - NSError: %@", error);
+        [expectation fulfill];
+    }];
+
+    [self waitForExpectationsWithTimeout:10 handler:nil];
+}
+
+- (void)testFileStoreOpenAndCommit
+{
+    XCTestExpectation *expectation = [self expectationWithDescription:@"asyncTest"];
+
+    MXFileStore *store = [[MXFileStore alloc] init];
+    [store openWithCredentials:credentials onComplete:^{
+
+        MXBackgroundModeHandlerTestsTask *openTask = [backgroundModeHandler tasksWithName:@"openWithCredentials"].firstObject;
+        XCTAssertNotNil(openTask);
+        XCTAssert(openTask.isStopped, @"The task must be stopped once the store is open");
+
+        [store storePaginationTokenOfRoom:@"!room:matrix.org" andToken:@"token"];
+        [store commit];
+
+        MXBackgroundModeHandlerTestsTask *commitTask = [backgroundModeHandler tasksWithName:@"commit"].firstObject;
+        XCTAssertNotNil(commitTask, @"A commit must run in background");
+        XCTAssertFalse(commitTask.isStopped);
+
+        // Wait for the end of the commit
+        [store close];
+
+        dispatch_async(dispatch_get_main_queue(), ^{
+
+            XCTAssert(commitTask.isStopped, @"The task must be stopped once the data is written");
+
+            [store deleteAllData];
+            [expectation fulfill];
+        });
+
+    } failure:^(NSError *error) {
+        XCTFail(@"The request should not fail - NSError: %@", error);
+        [expectation fulfill];
+    }];
+
+    [self waitForExpectationsWithTimeout:10 handler:nil];
+}
+
+- (void)testFileStoreWithNoHandler
+{
+    [MXSDKOptions sharedInstance].backgroundModeHandler = nil;
+
+    XCTestExpectation *expectation = [self expectationWithDescription:@"asyncTest"];
+
+    MXFileStore *store = [[MXFileStore alloc] init];
+    [store openWithCredentials:credentials onComplete:^{
+
+        [store commit];
+        [store close];
+
+        XCTAssertEqual(backgroundModeHandler.tasks.count, 0);
+
+        [store deleteAllData];
+        [expectation fulfill];
+
+    } failure:^(NSError *error) {
+        XCTFail(@"The request should not fail - NSError: %@", error);
+        [expectation fulfill];
+    }];
+
+    [self waitForExpectationsWithTimeout:10 handler:nil];
+}
+
+@end
@@ -0,0 +1,419 @@
+/*
+ Copyright 2016 OpenMarket Ltd
+
+ Licensed under the Apache License, Version 2.0 (the "License");
+ you may not use this file except in compliance with the License.
+ You may obtain a copy of the License at
+
+ http://www.apache.org/licenses/LICENSE-2.0
+
+ Unless required by applicable law or agreed to in writing, software
+ distributed under the License is distributed on an "AS IS" BASIS,
+ WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ See the License for the specific language governing permissions and
+ limitations under the License.
+ */
+
+#import <UIKit/UIKit.h>
+#import <XCTest/XCTest.h>
+
+#import <mach/mach_time.h>
+#import <stdatomic.h>
+
+#import "MXEvent.h"
+#import "MXRoomState.h"
+#import "MXNotificationCenter.h"
+#import "MXEventsByTypesEnumeratorOnArray.h"
+#import "MXMemoryStore.h"
+#import "MXReceiptData.h"
+
+/**
+ The minimum duration in seconds of the measure of a benchmark.
+ */
+#define MXBENCHMARK_MEASURE_DURATION_S 0.1
+
+/**
+ The minimum number of iterations of a benchmark.
+ */
+#define MXBENCHMARK_MIN_ITERATIONS 10
+
+/**
+ The environment variable giving the path of the file where results are appended.
+ */
+#define MXBENCHMARK_OUTPUT_ENV @"MXBENCHMARK_OUTPUT"
+
+#pragma mark - Allocations counting
+/**
+ The hook called by libmalloc on every malloc zone operation.
+ It is not part of the public headers but it is the one used by the malloc stack logging tools.
+ */
+extern void (*malloc_logger)(uint32_t type, uintptr_t arg1, uintptr_t arg2, uintptr_t arg3, uintptr_t result, uint32_t num_hot_frames_to_skip);
+
+/**
+ The malloc_logger type flag of an allocation.
+ */
+#define MXBENCHMARK_MALLOC_LOG_TYPE_ALLOCATE 2
+
+static atomic_ullong allocationsCount;
+
+static void benchmarkMallocLogger(uint32_t type, uintptr_t arg1, uintptr_t arg2, uintptr_t arg3, uintptr_t result, uint32_t num_hot_frames_to_skip)
+{
+    if (type & MXBENCHMARK_MALLOC_LOG_TYPE_ALLOCATE)
+    {
+        atomic_fetch_add_explicit(&allocationsCount, 1, memory_order_relaxed);
+    }
+}
+
+
+/**
+ Microbenchmarks of the model primitives that dominate the SDK profiles.
+
+ Each benchmark reports the time per operation in nanoseconds and the number of malloc
+ allocations per operation. Results are printed as one JSON object per line, prefixed by
+ "MXBENCH ", and are appended to the file named by the MXBENCHMARK_OUTPUT environment
+ variable if it is set.
+
+ They can be run headlessly with:
+     xcodebuild test -workspace MatrixSDK.xcworkspace -scheme MatrixSDK
+         -destination '<destination>' -only-testing:MatrixSDKTests/MXBenchmarkTests
+
+ Allocations made by other threads during the measure are counted too: the numbers are
+ meaningful for comparisons between runs, not as absolute values.
+ */
+@interface MXBenchmarkTests : XCTestCase
+
+@end
+
+@implementation MXBenchmarkTests
+
+#pragma mark - Benchmark runner
+- (void)benchmark:(NSString*)name block:(void (^)())block
+{
+    // Warm up caches and lazy initialisations
+    for (NSUInteger i = 0; i < MXBENCHMARK_MIN_ITERATIONS; i++)
+    {
+        @autoreleasepool
+        {
+            block();
+        }
+    }
+
+    mach_timebase_info_data_t timebase;
+    mach_timebase_info(&timebase);
+
+    uint64_t budget = MXBENCHMARK_MEASURE_DURATION_S * NSEC_PER_SEC * timebase.denom / timebase.numer;
+
+    NSUInteger iterations = 0;
+    uint64_t elapsed = 0;
+
+    atomic_store(&allocationsCount, 0);
+
+    // Do not break the malloc stack logging if it is on
+    void (*previousMallocLogger)(uint32_t, uintptr_t, uintptr_t, uintptr_t, uintptr_t, uint32_t) = malloc_logger;
+    malloc_logger = benchmarkMallocLogger;
+
+    uint64_t start = mach_absolute_time();
+    while (iterations < MXBENCHMARK_MIN_ITERATIONS || elapsed < budget)
+    {
+        @autoreleasepool
+        {
+            block();
+        }
+        iterations++;
+        elapsed = mach_absolute_time() - start;
+    }
+
+    malloc_logger = previousMallocLogger;
+    unsigned long long allocations = atomic_load(&allocationsCount);
+
+    double nsPerOp = (double)elapsed * timebase.numer / timebase.denom / iterations;
+    double allocationsPerOp = (double)allocations / iterations;
+
+    NSDictionary *result = @{
+                             @"name": name,
+                             @"iterations": @(iterations),
+                             @"ns_per_op": @(round(nsPerOp)),
+                             @"allocs_per_op": @(round(allocationsPerOp * 10) / 10)
+                             };
+
+    NSData *JSONData = [NSJSONSerialization dataWithJSONObject:result options:NSJSONWritingSortedKeys error:nil];
+    NSString *JSONString = [[NSString alloc] initWithData:JSONData encoding:NSUTF8StringEncoding];
+
+    printf("MXBENCH %s\n", JSONString.UTF8String);
+
+    NSString *outputFile = [NSProcessInfo processInfo].environment[MXBENCHMARK_OUTPUT_ENV];
+    if (outputFile)
+    {
+        if (![[NSFileManager defaultManager] fileExistsAtPath:outputFile])
+        {
+            [[NSFileManager defaultManager] createFileAtPath:outputFile contents:nil attributes:nil];
+        }
+
+        NSFileHandle *fileHandle = [NSFileHandle fileHandleForWritingAtPath:outputFile];
+        [fileHandle seekToEndOfFile];
+        [fileHandle writeData:[[JSONString stringByAppendingString:@"\n"] dataUsingEncoding:NSUTF8StringEncoding]];
+        [fileHandle closeFile];
+    }
+
+    XCTAssertGreaterThan(iterations, 0);
+}
+
+
+#pragma mark - Fixtures
+- (NSDictionary*)messageJSON:(NSUInteger)index
+{
+    return @{
+             @"event_id": [NSString stringWithFormat:@"$%tu:matrix.org", index],
+             @"type": kMXEventTypeStringRoomMessage,
+             @"room_id": @"!room:matrix.org",
+             @"sender": @"@alice:matrix.org",
+             @"origin_server_ts": @(1460000000000 + index),
+             @"unsigned": @{@"age": @(1000), @"prev_content": [NSNull null]},
+             @"content": @{
+                     @"msgtype": kMXMessageTypeText,
+                     @"body": [NSString stringWithFormat:@"Message %tu", index],
+                     @"format": [NSNull null]
+                     }
+             };
+}
+
+- (MXRoomState*)roomStateWithMembersCount:(NSUInteger)membersCount
+{
+    MXRoomState *roomState = [[MXRoomState alloc] initWithRoomId:@"!room:matrix.org" andMatrixSession:nil andDirection:YES];
+
+    [roomState handleStateEvent:[MXEvent modelFromJSON:@{
+                                                         @"event_id": @"$name:matrix.org",
+                                                         @"type": kMXEventTypeStringRoomName,
+                                                         @"state_key": @"",
+                                                         @"sender": @"@user0:matrix.org",
+                                                         @"content": @{@"name": @"Benchmark"}
+                                                         }]];
+
+    for (NSUInteger i = 0; i < membersCount; i++)
+    {
+        NSString *userId = [NSString stringWithFormat:@"@user%tu:matrix.org", i];
+
+        [roomState handleStateEvent:[MXEvent modelFromJSON:@{
+                                                             @"event_id": [NSString stringWithFormat:@"$member%tu:matrix.org", i],
+                                                             @"type": kMXEventTypeStringRoomMember,
+                                                             @"state_key": userId,
+                                                             @"sender": userId,
+                                                             @"content": @{
+                                                                     @"membership": kMXMembershipStringJoin,
+                                                                     // Make some displaynames ambiguous
+                                                                     @"displayname": [NSString stringWithFormat:@"User %tu", i / 2]
+                                                                     }
+                                                             }]];
+    }
+
+    return roomState;
+}
+
+- (MXNotificationCenter*)notificationCenterWithRulesCount:(NSUInteger)rulesCount
+{
+    NSMutableArray *overrideRules = [NSMutableArray arrayWithCapacity:rulesCount / 2];
+    NSMutableArray *contentRules = [NSMutableArray arrayWithCapacity:rulesCount - rulesCount / 2];
+
+    for (NSUInteger i = 0; i < rulesCount; i++)
+    {
+        NSString *ruleId = [NSString stringWithFormat:@"rule%tu", i];
+
+        // Patterns never match so that every rule is checked
+        if (i % 2)
+        {
+            [overrideRules addObject:@{
+                                       @"rule_id": ruleId,
+                                       @"enabled": @YES,
+                                       @"default": @NO,
+                                       @"actions": @[@"notify"],
+                                       @"conditions": @[@{
+                                                            @"kind": kMXPushRuleConditionStringEventMatch,
+                                                            @"key": @"content.body",
+                                                            @"pattern": [NSString stringWithFormat:@"keyword%tu*", i]
+                                                            }]
+                                       }];
+        }
+        else
+        {
+            [contentRules addObject:@{
+                                      @"rule_id": ruleId,
+                                      @"enabled": @YES,
+                                      @"default": @NO,
+                                      @"actions": @[@"notify"],
+                                      @"pattern": [NSString stringWithFormat:@"keyword%tu", i]
+                                      }];
+        }
+    }
+
+    MXPushRulesResponse *pushRules = [MXPushRulesResponse modelFromJSON:@{
+                                                                         @"global": @{
+                                                                                 @"override": overrideRules,
+                                                                                 @"content": contentRules,
+                                                                                 @"room": @[],
+                                                                                 @"sender": @[],
+                                                                                 @"underride": @[]
+                                                                                 }
+                                                                         }];
+
+    MXNotificationCenter *notificationCenter = [[MXNotificationCenter alloc] initWithMatrixSession:nil];
+    [notificationCenter handlePushRulesResponse:pushRules];
+
+    return notificationCenter;
+}
+
+
+#pragma mark - JSON parsing
+- (void)testModelFromJSON
+{
+    NSDictionary *JSONDictionary = [self messageJSON:0];
+
+    [self benchmark:@"MXEvent.modelFromJSON" block:^{
+        [MXEvent modelFromJSON:JSONDictionary];
+    }];
+}
+
+- (void)testRemoveNullValuesInJSON
+{
+    NSDictionary *JSONDictionary = [self messageJSON:0];
+
+    [self benchmark:@"MXJSONModel.removeNullValuesInJSON" block:^{
+        [MXJSONModel removeNullValuesInJSON:JSONDictionary];
+    }];
+}
+
+
+#pragma mark - NSCoding
+- (void)testEventCodingRoundTrip
+{
+    MXEvent *event = [MXEvent modelFromJSON:[self messageJSON:0]];
+
+    [self benchmark:@"MXEvent.NSCodingRoundTrip" block:^{
+        NSData *data = [NSKeyedArchiver archivedDataWithRootObject:event];
+        [NSKeyedUnarchiver unarchiveObjectWithData:data];
+    }];
+}
+
+
+#pragma mark - Room state
+- (void)testRoomStateCopy
+{
+    for (NSNumber *membersCount in @[@(10), @(1000), @(10000)])
+    {
+        MXRoomState *roomState = [self roomStateWithMembersCount:membersCount.unsignedIntegerValue];
+
+        [self benchmark:[NSString stringWithFormat:@"MXRoomState.copy.%@", membersCount] block:^{
+            [roomState copy];
+        }];
+    }
+}
+
+- (void)testRoomStateMemberName
+{
+    for (NSNumber *membersCount in @[@(10), @(1000), @(10000)])
+    {
+        MXRoomState *roomState = [self roomStateWithMembersCount:membersCount.unsignedIntegerValue];
+
+        NSMutableArray<NSString*> *userIds = [NSMutableArray arrayWithCapacity:membersCount.unsignedIntegerValue];
+        for (NSUInteger i = 0; i < membersCount.unsignedIntegerValue; i++)
+        {
+            [userIds addObject:[NSString stringWithFormat:@"@user%tu:matrix.org", i]];
+        }
+
+        // Go through all members so that the cache is not hit by the same entry each time
+        __block NSUInteger index = 0;
+        [self benchmark:[NSString stringWithFormat:@"MXRoomState.memberName.%@", membersCount] block:^{
+            [roomState memberName:userIds[index++ % userIds.count]];
+        }];
+
+        // Measure the disambiguation itself with an empty names cache
+        [self benchmark:[NSString stringWithFormat:@"MXRoomState.memberName.uncached.%@", membersCount] block:^{
+            [roomState handleMemoryPressure:MXMemoryPressureLevelModerate];
+            [roomState memberName:userIds[index++ % userIds.count]];
+        }];
+    }
+}
+
+- (void)testRoomStateDisplayname
+{
+    for (NSNumber *membersCount in @[@(10), @(1000), @(10000)])
+    {
+        MXRoomState *roomState = [self roomStateWithMembersCount:membersCount.unsignedIntegerValue];
+
+        [self benchmark:[NSString stringWithFormat:@"MXRoomState.displayname.%@", membersCount] block:^{
+            [roomState displayname];
+        }];
+    }
+}
+
+- (void)testRoomStateStateEvents
+{
+    for (NSNumber *membersCount in @[@(10), @(1000), @(10000)])
+    {
+        MXRoomState *roomState = [self roomStateWithMembersCount:membersCount.unsignedIntegerValue];
+
+        [self benchmark:[NSString stringWithFormat:@"MXRoomState.stateEvents.%@", membersCount] block:^{
+            [roomState stateEvents];
+        }];
+    }
+}
+
+
+#pragma mark - Push rules
+- (void)testRuleMatchingEvent
+{
+    MXEvent *event = [MXEvent modelFromJSON:[self messageJSON:0]];
+
+    for (NSNumber *rulesCount in @[@(5), @(50), @(500)])
+    {
+        MXNotificationCenter *notificationCenter = [self notificationCenterWithRulesCount:rulesCount.unsignedIntegerValue];
+
+        XCTAssertNil([notificationCenter ruleMatchingEvent:event]);
+
+        [self benchmark:[NSString stringWithFormat:@"MXNotificationCenter.ruleMatchingEvent.%@", rulesCount] block:^{
+            [notificationCenter ruleMatchingEvent:event];
+        }];
+    }
+}
+
+
+#pragma mark - Store
+- (void)testEventsByTypesEnumeratorScan
+{
+    NSMutableArray<MXEvent*> *messages = [NSMutableArray arrayWithCapacity:1000];
+    for (NSUInteger i = 0; i < 1000; i++)
+    {
+        [messages addObject:[MXEvent modelFromJSON:[self messageJSON:i]]];
+    }
+
+    // Look for a type that is absent to scan all messages
+    [self benchmark:@"MXEventsByTypesEnumeratorOnArray.scan.1000" block:^{
+        MXEventsByTypesEnumeratorOnArray *enumerator = [[MXEventsByTypesEnumeratorOnArray alloc] initWithMessages:messages andTypesIn:@[kMXEventTypeStringRoomTopic] ignoreMemberProfileChanges:YES];
+        MXEvent *event;
+        do
+        {
+            event = enumerator.nextEvent;
+        }
+        while (event);
+    }];
+}
+
+- (void)testGetEventReceipts
+{
+    NSString *roomId = @"!room:matrix.org";
+    MXMemoryStore *store = [[MXMemoryStore alloc] init];
+
+    for (NSUInteger i = 0; i < 1000; i++)
+    {
+        MXReceiptData *receipt = [[MXReceiptData alloc] init];
+        receipt.userId = [NSString stringWithFormat:@"@user%tu:matrix.org", i];
+        receipt.eventId = [NSString stringWithFormat:@"$%tu:matrix.org", i % 10];
+        receipt.ts = i;
+        [store storeReceipt:receipt inRoom:roomId];
+    }
+
+    [self benchmark:@"MXStore.getEventReceipts.1000" block:^{
+        [store getEventReceipts:roomId eventId:@"$0:matrix.org" sorted:YES];
+    }];
+}
+
+@end
@@ -0,0 +1,184 @@
+/*
+ Copyright 2016 OpenMarket Ltd
+
+ Licensed under the Apache License, Version 2.0 (the "License");
+ you may not use this file except in compliance with the License.
+ You may obtain a copy of the License at
+
+ http://www.apache.org/licenses/LICENSE-2.0
+
+ Unless required by applicable law or agreed to in writing, software
+ distributed under the License is distributed on an "AS IS" BASIS,
+ WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ See the License for the specific language governing permissions and
+ limitations under the License.
+ */
+
+#import <UIKit/UIKit.h>
+#import <XCTest/XCTest.h>
+
+#import "MXEventContentPool.h"
+#import "MXEvent.h"
+#import "MXSDKOptions.h"
+
+@interface MXEventContentPoolTests : XCTestCase
+
+@end
+
+@implementation MXEventContentPoolTests
+
+- (void)setUp
+{
+    [super setUp];
+
+    [[MXEventContentPool sharedPool] reset];
+}
+
+- (void)tearDown
+{
+    [MXSDKOptions sharedInstance].enableEventContentDeduplication = NO;
+    [[MXEventContentPool sharedPool] reset];
+
+    [super tearDown];
+}
+
+- (void)testHashOfJSON
+{
+    NSDictionary *content1 = @{@"membership": @"join", @"displayname": @"Bob", @"avatar_url": @"mxc://matrix.org/abc"};
+    NSDictionary *content2 = @{@"avatar_url": @"mxc://matrix.org/abc", @"displayname": @"Bob", @"membership": @"join"};
+    NSDictionary *content3 = @{@"membership": @"leave", @"displayname": @"Bob", @"avatar_url": @"mxc://matrix.org/abc"};
+
+    XCTAssertEqual([MXEventContentPool hashOfJSON:content1], [MXEventContentPool hashOfJSON:content2]);
+    XCTAssertNotEqual([MXEventContentPool hashOfJSON:content1], [MXEventContentPool hashOfJSON:content3]);
+}
+
+- (void)testInternContent
+{
+    MXEventContentPool *pool = [[MXEventContentPool alloc] init];
+
+    NSDictionary *content1 = @{@"membership": @"join", @"users": @{@"@bob:matrix.org": @100}};
+    NSDictionary *content2 = [NSMutableDictionary dictionaryWithDictionary:content1];
+    NSDictionary *content3 = @{@"membership": @"join", @"users": @{@"@bob:matrix.org": @50}};
+
+    NSDictionary *interned1 = [pool internContent:content1];
+    NSDictionary *interned2 = [pool internContent:content2];
+    NSDictionary *interned3 = [pool internContent:content3];
+
+    XCTAssertEqual(interned1, interned2, @"Equal contents must share the same instance");
+    XCTAssertNotEqual(interned1, interned3);
+    XCTAssertFalse([interned2 isKindOfClass:[NSMutableDictionary class]], @"Shared contents must be immutable");
+
+    XCTAssertEqual(pool.lookupsCount, 3);
+    XCTAssertEqual(pool.hitsCount, 1);
+    XCTAssertEqual(pool.count, 2);
+}
+
+- (void)testBooleansAreNotSharedWithNumbers
+{
+    MXEventContentPool *pool = [[MXEventContentPool alloc] init];
+
+    NSDictionary *booleanContent = [NSJSONSerialization JSONObjectWithData:[@"{\"highlight\": true}" dataUsingEncoding:NSUTF8StringEncoding] options:0 error:nil];
+    NSDictionary *numberContent = [NSJSONSerialization JSONObjectWithData:[@"{\"highlight\": 1}" dataUsingEncoding:NSUTF8StringEncoding] options:0 error:nil];
+
+    XCTAssertFalse([MXEventContentPool isJSON:booleanContent equalToJSON:numberContent]);
+    XCTAssertTrue([MXEventContentPool isJSON:numberContent equalToJSON:@{@"highlight": @1}]);
+
+    NSDictionary *interned1 = [pool internContent:booleanContent];
+    NSDictionary *interned2 = [pool internContent:numberContent];
+
+    XCTAssertNotEqual(interned1, interned2);
+    XCTAssertEqual(CFGetTypeID((__bridge CFTypeRef)interned2[@"highlight"]), CFNumberGetTypeID());
+}
+
+- (void)testInternedContentIsDeepCopied
+{
+    MXEventContentPool *pool = [[MXEventContentPool alloc] init];
+
+    NSMutableDictionary *users = [NSMutableDictionary dictionaryWithDictionary:@{@"@bob:matrix.org": @100}];
+    NSDictionary *content = @{@"users": users};
+
+    NSDictionary *interned = [pool internContent:content];
+    users[@"@alice:matrix.org"] = @50;
+
+    XCTAssertEqual([interned[@"users"] count], 1, @"Interned contents must not share mutable containers");
+    XCTAssertFalse([interned[@"users"] isKindOfClass:[NSMutableDictionary class]]);
+}
+
+- (void)testMemorySavingsReport
+{
+    [MXSDKOptions sharedInstance].enableEventContentDeduplication = YES;
+
+    // A fixture shaped like the state of a big room: members join, change their
+    // profile and leave, and power levels are sent again with few changes
+    NSMutableArray *events = [NSMutableArray array];
+    for (NSUInteger i = 0; i < 2000; i++)
+    {
+        NSString *userId = [NSString stringWithFormat:@"@user%tu:matrix.org", i % 500];
+        NSDictionary *JSON = @{
+                               @"event_id": [NSString stringWithFormat:@"$member%tu:matrix.org", i],
+                               @"type": kMXEventTypeStringRoomMember,
+                               @"state_key": userId,
+                               @"sender": userId,
+                               @"content": @{@"membership": (i % 3) ? kMXMembershipStringJoin : kMXMembershipStringLeave,
+                                             @"displayname": [NSString stringWithFormat:@"User %tu", i % 500],
+                                             @"avatar_url": @"mxc://matrix.org/avatar"}
+                               };
+        [events addObject:[MXEvent modelFromJSON:JSON]];
+    }
+    for (NSUInteger i = 0; i < 100; i++)
+    {
+        NSDictionary *JSON = @{
+                               @"event_id": [NSString stringWithFormat:@"$powerlevels%tu:matrix.org", i],
+                               @"type": kMXEventTypeStringRoomPowerLevels,
+                               @"state_key": @"",
+                               @"sender": @"@user0:matrix.org",
+                               @"content": @{@"ban": @50, @"kick": @50, @"redact": @50, @"state_default": @50,
+                                             @"users": @{@"@user0:matrix.org": @100, @"@user1:matrix.org": (i < 50) ? @50 : @100}}
+                               };
+        [events addObject:[MXEvent modelFromJSON:JSON]];
+    }
+
+    MXEventContentPool *pool = [MXEventContentPool sharedPool];
+
+    NSLog(@"[MXEventContentPoolTests] Memory savings on %tu events: %tu lookups, %tu hits, %tu distinct contents, %tu bytes saved",
+          events.count, pool.lookupsCount, pool.hitsCount, pool.count, pool.savedBytesCount);
+
+    XCTAssertEqual(pool.count, 1002);
+    XCTAssertGreaterThan(pool.savedBytesCount, 0);
+}
+
+- (void)testEventsDeduplication
+{
+    [MXSDKOptions sharedInstance].enableEventContentDeduplication = YES;
+
+    NSMutableArray *events = [NSMutableArray array];
+    for (NSUInteger i = 0; i < 100; i++)
+    {
+        NSDictionary *JSON = @{
+                               @"event_id": [NSString stringWithFormat:@"$%tu:matrix.org", i],
+                               @"type": kMXEventTypeStringRoomMember,
+                               @"state_key": @"@bob:matrix.org",
+                               @"sender": @"@bob:matrix.org",
+                               @"content": @{@"membership": (i % 2) ? @"join" : @"leave", @"displayname": @"Bob", @"avatar_url": [NSNull null]}
+                               };
+        [events addObject:[MXEvent modelFromJSON:JSON]];
+    }
+
+    MXEvent *event0 = events[0], *event1 = events[1], *event2 = events[2];
+    XCTAssertEqual(event0.content, event2.content);
+    XCTAssertNotEqual(event0.content, event1.content);
+    XCTAssertNil(event0.content[@"avatar_url"], @"Null values must still be removed");
+
+    // Only 2 distinct contents for 100 events
+    XCTAssertEqual([MXEventContentPool sharedPool].count, 2);
+    XCTAssertEqual([MXEventContentPool sharedPool].hitsCount, 98);
+
+    // Contents must be shared again after a store serialisation round trip
+    NSData *data = [NSKeyedArchiver archivedDataWithRootObject:events];
+    NSArray<MXEvent*> *decodedEvents = [NSKeyedUnarchiver unarchiveObjectWithData:data];
+
+    XCTAssertEqual(decodedEvents[0].content, event0.content);
+    XCTAssertEqual(decodedEvents[1].content, event1.content);
+}
+
+@end
@@ -0,0 +1,140 @@
+/*
+ Copyright 2016 OpenMarket Ltd
+
+ Licensed under the Apache License, Version 2.0 (the "License");
+ you may not use this file except in compliance with the License.
+ You may obtain a copy of the License at
+
+ http://www.apache.org/licenses/LICENSE-2.0
+
+ Unless required by applicable law or agreed to in writing, software
+ distributed under the License is distributed on an "AS IS" BASIS,
+ WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ See the License for the specific language governing permissions and
+ limitations under the License.
+ */
+
+#import <UIKit/UIKit.h>
+#import <XCTest/XCTest.h>
+
+#import "MXEventContextCache.h"
+
+@interface MXEventContextCacheTests : XCTestCase
+{
+    NSMutableArray<MXEvent*> *events;
+}
+
+@end
+
+@implementation MXEventContextCacheTests
+
+- (void)setUp
+{
+    [super setUp];
+
+    // A fake room timeline with 20 events
+    events = [NSMutableArray array];
+    for (NSUInteger i = 0; i < 20; i++)
+    {
+        MXEvent *event = [MXEvent modelFromJSON:@{
+                                                  @"event_id": [NSString stringWithFormat:@"$%tu", i],
+                                                  @"type": kMXEventTypeStringRoomMessage,
+                                                  @"sender": @"@bob:matrix.org",
+                                                  @"content": @{@"msgtype": kMXMessageTypeText, @"body": @(i).stringValue}
+                                                  }];
+        [events addObject:event];
+    }
+}
+
+- (void)tearDown
+{
+    events = nil;
+
+    [super tearDown];
+}
+
+/**
+ Build the /context response of the event at `index` with `count` events on both sides.
+ */
+- (MXEventContext*)contextAtIndex:(NSUInteger)index count:(NSUInteger)count
+{
+    MXEventContext *eventContext = [[MXEventContext alloc] init];
+    eventContext.event = events[index];
+    eventContext.eventsBefore = [[events subarrayWithRange:NSMakeRange(index - count, count)] reverseObjectEnumerator].allObjects;
+    eventContext.eventsAfter = [events subarrayWithRange:NSMakeRange(index + 1, count)];
+    eventContext.start = [NSString stringWithFormat:@"s%tu", index - count];
+    eventContext.end = [NSString stringWithFormat:@"e%tu", index + count];
+    return eventContext;
+}
+
+- (void)testContextOfEvent
+{
+    MXEventContextCache *cache = [[MXEventContextCache alloc] initWithCapacity:2];
+    [cache storeContext:[self contextAtIndex:5 count:3] inRoom:@"!room"];
+
+    XCTAssertNil([cache contextOfEvent:@"$5" inRoom:@"!anotherRoom"]);
+    XCTAssertNil([cache contextOfEvent:@"$9" inRoom:@"!room"]);
+
+    // Any event of the window can be the pivot
+    MXEventContext *eventContext = [cache contextOfEvent:@"$3" inRoom:@"!room"];
+    XCTAssertEqualObjects(eventContext.event.eventId, @"$3");
+    XCTAssertEqual(eventContext.eventsBefore.count, 1);
+    XCTAssertEqualObjects(eventContext.eventsBefore[0].eventId, @"$2");
+    XCTAssertEqual(eventContext.eventsAfter.count, 5);
+    XCTAssertEqualObjects(eventContext.start, @"s2");
+    XCTAssertEqualObjects(eventContext.end, @"e8");
+}
+
+- (void)testMerge
+{
+    MXEventContextCache *cache = [[MXEventContextCache alloc] initWithCapacity:2];
+    [cache storeContext:[self contextAtIndex:5 count:3] inRoom:@"!room"];
+    [cache storeContext:[self contextAtIndex:9 count:3] inRoom:@"!room"];
+
+    XCTAssertEqual(cache.count, 1, @"Overlapping windows must be merged");
+
+    MXEventContext *eventContext = [cache contextOfEvent:@"$7" inRoom:@"!room"];
+    XCTAssertEqual(eventContext.eventsBefore.count, 5);
+    XCTAssertEqual(eventContext.eventsAfter.count, 5);
+    XCTAssertEqualObjects(eventContext.start, @"s2");
+    XCTAssertEqualObjects(eventContext.end, @"e12");
+
+    // A window included in another one changes nothing
+    [cache storeContext:[self contextAtIndex:6 count:1] inRoom:@"!room"];
+    XCTAssertEqual(cache.count, 1);
+    XCTAssertEqualObjects([cache contextOfEvent:@"$6" inRoom:@"!room"].end, @"e12");
+}
+
+- (void)testLRU
+{
+    MXEventContextCache *cache = [[MXEventContextCache alloc] initWithCapacity:2];
+    [cache storeContext:[self contextAtIndex:2 count:1] inRoom:@"!room"];
+    [cache storeContext:[self contextAtIndex:8 count:1] inRoom:@"!room"];
+
+    // Use the first window so that the second one is the least recently used
+    XCTAssertNotNil([cache contextOfEvent:@"$2" inRoom:@"!room"]);
+
+    [cache storeContext:[self contextAtIndex:14 count:1] inRoom:@"!room"];
+
+    XCTAssertEqual(cache.count, 2);
+    XCTAssertNotNil([cache contextOfEvent:@"$2" inRoom:@"!room"]);
+    XCTAssertNil([cache contextOfEvent:@"$8" inRoom:@"!room"]);
+    XCTAssertNotNil([cache contextOfEvent:@"$14" inRoom:@"!room"]);
+}
+
+- (void)testMemoryPressure
+{
+    MXEventContextCache *cache = [[MXEventContextCache alloc] initWithCapacity:5];
+    [cache storeContext:[self contextAtIndex:2 count:1] inRoom:@"!room"];
+    [cache storeContext:[self contextAtIndex:8 count:1] inRoom:@"!room"];
+
+    // Windows are kept on moderate pressure
+    XCTAssertEqual([cache handleMemoryPressure:MXMemoryPressureLevelModerate], 0);
+    XCTAssertEqual(cache.count, 2);
+
+    XCTAssertEqual([cache handleMemoryPressure:MXMemoryPressureLevelCritical], 2);
+    XCTAssertEqual(cache.count, 0);
+    XCTAssertNil([cache contextOfEvent:@"$2" inRoom:@"!room"]);
+}
+
+@end
@@ -0,0 +1,91 @@
+/*
+ Copyright 2016 OpenMarket Ltd
+
+ Licensed under the Apache License, Version 2.0 (the "License");
+ you may not use this file except in compliance with the License.
+ You may obtain a copy of the License at
+
+ http://www.apache.org/licenses/LICENSE-2.0
+
+ Unless required by applicable law or agreed to in writing, software
+ distributed under the License is distributed on an "AS IS" BASIS,
+ WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ See the License for the specific language governing permissions and
+ limitations under the License.
+ */
+
+#import <UIKit/UIKit.h>
+#import <XCTest/XCTest.h>
+
+#import "MXRoomState.h"
+
+@interface MXEventSenderProfileTests : XCTestCase
+{
+    MXRoomState *roomState;
+}
+
+@end
+
+@implementation MXEventSenderProfileTests
+
+- (void)setUp
+{
+    [super setUp];
+
+    roomState = [[MXRoomState alloc] initWithRoomId:@"!room:matrix.org" andMatrixSession:nil andDirection:YES];
+}
+
+- (void)tearDown
+{
+    roomState = nil;
+
+    [super tearDown];
+}
+
+- (MXEvent*)memberEventOf:(NSString*)userId displayname:(NSString*)displayname
+{
+    return [MXEvent modelFromJSON:@{
+                                    @"event_id": [[NSUUID UUID] UUIDString],
+                                    @"type": kMXEventTypeStringRoomMember,
+                                    @"state_key": userId,
+                                    @"sender": userId,
+                                    @"content": @{
+                                            @"membership": kMXMembershipStringJoin,
+                                            @"displayname": displayname,
+                                            @"avatar_url": @"mxc://matrix.org/avatar"
+                                            }
+                                    }];
+}
+
+- (void)testSenderProfile
+{
+    [roomState handleStateEvent:[self memberEventOf:@"@alice:matrix.org" displayname:@"Alice"]];
+
+    MXEventSenderProfile *profile = [roomState senderProfile:@"@alice:matrix.org"];
+    XCTAssertEqualObjects(profile.userId, @"@alice:matrix.org");
+    XCTAssertEqualObjects(profile.displayname, @"Alice");
+    XCTAssertEqualObjects(profile.disambiguatedName, @"Alice");
+    XCTAssertEqualObjects(profile.avatarUrl, @"mxc://matrix.org/avatar");
+
+    // The profile is cached and shared by copies of the state
+    XCTAssertEqual([roomState senderProfile:@"@alice:matrix.org"], profile);
+    MXRoomState *stateCopy = [roomState copy];
+    XCTAssertEqual([stateCopy senderProfile:@"@alice:matrix.org"], profile);
+
+    // A new member with the same name requires disambiguation
+    [stateCopy handleStateEvent:[self memberEventOf:@"@alice2:matrix.org" displayname:@"Alice"]];
+
+    MXEventSenderProfile *newProfile = [stateCopy senderProfile:@"@alice:matrix.org"];
+    XCTAssertNotEqual(newProfile, profile);
+    XCTAssertEqualObjects(newProfile.disambiguatedName, @"Alice (@alice:matrix.org)");
+
+    // The profile resolved in the previous state is unchanged
+    XCTAssertEqualObjects(profile.disambiguatedName, @"Alice");
+    XCTAssertEqual([roomState senderProfile:@"@alice:matrix.org"], profile);
+
+    // Unknown user
+    XCTAssertEqualObjects([roomState senderProfile:@"@bob:matrix.org"].disambiguatedName, @"@bob:matrix.org");
+    XCTAssertNil([roomState senderProfile:nil]);
+}
+
+@end
@@ -0,0 +1,418 @@
+/*
+ Copyright 2016 OpenMarket Ltd
+
+ Licensed under the Apache License, Version 2.0 (the "License");
+ you may not use this file except in compliance with the License.
+ You may obtain a copy of the License at
+
+ http://www.apache.org/licenses/LICENSE-2.0
+
+ Unless required by applicable law or agreed to in writing, software
+ distributed under the License is distributed on an "AS IS" BASIS,
+ WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ See the License for the specific language governing permissions and
+ limitations under the License.
+ */
+
+#import <UIKit/UIKit.h>
+#import <XCTest/XCTest.h>
+
+#import "MXSession.h"
+#import "MXMemoryStore.h"
+#import "MXSDKOptions.h"
+
+@interface MXEventTimeline (MXEventTimelineStateTests)
+
+- (void)handlePaginationResponse:(MXPaginationResponse*)paginatedResponse direction:(MXTimelineDirection)direction;
+
+@end
+
+/**
+ Tests of the room states computed by the timeline, without homeserver: /sync responses
+ are fed directly to the live timeline of a room.
+ */
+@interface MXEventTimelineStateTests : XCTestCase
+{
+    MXSession *mxSession;
+    MXMemoryStore *store;
+    MXRoom *room;
+}
+
+@end
+
+static NSString *const kRoomId = @"!room:matrix.org";
+static NSString *const kAliceUserId = @"@alice:matrix.org";
+
+@implementation MXEventTimelineStateTests
+
+- (void)setUp
+{
+    [super setUp];
+
+    MXCredentials *credentials = [[MXCredentials alloc] initWithHomeServer:@"https://matrix.org" userId:kAliceUserId accessToken:@"token"];
+    MXRestClient *restClient = [[MXRestClient alloc] initWithCredentials:credentials andOnUnrecognizedCertificateBlock:nil];
+    mxSession = [[MXSession alloc] initWithMatrixRestClient:restClient];
+
+    // MXMemoryStore opens synchronously
+    store = [[MXMemoryStore alloc] init];
+    [mxSession setStore:store success:^{
+    } failure:^(NSError *error) {
+        XCTFail(@"The request should not fail - NSError: %@", error);
+    }];
+
+    room = [[MXRoom alloc] initWithRoomId:kRoomId andMatrixSession:mxSession];
+}
+
+- (void)tearDown
+{
+    [mxSession close];
+    mxSession = nil;
+    store = nil;
+    room = nil;
+
+    [super tearDown];
+}
+
+#pragma mark - Fixtures
+- (MXEvent*)eventWithJSON:(NSDictionary*)JSON
+{
+    NSMutableDictionary *eventJSON = [NSMutableDictionary dictionaryWithDictionary:@{
+                                                                                     @"room_id": kRoomId,
+                                                                                     @"sender": kAliceUserId,
+                                                                                     @"origin_server_ts": @(1475000000000)
+                                                                                     }];
+    [eventJSON addEntriesFromDictionary:JSON];
+    return [MXEvent modelFromJSON:eventJSON];
+}
+
+- (NSDictionary*)memberEventJSON:(NSString*)eventId userId:(NSString*)userId displayname:(NSString*)displayname prevDisplayname:(NSString*)prevDisplayname
+{
+    NSMutableDictionary *JSON = [NSMutableDictionary dictionaryWithDictionary:@{
+                                                                                @"event_id": eventId,
+                                                                                @"type": kMXEventTypeStringRoomMember,
+                                                                                @"state_key": userId,
+                                                                                @"sender": userId,
+                                                                                @"content": @{@"membership": kMXMembershipStringJoin, @"displayname": displayname}
+                                                                                }];
+    if (prevDisplayname)
+    {
+        JSON[@"unsigned"] = @{@"prev_content": @{@"membership": kMXMembershipStringJoin, @"displayname": prevDisplayname}};
+    }
+    return JSON;
+}
+
+- (NSDictionary*)nameEventJSON:(NSString*)eventId name:(NSString*)name prevName:(NSString*)prevName
+{
+    NSMutableDictionary *JSON = [NSMutableDictionary dictionaryWithDictionary:@{
+                                                                                @"event_id": eventId,
+                                                                                @"type": kMXEventTypeStringRoomName,
+                                                                                @"state_key": @"",
+                                                                                @"sender": kAliceUserId,
+                                                                                @"content": @{@"name": name}
+                                                                                }];
+    if (prevName)
+    {
+        JSON[@"unsigned"] = @{@"prev_content": @{@"name": prevName}};
+    }
+    return JSON;
+}
+
+- (NSDictionary*)messageEventJSON:(NSString*)eventId
+{
+    return @{
+             @"event_id": eventId,
+             @"type": kMXEventTypeStringRoomMessage,
+             @"sender": kAliceUserId,
+             @"content": @{@"msgtype": kMXMessageTypeText, @"body": eventId}
+             };
+}
+
+- (void)handleSyncWithState:(NSArray<NSDictionary*>*)stateEvents timeline:(NSArray<NSDictionary*>*)timelineEvents limited:(BOOL)limited
+{
+    MXRoomSync *roomSync = [MXRoomSync modelFromJSON:@{
+                                                       @"state": @{@"events": stateEvents},
+                                                       @"timeline": @{@"events": timelineEvents, @"limited": @(limited), @"prev_batch": @"prev_batch"}
+                                                       }];
+
+    [room.liveTimeline handleJoinedRoomSync:roomSync];
+}
+
+
+#pragma mark - State checkpoints
+- (void)testBackStateDoesNotModifyEvents
+{
+    MXEvent *nameEvent = [self eventWithJSON:[self nameEventJSON:@"$name" name:@"B" prevName:@"A"]];
+
+    MXRoomState *state = [[MXRoomState alloc] initWithRoomId:kRoomId andMatrixSession:nil andDirection:YES];
+    [state handleStateEvent:nameEvent];
+
+    MXRoomState *backState = [[MXRoomState alloc] initBackStateWith:state];
+    XCTAssertFalse(backState.isLive);
+    XCTAssertEqualObjects(backState.name, @"B");
+    XCTAssertEqualObjects(nameEvent.prevContent[@"name"], @"A", @"Events shared with the store must not be modified");
+
+    // Back paginate the event
+    [backState handleStateEvent:nameEvent];
+    XCTAssertEqualObjects(backState.name, @"A");
+    XCTAssertEqualObjects(state.name, @"B");
+
+    // The snapshot of the back state describes the state before the event
+    MXRoomState *backStateCopy = [[MXRoomState alloc] initBackStateWithRoomId:kRoomId andMatrixSession:nil andStateEvents:backState.stateEventsSnapshot];
+    XCTAssertFalse(backStateCopy.isLive);
+    XCTAssertEqualObjects(backStateCopy.name, @"A");
+}
+
+- (void)testStateBeforeStoredEvent
+{
+    [self handleSyncWithState:@[[self memberEventJSON:@"$alice" userId:kAliceUserId displayname:@"Alice" prevDisplayname:nil]]
+                     timeline:@[[self nameEventJSON:@"$n1" name:@"A" prevName:nil],
+                                [self messageEventJSON:@"$m1"],
+                                [self nameEventJSON:@"$n2" name:@"B" prevName:@"A"],
+                                [self messageEventJSON:@"$m2"]]
+                      limited:YES];
+
+    // The state at the start of the timeline is the first checkpoint
+    MXRoomState *roomState = [room stateBeforeStoredEvent:@"$n1"];
+    XCTAssertFalse(roomState.isLive);
+    XCTAssertNil(roomState.name);
+    XCTAssertEqualObjects([roomState memberName:kAliceUserId], @"Alice");
+
+    // Later states are rebuilt from it
+    XCTAssertEqualObjects([room stateBeforeStoredEvent:@"$m1"].name, @"A");
+    XCTAssertEqualObjects([room stateBeforeStoredEvent:@"$m2"].name, @"B");
+}
+
+- (void)testBackPaginationUsesStateCheckpoints
+{
+    [self handleSyncWithState:@[[self memberEventJSON:@"$alice" userId:kAliceUserId displayname:@"Alice" prevDisplayname:nil]]
+                     timeline:@[[self nameEventJSON:@"$n1" name:@"A" prevName:nil],
+                                [self messageEventJSON:@"$m1"],
+                                [self nameEventJSON:@"$n2" name:@"B" prevName:@"A"],
+                                [self messageEventJSON:@"$m2"]]
+                      limited:YES];
+
+    // A checkpoint that does not match the replay of prev_contents
+    [store storeStateCheckpointForRoom:kRoomId
+                           stateEvents:@[[self eventWithJSON:[self memberEventJSON:@"$alice" userId:kAliceUserId displayname:@"Alice" prevDisplayname:nil]],
+                                         [self eventWithJSON:[self nameEventJSON:@"$n0" name:@"Checkpoint" prevName:nil]]]
+                           beforeEvent:@"$m1"];
+
+    NSMutableDictionary<NSString*, NSString*> *roomNames = [NSMutableDictionary dictionary];
+    [room.liveTimeline listenToEvents:^(MXEvent *event, MXTimelineDirection direction, MXRoomState *roomState) {
+        roomNames[event.eventId] = roomState.name ? roomState.name : @"";
+    }];
+
+    [room.liveTimeline resetPagination];
+    [room.liveTimeline paginate:10 direction:MXTimelineDirectionBackwards onlyFromStore:YES complete:^{
+    } failure:^(NSError *error) {
+        XCTFail(@"The request should not fail - NSError: %@", error);
+    }];
+
+    XCTAssertEqualObjects(roomNames[@"$m2"], @"B");
+    XCTAssertEqualObjects(roomNames[@"$n2"], @"A");
+    XCTAssertEqualObjects(roomNames[@"$m1"], @"Checkpoint");
+    XCTAssertEqualObjects(roomNames[@"$n1"], @"");
+}
+
+- (void)testBackPaginationStoresStateCheckpoints
+{
+    // A room with 60 members
+    NSMutableArray *stateEvents = [NSMutableArray arrayWithObject:[self memberEventJSON:@"$alice" userId:kAliceUserId displayname:@"Alice" prevDisplayname:nil]];
+    for (NSUInteger i = 0; i < 60; i++)
+    {
+        NSString *userId = [NSString stringWithFormat:@"@user%tu:matrix.org", i];
+        [stateEvents addObject:[self memberEventJSON:[NSString stringWithFormat:@"$state%tu", i] userId:userId displayname:userId prevDisplayname:nil]];
+    }
+
+    [self handleSyncWithState:stateEvents timeline:@[[self messageEventJSON:@"$m1"]] limited:YES];
+
+    // Back paginate their joins from the homeserver, the most recent first
+    NSMutableArray *chunk = [NSMutableArray array];
+    for (NSInteger i = 59; i >= 0; i--)
+    {
+        NSString *userId = [NSString stringWithFormat:@"@user%tu:matrix.org", i];
+        [chunk addObject:[self memberEventJSON:[NSString stringWithFormat:@"$join%tu", i] userId:userId displayname:userId prevDisplayname:nil]];
+    }
+
+    MXPaginationResponse *paginationResponse = [MXPaginationResponse modelFromJSON:@{@"chunk": chunk, @"start": @"prev_batch", @"end": @"end"}];
+
+    [room.liveTimeline resetPagination];
+    [room.liveTimeline handlePaginationResponse:paginationResponse direction:MXTimelineDirectionBackwards];
+
+    // A checkpoint is stored after 50 state events: before the join of user10
+    XCTAssertNil([store stateCheckpointOfRoom:kRoomId beforeEvent:@"$join11"]);
+
+    NSArray<MXEvent*> *checkpoint = [store stateCheckpointOfRoom:kRoomId beforeEvent:@"$join10"];
+    XCTAssertEqual(checkpoint.count, 11, @"Only Alice and the 10 first users were members before");
+
+    MXRoomState *roomState = [[MXRoomState alloc] initBackStateWithRoomId:kRoomId andMatrixSession:mxSession andStateEvents:checkpoint];
+    XCTAssertNotNil([roomState memberWithUserId:@"@user9:matrix.org"]);
+    XCTAssertNil([roomState memberWithUserId:@"@user10:matrix.org"]);
+}
+
+
+#pragma mark - Event context cache
+- (void)testCachedEventContextIsTrimmedToLimit
+{
+    XCTestExpectation *expectation = [self expectationWithDescription:@"asyncTest"];
+
+    NSMutableArray<MXEvent*> *eventsBefore = [NSMutableArray array];
+    NSMutableArray<MXEvent*> *eventsAfter = [NSMutableArray array];
+    for (NSUInteger i = 1; i <= 10; i++)
+    {
+        [eventsBefore addObject:[self eventWithJSON:[self messageEventJSON:[NSString stringWithFormat:@"$b%tu", i]]]];
+        [eventsAfter addObject:[self eventWithJSON:[self messageEventJSON:[NSString stringWithFormat:@"$a%tu", i]]]];
+    }
+
+    MXEventContext *eventContext = [[MXEventContext alloc] init];
+    eventContext.event = [self eventWithJSON:[self messageEventJSON:@"$e"]];
+    eventContext.eventsBefore = eventsBefore;
+    eventContext.eventsAfter = eventsAfter;
+    eventContext.start = @"start";
+    eventContext.end = @"end";
+    eventContext.state = @[[self eventWithJSON:[self memberEventJSON:@"$alice" userId:kAliceUserId displayname:@"Alice" prevDisplayname:nil]]];
+    [mxSession.eventContextCache storeContext:eventContext inRoom:kRoomId];
+
+    MXEventTimeline *timeline = [[MXEventTimeline alloc] initWithRoom:room andInitialEventId:@"$e"];
+
+    NSMutableArray<NSString*> *eventIds = [NSMutableArray array];
+    [timeline listenToEvents:^(MXEvent *event, MXTimelineDirection direction, MXRoomState *roomState) {
+        [eventIds addObject:event.eventId];
+    }];
+
+    [timeline resetPaginationAroundInitialEventWithLimit:4 success:^{
+
+        // The window has the requested size
+        XCTAssertEqualObjects(eventIds, (@[@"$e", @"$b1", @"$b2", @"$a1", @"$a2"]));
+
+        // Other cached events are provided by paginations, without request
+        [eventIds removeAllObjects];
+        XCTAssertTrue([timeline canPaginate:MXTimelineDirectionBackwards]);
+        XCTAssertNil([timeline paginate:3 direction:MXTimelineDirectionBackwards onlyFromStore:NO complete:^{
+        } failure:^(NSError *error) {
+            XCTFail(@"The request should not fail - NSError: %@", error);
+        }]);
+        XCTAssertEqualObjects(eventIds, (@[@"$b3", @"$b4", @"$b5"]));
+
+        [eventIds removeAllObjects];
+        XCTAssertNil([timeline paginate:20 direction:MXTimelineDirectionForwards onlyFromStore:NO complete:^{
+        } failure:^(NSError *error) {
+            XCTFail(@"The request should not fail - NSError: %@", error);
+        }]);
+        XCTAssertEqual(eventIds.count, 8);
+        XCTAssertEqualObjects(eventIds.lastObject, @"$a10");
+
+        [expectation fulfill];
+
+    } failure:^(NSError *error) {
+        XCTFail(@"The request should not fail - NSError: %@", error);
+        [expectation fulfill];
+    }];
+
+    // Like a request, the callback is asynchronous
+    XCTAssertEqual(eventIds.count, 0);
+
+    [self waitForExpectationsWithTimeout:1 handler:nil];
+}
+
+
+#pragma mark - Fast join
+- (void)testFastJoinReconciliation
+{
+    NSDictionary *aliceJSON = [self memberEventJSON:@"$alice" userId:kAliceUserId displayname:@"Alice" prevDisplayname:nil];
+    NSDictionary *oldNameJSON = [self nameEventJSON:@"$name1" name:@"Old" prevName:nil];
+    NSDictionary *newNameJSON = [self nameEventJSON:@"$name2" name:@"New" prevName:@"Old"];
+
+    // Fast join: /initialSync provides the current state
+    [room.liveTimeline handleRoomInitialSync:[MXRoomInitialSync modelFromJSON:@{
+                                                                                 @"room_id": kRoomId,
+                                                                                 @"state": @[aliceJSON, newNameJSON],
+                                                                                 @"messages": @{@"chunk": @[newNameJSON, [self messageEventJSON:@"$msg1"]], @"start": @"start", @"end": @"end"}
+                                                                                 }]];
+    XCTAssertEqualObjects(room.state.name, @"New");
+
+    NSCountedSet<NSString*> *notifiedEventIds = [NSCountedSet set];
+    [room.liveTimeline listenToEvents:^(MXEvent *event, MXTimelineDirection direction, MXRoomState *roomState) {
+        [notifiedEventIds addObject:event.eventId];
+    }];
+
+    // The overlapping /sync response comes with the state at the start of its timeline
+    [self handleSyncWithState:@[aliceJSON, oldNameJSON]
+                     timeline:@[newNameJSON, [self messageEventJSON:@"$msg1"], [self messageEventJSON:@"$msg3"]]
+                      limited:YES];
+
+    XCTAssertEqualObjects(room.state.name, @"New", @"The older /sync state must not override the current one");
+    XCTAssertEqualObjects(notifiedEventIds, [NSCountedSet setWithObject:@"$msg3"], @"Only the new event must be notified, once");
+    XCTAssertTrue([store eventExistsWithEventId:@"$msg1" inRoom:kRoomId], @"The timeline must not be flushed");
+
+    // Next responses are handled normally
+    [self handleSyncWithState:@[] timeline:@[[self nameEventJSON:@"$name3" name:@"Newer" prevName:@"New"]] limited:NO];
+    XCTAssertEqualObjects(room.state.name, @"Newer");
+    XCTAssertEqual([notifiedEventIds countForObject:@"$name3"], 1);
+}
+
+
+#pragma mark - Sender profiles
+- (void)testEventSenderProfile
+{
+    BOOL enableEventSenderProfileDecoration = [MXSDKOptions sharedInstance].enableEventSenderProfileDecoration;
+    [MXSDKOptions sharedInstance].enableEventSenderProfileDecoration = YES;
+
+    NSMutableDictionary<NSString*, MXEvent*> *events = [NSMutableDictionary dictionary];
+    [room.liveTimeline listenToEvents:^(MXEvent *event, MXTimelineDirection direction, MXRoomState *roomState) {
+        events[event.eventId] = event;
+    }];
+
+    // Live events
+    [self handleSyncWithState:@[[self memberEventJSON:@"$alice" userId:kAliceUserId displayname:@"Alice" prevDisplayname:nil]]
+                     timeline:@[[self messageEventJSON:@"$m1"],
+                                [self memberEventJSON:@"$alice2" userId:kAliceUserId displayname:@"Alice2" prevDisplayname:@"Alice"],
+                                [self messageEventJSON:@"$m2"]]
+                      limited:YES];
+
+    XCTAssertEqualObjects(events[@"$m1"].senderProfile.displayname, @"Alice");
+    XCTAssertEqualObjects(events[@"$alice2"].senderProfile.displayname, @"Alice", @"A member event has the profile of the state before it");
+    XCTAssertEqualObjects(events[@"$m2"].senderProfile.displayname, @"Alice2");
+
+    // The profile survives the redaction
+    [self handleSyncWithState:@[]
+                     timeline:@[@{
+                                    @"event_id": @"$redaction",
+                                    @"type": kMXEventTypeStringRoomRedaction,
+                                    @"sender": kAliceUserId,
+                                    @"redacts": @"$m2",
+                                    @"content": @{}
+                                    }]
+                      limited:NO];
+
+    MXEvent *redactedEvent = [store eventWithEventId:@"$m2" inRoom:kRoomId];
+    XCTAssertNotNil(redactedEvent.redactedBecause);
+    XCTAssertEqualObjects(redactedEvent.senderProfile.displayname, @"Alice2");
+
+    // Paginated events get the profile from the back state
+    [events removeAllObjects];
+    [room.liveTimeline resetPagination];
+    [room.liveTimeline paginate:10 direction:MXTimelineDirectionBackwards onlyFromStore:YES complete:^{
+    } failure:^(NSError *error) {
+        XCTFail(@"The request should not fail - NSError: %@", error);
+    }];
+
+    XCTAssertEqualObjects(events[@"$m2"].senderProfile.displayname, @"Alice2");
+    XCTAssertEqualObjects(events[@"$alice2"].senderProfile.displayname, @"Alice");
+    XCTAssertEqualObjects(events[@"$m1"].senderProfile.displayname, @"Alice");
+
+    MXPaginationResponse *paginationResponse = [MXPaginationResponse modelFromJSON:@{
+                                                                                     @"chunk": @[[self memberEventJSON:@"$alice1" userId:kAliceUserId displayname:@"Alice" prevDisplayname:@"Alice0"],
+                                                                                                 [self messageEventJSON:@"$m0"]],
+                                                                                     @"start": @"prev_batch",
+                                                                                     @"end": @"end"
+                                                                                     }];
+    [room.liveTimeline handlePaginationResponse:paginationResponse direction:MXTimelineDirectionBackwards];
+
+    XCTAssertEqualObjects(events[@"$alice1"].senderProfile.displayname, @"Alice0");
+    XCTAssertEqualObjects(events[@"$m0"].senderProfile.displayname, @"Alice0");
+
+    [MXSDKOptions sharedInstance].enableEventSenderProfileDecoration = enableEventSenderProfileDecoration;
+}
+
+@end
@@ -0,0 +1,178 @@
+/*
+ Copyright 2016 OpenMarket Ltd
+
+ Licensed under the Apache License, Version 2.0 (the "License");
+ you may not use this file except in compliance with the License.
+ You may obtain a copy of the License at
+
+ http://www.apache.org/licenses/LICENSE-2.0
+
+ Unless required by applicable law or agreed to in writing, software
+ distributed under the License is distributed on an "AS IS" BASIS,
+ WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ See the License for the specific language governing permissions and
+ limitations under the License.
+ */
+
+#import <UIKit/UIKit.h>
+#import <XCTest/XCTest.h>
+
+#import "MXFileRoomStore.h"
+
+#pragma mark - MXCorruptedFileRoomStore
+// Archive a membership events table with a truncated column
+@interface MXCorruptedFileRoomStore : NSObject <NSCoding>
+@end
+
+@implementation MXCorruptedFileRoomStore
+
+- (Class)classForKeyedArchiver
+{
+    return MXFileRoomStore.class;
+}
+
+- (id)initWithCoder:(NSCoder *)aDecoder
+{
+    return nil;
+}
+
+- (void)encodeWithCoder:(NSCoder *)aCoder
+{
+    uint32_t refs[2] = {0, 0};
+    uint64_t ts[2] = {0, 0};
+
+    [aCoder encodeObject:@[] forKey:@"messages"];
+    [aCoder encodeObject:[NSData dataWithBytes:(uint32_t[]){0, 1} length:2 * sizeof(uint32_t)] forKey:@"memberEventsPositions"];
+    [aCoder encodeObject:@"!room:matrix.org" forKey:@"memberEventsRoomId"];
+    [aCoder encodeObject:@[@"$0", @"$1"] forKey:@"memberEventsEventIds"];
+    [aCoder encodeObject:@[@"@alice:matrix.org"] forKey:@"memberEventsUserIds"];
+    [aCoder encodeObject:[NSData dataWithBytes:refs length:sizeof(uint32_t)] forKey:@"memberEventsSenders"];
+    [aCoder encodeObject:[NSData dataWithBytes:refs length:sizeof(refs)] forKey:@"memberEventsStateKeys"];
+    [aCoder encodeObject:@[@{@"membership": @"join"}] forKey:@"memberEventsContents"];
+    [aCoder encodeObject:[NSData dataWithBytes:refs length:sizeof(refs)] forKey:@"memberEventsContentRefs"];
+    [aCoder encodeObject:[NSData dataWithBytes:refs length:sizeof(refs)] forKey:@"memberEventsPrevContentRefs"];
+    [aCoder encodeObject:[NSData dataWithBytes:ts length:sizeof(ts)] forKey:@"memberEventsOriginServerTs"];
+    [aCoder encodeObject:[NSData dataWithBytes:ts length:sizeof(ts)] forKey:@"memberEventsAgeLocalTs"];
+}
+
+@end
+
+
+@interface MXFileRoomStoreTests : XCTestCase
+
+@end
+
+@implementation MXFileRoomStoreTests
+
+- (MXEvent*)memberEventWithId:(NSString*)eventId userId:(NSString*)userId content:(NSDictionary*)content prevContent:(NSDictionary*)prevContent
+{
+    NSMutableDictionary *JSON = [NSMutableDictionary dictionaryWithDictionary:@{
+                                                                                 @"event_id": eventId,
+                                                                                 @"type": kMXEventTypeStringRoomMember,
+                                                                                 @"room_id": @"!room:matrix.org",
+                                                                                 @"sender": userId,
+                                                                                 @"state_key": userId,
+                                                                                 @"origin_server_ts": @(1000),
+                                                                                 @"content": content
+                                                                                 }];
+    if (prevContent)
+    {
+        JSON[@"unsigned"] = @{@"prev_content": prevContent};
+    }
+    return [MXEvent modelFromJSON:JSON];
+}
+
+- (MXEvent*)messageEventWithId:(NSString*)eventId
+{
+    return [MXEvent modelFromJSON:@{
+                                    @"event_id": eventId,
+                                    @"type": kMXEventTypeStringRoomMessage,
+                                    @"room_id": @"!room:matrix.org",
+                                    @"sender": @"@alice:matrix.org",
+                                    @"content": @{@"msgtype": kMXMessageTypeText, @"body": eventId}
+                                    }];
+}
+
+- (MXFileRoomStore*)roundTrip:(MXFileRoomStore*)roomStore
+{
+    NSData *data = [NSKeyedArchiver archivedDataWithRootObject:roomStore];
+    return [NSKeyedUnarchiver unarchiveObjectWithData:data];
+}
+
+- (void)testRoundTripKeepsPositions
+{
+    NSDictionary *join = @{@"membership": kMXMembershipStringJoin, @"displayname": @"Alice"};
+
+    NSArray<MXEvent*> *events = @[
+                                  [self memberEventWithId:@"$0" userId:@"@alice:matrix.org" content:join prevContent:nil],
+                                  [self messageEventWithId:@"$1"],
+                                  [self memberEventWithId:@"$2" userId:@"@bob:matrix.org" content:join prevContent:nil],
+                                  [self messageEventWithId:@"$3"],
+                                  [self memberEventWithId:@"$4" userId:@"@alice:matrix.org" content:@{@"membership": kMXMembershipStringLeave} prevContent:join]
+                                  ];
+
+    MXFileRoomStore *roomStore = [[MXFileRoomStore alloc] init];
+    for (MXEvent *event in events)
+    {
+        [roomStore storeEvent:event direction:MXTimelineDirectionForwards];
+    }
+
+    MXFileRoomStore *decodedRoomStore = [self roundTrip:roomStore];
+    NSArray<MXEvent*> *decodedEvents = decodedRoomStore.messagesSnapshot;
+
+    XCTAssertEqual(decodedEvents.count, events.count);
+    for (NSUInteger i = 0; i < events.count; i++)
+    {
+        XCTAssertEqualObjects(decodedEvents[i].eventId, events[i].eventId);
+        XCTAssertEqualObjects(decodedEvents[i].type, events[i].type);
+        XCTAssertEqualObjects(decodedEvents[i].roomId, events[i].roomId);
+        XCTAssertEqualObjects(decodedEvents[i].sender, events[i].sender);
+        XCTAssertEqualObjects(decodedEvents[i].stateKey, events[i].stateKey);
+        XCTAssertEqualObjects(decodedEvents[i].content, events[i].content);
+        XCTAssertEqualObjects(decodedEvents[i].prevContent, events[i].prevContent);
+        XCTAssertEqual(decodedEvents[i].originServerTs, events[i].originServerTs);
+    }
+
+    // Membership events are built once
+    XCTAssertEqual([decodedRoomStore eventWithEventId:@"$4"], decodedEvents[4]);
+    XCTAssertEqual(decodedRoomStore.messagesSnapshot[4], decodedEvents[4]);
+
+    // The decoded store is still writable
+    [decodedRoomStore storeEvent:[self messageEventWithId:@"$5"] direction:MXTimelineDirectionForwards];
+    XCTAssertEqual(decodedRoomStore.messagesSnapshot.count, 6);
+    XCTAssertNotNil([decodedRoomStore eventWithEventId:@"$5"]);
+
+    MXEvent *redactedEvent = [self memberEventWithId:@"$2" userId:@"@bob:matrix.org" content:@{} prevContent:nil];
+    [decodedRoomStore replaceEvent:redactedEvent];
+    XCTAssertEqual([decodedRoomStore eventWithEventId:@"$2"], redactedEvent);
+    XCTAssertEqual(decodedRoomStore.messagesSnapshot[2], redactedEvent);
+
+    XCTAssertEqual([decodedRoomStore removeMessagesBeforeEvent:@"$3"], 3);
+    XCTAssertNil([decodedRoomStore eventWithEventId:@"$0"]);
+    XCTAssertEqualObjects(decodedRoomStore.messagesSnapshot.firstObject.eventId, @"$3");
+
+    // A second round trip gives the same messages
+    NSArray<MXEvent*> *decodedEvents2 = [self roundTrip:decodedRoomStore].messagesSnapshot;
+    XCTAssertEqualObjects([decodedEvents2 valueForKey:@"eventId"], (@[@"$3", @"$4", @"$5"]));
+}
+
+- (void)testBooleanContentsAreNotShared
+{
+    MXFileRoomStore *roomStore = [[MXFileRoomStore alloc] init];
+    [roomStore storeEvent:[self memberEventWithId:@"$0" userId:@"@alice:matrix.org" content:@{@"membership": @"join", @"flag": @YES} prevContent:nil] direction:MXTimelineDirectionForwards];
+    [roomStore storeEvent:[self memberEventWithId:@"$1" userId:@"@bob:matrix.org" content:@{@"membership": @"join", @"flag": @1} prevContent:nil] direction:MXTimelineDirectionForwards];
+
+    NSArray<MXEvent*> *decodedEvents = [self roundTrip:roomStore].messagesSnapshot;
+
+    XCTAssertEqual(CFGetTypeID((__bridge CFTypeRef)decodedEvents[0].content[@"flag"]), CFBooleanGetTypeID());
+    XCTAssertEqual(CFGetTypeID((__bridge CFTypeRef)decodedEvents[1].content[@"flag"]), CFNumberGetTypeID());
+}
+
+- (void)testCorruptedTableFailsDecoding
+{
+    NSData *data = [NSKeyedArchiver archivedDataWithRootObject:[[MXCorruptedFileRoomStore alloc] init]];
+
+    XCTAssertNil([NSKeyedUnarchiver unarchiveObjectWithData:data]);
+}
+
+@end
@@ -0,0 +1,126 @@
+/*
+ Copyright 2016 OpenMarket Ltd
+
+ Licensed under the Apache License, Version 2.0 (the "License");
+ you may not use this file except in compliance with the License.
+ You may obtain a copy of the License at
+
+ http://www.apache.org/licenses/LICENSE-2.0
+
+ Unless required by applicable law or agreed to in writing, software
+ distributed under the License is distributed on an "AS IS" BASIS,
+ WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ See the License for the specific language governing permissions and
+ limitations under the License.
+ */
+
+#import <UIKit/UIKit.h>
+#import <XCTest/XCTest.h>
+
+#import "MXJSONResponseSerializer.h"
+
+#pragma mark - MXTestJSONResponseParser
+// A parser based on NSJSONSerialization, like AFJSONResponseSerializer
+@interface MXTestJSONResponseParser : NSObject <MXJSONResponseParser>
+@end
+
+@implementation MXTestJSONResponseParser
+
+- (id)JSONObjectWithData:(NSData *)data error:(NSError *__autoreleasing *)error
+{
+    return [NSJSONSerialization JSONObjectWithData:data options:0 error:error];
+}
+
+@end
+
+
+@interface MXJSONResponseSerializerTests : XCTestCase
+{
+    AFJSONResponseSerializer *afSerializer;
+    MXJSONResponseSerializer *mxSerializer;
+}
+
+@end
+
+@implementation MXJSONResponseSerializerTests
+
+- (void)setUp
+{
+    [super setUp];
+
+    afSerializer = [AFJSONResponseSerializer serializer];
+
+    mxSerializer = [MXJSONResponseSerializer serializer];
+    mxSerializer.parser = [[MXTestJSONResponseParser alloc] init];
+}
+
+- (void)tearDown
+{
+    afSerializer = nil;
+    mxSerializer = nil;
+
+    [super tearDown];
+}
+
+// Check that both serializers give the same result for a response
+- (void)checkResponseWithStatusCode:(NSInteger)statusCode contentType:(NSString*)contentType body:(NSString*)body
+{
+    NSDictionary *headers = contentType ? @{@"Content-Type": contentType} : @{};
+    NSHTTPURLResponse *response = [[NSHTTPURLResponse alloc] initWithURL:[NSURL URLWithString:@"https://matrix.org/_matrix/client/r0/sync"]
+                                                              statusCode:statusCode
+                                                             HTTPVersion:@"HTTP/1.1"
+                                                            headerFields:headers];
+    NSData *data = [body dataUsingEncoding:NSUTF8StringEncoding];
+
+    NSError *afError, *mxError;
+    id afResponseObject = [afSerializer responseObjectForResponse:response data:data error:&afError];
+    id mxResponseObject = [mxSerializer responseObjectForResponse:response data:data error:&mxError];
+
+    NSString *description = [NSString stringWithFormat:@"%tu %@ '%@'", statusCode, contentType, body];
+
+    XCTAssertEqualObjects(mxResponseObject, afResponseObject, @"%@", description);
+    XCTAssertEqualObjects(mxError.domain, afError.domain, @"%@", description);
+    XCTAssertEqual(mxError.code, afError.code, @"%@", description);
+
+    NSError *afUnderlyingError = afError.userInfo[NSUnderlyingErrorKey];
+    NSError *mxUnderlyingError = mxError.userInfo[NSUnderlyingErrorKey];
+    XCTAssertEqualObjects(mxUnderlyingError.domain, afUnderlyingError.domain, @"%@", description);
+    XCTAssertEqual(mxUnderlyingError.code, afUnderlyingError.code, @"%@", description);
+
+    // Without error pointer
+    XCTAssertEqualObjects([mxSerializer responseObjectForResponse:response data:data error:nil],
+                          [afSerializer responseObjectForResponse:response data:data error:nil], @"%@", description);
+}
+
+- (void)testJSONResponse
+{
+    [self checkResponseWithStatusCode:200 contentType:@"application/json" body:@"{\"next_batch\": \"s72595_4483_1934\", \"rooms\": {\"join\": {}}}"];
+    [self checkResponseWithStatusCode:200 contentType:@"application/json" body:@"[1, true, null, \"a\"]"];
+}
+
+- (void)testEmptyBody
+{
+    [self checkResponseWithStatusCode:200 contentType:@"application/json" body:@""];
+    [self checkResponseWithStatusCode:200 contentType:@"application/json" body:@" "];
+    [self checkResponseWithStatusCode:404 contentType:@"application/json" body:@""];
+}
+
+- (void)testInvalidJSON
+{
+    [self checkResponseWithStatusCode:200 contentType:@"application/json" body:@"{\"next_batch\": "];
+}
+
+- (void)testMatrixError
+{
+    [self checkResponseWithStatusCode:403 contentType:@"application/json" body:@"{\"errcode\": \"M_FORBIDDEN\", \"error\": \"Invalid password\"}"];
+    [self checkResponseWithStatusCode:500 contentType:@"application/json" body:@"Internal error"];
+}
+
+- (void)testNonJSONContentType
+{
+    [self checkResponseWithStatusCode:200 contentType:@"text/html" body:@"<html></html>"];
+    [self checkResponseWithStatusCode:502 contentType:@"text/html" body:@"<html>Bad gateway</html>"];
+    [self checkResponseWithStatusCode:200 contentType:nil body:@"{}"];
+}
+
+@end
@@ -0,0 +1,205 @@
+/*
+ Copyright 2016 OpenMarket Ltd
+
+ Licensed under the Apache License, Version 2.0 (the "License");
+ you may not use this file except in compliance with the License.
+ You may obtain a copy of the License at
+
+ http://www.apache.org/licenses/LICENSE-2.0
+
+ Unless required by applicable law or agreed to in writing, software
+ distributed under the License is distributed on an "AS IS" BASIS,
+ WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ See the License for the specific language governing permissions and
+ limitations under the License.
+ */
+
+#import <UIKit/UIKit.h>
+#import <XCTest/XCTest.h>
+
+#import "MXSession.h"
+#import "MXMemoryStore.h"
+#import "MXFileStore.h"
+#import "MXPushRuleEventMatchConditionChecker.h"
+
+@interface MXSession (MXMemoryPressureTests)
+
+- (MXRoom *)getOrCreateRoom:(NSString *)roomId notify:(BOOL)notify;
+
+@end
+
+/**
+ A memory pressure handler that releases a fixed number of objects.
+ */
+@interface MXMemoryPressureTestsHandler : NSObject <MXMemoryPressureHandler>
+
+@property (nonatomic) NSUInteger objectsCount;
+@property (nonatomic) MXMemoryPressureLevel lastLevel;
+
+@end
+
+@implementation MXMemoryPressureTestsHandler
+
+- (NSUInteger)handleMemoryPressure:(MXMemoryPressureLevel)level
+{
+    _lastLevel = level;
+
+    NSUInteger count = _objectsCount;
+    _objectsCount = 0;
+
+    return count;
+}
+
+@end
+
+
+/**
+ Tests of the memory pressure handling, without homeserver.
+ */
+@interface MXMemoryPressureTests : XCTestCase
+{
+    MXSession *mxSession;
+}
+
+@end
+
+static NSString *const kRoomId = @"!room:matrix.org";
+
+@implementation MXMemoryPressureTests
+
+- (void)setUp
+{
+    [super setUp];
+
+    MXCredentials *credentials = [[MXCredentials alloc] initWithHomeServer:@"https://matrix.org" userId:@"@alice:matrix.org" accessToken:@"token"];
+    MXRestClient *restClient = [[MXRestClient alloc] initWithCredentials:credentials andOnUnrecognizedCertificateBlock:nil];
+    mxSession = [[MXSession alloc] initWithMatrixRestClient:restClient];
+
+    // MXMemoryStore opens synchronously
+    [mxSession setStore:[[MXMemoryStore alloc] init] success:^{
+    } failure:^(NSError *error) {
+        XCTFail(@"The request should not fail - NSError: %@", error);
+    }];
+}
+
+- (void)tearDown
+{
+    [mxSession close];
+    mxSession = nil;
+
+    [super tearDown];
+}
+
+- (void)testAggregatedCount
+{
+    XCTAssertEqual([mxSession handleMemoryPressure:MXMemoryPressureLevelCritical], 0, @"A new session has nothing to release");
+
+    MXMemoryPressureTestsHandler *handler = [[MXMemoryPressureTestsHandler alloc] init];
+    handler.objectsCount = 3;
+    [mxSession registerMemoryPressureHandler:handler];
+
+    MXRoom *room = [mxSession getOrCreateRoom:kRoomId notify:NO];
+    [room.state memberName:@"@bob:matrix.org"];
+
+    XCTAssertEqual([mxSession handleMemoryPressure:MXMemoryPressureLevelModerate], 4);
+    XCTAssertEqual(handler.lastLevel, MXMemoryPressureLevelModerate);
+
+    // Unregistered handlers are no more called
+    handler.objectsCount = 3;
+    [mxSession unregisterMemoryPressureHandler:handler];
+
+    XCTAssertEqual([mxSession handleMemoryPressure:MXMemoryPressureLevelModerate], 0);
+    XCTAssertEqual(handler.objectsCount, 3);
+}
+
+- (void)testRoomStateCaches
+{
+    MXRoom *room = [mxSession getOrCreateRoom:kRoomId notify:NO];
+
+    [room.state memberName:@"@bob:matrix.org"];
+    [room.state senderProfile:@"@bob:matrix.org"];
+    [room.state senderProfile:@"@charlie:matrix.org"];
+
+    XCTAssertEqual([mxSession handleMemoryPressure:MXMemoryPressureLevelModerate], 3);
+    XCTAssertEqual([mxSession handleMemoryPressure:MXMemoryPressureLevelModerate], 0, @"The caches must have been emptied");
+
+    // The caches are rebuilt on demand
+    XCTAssertEqualObjects([room.state memberName:@"@bob:matrix.org"], @"@bob:matrix.org");
+    XCTAssertEqual([room.liveTimeline handleMemoryPressure:MXMemoryPressureLevelModerate], 1);
+}
+
+- (void)testRoomTimelinePreviousState
+{
+    MXRoom *room = [mxSession getOrCreateRoom:kRoomId notify:NO];
+    [room.liveTimeline setValue:[room.state copy] forKey:@"previousState"];
+
+    XCTAssertEqual([room.liveTimeline handleMemoryPressure:MXMemoryPressureLevelModerate], 0, @"The previous state must be kept on moderate pressure");
+    XCTAssertNotNil([room.liveTimeline valueForKey:@"previousState"]);
+
+    XCTAssertEqual([mxSession handleMemoryPressure:MXMemoryPressureLevelCritical], 1);
+    XCTAssertNil([room.liveTimeline valueForKey:@"previousState"]);
+}
+
+- (void)testFileStorePreloadCaches
+{
+    MXFileStore *store = [[MXFileStore alloc] init];
+
+    NSMutableDictionary *preloadedRoomsStates = [store valueForKey:@"preloadedRoomsStates"];
+    NSMutableDictionary *preloadedRoomAccountData = [store valueForKey:@"preloadedRoomAccountData"];
+
+    preloadedRoomsStates[kRoomId] = @[];
+    preloadedRoomsStates[@"!room2:matrix.org"] = @[];
+    preloadedRoomAccountData[kRoomId] = [[MXRoomAccountData alloc] init];
+
+    XCTAssertEqual([store handleMemoryPressure:MXMemoryPressureLevelModerate], 3);
+    XCTAssertEqual(preloadedRoomsStates.count, 0);
+    XCTAssertEqual(preloadedRoomAccountData.count, 0);
+
+    XCTAssertEqual([store handleMemoryPressure:MXMemoryPressureLevelModerate], 0);
+}
+
+- (void)testPushRuleRegexCache
+{
+    MXPushRuleEventMatchConditionChecker *checker = [[MXPushRuleEventMatchConditionChecker alloc] init];
+    [mxSession.notificationCenter setChecker:checker forConditionKind:kMXPushRuleConditionStringEventMatch];
+
+    MXPushRuleCondition *condition = [[MXPushRuleCondition alloc] init];
+    condition.kind = kMXPushRuleConditionStringEventMatch;
+
+    NSDictionary *eventDict = @{@"content": @{@"body": @"Hello world"}};
+    for (NSString *pattern in @[@"hello", @"world"])
+    {
+        condition.parameters = @{@"key": @"content.body", @"pattern": pattern};
+        XCTAssert([checker isCondition:condition satisfiedBy:nil withJsonDict:eventDict]);
+    }
+
+    XCTAssertEqual([mxSession handleMemoryPressure:MXMemoryPressureLevelModerate], 2);
+    XCTAssertEqual([mxSession handleMemoryPressure:MXMemoryPressureLevelModerate], 0, @"The regex cache must have been emptied");
+
+    // The regexs are compiled again on demand
+    XCTAssert([checker isCondition:condition satisfiedBy:nil withJsonDict:eventDict]);
+}
+
+- (void)testStoreCompactorIsOptIn
+{
+    MXStoreCompactor *storeCompactor = mxSession.storeCompactor;
+
+    MXRetentionPolicy *retentionPolicy = [[MXRetentionPolicy alloc] init];
+    retentionPolicy.maxEvents = 10;
+    storeCompactor.defaultRetentionPolicy = retentionPolicy;
+
+    XCTAssertFalse(storeCompactor.compactsOnMemoryPressure);
+
+    [mxSession handleMemoryPressure:MXMemoryPressureLevelCritical];
+    XCTAssertNil([storeCompactor valueForKey:@"lastCompactionDate"], @"The compaction on memory pressure must be opt-in");
+
+    storeCompactor.compactsOnMemoryPressure = YES;
+
+    [mxSession handleMemoryPressure:MXMemoryPressureLevelModerate];
+    XCTAssertNil([storeCompactor valueForKey:@"lastCompactionDate"], @"Only critical pressure can trigger a compaction");
+
+    [mxSession handleMemoryPressure:MXMemoryPressureLevelCritical];
+    XCTAssertNotNil([storeCompactor valueForKey:@"lastCompactionDate"]);
+}
+
+@end
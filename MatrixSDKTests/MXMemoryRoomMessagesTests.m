@@ -0,0 +1,228 @@
+/*
+ Copyright 2016 OpenMarket Ltd
+
+ Licensed under the Apache License, Version 2.0 (the "License");
+ you may not use this file except in compliance with the License.
+ You may obtain a copy of the License at
+
+ http://www.apache.org/licenses/LICENSE-2.0
+
+ Unless required by applicable law or agreed to in writing, software
+ distributed under the License is distributed on an "AS IS" BASIS,
+ WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ See the License for the specific language governing permissions and
+ limitations under the License.
+ */
+
+#import <UIKit/UIKit.h>
+#import <XCTest/XCTest.h>
+
+#import "MXMemoryRoomMessages.h"
+
+/**
+ A messages storage that counts the messages it has to provide.
+ */
+@interface MXMemoryRoomMessagesTestsStorage : NSMutableArray
+{
+    NSMutableArray *events;
+}
+
+@property (nonatomic) NSUInteger readsCount;
+
+@end
+
+@implementation MXMemoryRoomMessagesTestsStorage
+
+- (instancetype)initWithCapacity:(NSUInteger)numItems
+{
+    self = [super init];
+    if (self)
+    {
+        events = [NSMutableArray arrayWithCapacity:numItems];
+    }
+    return self;
+}
+
+- (instancetype)init
+{
+    return [self initWithCapacity:0];
+}
+
+- (NSUInteger)count
+{
+    return events.count;
+}
+
+- (id)objectAtIndex:(NSUInteger)index
+{
+    _readsCount++;
+    return events[index];
+}
+
+- (void)insertObject:(id)anObject atIndex:(NSUInteger)index
+{
+    [events insertObject:anObject atIndex:index];
+}
+
+- (void)removeObjectAtIndex:(NSUInteger)index
+{
+    [events removeObjectAtIndex:index];
+}
+
+- (void)addObject:(id)anObject
+{
+    [events addObject:anObject];
+}
+
+- (void)removeLastObject
+{
+    [events removeLastObject];
+}
+
+- (void)replaceObjectAtIndex:(NSUInteger)index withObject:(id)anObject
+{
+    [events replaceObjectAtIndex:index withObject:anObject];
+}
+
+- (void)removeObjectsInRange:(NSRange)range
+{
+    [events removeObjectsInRange:range];
+}
+
+@end
+
+
+@interface MXMemoryRoomMessagesTests : XCTestCase
+@end
+
+@implementation MXMemoryRoomMessagesTests
+
+- (MXEvent*)eventWithId:(NSString*)eventId
+{
+    return [MXEvent modelFromJSON:@{
+                                    @"event_id": eventId,
+                                    @"type": kMXEventTypeStringRoomMessage,
+                                    @"room_id": @"!room:matrix.org",
+                                    @"sender": @"@alice:matrix.org",
+                                    @"content": @{@"msgtype": kMXMessageTypeText, @"body": eventId}
+                                    }];
+}
+
+- (NSArray<NSString*>*)eventIdsOf:(NSArray<MXEvent*>*)events
+{
+    return [events valueForKey:@"eventId"];
+}
+
+- (void)testOrder
+{
+    MXMemoryRoomMessages *messages = [[MXMemoryRoomMessages alloc] initWithEvents:@[[self eventWithId:@"$2"], [self eventWithId:@"$3"]]];
+
+    [messages appendEvent:[self eventWithId:@"$4"]];
+    [messages prependEvent:[self eventWithId:@"$1"]];
+    [messages prependEvent:[self eventWithId:@"$0"]];
+    [messages appendEvent:[self eventWithId:@"$5"]];
+
+    XCTAssertEqual(messages.count, 6);
+    NSArray *expected = @[@"$0", @"$1", @"$2", @"$3", @"$4", @"$5"];
+    XCTAssertEqualObjects([self eventIdsOf:messages.snapshot], expected);
+
+    NSArray<MXEvent*> *snapshot = messages.snapshot;
+    for (NSUInteger i = 0; i < snapshot.count; i++)
+    {
+        XCTAssertEqual([messages indexOfEvent:snapshot[i]], i);
+    }
+    XCTAssertEqual([messages indexOfEvent:[self eventWithId:@"$3"]], NSNotFound);
+}
+
+- (void)testSnapshotIsolation
+{
+    MXMemoryRoomMessages *messages = [[MXMemoryRoomMessages alloc] init];
+    [messages appendEvent:[self eventWithId:@"$1"]];
+
+    NSArray<MXEvent*> *snapshot = messages.snapshot;
+
+    [messages appendEvent:[self eventWithId:@"$2"]];
+    [messages prependEvent:[self eventWithId:@"$0"]];
+
+    XCTAssertEqualObjects([self eventIdsOf:snapshot], @[@"$1"]);
+
+    // Copying a snapshot does not copy the messages
+    XCTAssertEqual([snapshot copy], snapshot);
+
+    // Removals do not affect existing snapshots either. Replacements do
+    snapshot = messages.snapshot;
+
+    [messages replaceEventAtIndex:1 withEvent:[self eventWithId:@"$1bis"]];
+    [messages removeEventsBeforeIndex:1];
+
+    NSArray *expected = @[@"$0", @"$1bis", @"$2"];
+    XCTAssertEqualObjects([self eventIdsOf:snapshot], expected);
+    expected = @[@"$1bis", @"$2"];
+    XCTAssertEqualObjects([self eventIdsOf:messages.snapshot], expected);
+
+    [messages removeAllEvents];
+    XCTAssertEqual(messages.count, 0);
+    XCTAssertEqual(snapshot.count, 3);
+}
+
+- (void)testChangesDoNotReadTheStorage
+{
+    MXMemoryRoomMessagesTestsStorage *storage = [[MXMemoryRoomMessagesTestsStorage alloc] init];
+    for (NSUInteger i = 0; i < 10; i++)
+    {
+        [storage addObject:[self eventWithId:[NSString stringWithFormat:@"$%tu", i]]];
+    }
+
+    MXMemoryRoomMessages *messages = [[MXMemoryRoomMessages alloc] initWithEventsStorage:storage];
+    [messages prependEvent:[self eventWithId:@"$-1"]];
+
+    // Replace and remove in both the backward and the forward arrays
+    [messages replaceEventAtIndex:0 withEvent:[self eventWithId:@"$-1bis"]];
+    [messages replaceEventAtIndex:5 withEvent:[self eventWithId:@"$4bis"]];
+    [messages removeEventsBeforeIndex:1];
+    [messages removeEventsBeforeIndex:2];
+
+    XCTAssertEqual(storage.readsCount, 0, @"Replacements and removals must not build the stored messages");
+    XCTAssertEqual(messages.count, 8);
+
+    NSArray *expected = @[@"$2", @"$3", @"$4bis", @"$5", @"$6", @"$7", @"$8", @"$9"];
+    XCTAssertEqualObjects([self eventIdsOf:messages.snapshot], expected);
+}
+
+- (void)testRemovedEventsAreReleasedWithTheirLastSnapshot
+{
+    MXMemoryRoomMessagesTestsStorage *storage = [[MXMemoryRoomMessagesTestsStorage alloc] init];
+    for (NSUInteger i = 0; i < 5; i++)
+    {
+        [storage addObject:[self eventWithId:[NSString stringWithFormat:@"$%tu", i]]];
+    }
+
+    MXMemoryRoomMessages *messages = [[MXMemoryRoomMessages alloc] initWithEventsStorage:storage];
+
+    // No snapshot: the removed messages are released at once
+    [messages removeEventsBeforeIndex:1];
+    XCTAssertEqual(storage.count, 4);
+
+    @autoreleasepool
+    {
+        NSArray<MXEvent*> *snapshot = messages.snapshot;
+
+        // The snapshot still reads the removed messages, even after several removals
+        [messages removeEventsBeforeIndex:1];
+        [messages removeEventsBeforeIndex:1];
+        XCTAssertEqual(storage.count, 4);
+        XCTAssertEqual(messages.count, 2);
+
+        NSArray *expected = @[@"$1", @"$2", @"$3", @"$4"];
+        XCTAssertEqualObjects([self eventIdsOf:snapshot], expected);
+    }
+
+    // They are released by the next removal
+    [messages removeEventsBeforeIndex:1];
+    XCTAssertEqual(storage.count, 1);
+
+    NSArray *expected = @[@"$4"];
+    XCTAssertEqualObjects([self eventIdsOf:messages.snapshot], expected);
+}
+
+@end
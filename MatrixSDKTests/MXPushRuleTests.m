@@ -17,6 +17,8 @@
 #import <XCTest/XCTest.h>
 
 #import "MXNotificationCenter.h"
+#import "MXSession.h"
+#import "MXTools.h"
 
 #pragma mark - MXNotificationCenter overide for tests
 @interface MXNotificationCenterTests: MXNotificationCenter
@@ -37,6 +39,29 @@
 @end
 
 
+#pragma mark - MXRestClient overide for tests
+/**
+ A rest client that applies push rules changes without homeserver.
+ */
+@interface MXPushRuleTestsRestClient : MXRestClient
+@end
+
+@implementation MXPushRuleTestsRestClient
+
+- (MXHTTPOperation *)enablePushRule:(NSString*)ruleId
+                              scope:(NSString*)scope
+                               kind:(MXPushRuleKind)kind
+                             enable:(BOOL)enable
+                            success:(void (^)())success
+                            failure:(void (^)(NSError *error))failure
+{
+    success();
+    return nil;
+}
+
+@end
+
+
 @interface MXPushRuleTests : XCTestCase
 {
 }
@@ -210,4 +235,73 @@
     XCTAssertEqual(matchingRule, rule);
 }
 
+// Test that push rules updates are applied rule by rule
+- (void)testIncrementalRulesUpdate
+{
+    NSDictionary *fooRule = @{@"rule_id": @"foo", @"pattern": @"foo", @"enabled": @YES, @"actions": @[@"notify"]};
+    NSDictionary *barRule = @{@"rule_id": @"bar", @"pattern": @"bar", @"enabled": @YES, @"actions": @[@"notify"]};
+    NSDictionary *modifiedBarRule = @{@"rule_id": @"bar", @"pattern": @"baz", @"enabled": @YES, @"actions": @[@"notify"]};
+
+    MXNotificationCenter *notificationCenter = [[MXNotificationCenter alloc] initWithMatrixSession:nil];
+    [notificationCenter handlePushRulesResponse:[MXPushRulesResponse modelFromJSON:@{@"global": @{@"content": @[fooRule, barRule]}}]];
+
+    MXPushRule *foo = [notificationCenter ruleById:@"foo"];
+    MXPushRule *bar = [notificationCenter ruleById:@"bar"];
+    XCTAssertEqual([notificationCenter ruleMatchingEvent:[self messageTextEventWithContent:@"bar"]], bar);
+
+    [notificationCenter handlePushRulesResponse:[MXPushRulesResponse modelFromJSON:@{@"global": @{@"content": @[modifiedBarRule, fooRule]}}]];
+
+    // The unchanged rule is kept, the modified one is replaced
+    XCTAssertEqual([notificationCenter ruleById:@"foo"], foo);
+    XCTAssertNotEqual([notificationCenter ruleById:@"bar"], bar);
+    XCTAssertEqual(notificationCenter.rules.global.content[1], foo);
+
+    // The new priority order is applied
+    XCTAssertEqualObjects([notificationCenter.flatRules valueForKey:@"ruleId"], (@[@"bar", @"foo"]));
+
+    XCTAssertNil([notificationCenter ruleMatchingEvent:[self messageTextEventWithContent:@"bar"]]);
+    XCTAssertEqualObjects([notificationCenter ruleMatchingEvent:[self messageTextEventWithContent:@"baz"]].ruleId, @"bar");
+    XCTAssertEqual([notificationCenter ruleMatchingEvent:[self messageTextEventWithContent:@"foo"]], foo);
+}
+
+// Test that a rule changed locally is not kept when the home server sends it again
+- (void)testIncrementalRulesUpdateAfterLocalChange
+{
+    NSDictionary *fooRule = @{@"rule_id": @"foo", @"pattern": @"foo", @"enabled": @YES, @"actions": @[@"notify"]};
+    NSDictionary *barRule = @{@"rule_id": @"bar", @"pattern": @"bar", @"enabled": @YES, @"actions": @[@"notify"]};
+    NSDictionary *modifiedBarRule = @{@"rule_id": @"bar", @"pattern": @"baz", @"enabled": @YES, @"actions": @[@"notify"]};
+
+    NSDictionary *content = @{@"global": @{@"content": @[fooRule, barRule]}};
+
+    MXCredentials *credentials = [[MXCredentials alloc] initWithHomeServer:@"https://matrix.org" userId:@"@alice:matrix.org" accessToken:@"token"];
+    MXRestClient *restClient = [[MXPushRuleTestsRestClient alloc] initWithCredentials:credentials andOnUnrecognizedCertificateBlock:nil];
+    MXSession *mxSession = [[MXSession alloc] initWithMatrixRestClient:restClient];
+
+    MXNotificationCenter *notificationCenter = mxSession.notificationCenter;
+    [notificationCenter handlePushRulesResponse:[MXPushRulesResponse modelFromJSON:content]];
+
+    // The user disables the rule locally
+    MXPushRule *foo = [notificationCenter ruleById:@"foo"];
+    NSString *fooContentHash = foo.contentHash;
+    [notificationCenter enableRule:foo isEnabled:NO];
+
+    XCTAssertFalse([notificationCenter ruleById:@"foo"].enabled);
+    XCTAssertNil([notificationCenter ruleMatchingEvent:[self messageTextEventWithContent:@"foo"]]);
+
+    // Another client enables it again while a different rule changes in the same update
+    XCTAssertNotEqualObjects(notificationCenter.rules.contentHash, [MXTools contentHashOfJSON:content], @"The update of the rules must not be skipped");
+    [notificationCenter handlePushRulesResponse:[MXPushRulesResponse modelFromJSON:@{@"global": @{@"content": @[fooRule, modifiedBarRule]}}]];
+
+    // The stale disabled rule must not be kept
+    MXPushRule *newFoo = [notificationCenter ruleById:@"foo"];
+    XCTAssertNotEqual(newFoo, foo);
+    XCTAssertTrue(newFoo.enabled);
+    XCTAssertEqualObjects(newFoo.contentHash, fooContentHash);
+
+    XCTAssertEqual([notificationCenter ruleMatchingEvent:[self messageTextEventWithContent:@"foo"]], newFoo);
+    XCTAssertEqualObjects([notificationCenter ruleMatchingEvent:[self messageTextEventWithContent:@"baz"]].ruleId, @"bar");
+
+    [mxSession close];
+}
+
 @end
@@ -21,6 +21,7 @@
 #import "MXError.h"
 
 #import "MXRestClient.h"
+#import "MXPublicRoomDirectory.h"
 
 #define MXTESTS_USER @"mxtest"
 #define MXTESTS_PWD @"password"
@@ -382,4 +383,119 @@
     }];
 }
 
+- (void)testPublicRoomsWithLimit
+{
+    [matrixSDKTestsData doMXRestClientTestWithBobAndThePublicRoom:self readyToTest:^(MXRestClient *bobRestClient, NSString *roomId, XCTestExpectation *expectation) {
+
+        [mxRestClient publicRoomsWithLimit:1 since:nil searchTerm:nil success:^(MXPublicRoomsResponse *publicRoomsResponse) {
+
+            XCTAssertEqual(publicRoomsResponse.chunk.count, 1);
+
+            // Filter on the server side. It requires an access token
+            [bobRestClient publicRoomsWithLimit:0 since:nil searchTerm:@"MX Public Room test" success:^(MXPublicRoomsResponse *publicRoomsResponse) {
+
+                XCTAssertGreaterThanOrEqual(publicRoomsResponse.chunk.count, 1);
+
+                MXPublicRoom *theMXPublicRoom;
+                for (MXPublicRoom *room in publicRoomsResponse.chunk)
+                {
+                    if ([room.roomId isEqualToString:roomId])
+                    {
+                        theMXPublicRoom = room;
+                    }
+                }
+                XCTAssertNotNil(theMXPublicRoom);
+
+                [expectation fulfill];
+
+            } failure:^(NSError *error) {
+                XCTFail(@"The request should not fail - NSError: %@", error);
+                [expectation fulfill];
+            }];
+
+        } failure:^(NSError *error) {
+            XCTFail(@"The request should not fail - NSError: %@", error);
+            [expectation fulfill];
+        }];
+
+    }];
+}
+
+- (void)testPublicRoomDirectory
+{
+    [matrixSDKTestsData doMXRestClientTestWithBobAndThePublicRoom:self readyToTest:^(MXRestClient *bobRestClient, NSString *roomId, XCTestExpectation *expectation) {
+
+        MXPublicRoomDirectory *publicRoomDirectory = [[MXPublicRoomDirectory alloc] initWithRestClient:mxRestClient];
+
+        [publicRoomDirectory paginate:^(NSArray<MXPublicRoom *> *rooms) {
+
+            XCTAssertGreaterThan(rooms.count, 0);
+            XCTAssertEqualObjects(publicRoomDirectory.rooms, rooms);
+
+            // The local filter must find the test room
+            NSArray<MXPublicRoom *> *matchingRooms = [publicRoomDirectory roomsMatchingFilter:@"public ROOM"];
+            BOOL found = NO;
+            for (MXPublicRoom *room in matchingRooms)
+            {
+                found |= [room.roomId isEqualToString:roomId];
+            }
+            XCTAssert(found || publicRoomDirectory.hasMoreRooms);
+            XCTAssertEqual([publicRoomDirectory roomsMatchingFilter:@"xyzunknownword"].count, 0);
+
+            // The first page must now come from the cache
+            [publicRoomDirectory reset];
+            MXHTTPOperation *operation = [publicRoomDirectory paginate:^(NSArray<MXPublicRoom *> *cachedRooms) {
+
+                XCTAssertEqualObjects(cachedRooms, rooms);
+                [expectation fulfill];
+
+            } failure:^(NSError *error) {
+                XCTFail(@"The request should not fail - NSError: %@", error);
+                [expectation fulfill];
+            }];
+            XCTAssertNil(operation);
+
+        } failure:^(NSError *error) {
+            XCTFail(@"The request should not fail - NSError: %@", error);
+            [expectation fulfill];
+        }];
+
+    }];
+}
+
+- (void)testPublicRoomDirectoryConcurrentPaginations
+{
+    [matrixSDKTestsData doMXRestClientTestWithBobAndThePublicRoom:self readyToTest:^(MXRestClient *bobRestClient, NSString *roomId, XCTestExpectation *expectation) {
+
+        MXPublicRoomDirectory *publicRoomDirectory = [[MXPublicRoomDirectory alloc] initWithRestClient:mxRestClient];
+        publicRoomDirectory.cacheLifetime = 0;
+
+        __block NSArray<MXPublicRoom *> *firstRooms;
+        MXHTTPOperation *operation = [publicRoomDirectory paginate:^(NSArray<MXPublicRoom *> *rooms) {
+
+            firstRooms = rooms;
+
+        } failure:^(NSError *error) {
+            XCTFail(@"The request should not fail - NSError: %@", error);
+            [expectation fulfill];
+        }];
+        XCTAssertNotNil(operation);
+
+        // The second caller must get the same page
+        MXHTTPOperation *operation2 = [publicRoomDirectory paginate:^(NSArray<MXPublicRoom *> *rooms) {
+
+            XCTAssertNotNil(firstRooms, @"Callers must be called back in order");
+            XCTAssertEqualObjects(rooms, firstRooms);
+            XCTAssertEqualObjects(publicRoomDirectory.rooms, rooms, @"The page must be added once");
+            [expectation fulfill];
+
+        } failure:^(NSError *error) {
+            XCTFail(@"The request should not fail - NSError: %@", error);
+            [expectation fulfill];
+        }];
+        XCTAssertNil(operation2);
+
+    }];
+}
+
 @end
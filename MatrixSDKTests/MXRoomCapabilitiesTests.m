@@ -0,0 +1,164 @@
+/*
+ Copyright 2016 OpenMarket Ltd
+
+ Licensed under the Apache License, Version 2.0 (the "License");
+ you may not use this file except in compliance with the License.
+ You may obtain a copy of the License at
+
+ http://www.apache.org/licenses/LICENSE-2.0
+
+ Unless required by applicable law or agreed to in writing, software
+ distributed under the License is distributed on an "AS IS" BASIS,
+ WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ See the License for the specific language governing permissions and
+ limitations under the License.
+ */
+
+#import <UIKit/UIKit.h>
+#import <XCTest/XCTest.h>
+
+#import "MXRoomState.h"
+
+@interface MXRoomCapabilitiesTests : XCTestCase
+{
+    MXRoomState *roomState;
+}
+
+@end
+
+@implementation MXRoomCapabilitiesTests
+
+- (void)setUp
+{
+    [super setUp];
+
+    roomState = [[MXRoomState alloc] initWithRoomId:@"!room:matrix.org" andMatrixSession:nil andDirection:YES];
+}
+
+- (void)tearDown
+{
+    roomState = nil;
+
+    [super tearDown];
+}
+
+- (MXEvent*)powerLevelsEventWithContent:(NSDictionary*)content
+{
+    return [MXEvent modelFromJSON:@{
+                                    @"event_id": [[NSUUID UUID] UUIDString],
+                                    @"type": kMXEventTypeStringRoomPowerLevels,
+                                    @"state_key": @"",
+                                    @"sender": @"@alice:matrix.org",
+                                    @"content": content
+                                    }];
+}
+
+- (void)testCapabilities
+{
+    [roomState handleStateEvent:[self powerLevelsEventWithContent:@{
+                                                                    @"users": @{@"@alice:matrix.org": @100, @"@bob:matrix.org": @50},
+                                                                    @"users_default": @0,
+                                                                    @"ban": @50,
+                                                                    @"kick": @50,
+                                                                    @"redact": @50,
+                                                                    @"invite": @0,
+                                                                    @"events": @{kMXEventTypeStringRoomName: @100},
+                                                                    @"events_default": @0,
+                                                                    @"state_default": @50
+                                                                    }]];
+
+    XCTAssertTrue([roomState canUser:@"@alice:matrix.org" perform:MXRoomCapabilityBan | MXRoomCapabilityKick]);
+    XCTAssertTrue([roomState canUser:@"@bob:matrix.org" perform:MXRoomCapabilityRedact]);
+    XCTAssertFalse([roomState canUser:@"@charlie:matrix.org" perform:MXRoomCapabilityKick]);
+    XCTAssertEqual([roomState capabilitiesOfUser:@"@charlie:matrix.org"], MXRoomCapabilityInvite | MXRoomCapabilitySendMessage);
+
+    XCTAssertTrue([roomState canUser:@"@alice:matrix.org" sendEventOfType:kMXEventTypeStringRoomName asStateEvent:YES]);
+    XCTAssertFalse([roomState canUser:@"@bob:matrix.org" sendEventOfType:kMXEventTypeStringRoomName asStateEvent:YES]);
+    XCTAssertTrue([roomState canUser:@"@bob:matrix.org" sendEventOfType:kMXEventTypeStringRoomTopic asStateEvent:YES]);
+    XCTAssertTrue([roomState canUser:@"@charlie:matrix.org" sendEventOfType:kMXEventTypeStringRoomMessage asStateEvent:NO]);
+
+    XCTAssertEqual([roomState memberNormalizedPowerLevel:@"@bob:matrix.org"], 0.5);
+}
+
+- (void)testCapabilitiesDidChangeNotification
+{
+    [roomState handleStateEvent:[self powerLevelsEventWithContent:@{
+                                                                    @"users": @{@"@alice:matrix.org": @100, @"@bob:matrix.org": @50},
+                                                                    @"kick": @50
+                                                                    }]];
+
+    __block NSArray<NSString*> *changedUserIds;
+    id observer = [[NSNotificationCenter defaultCenter] addObserverForName:kMXRoomStateCapabilitiesDidChangeNotification object:roomState queue:nil usingBlock:^(NSNotification *notif) {
+        changedUserIds = notif.userInfo[kMXRoomStateCapabilitiesUserIdsKey];
+    }];
+
+    // Bob is demoted, Alice keeps the same capabilities
+    [roomState handleStateEvent:[self powerLevelsEventWithContent:@{
+                                                                    @"users": @{@"@alice:matrix.org": @90, @"@bob:matrix.org": @10},
+                                                                    @"kick": @50
+                                                                    }]];
+
+    XCTAssertEqualObjects(changedUserIds, @[@"@bob:matrix.org"]);
+
+    [[NSNotificationCenter defaultCenter] removeObserver:observer];
+}
+
+- (void)testCapabilitiesWithoutPowerLevels
+{
+    [roomState handleStateEvent:[MXEvent modelFromJSON:@{
+                                                         @"event_id": [[NSUUID UUID] UUIDString],
+                                                         @"type": kMXEventTypeStringRoomCreate,
+                                                         @"state_key": @"",
+                                                         @"sender": @"@alice:matrix.org",
+                                                         @"content": @{@"creator": @"@alice:matrix.org"}
+                                                         }]];
+
+    // The room creator has the power level 100
+    XCTAssertTrue([roomState canUser:@"@alice:matrix.org" perform:MXRoomCapabilityBan | MXRoomCapabilityKick | MXRoomCapabilityRedact]);
+    XCTAssertTrue([roomState canUser:@"@alice:matrix.org" sendEventOfType:kMXEventTypeStringRoomName asStateEvent:YES]);
+    XCTAssertEqual([roomState memberNormalizedPowerLevel:@"@alice:matrix.org"], 1);
+
+    // Other users have the power level 0
+    XCTAssertFalse([roomState canUser:@"@bob:matrix.org" perform:MXRoomCapabilityKick]);
+    XCTAssertFalse([roomState canUser:@"@bob:matrix.org" perform:MXRoomCapabilityBan]);
+    XCTAssertFalse([roomState canUser:@"@bob:matrix.org" perform:MXRoomCapabilityRedact]);
+    XCTAssertTrue([roomState canUser:@"@bob:matrix.org" sendEventOfType:kMXEventTypeStringRoomMessage asStateEvent:NO]);
+    XCTAssertTrue([roomState canUser:@"@bob:matrix.org" sendEventOfType:kMXEventTypeStringRoomTopic asStateEvent:YES]);
+}
+
+- (void)testCapabilitiesDefaultLevels
+{
+    [roomState handleStateEvent:[self powerLevelsEventWithContent:@{
+                                                                    @"users": @{@"@alice:matrix.org": @100, @"@bob:matrix.org": @49}
+                                                                    }]];
+
+    // ban, kick, redact and state_default are 50 when they are not specified
+    XCTAssertEqual(roomState.powerLevels.ban, 50);
+    XCTAssertEqual(roomState.powerLevels.kick, 50);
+    XCTAssertEqual(roomState.powerLevels.redact, 50);
+    XCTAssertEqual(roomState.powerLevels.stateDefault, 50);
+
+    XCTAssertFalse([roomState canUser:@"@bob:matrix.org" perform:MXRoomCapabilityKick]);
+    XCTAssertFalse([roomState canUser:@"@bob:matrix.org" perform:MXRoomCapabilityBan]);
+    XCTAssertFalse([roomState canUser:@"@bob:matrix.org" perform:MXRoomCapabilityRedact]);
+    XCTAssertFalse([roomState canUser:@"@bob:matrix.org" sendEventOfType:kMXEventTypeStringRoomTopic asStateEvent:YES]);
+    XCTAssertTrue([roomState canUser:@"@alice:matrix.org" perform:MXRoomCapabilityKick | MXRoomCapabilityBan | MXRoomCapabilityRedact]);
+}
+
+- (void)testCapabilitiesDidChangeNotificationOnFirstPowerLevels
+{
+    __block NSArray<NSString*> *changedUserIds;
+    id observer = [[NSNotificationCenter defaultCenter] addObserverForName:kMXRoomStateCapabilitiesDidChangeNotification object:roomState queue:nil usingBlock:^(NSNotification *notif) {
+        changedUserIds = notif.userInfo[kMXRoomStateCapabilitiesUserIdsKey];
+    }];
+
+    [roomState handleStateEvent:[self powerLevelsEventWithContent:@{
+                                                                    @"users": @{@"@alice:matrix.org": @100}
+                                                                    }]];
+
+    XCTAssertEqualObjects(changedUserIds, @[@"@alice:matrix.org"]);
+
+    [[NSNotificationCenter defaultCenter] removeObserver:observer];
+}
+
+@end
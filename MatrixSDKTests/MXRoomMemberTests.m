@@ -41,6 +41,44 @@
     [super tearDown];
 }
 
+- (MXEvent*)memberEventInRoom:(NSString*)roomId displayname:(NSString*)displayname
+{
+    return [MXEvent modelFromJSON:@{
+                                    @"event_id": [[NSUUID UUID] UUIDString],
+                                    @"type": kMXEventTypeStringRoomMember,
+                                    @"room_id": roomId,
+                                    @"state_key": @"@alice:matrix.org",
+                                    @"sender": @"@alice:matrix.org",
+                                    @"content": @{
+                                            @"membership": kMXMembershipStringJoin,
+                                            @"displayname": displayname,
+                                            @"avatar_url": @"mxc://matrix.org/avatar"
+                                            }
+                                    }];
+}
+
+- (void)testSharedProfile
+{
+    MXRoomMember *member1 = [[MXRoomMember alloc] initWithMXEvent:[self memberEventInRoom:@"!room1:matrix.org" displayname:@"Alice"]];
+    MXRoomMember *member2 = [[MXRoomMember alloc] initWithMXEvent:[self memberEventInRoom:@"!room2:matrix.org" displayname:@"Alice"]];
+    MXRoomMember *member3 = [[MXRoomMember alloc] initWithMXEvent:[self memberEventInRoom:@"!room3:matrix.org" displayname:@"Alice at work"]];
+
+    // Members with the same profile share it
+    XCTAssertEqual(member1.profile, member2.profile);
+    XCTAssertEqualObjects(member2.displayname, @"Alice");
+    XCTAssertEqualObjects(member2.avatarUrl, @"mxc://matrix.org/avatar");
+
+    // A room specific profile has its own instance
+    XCTAssertNotEqual(member1.profile, member3.profile);
+    XCTAssertEqualObjects(member3.displayname, @"Alice at work");
+
+    // Changing a member avatar does not affect others
+    member2.avatarUrl = @"mxc://matrix.org/avatar2";
+    XCTAssertNotEqual(member1.profile, member2.profile);
+    XCTAssertEqualObjects(member1.avatarUrl, @"mxc://matrix.org/avatar");
+    XCTAssertEqualObjects(member2.displayname, @"Alice");
+}
+
 - (void)testKickedMember
 {
     [matrixSDKTestsData doMXRestClientTestWithBobAndAliceInARoom:self readyToTest:^(MXRestClient *bobRestClient, MXRestClient *aliceRestClient, NSString *roomId, XCTestExpectation *expectation) {
@@ -0,0 +1,356 @@
+/*
+ Copyright 2016 OpenMarket Ltd
+
+ Licensed under the Apache License, Version 2.0 (the "License");
+ you may not use this file except in compliance with the License.
+ You may obtain a copy of the License at
+
+ http://www.apache.org/licenses/LICENSE-2.0
+
+ Unless required by applicable law or agreed to in writing, software
+ distributed under the License is distributed on an "AS IS" BASIS,
+ WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ See the License for the specific language governing permissions and
+ limitations under the License.
+ */
+
+#import <UIKit/UIKit.h>
+#import <XCTest/XCTest.h>
+
+#import "MXSession.h"
+#import "MXMemoryStore.h"
+#import "MXSearchClient.h"
+
+/**
+ A MXRestClient that records /search requests instead of sending them.
+ */
+@interface MXSearchClientTestsRestClient : MXRestClient
+
+@property (nonatomic) NSMutableArray<NSDictionary*> *searchParameters;
+@property (nonatomic) NSMutableArray<NSString*> *searchNextBatches;
+@property (nonatomic) NSMutableArray<MXHTTPOperation*> *searchOperations;
+@property (nonatomic) NSMutableArray<void (^)(MXSearchRoomEventResults *roomEventResults)> *searchSuccessBlocks;
+
+@end
+
+@implementation MXSearchClientTestsRestClient
+
+- (MXHTTPOperation*)search:(NSDictionary*)parameters
+                 nextBatch:(NSString*)nextBatch
+                   success:(void (^)(MXSearchRoomEventResults *roomEventResults))success
+                   failure:(void (^)(NSError *error))failure
+{
+    if (!_searchParameters)
+    {
+        _searchParameters = [NSMutableArray array];
+        _searchNextBatches = [NSMutableArray array];
+        _searchOperations = [NSMutableArray array];
+        _searchSuccessBlocks = [NSMutableArray array];
+    }
+
+    MXHTTPOperation *operation = [[MXHTTPOperation alloc] init];
+
+    [_searchParameters addObject:parameters];
+    [_searchNextBatches addObject:nextBatch ? nextBatch : @""];
+    [_searchOperations addObject:operation];
+    [_searchSuccessBlocks addObject:success];
+
+    return operation;
+}
+
+@end
+
+
+/**
+ Tests of MXSearchClient without homeserver.
+ */
+@interface MXSearchClientTests : XCTestCase
+{
+    MXSearchClientTestsRestClient *restClient;
+    MXSession *mxSession;
+    MXMemoryStore *store;
+    MXSearchClient *searchClient;
+}
+
+@end
+
+static NSString *const kRoomId = @"!room:matrix.org";
+static NSString *const kAliceUserId = @"@alice:matrix.org";
+
+@implementation MXSearchClientTests
+
+- (void)setUp
+{
+    [super setUp];
+
+    MXCredentials *credentials = [[MXCredentials alloc] initWithHomeServer:@"https://matrix.org" userId:kAliceUserId accessToken:@"token"];
+    restClient = [[MXSearchClientTestsRestClient alloc] initWithCredentials:credentials andOnUnrecognizedCertificateBlock:nil];
+    mxSession = [[MXSession alloc] initWithMatrixRestClient:restClient];
+
+    // MXMemoryStore opens synchronously
+    store = [[MXMemoryStore alloc] init];
+    [mxSession setStore:store success:^{
+    } failure:^(NSError *error) {
+        XCTFail(@"The request should not fail - NSError: %@", error);
+    }];
+
+    searchClient = [[MXSearchClient alloc] initWithMatrixSession:mxSession];
+    searchClient.prefetchNextBatch = NO;
+}
+
+- (void)tearDown
+{
+    [mxSession close];
+    mxSession = nil;
+    store = nil;
+    restClient = nil;
+    searchClient = nil;
+
+    [super tearDown];
+}
+
+#pragma mark - Fixtures
+- (MXEvent*)messageEvent:(NSString*)eventId
+{
+    return [MXEvent modelFromJSON:@{
+                                    @"event_id": eventId,
+                                    @"type": kMXEventTypeStringRoomMessage,
+                                    @"room_id": kRoomId,
+                                    @"sender": kAliceUserId,
+                                    @"origin_server_ts": @(1475000000000),
+                                    @"content": @{@"msgtype": kMXMessageTypeText, @"body": @"Hello"}
+                                    }];
+}
+
+- (MXSearchRoomEventResults*)resultsWithEventIds:(NSArray<NSString*>*)eventIds nextBatch:(NSString*)nextBatch
+{
+    NSMutableArray *results = [NSMutableArray array];
+    for (NSString *eventId in eventIds)
+    {
+        [results addObject:@{
+                             @"rank": @(1),
+                             @"result": [self messageEvent:eventId].JSONDictionary
+                             }];
+    }
+
+    NSMutableDictionary *JSON = [NSMutableDictionary dictionaryWithDictionary:@{
+                                                                                @"count": @(eventIds.count),
+                                                                                @"results": results
+                                                                                }];
+    if (nextBatch)
+    {
+        JSON[@"next_batch"] = nextBatch;
+    }
+    return [MXSearchRoomEventResults modelFromJSON:JSON];
+}
+
+- (MXHTTPOperation*)searchHelloWithNextBatch:(NSString*)nextBatch success:(void (^)(MXSearchRoomEventResults *roomEventResults))success failure:(void (^)(NSError *error))failure
+{
+    return [searchClient searchMessageText:@"Hello" inRooms:@[kRoomId] beforeLimit:1 afterLimit:1 nextBatch:nextBatch success:success failure:failure];
+}
+
+#pragma mark - Tests
+- (void)testIdenticalSearchesAreShared
+{
+    __block NSUInteger successCount = 0;
+
+    MXHTTPOperation *operation1 = [self searchHelloWithNextBatch:nil success:^(MXSearchRoomEventResults *roomEventResults) {
+        successCount++;
+    } failure:nil];
+    MXHTTPOperation *operation2 = [self searchHelloWithNextBatch:nil success:^(MXSearchRoomEventResults *roomEventResults) {
+        successCount++;
+    } failure:nil];
+
+    XCTAssertEqual(restClient.searchParameters.count, 1, @"Identical requests in progress must be shared");
+    XCTAssertNotEqual(operation1, operation2, @"Each caller must get its own operation");
+
+    restClient.searchSuccessBlocks[0]([self resultsWithEventIds:@[@"$1"] nextBatch:nil]);
+
+    XCTAssertEqual(successCount, 2);
+}
+
+- (void)testCancelOneCallerOfASharedSearch
+{
+    XCTestExpectation *expectation = [self expectationWithDescription:@"asyncTest"];
+
+    __block BOOL isCancelledCallerCalledBack = NO;
+    __block NSUInteger successCount = 0;
+
+    MXHTTPOperation *operation1 = [self searchHelloWithNextBatch:nil success:^(MXSearchRoomEventResults *roomEventResults) {
+        XCTFail(@"A cancelled caller must not get results");
+    } failure:^(NSError *error) {
+        XCTAssertEqualObjects(error.domain, NSURLErrorDomain);
+        XCTAssertEqual(error.code, NSURLErrorCancelled);
+        isCancelledCallerCalledBack = YES;
+    }];
+    [self searchHelloWithNextBatch:nil success:^(MXSearchRoomEventResults *roomEventResults) {
+        successCount++;
+    } failure:nil];
+
+    [operation1 cancel];
+
+    // The request is still needed by the other caller
+    XCTAssertNotEqual(restClient.searchOperations[0].maxNumberOfTries, 0);
+
+    restClient.searchSuccessBlocks[0]([self resultsWithEventIds:@[@"$1"] nextBatch:nil]);
+    XCTAssertEqual(successCount, 1);
+
+    dispatch_async(dispatch_get_main_queue(), ^{
+        XCTAssert(isCancelledCallerCalledBack);
+        [expectation fulfill];
+    });
+
+    [self waitForExpectationsWithTimeout:10 handler:nil];
+}
+
+- (void)testCancelAllCallersOfASharedSearch
+{
+    MXHTTPOperation *operation1 = [self searchHelloWithNextBatch:nil success:^(MXSearchRoomEventResults *roomEventResults) {
+        XCTFail(@"A cancelled caller must not get results");
+    } failure:nil];
+    MXHTTPOperation *operation2 = [self searchHelloWithNextBatch:nil success:^(MXSearchRoomEventResults *roomEventResults) {
+        XCTFail(@"A cancelled caller must not get results");
+    } failure:nil];
+
+    [operation1 cancel];
+    [operation2 cancel];
+
+    XCTAssertEqual(restClient.searchOperations[0].maxNumberOfTries, 0, @"The request must be cancelled with its last caller");
+
+    // A late response must be ignored
+    restClient.searchSuccessBlocks[0]([self resultsWithEventIds:@[@"$1"] nextBatch:nil]);
+
+    // And must not be cached
+    [self searchHelloWithNextBatch:nil success:nil failure:nil];
+    XCTAssertEqual(restClient.searchParameters.count, 2);
+}
+
+- (void)testSupersededSearchCallersAreCancelled
+{
+    XCTestExpectation *expectation = [self expectationWithDescription:@"asyncTest"];
+
+    __block NSUInteger cancelledCallersCount = 0;
+    void (^failure)(NSError *error) = ^(NSError *error) {
+        XCTAssertEqualObjects(error.domain, NSURLErrorDomain);
+        XCTAssertEqual(error.code, NSURLErrorCancelled);
+        cancelledCallersCount++;
+    };
+
+    [self searchHelloWithNextBatch:nil success:^(MXSearchRoomEventResults *roomEventResults) {
+        XCTFail(@"A superseded caller must not get results");
+    } failure:failure];
+    [self searchHelloWithNextBatch:nil success:^(MXSearchRoomEventResults *roomEventResults) {
+        XCTFail(@"A superseded caller must not get results");
+    } failure:failure];
+
+    // A new query supersedes the previous one
+    [searchClient searchMessageText:@"World" inRooms:@[kRoomId] beforeLimit:1 afterLimit:1 nextBatch:nil success:nil failure:^(NSError *error) {
+        XCTFail(@"The new query must not be cancelled");
+    }];
+
+    XCTAssertEqual(restClient.searchOperations[0].maxNumberOfTries, 0, @"The superseded request must be cancelled");
+
+    dispatch_async(dispatch_get_main_queue(), ^{
+        XCTAssertEqual(cancelledCallersCount, 2, @"Each superseded caller must be called back");
+        [expectation fulfill];
+    });
+
+    [self waitForExpectationsWithTimeout:10 handler:nil];
+}
+
+- (void)testCacheLifetime
+{
+    XCTestExpectation *expectation = [self expectationWithDescription:@"asyncTest"];
+
+    searchClient.cacheLifetime = 0.5;
+
+    [self searchHelloWithNextBatch:nil success:nil failure:nil];
+    restClient.searchSuccessBlocks[0]([self resultsWithEventIds:@[@"$1"] nextBatch:nil]);
+
+    __block BOOL isServedFromCache = NO;
+    MXHTTPOperation *operation = [self searchHelloWithNextBatch:nil success:^(MXSearchRoomEventResults *roomEventResults) {
+        isServedFromCache = YES;
+    } failure:nil];
+
+    XCTAssertNil(operation);
+    XCTAssert(isServedFromCache, @"The success block must be called synchronously with the cached response");
+    XCTAssertEqual(restClient.searchParameters.count, 1);
+
+    dispatch_after(dispatch_time(DISPATCH_TIME_NOW, (int64_t)(1 * NSEC_PER_SEC)), dispatch_get_main_queue(), ^{
+
+        // The cached response has expired
+        MXHTTPOperation *operation = [self searchHelloWithNextBatch:nil success:nil failure:nil];
+
+        XCTAssertNotNil(operation);
+        XCTAssertEqual(restClient.searchParameters.count, 2);
+
+        [expectation fulfill];
+    });
+
+    [self waitForExpectationsWithTimeout:10 handler:nil];
+}
+
+- (void)testPrefetchNextBatch
+{
+    searchClient.prefetchNextBatch = YES;
+
+    [self searchHelloWithNextBatch:nil success:nil failure:nil];
+    restClient.searchSuccessBlocks[0]([self resultsWithEventIds:@[@"$2"] nextBatch:@"batch2"]);
+
+    XCTAssertEqual(restClient.searchParameters.count, 2, @"The next batch must be requested in advance");
+    XCTAssertEqualObjects(restClient.searchNextBatches[1], @"batch2");
+
+    restClient.searchSuccessBlocks[1]([self resultsWithEventIds:@[@"$1"] nextBatch:nil]);
+
+    __block MXSearchRoomEventResults *nextResults;
+    MXHTTPOperation *operation = [self searchHelloWithNextBatch:@"batch2" success:^(MXSearchRoomEventResults *roomEventResults) {
+        nextResults = roomEventResults;
+    } failure:nil];
+
+    XCTAssertNil(operation, @"The next batch must come from the prefetch");
+    XCTAssertEqualObjects(nextResults.results.firstObject.result.eventId, @"$1");
+    XCTAssertEqual(restClient.searchParameters.count, 2);
+}
+
+- (void)testResolveContextFromStore
+{
+    searchClient.resolveContextFromStore = YES;
+
+    for (NSString *eventId in @[@"$1", @"$2", @"$3", @"$4", @"$5"])
+    {
+        [store storeEventForRoom:kRoomId event:[self messageEvent:eventId] direction:MXTimelineDirectionForwards];
+    }
+    [store storeHasReachedHomeServerPaginationEndForRoom:kRoomId andValue:YES];
+
+    __block MXSearchRoomEventResults *results;
+    [self searchHelloWithNextBatch:nil success:^(MXSearchRoomEventResults *roomEventResults) {
+        results = roomEventResults;
+    } failure:nil];
+
+    XCTAssertNil(restClient.searchParameters[0][@"search_categories"][@"room_events"][@"event_context"], @"The store has the whole room history: the context must not be requested");
+
+    restClient.searchSuccessBlocks[0]([self resultsWithEventIds:@[@"$4", @"$2"] nextBatch:nil]);
+
+    XCTAssertEqual(results.results.count, 2);
+
+    MXSearchEventContext *context4 = results.results[0].context;
+    XCTAssertEqualObjects([context4.eventsBefore valueForKey:@"eventId"], @[@"$3"]);
+    XCTAssertEqualObjects([context4.eventsAfter valueForKey:@"eventId"], @[@"$5"]);
+
+    MXSearchEventContext *context2 = results.results[1].context;
+    XCTAssertEqualObjects([context2.eventsBefore valueForKey:@"eventId"], @[@"$1"]);
+    XCTAssertEqualObjects([context2.eventsAfter valueForKey:@"eventId"], @[@"$3"]);
+}
+
+- (void)testResolveContextFromStoreWithPartialHistory
+{
+    searchClient.resolveContextFromStore = YES;
+
+    [store storeEventForRoom:kRoomId event:[self messageEvent:@"$1"] direction:MXTimelineDirectionForwards];
+
+    [self searchHelloWithNextBatch:nil success:nil failure:nil];
+
+    XCTAssertNotNil(restClient.searchParameters[0][@"search_categories"][@"room_events"][@"event_context"], @"The store cannot resolve the context of older results: the context must be requested");
+}
+
+@end
@@ -0,0 +1,269 @@
+/*
+ Copyright 2016 OpenMarket Ltd
+
+ Licensed under the Apache License, Version 2.0 (the "License");
+ you may not use this file except in compliance with the License.
+ You may obtain a copy of the License at
+
+ http://www.apache.org/licenses/LICENSE-2.0
+
+ Unless required by applicable law or agreed to in writing, software
+ distributed under the License is distributed on an "AS IS" BASIS,
+ WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ See the License for the specific language governing permissions and
+ limitations under the License.
+ */
+
+#import <UIKit/UIKit.h>
+#import <XCTest/XCTest.h>
+
+#import "MXSession.h"
+#import "MXMemoryStore.h"
+#import "MXFileStoreMetaData.h"
+
+@interface MXSession (MXSessionCatchUpTests)
+
+- (void)serverSyncWithServerTimeout:(NSUInteger)serverTimeout
+                            success:(void (^)())success
+                            failure:(void (^)(NSError *error))failure
+                      clientTimeout:(NSUInteger)clientTimeout
+                        setPresence:(NSString*)setPresence;
+
+@end
+
+/**
+ A MXRestClient that records /sync requests instead of sending them.
+ */
+@interface MXSessionCatchUpTestsRestClient : MXRestClient
+
+@property (nonatomic) NSMutableArray *syncFilters;
+@property (nonatomic) NSMutableArray<void (^)(MXSyncResponse *syncResponse)> *syncSuccessBlocks;
+
+@end
+
+@implementation MXSessionCatchUpTestsRestClient
+
+- (MXHTTPOperation *)syncFromToken:(NSString*)token
+                     serverTimeout:(NSUInteger)serverTimeout
+                     clientTimeout:(NSUInteger)clientTimeout
+                       setPresence:(NSString*)setPresence
+                            filter:(NSString*)filterId
+                           success:(void (^)(MXSyncResponse *syncResponse))success
+                           failure:(void (^)(NSError *error))failure
+{
+    if (!_syncFilters)
+    {
+        _syncFilters = [NSMutableArray array];
+        _syncSuccessBlocks = [NSMutableArray array];
+    }
+
+    [_syncFilters addObject:filterId ? filterId : [NSNull null]];
+    [_syncSuccessBlocks addObject:success];
+
+    return [[MXHTTPOperation alloc] init];
+}
+
+@end
+
+
+/**
+ Tests of the catch-up mode of the server sync, without homeserver.
+ */
+@interface MXSessionCatchUpTests : XCTestCase
+{
+    MXSessionCatchUpTestsRestClient *restClient;
+    MXMemoryStore *store;
+    MXSession *mxSession;
+}
+
+@end
+
+static NSString *const kAliceUserId = @"@alice:matrix.org";
+
+@implementation MXSessionCatchUpTests
+
+- (void)setUp
+{
+    [super setUp];
+
+    MXCredentials *credentials = [[MXCredentials alloc] initWithHomeServer:@"https://matrix.org" userId:kAliceUserId accessToken:@"token"];
+    restClient = [[MXSessionCatchUpTestsRestClient alloc] initWithCredentials:credentials andOnUnrecognizedCertificateBlock:nil];
+
+    store = [[MXMemoryStore alloc] init];
+    store.eventStreamToken = @"token";
+}
+
+- (void)tearDown
+{
+    [mxSession close];
+    mxSession = nil;
+    store = nil;
+    restClient = nil;
+
+    [super tearDown];
+}
+
+#pragma mark - Fixtures
+- (void)openSession
+{
+    mxSession = [[MXSession alloc] initWithMatrixRestClient:restClient];
+
+    // MXMemoryStore opens synchronously
+    [mxSession setStore:store success:^{
+    } failure:^(NSError *error) {
+        XCTFail(@"The request should not fail - NSError: %@", error);
+    }];
+}
+
+- (void)setTokenAge:(NSTimeInterval)tokenAge
+{
+    [store setValue:[NSDate dateWithTimeIntervalSinceNow:-tokenAge] forKey:@"eventStreamTokenDate"];
+}
+
+- (void)serverSync
+{
+    [mxSession serverSyncWithServerTimeout:0 success:nil failure:nil clientTimeout:30000 setPresence:nil];
+}
+
+- (MXSyncResponse*)syncResponseWithLimitedRoomsCount:(NSUInteger)limitedRoomsCount
+{
+    NSMutableDictionary *joinedRooms = [NSMutableDictionary dictionary];
+    for (NSUInteger i = 0; i < limitedRoomsCount; i++)
+    {
+        joinedRooms[[NSString stringWithFormat:@"!room%tu:matrix.org", i]] = @{
+                                                                               @"state": @{@"events": @[]},
+                                                                               @"timeline": @{
+                                                                                       @"events": @[],
+                                                                                       @"limited": @(YES),
+                                                                                       @"prev_batch": @"prev"
+                                                                                       }
+                                                                               };
+    }
+
+    return [MXSyncResponse modelFromJSON:@{
+                                           @"next_batch": @"nextToken",
+                                           @"rooms": @{@"join": joinedRooms}
+                                           }];
+}
+
+- (NSDictionary*)lastSyncFilter
+{
+    id filter = restClient.syncFilters.lastObject;
+    if ([filter isKindOfClass:NSString.class])
+    {
+        return [NSJSONSerialization JSONObjectWithData:[filter dataUsingEncoding:NSUTF8StringEncoding] options:0 error:nil];
+    }
+    return nil;
+}
+
+#pragma mark - Tests
+- (void)testNoCatchUpWithARecentToken
+{
+    [self openSession];
+    [self setTokenAge:60];
+
+    [self serverSync];
+
+    XCTAssertFalse(mxSession.isCatchingUp);
+    XCTAssertNil(self.lastSyncFilter);
+}
+
+- (void)testCatchUpWithAStaleToken
+{
+    [self openSession];
+    [self setTokenAge:2 * 24 * 3600];
+
+    [self serverSync];
+
+    XCTAssert(mxSession.isCatchingUp);
+
+    NSDictionary *filter = self.lastSyncFilter;
+    XCTAssertEqualObjects(filter[@"room"][@"timeline"][@"limit"], @(5));
+    XCTAssertEqualObjects(filter[@"presence"][@"types"], @[], @"No presence must be fetched while catching up");
+}
+
+- (void)testCatchUpKeepsASmallerMessagesLimit
+{
+    [self openSession];
+    [mxSession setValue:@(3) forKey:@"syncMessagesLimit"];
+    [self setTokenAge:2 * 24 * 3600];
+
+    [self serverSync];
+
+    XCTAssertEqualObjects(self.lastSyncFilter[@"room"][@"timeline"][@"limit"], @(3));
+}
+
+- (void)testCatchUpTokenAgeIsLoweredByALargeResponse
+{
+    [self openSession];
+    [self setTokenAge:2 * 3600];
+
+    [self serverSync];
+    XCTAssertFalse(mxSession.isCatchingUp);
+
+    restClient.syncSuccessBlocks.lastObject([self syncResponseWithLimitedRoomsCount:20]);
+
+    XCTAssertEqualWithAccuracy(store.catchUpTokenAge, 2 * 3600, 60, @"The adapted threshold must be stored");
+
+    // A token of the same age is now considered as stale
+    [self setTokenAge:2 * 3600];
+    [self serverSync];
+    XCTAssert(mxSession.isCatchingUp);
+}
+
+- (void)testCatchUpTokenAgeIsNotLoweredUnderTheMinimum
+{
+    [self openSession];
+    [self setTokenAge:1800];
+
+    [self serverSync];
+    restClient.syncSuccessBlocks.lastObject([self syncResponseWithLimitedRoomsCount:20]);
+
+    XCTAssertEqual(store.catchUpTokenAge, 0);
+}
+
+- (void)testCatchUpTokenAgeRecovers
+{
+    // The threshold has been lowered by a previous session
+    store.catchUpTokenAge = 2 * 3600;
+    [self openSession];
+    [self setTokenAge:3 * 3600];
+
+    [self serverSync];
+    XCTAssert(mxSession.isCatchingUp);
+
+    // Few rooms with a gap: a full sync would have been fine
+    restClient.syncSuccessBlocks.lastObject([self syncResponseWithLimitedRoomsCount:1]);
+    XCTAssertEqual(store.catchUpTokenAge, 4 * 3600);
+
+    // Up to the default threshold
+    for (NSUInteger i = 0; i < 5; i++)
+    {
+        [self setTokenAge:2 * 24 * 3600];
+        [self serverSync];
+        restClient.syncSuccessBlocks.lastObject([self syncResponseWithLimitedRoomsCount:1]);
+    }
+    XCTAssertEqual(store.catchUpTokenAge, 24 * 3600);
+}
+
+- (void)testFileStoreMetaDataCatchUpDataPersistence
+{
+    MXFileStoreMetaData *metaData = [[MXFileStoreMetaData alloc] init];
+    metaData.homeServer = @"https://matrix.org";
+    metaData.userId = kAliceUserId;
+    metaData.accessToken = @"token";
+    metaData.eventStreamToken = @"token";
+    metaData.eventStreamTokenDate = [NSDate dateWithTimeIntervalSince1970:1475000000];
+    metaData.catchUpTokenAge = 7200;
+
+    MXFileStoreMetaData *metaData2 = [NSKeyedUnarchiver unarchiveObjectWithData:[NSKeyedArchiver archivedDataWithRootObject:metaData]];
+
+    XCTAssertEqualObjects(metaData2.eventStreamTokenDate, metaData.eventStreamTokenDate);
+    XCTAssertEqual(metaData2.catchUpTokenAge, 7200);
+
+    MXFileStoreMetaData *metaData3 = [metaData copy];
+    XCTAssertEqualObjects(metaData3.eventStreamTokenDate, metaData.eventStreamTokenDate);
+    XCTAssertEqual(metaData3.catchUpTokenAge, 7200);
+}
+
+@end
@@ -0,0 +1,120 @@
+/*
+ Copyright 2016 OpenMarket Ltd
+
+ Licensed under the Apache License, Version 2.0 (the "License");
+ you may not use this file except in compliance with the License.
+ You may obtain a copy of the License at
+
+ http://www.apache.org/licenses/LICENSE-2.0
+
+ Unless required by applicable law or agreed to in writing, software
+ distributed under the License is distributed on an "AS IS" BASIS,
+ WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ See the License for the specific language governing permissions and
+ limitations under the License.
+ */
+
+#import <UIKit/UIKit.h>
+#import <XCTest/XCTest.h>
+
+#import "MXStoreCompactor.h"
+#import "MXMemoryStore.h"
+
+@interface MXStoreCompactorTests : XCTestCase
+{
+    MXMemoryStore *store;
+    NSString *roomId;
+}
+
+@end
+
+@implementation MXStoreCompactorTests
+
+- (void)setUp
+{
+    [super setUp];
+
+    store = [[MXMemoryStore alloc] init];
+    roomId = @"!room:matrix.org";
+
+    // 10 messages, one per hour, the last one is 1 hour old
+    uint64_t now = (uint64_t)([[NSDate date] timeIntervalSince1970] * 1000);
+    for (NSUInteger i = 0; i < 10; i++)
+    {
+        MXEvent *event = [MXEvent modelFromJSON:@{
+                                                  @"event_id": [NSString stringWithFormat:@"$%tu", i],
+                                                  @"type": kMXEventTypeStringRoomMessage,
+                                                  @"room_id": roomId,
+                                                  @"sender": @"@alice:matrix.org",
+                                                  @"origin_server_ts": @(now - (10 - i) * 3600 * 1000),
+                                                  @"content": @{@"msgtype": kMXMessageTypeText, @"body": @"Hello"}
+                                                  }];
+        [store storeEventForRoom:roomId event:event direction:MXTimelineDirectionForwards];
+    }
+    [store storePaginationTokenOfRoom:roomId andToken:@"oldToken"];
+    [store storeHasReachedHomeServerPaginationEndForRoom:roomId andValue:YES];
+}
+
+- (void)tearDown
+{
+    store = nil;
+
+    [super tearDown];
+}
+
+- (void)testMaxEvents
+{
+    MXRetentionPolicy *retentionPolicy = [[MXRetentionPolicy alloc] init];
+    retentionPolicy.maxEvents = 3;
+
+    MXEvent *event = [retentionPolicy oldestEventToKeepInEnumerator:[store messagesEnumeratorForRoom:roomId]];
+    XCTAssertEqualObjects(event.eventId, @"$7");
+
+    retentionPolicy.maxEvents = 10;
+    XCTAssertNil([retentionPolicy oldestEventToKeepInEnumerator:[store messagesEnumeratorForRoom:roomId]]);
+}
+
+- (void)testMaxAge
+{
+    MXRetentionPolicy *retentionPolicy = [[MXRetentionPolicy alloc] init];
+    retentionPolicy.maxAge = 4.5 * 3600;
+
+    MXEvent *event = [retentionPolicy oldestEventToKeepInEnumerator:[store messagesEnumeratorForRoom:roomId]];
+    XCTAssertEqualObjects(event.eventId, @"$6");
+
+    // The most recent message is always kept
+    retentionPolicy.maxAge = 60;
+    event = [retentionPolicy oldestEventToKeepInEnumerator:[store messagesEnumeratorForRoom:roomId]];
+    XCTAssertEqualObjects(event.eventId, @"$9");
+}
+
+- (void)testMaxBytes
+{
+    MXRetentionPolicy *retentionPolicy = [[MXRetentionPolicy alloc] init];
+    retentionPolicy.maxBytes = 1;
+
+    MXEvent *event = [retentionPolicy oldestEventToKeepInEnumerator:[store messagesEnumeratorForRoom:roomId]];
+    XCTAssertEqualObjects(event.eventId, @"$9");
+
+    retentionPolicy.maxBytes = 1000000;
+    XCTAssertNil([retentionPolicy oldestEventToKeepInEnumerator:[store messagesEnumeratorForRoom:roomId]]);
+}
+
+- (void)testRemoveMessagesBeforeEvent
+{
+    NSUInteger count = [store removeMessagesBeforeEvent:@"$7" inRoom:roomId paginationToken:@"newToken"];
+
+    XCTAssertEqual(count, 7);
+    XCTAssertEqual([store messagesEnumeratorForRoom:roomId].remaining, 3);
+    XCTAssertFalse([store eventExistsWithEventId:@"$6" inRoom:roomId]);
+    XCTAssertTrue([store eventExistsWithEventId:@"$7" inRoom:roomId]);
+    XCTAssertEqualObjects([store paginationTokenOfRoom:roomId], @"newToken");
+    XCTAssertFalse([store hasReachedHomeServerPaginationEndForRoom:roomId]);
+
+    // Unknown event
+    count = [store removeMessagesBeforeEvent:@"$unknown" inRoom:roomId paginationToken:@"anotherToken"];
+    XCTAssertEqual(count, 0);
+    XCTAssertEqualObjects([store paginationTokenOfRoom:roomId], @"newToken");
+}
+
+@end
@@ -24,6 +24,15 @@
 #pragma clang diagnostic push
 #pragma clang diagnostic ignored "-Warc-retain-cycles"
 
+@interface MXFileStore (MXStoreFileStoreTests)
+
+- (void)openLockFile;
+- (void)lockFiles;
+- (void)unlockFiles;
+- (void)reloadCommittedData;
+
+@end
+
 @interface MXStoreFileStoreTests : MXStoreTests
 @end
 
@@ -246,6 +255,277 @@
     [self checkMultiAccount:MXFileStore.class];
 }
 
+- (void)testMXFileStoreReadOnlyAccess
+{
+    [self doTestWithMXFileStore:^(MXRoom *room) {
+
+        MXFileStore *fileStore = mxSession.store;
+        NSString *roomId = room.state.roomId;
+
+        [mxSession close];
+        mxSession = nil;
+
+        MXFileStore *readOnlyStore = [[MXFileStore alloc] init];
+        readOnlyStore.accessMode = MXFileStoreAccessModeReadOnly;
+        [readOnlyStore openWithCredentials:matrixSDKTestsData.bobCredentials onComplete:^{
+
+            XCTAssertEqualObjects(readOnlyStore.eventStreamToken, fileStore.eventStreamToken);
+            XCTAssertNotNil([readOnlyStore messagesEnumeratorForRoom:roomId].nextEvent);
+
+            // A reader must not modify files
+            [readOnlyStore deleteAllData];
+            [readOnlyStore commit];
+
+            MXFileStore *fileStore2 = [[MXFileStore alloc] init];
+            [fileStore2 openWithCredentials:matrixSDKTestsData.bobCredentials onComplete:^{
+
+                XCTAssertEqualObjects(fileStore2.eventStreamToken, fileStore.eventStreamToken);
+                XCTAssertNotNil([fileStore2 messagesEnumeratorForRoom:roomId].nextEvent);
+                [expectation fulfill];
+
+            } failure:^(NSError *error) {
+                XCTFail(@"The request should not fail - NSError: %@", error);
+                [expectation fulfill];
+            }];
+
+        } failure:^(NSError *error) {
+            XCTFail(@"The request should not fail - NSError: %@", error);
+            [expectation fulfill];
+        }];
+    }];
+}
+
+- (void)testMXFileStoreBackgroundReadsDoNotFillPreloadCaches
+{
+    [self doTestWithMXFileStore:^(MXRoom *room) {
+
+        NSString *roomId = room.state.roomId;
+
+        [mxSession close];
+        mxSession = nil;
+
+        MXFileStore *fileStore = [[MXFileStore alloc] init];
+        [fileStore openWithCredentials:matrixSDKTestsData.bobCredentials onComplete:^{
+
+            NSMutableDictionary *preloadedRoomsStates = [fileStore valueForKey:@"preloadedRoomsStates"];
+            NSMutableDictionary *preloadedRoomAccountData = [fileStore valueForKey:@"preloadedRoomAccountData"];
+
+            // The preload fills the caches. They are consumed by the first read
+            XCTAssertNotNil(preloadedRoomsStates[roomId]);
+            XCTAssertNotNil([fileStore stateOfRoom:roomId]);
+            [fileStore accountDataOfRoom:roomId];
+            XCTAssertNil(preloadedRoomsStates[roomId]);
+            XCTAssertNil(preloadedRoomAccountData[roomId]);
+
+            // Reads from other threads must not fill them again
+            dispatch_async(dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_DEFAULT, 0), ^{
+
+                NSArray *stateEvents = [fileStore stateOfRoom:roomId];
+                [fileStore accountDataOfRoom:roomId];
+
+                dispatch_async(dispatch_get_main_queue(), ^{
+
+                    XCTAssertNotNil(stateEvents);
+                    XCTAssertNil(preloadedRoomsStates[roomId]);
+                    XCTAssertNil(preloadedRoomAccountData[roomId]);
+
+                    [fileStore close];
+                    [expectation fulfill];
+                });
+            });
+
+        } failure:^(NSError *error) {
+            XCTFail(@"The request should not fail - NSError: %@", error);
+            [expectation fulfill];
+        }];
+    }];
+}
+
+- (void)testMXFileStoreDeleteAllDataDoesNotWaitForReaders
+{
+    [self doTestWithMXFileStore:^(MXRoom *room) {
+
+        NSString *roomId = room.state.roomId;
+
+        [mxSession close];
+        mxSession = nil;
+
+        MXFileStore *fileStore = [[MXFileStore alloc] init];
+        [fileStore openWithCredentials:matrixSDKTestsData.bobCredentials onComplete:^{
+
+            MXFileStore *readOnlyStore = [[MXFileStore alloc] init];
+            readOnlyStore.accessMode = MXFileStoreAccessModeReadOnly;
+            [readOnlyStore openWithCredentials:matrixSDKTestsData.bobCredentials onComplete:^{
+
+                // Simulate two processes sharing the store. The reader is reading
+                [fileStore openLockFile];
+                [readOnlyStore openLockFile];
+                [readOnlyStore lockFiles];
+
+                NSDate *startDate = [NSDate date];
+                [fileStore deleteAllData];
+                XCTAssertLessThan([[NSDate date] timeIntervalSinceDate:startDate], 0.1, @"deleteAllData must not wait for the reader on the main thread");
+
+                [readOnlyStore unlockFiles];
+
+                // Wait for the files deletion
+                [fileStore close];
+                [readOnlyStore close];
+
+                MXFileStore *fileStore2 = [[MXFileStore alloc] init];
+                [fileStore2 openWithCredentials:matrixSDKTestsData.bobCredentials onComplete:^{
+
+                    XCTAssertNil(fileStore2.eventStreamToken);
+                    XCTAssertNil([fileStore2 messagesEnumeratorForRoom:roomId].nextEvent);
+                    [expectation fulfill];
+
+                } failure:^(NSError *error) {
+                    XCTFail(@"The request should not fail - NSError: %@", error);
+                    [expectation fulfill];
+                }];
+
+            } failure:^(NSError *error) {
+                XCTFail(@"The request should not fail - NSError: %@", error);
+                [expectation fulfill];
+            }];
+
+        } failure:^(NSError *error) {
+            XCTFail(@"The request should not fail - NSError: %@", error);
+            [expectation fulfill];
+        }];
+    }];
+}
+
+- (void)testMXFileStoreLockFilesWaitsForOtherProcesses
+{
+    [self doTestWithMXFileStore:^(MXRoom *room) {
+
+        [mxSession close];
+        mxSession = nil;
+
+        MXFileStore *fileStore = [[MXFileStore alloc] init];
+        [fileStore openWithCredentials:matrixSDKTestsData.bobCredentials onComplete:^{
+
+            MXFileStore *readOnlyStore = [[MXFileStore alloc] init];
+            readOnlyStore.accessMode = MXFileStoreAccessModeReadOnly;
+            [readOnlyStore openWithCredentials:matrixSDKTestsData.bobCredentials onComplete:^{
+
+                // Simulate two processes sharing the store. The writer is committing
+                [fileStore openLockFile];
+                [readOnlyStore openLockFile];
+                [fileStore lockFiles];
+
+                __block BOOL isLockedByReader = NO;
+                dispatch_async(dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_DEFAULT, 0), ^{
+
+                    [readOnlyStore lockFiles];
+                    isLockedByReader = YES;
+                    [readOnlyStore unlockFiles];
+
+                    dispatch_async(dispatch_get_main_queue(), ^{
+
+                        [fileStore close];
+                        [readOnlyStore close];
+                        [expectation fulfill];
+                    });
+                });
+
+                dispatch_after(dispatch_time(DISPATCH_TIME_NOW, (int64_t)(0.2 * NSEC_PER_SEC)), dispatch_get_main_queue(), ^{
+
+                    XCTAssertFalse(isLockedByReader, @"The reader must wait for the writer");
+
+                    // The writer can still nest locks while the reader is waiting
+                    [fileStore lockFiles];
+                    [fileStore unlockFiles];
+
+                    [fileStore unlockFiles];
+                });
+
+            } failure:^(NSError *error) {
+                XCTFail(@"The request should not fail - NSError: %@", error);
+                [expectation fulfill];
+            }];
+
+        } failure:^(NSError *error) {
+            XCTFail(@"The request should not fail - NSError: %@", error);
+            [expectation fulfill];
+        }];
+    }];
+}
+
+- (void)testMXFileStoreReloadOnlyChangedRooms
+{
+    [self doTestWithMXFileStore:^(MXRoom *room) {
+
+        NSString *roomId = room.state.roomId;
+
+        [mxSession close];
+        mxSession = nil;
+
+        MXFileStore *fileStore = [[MXFileStore alloc] init];
+        [fileStore openWithCredentials:matrixSDKTestsData.bobCredentials onComplete:^{
+
+            MXFileStore *readOnlyStore = [[MXFileStore alloc] init];
+            readOnlyStore.accessMode = MXFileStoreAccessModeReadOnly;
+            [readOnlyStore openWithCredentials:matrixSDKTestsData.bobCredentials onComplete:^{
+
+                MXEvent *event = [MXEvent modelFromJSON:@{
+                                                          @"event_id": @"anID",
+                                                          @"type": kMXEventTypeStringRoomMessage,
+                                                          @"room_id": roomId,
+                                                          @"sender": matrixSDKTestsData.bobCredentials.userId,
+                                                          @"content": @{
+                                                                  @"msgtype": kMXMessageTypeText,
+                                                                  @"body": @"Hello"
+                                                                  }
+                                                          }];
+
+                [fileStore storeEventForRoom:roomId event:event direction:MXTimelineDirectionForwards];
+                [fileStore commit];
+
+                // Wait for the commit
+                [fileStore close];
+
+                __block NSUInteger reloadCount = 0;
+                __block id observer;
+                observer = [[NSNotificationCenter defaultCenter] addObserverForName:kMXFileStoreDidReloadNotification object:readOnlyStore queue:nil usingBlock:^(NSNotification *notif) {
+
+                    NSArray<NSString*> *roomIds = notif.userInfo[kMXFileStoreDidReloadNotificationRoomIdsKey];
+
+                    if (++reloadCount == 1)
+                    {
+                        XCTAssertEqualObjects(roomIds, @[roomId], @"Only the committed room must be reloaded");
+                        XCTAssertNotNil([readOnlyStore eventWithEventId:@"anID" inRoom:roomId]);
+                        XCTAssertNotNil([readOnlyStore stateOfRoom:roomId]);
+
+                        // Nothing has been committed since
+                        [readOnlyStore reloadCommittedData];
+                    }
+                    else
+                    {
+                        XCTAssertEqual(roomIds.count, 0);
+                        XCTAssertNotNil([readOnlyStore eventWithEventId:@"anID" inRoom:roomId]);
+
+                        [[NSNotificationCenter defaultCenter] removeObserver:observer];
+                        [readOnlyStore close];
+                        [expectation fulfill];
+                    }
+                }];
+
+                [readOnlyStore reloadCommittedData];
+
+            } failure:^(NSError *error) {
+                XCTFail(@"The request should not fail - NSError: %@", error);
+                [expectation fulfill];
+            }];
+
+        } failure:^(NSError *error) {
+            XCTFail(@"The request should not fail - NSError: %@", error);
+            [expectation fulfill];
+        }];
+    }];
+}
+
 - (void)testMXFileStoreRoomAccountDataTags
 {
     [self checkRoomAccountDataTags:MXFileStore.class];
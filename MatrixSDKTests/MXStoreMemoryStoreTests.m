@@ -61,6 +61,180 @@
     [self checkEventWithEventIdOfStore:store];
 }
 
+- (void)testMXMemoryStoreConcurrentReads
+{
+    MXMemoryStore *store = [[MXMemoryStore alloc] init];
+    NSString *roomId = @"!room:matrix.org";
+
+    XCTestExpectation *expectation = [self expectationWithDescription:@"asyncTest"];
+
+    // Read from a background thread while the main thread writes
+    dispatch_async(dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_DEFAULT, 0), ^{
+
+        for (NSUInteger i = 0; i < 1000; i++)
+        {
+            // The enumerator must work on a consistent snapshot
+            id<MXEventsEnumerator> enumerator = [store messagesEnumeratorForRoom:roomId];
+            NSUInteger remaining = enumerator.remaining;
+            NSUInteger count = 0;
+            while (enumerator.nextEvent)
+            {
+                count++;
+            }
+            XCTAssertEqual(count, remaining);
+
+            [store eventWithEventId:@"$0" inRoom:roomId];
+            [store rooms];
+        }
+
+        dispatch_async(dispatch_get_main_queue(), ^{
+            [expectation fulfill];
+        });
+    });
+
+    for (NSUInteger i = 0; i < 1000; i++)
+    {
+        MXEvent *event = [MXEvent modelFromJSON:@{
+                                                  @"event_id": [NSString stringWithFormat:@"$%tu", i],
+                                                  @"type": kMXEventTypeStringRoomMessage,
+                                                  @"room_id": roomId,
+                                                  @"sender": @"@alice:matrix.org",
+                                                  @"content": @{@"msgtype": kMXMessageTypeText, @"body": @"Hello"}
+                                                  }];
+        [store storeEventForRoom:roomId event:event direction:MXTimelineDirectionForwards];
+    }
+
+    [self waitForExpectationsWithTimeout:10 handler:nil];
+
+    XCTAssertEqual([store messagesEnumeratorForRoom:roomId].remaining, 1000);
+}
+
+- (void)testMXMemoryStoreReadsDoNotCreateRooms
+{
+    MXMemoryStore *store = [[MXMemoryStore alloc] init];
+    NSString *roomId = @"!room:matrix.org";
+
+    XCTAssertNil([store eventWithEventId:@"$event" inRoom:roomId]);
+    XCTAssertFalse([store eventExistsWithEventId:@"$event" inRoom:roomId]);
+    XCTAssertNil([store paginationTokenOfRoom:roomId]);
+    XCTAssertEqual([store notificationCountOfRoom:roomId], 0);
+    XCTAssertEqual([store highlightCountOfRoom:roomId], 0);
+    XCTAssertFalse([store hasReachedHomeServerPaginationEndForRoom:roomId]);
+    XCTAssertNil([store partialTextMessageOfRoom:roomId]);
+    XCTAssertEqual([store outgoingMessagesInRoom:roomId].count, 0);
+    XCTAssertEqual([store messagesEnumeratorForRoom:roomId].remaining, 0);
+    XCTAssertNil([store messagesEnumeratorForRoom:roomId withTypeIn:@[kMXEventTypeStringRoomMessage] ignoreMemberProfileChanges:NO].nextEvent);
+
+    XCTAssertEqual(store.rooms.count, 0, @"Reading an unknown room must not create it");
+
+    [store storePaginationTokenOfRoom:roomId andToken:@"token"];
+    XCTAssertEqualObjects(store.rooms, @[roomId]);
+    XCTAssertEqualObjects([store paginationTokenOfRoom:roomId], @"token");
+}
+
+- (void)testMXMemoryStoreStateCheckpoints
+{
+    MXMemoryStore *store = [[MXMemoryStore alloc] init];
+    NSString *roomId = @"!room:matrix.org";
+
+    MXEvent *(^nameEvent)(NSUInteger) = ^MXEvent *(NSUInteger i) {
+        return [MXEvent modelFromJSON:@{
+                                        @"event_id": [NSString stringWithFormat:@"$%tu", i],
+                                        @"type": kMXEventTypeStringRoomName,
+                                        @"state_key": @"",
+                                        @"room_id": roomId,
+                                        @"sender": @"@alice:matrix.org",
+                                        @"content": @{@"name": [NSString stringWithFormat:@"Name %tu", i]}
+                                        }];
+    };
+
+    for (NSUInteger i = 0; i < 10; i++)
+    {
+        [store storeEventForRoom:roomId event:nameEvent(i) direction:MXTimelineDirectionForwards];
+    }
+
+    // No checkpoint yet
+    XCTAssertNil([store stateOfRoom:roomId beforeEvent:@"$5"]);
+
+    MXEvent *topicEvent = [MXEvent modelFromJSON:@{
+                                                   @"event_id": @"$topic",
+                                                   @"type": kMXEventTypeStringRoomTopic,
+                                                   @"state_key": @"",
+                                                   @"sender": @"@alice:matrix.org",
+                                                   @"content": @{@"topic": @"Topic"}
+                                                   }];
+    [store storeStateCheckpointForRoom:roomId stateEvents:@[topicEvent, nameEvent(1)] beforeEvent:@"$2"];
+
+    // Before the checkpoint
+    XCTAssertNil([store stateOfRoom:roomId beforeEvent:@"$1"]);
+
+    // At the checkpoint
+    NSArray<MXEvent*> *stateEvents = [store stateOfRoom:roomId beforeEvent:@"$2"];
+    XCTAssertEqual(stateEvents.count, 2);
+    XCTAssertTrue([[stateEvents valueForKey:@"eventId"] containsObject:@"$1"]);
+
+    // After the checkpoint, the state changes are applied
+    stateEvents = [store stateOfRoom:roomId beforeEvent:@"$6"];
+    XCTAssertEqual(stateEvents.count, 2);
+    XCTAssertTrue([[stateEvents valueForKey:@"eventId"] containsObject:@"$5"]);
+    XCTAssertTrue([[stateEvents valueForKey:@"eventId"] containsObject:@"$topic"]);
+
+    // Checkpoints go away with their messages
+    [store removeMessagesBeforeEvent:@"$3" inRoom:roomId paginationToken:nil];
+    XCTAssertNil([store stateOfRoom:roomId beforeEvent:@"$6"]);
+}
+
+- (void)testMXMemoryStoreStateCheckpointsLimits
+{
+    MXMemoryStore *store = [[MXMemoryStore alloc] init];
+    NSString *roomId = @"!room:matrix.org";
+
+    for (NSUInteger i = 0; i < 2000; i++)
+    {
+        MXEvent *event = [MXEvent modelFromJSON:@{
+                                                  @"event_id": [NSString stringWithFormat:@"$%tu", i],
+                                                  @"type": kMXEventTypeStringRoomMessage,
+                                                  @"room_id": roomId,
+                                                  @"sender": @"@alice:matrix.org",
+                                                  @"content": @{@"msgtype": kMXMessageTypeText, @"body": @"Hello"}
+                                                  }];
+        [store storeEventForRoom:roomId event:event direction:MXTimelineDirectionForwards];
+    }
+
+    MXEvent *topicEvent = [MXEvent modelFromJSON:@{
+                                                   @"event_id": @"$topic",
+                                                   @"type": kMXEventTypeStringRoomTopic,
+                                                   @"state_key": @"",
+                                                   @"sender": @"@alice:matrix.org",
+                                                   @"content": @{@"topic": @"Topic"}
+                                                   }];
+
+    // A checkpoint in the deep history then many recent ones
+    [store storeStateCheckpointForRoom:roomId stateEvents:@[topicEvent] beforeEvent:@"$0"];
+    for (NSUInteger i = 1900; i < 1950; i++)
+    {
+        [store storeStateCheckpointForRoom:roomId stateEvents:@[topicEvent] beforeEvent:[NSString stringWithFormat:@"$%tu", i]];
+    }
+
+    // The oldest and the most recent checkpoints are kept
+    XCTAssertNotNil([store stateCheckpointOfRoom:roomId beforeEvent:@"$0"]);
+    XCTAssertNotNil([store stateCheckpointOfRoom:roomId beforeEvent:@"$1949"]);
+
+    NSUInteger checkpointsCount = 0;
+    for (NSUInteger i = 0; i < 2000; i++)
+    {
+        if ([store stateCheckpointOfRoom:roomId beforeEvent:[NSString stringWithFormat:@"$%tu", i]])
+        {
+            checkpointsCount++;
+        }
+    }
+    XCTAssertEqual(checkpointsCount, 20);
+
+    // The state is not rebuilt from too far
+    XCTAssertNotNil([store stateOfRoom:roomId beforeEvent:@"$500"]);
+    XCTAssertNil([store stateOfRoom:roomId beforeEvent:@"$1500"]);
+}
+
 - (void)testMXMemoryStorePaginateBack
 {
     [self doTestWithMXMemoryStore:^(MXRoom *room) {
@@ -0,0 +1,207 @@
+/*
+ Copyright 2016 OpenMarket Ltd
+
+ Licensed under the Apache License, Version 2.0 (the "License");
+ you may not use this file except in compliance with the License.
+ You may obtain a copy of the License at
+
+ http://www.apache.org/licenses/LICENSE-2.0
+
+ Unless required by applicable law or agreed to in writing, software
+ distributed under the License is distributed on an "AS IS" BASIS,
+ WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ See the License for the specific language governing permissions and
+ limitations under the License.
+ */
+
+#import <UIKit/UIKit.h>
+#import <XCTest/XCTest.h>
+
+#import "MXStoreSnapshot.h"
+#import "MXMemoryStore.h"
+#import "MXFileStore.h"
+#import "MXReceiptData.h"
+
+@interface MXStoreSnapshotTests : XCTestCase
+{
+    NSString *snapshotFile;
+}
+
+@end
+
+@implementation MXStoreSnapshotTests
+
+- (void)setUp
+{
+    [super setUp];
+
+    snapshotFile = [NSTemporaryDirectory() stringByAppendingPathComponent:@"MXStoreSnapshotTests"];
+}
+
+- (void)tearDown
+{
+    [[NSFileManager defaultManager] removeItemAtPath:snapshotFile error:nil];
+
+    [super tearDown];
+}
+
+- (void)testExportImport
+{
+    NSString *roomId = @"!room:matrix.org";
+
+    MXMemoryStore *store = [[MXMemoryStore alloc] init];
+    store.eventStreamToken = @"streamToken";
+
+    for (NSUInteger i = 0; i < 10; i++)
+    {
+        MXEvent *event = [MXEvent modelFromJSON:@{
+                                                  @"event_id": [NSString stringWithFormat:@"$%tu", i],
+                                                  @"type": kMXEventTypeStringRoomMessage,
+                                                  @"room_id": roomId,
+                                                  @"sender": @"@alice:matrix.org",
+                                                  @"content": @{@"msgtype": kMXMessageTypeText, @"body": @"Hello"}
+                                                  }];
+        [store storeEventForRoom:roomId event:event direction:MXTimelineDirectionForwards];
+    }
+    [store storePaginationTokenOfRoom:roomId andToken:@"paginationToken"];
+    [store storeNotificationCountOfRoom:roomId count:3];
+
+    MXReceiptData *receipt = [[MXReceiptData alloc] init];
+    receipt.userId = @"@alice:matrix.org";
+    receipt.eventId = @"$9";
+    receipt.ts = 1000;
+    [store storeReceipt:receipt inRoom:roomId];
+
+    [store storeUser:[[MXUser alloc] initWithUserId:@"@bob:matrix.org"]];
+
+    XCTestExpectation *expectation = [self expectationWithDescription:@"asyncTest"];
+
+    [MXStoreSnapshot exportStore:store toFile:snapshotFile success:^{
+
+        MXMemoryStore *store2 = [[MXMemoryStore alloc] init];
+        [MXStoreSnapshot importFile:snapshotFile intoStore:store2 success:^{
+
+            XCTAssertEqualObjects(store2.eventStreamToken, @"streamToken");
+            XCTAssertEqualObjects(store2.rooms, @[roomId]);
+
+            id<MXEventsEnumerator> enumerator = [store2 messagesEnumeratorForRoom:roomId];
+            XCTAssertEqual(enumerator.remaining, 10);
+            XCTAssertEqualObjects(enumerator.nextEvent.eventId, @"$9");
+
+            XCTAssertEqualObjects([store2 paginationTokenOfRoom:roomId], @"paginationToken");
+            XCTAssertEqual([store2 notificationCountOfRoom:roomId], 3);
+            XCTAssertEqualObjects([store2 getReceiptInRoom:roomId forUserId:@"@alice:matrix.org"].eventId, @"$9");
+            XCTAssertNotNil([store2 userWithUserId:@"@bob:matrix.org"]);
+
+            [expectation fulfill];
+
+        } failure:^(NSError *error) {
+            XCTFail(@"The request should not fail - NSError: %@", error);
+            [expectation fulfill];
+        }];
+
+    } failure:^(NSError *error) {
+        XCTFail(@"The request should not fail - NSError: %@", error);
+        [expectation fulfill];
+    }];
+
+    [self waitForExpectationsWithTimeout:10 handler:nil];
+}
+
+- (void)testImportInvalidFile
+{
+    [@"Not a snapshot" writeToFile:snapshotFile atomically:YES encoding:NSUTF8StringEncoding error:nil];
+
+    XCTestExpectation *expectation = [self expectationWithDescription:@"asyncTest"];
+
+    [MXStoreSnapshot importFile:snapshotFile intoStore:[[MXMemoryStore alloc] init] success:^{
+
+        XCTFail(@"The import should fail");
+        [expectation fulfill];
+
+    } failure:^(NSError *error) {
+
+        XCTAssertEqualObjects(error.domain, kMXStoreSnapshotErrorDomain);
+        [expectation fulfill];
+    }];
+
+    [self waitForExpectationsWithTimeout:10 handler:nil];
+}
+
+- (void)testExportFileStoreUncommittedData
+{
+    NSString *committedRoomId = @"!committed:matrix.org";
+    NSString *pendingRoomId = @"!pending:matrix.org";
+
+    MXEvent *memberEvent = [MXEvent modelFromJSON:@{
+                                                    @"event_id": @"$member",
+                                                    @"type": kMXEventTypeStringRoomMember,
+                                                    @"state_key": @"@alice:matrix.org",
+                                                    @"sender": @"@alice:matrix.org",
+                                                    @"content": @{@"membership": kMXMembershipStringJoin}
+                                                    }];
+    MXRoomAccountData *accountData = [[MXRoomAccountData alloc] init];
+    [accountData handleEvent:[MXEvent modelFromJSON:@{
+                                                      @"type": kMXEventTypeStringRoomTag,
+                                                      @"content": @{@"tags": @{kMXRoomTagFavourite: @{}}}
+                                                      }]];
+
+    XCTestExpectation *expectation = [self expectationWithDescription:@"asyncTest"];
+
+    MXFileStore *store = [[MXFileStore alloc] init];
+    [store openWithCredentials:[[MXCredentials alloc] initWithHomeServer:@"http://localhost:8008" userId:@"@snapshot1:localhost" accessToken:@"token"] onComplete:^{
+
+        // The state of a room is committed, the data of the other one is not
+        [store storeEventForRoom:committedRoomId event:memberEvent direction:MXTimelineDirectionForwards];
+        [store storeStateForRoom:committedRoomId stateEvents:@[memberEvent]];
+        [store commit];
+
+        [store storeEventForRoom:pendingRoomId event:memberEvent direction:MXTimelineDirectionForwards];
+        [store storeStateForRoom:pendingRoomId stateEvents:@[memberEvent]];
+        [store storeAccountDataForRoom:pendingRoomId userData:accountData];
+
+        [MXStoreSnapshot exportStore:store toFile:snapshotFile success:^{
+
+            MXFileStore *store2 = [[MXFileStore alloc] init];
+            [store2 openWithCredentials:[[MXCredentials alloc] initWithHomeServer:@"http://localhost:8008" userId:@"@snapshot2:localhost" accessToken:@"token"] onComplete:^{
+
+                [MXStoreSnapshot importFile:snapshotFile intoStore:store2 success:^{
+
+                    [store2 asyncStatesAndAccountDataOfRooms:@[committedRoomId, pendingRoomId] onComplete:^(NSDictionary<NSString *,NSArray<MXEvent *> *> *states, NSDictionary<NSString *,MXRoomAccountData *> *accountData) {
+
+                        XCTAssertEqual(states[committedRoomId].count, 1);
+                        XCTAssertEqual(states[pendingRoomId].count, 1, @"Uncommitted states must be exported");
+                        XCTAssertNotNil(accountData[pendingRoomId].tags[kMXRoomTagFavourite], @"Uncommitted account data must be exported");
+
+                        [store deleteAllData];
+                        [store close];
+                        [store2 deleteAllData];
+                        [store2 close];
+
+                        [expectation fulfill];
+                    }];
+
+                } failure:^(NSError *error) {
+                    XCTFail(@"The request should not fail - NSError: %@", error);
+                    [expectation fulfill];
+                }];
+
+            } failure:^(NSError *error) {
+                XCTFail(@"The request should not fail - NSError: %@", error);
+                [expectation fulfill];
+            }];
+
+        } failure:^(NSError *error) {
+            XCTFail(@"The request should not fail - NSError: %@", error);
+            [expectation fulfill];
+        }];
+
+    } failure:^(NSError *error) {
+        XCTFail(@"The request should not fail - NSError: %@", error);
+        [expectation fulfill];
+    }];
+
+    [self waitForExpectationsWithTimeout:10 handler:nil];
+}
+
+@end
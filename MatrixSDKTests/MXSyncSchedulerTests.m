@@ -0,0 +1,70 @@
+/*
+ Copyright 2016 OpenMarket Ltd
+
+ Licensed under the Apache License, Version 2.0 (the "License");
+ you may not use this file except in compliance with the License.
+ You may obtain a copy of the License at
+
+ http://www.apache.org/licenses/LICENSE-2.0
+
+ Unless required by applicable law or agreed to in writing, software
+ distributed under the License is distributed on an "AS IS" BASIS,
+ WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ See the License for the specific language governing permissions and
+ limitations under the License.
+ */
+
+#import <XCTest/XCTest.h>
+
+#import "MXSyncScheduler.h"
+
+@interface MXSyncSchedulerTests : XCTestCase
+@end
+
+@implementation MXSyncSchedulerTests
+
+- (void)testServerTimeoutAdaptsToFailures
+{
+    MXSyncScheduler *syncScheduler = [[MXSyncScheduler alloc] init];
+    NSUInteger serverTimeout = syncScheduler.serverTimeout;
+
+    [syncScheduler didFail];
+    [syncScheduler didFail];
+
+    XCTAssertGreaterThan(syncScheduler.failureRate, 0);
+    XCTAssertLessThan(syncScheduler.serverTimeout, serverTimeout);
+
+    // The timeout has a floor
+    for (NSUInteger i = 0; i < 100; i++)
+    {
+        [syncScheduler didFail];
+    }
+    XCTAssertGreaterThanOrEqual(syncScheduler.serverTimeout, 5000);
+
+    // And it comes back once requests succeed again
+    for (NSUInteger i = 0; i < 100; i++)
+    {
+        [syncScheduler didSucceedWithTimeToFirstByte:100 serverTimeout:syncScheduler.serverTimeout];
+    }
+    XCTAssertEqual(syncScheduler.serverTimeout, serverTimeout);
+}
+
+- (void)testTimeToFirstByte
+{
+    MXSyncScheduler *syncScheduler = [[MXSyncScheduler alloc] init];
+
+    [syncScheduler didSucceedWithTimeToFirstByte:200 serverTimeout:0];
+    XCTAssertEqual(syncScheduler.lastTimeToFirstByte, 200);
+    XCTAssertEqual(syncScheduler.averageTimeToFirstByte, 200);
+
+    // Long polls do not count in the average
+    [syncScheduler didSucceedWithTimeToFirstByte:30000 serverTimeout:30000];
+    XCTAssertEqual(syncScheduler.lastTimeToFirstByte, 30000);
+    XCTAssertEqual(syncScheduler.averageTimeToFirstByte, 200);
+
+    [syncScheduler didSucceedWithTimeToFirstByte:400 serverTimeout:0];
+    XCTAssertGreaterThan(syncScheduler.averageTimeToFirstByte, 200);
+    XCTAssertLessThan(syncScheduler.averageTimeToFirstByte, 400);
+}
+
+@end
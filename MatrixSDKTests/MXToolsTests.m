@@ -42,4 +42,19 @@
     XCTAssertNotNil(secret);
 }
 
+- (void)testContentHashOfJSON
+{
+    NSString *contentHash = [MXTools contentHashOfJSON:@{@"a": @"b", @"c": @[@1, @"d"]}];
+
+    XCTAssertEqual(contentHash.length, 64);
+    XCTAssertEqualObjects(contentHash, [MXTools contentHashOfJSON:@{@"c": @[@1, @"d"], @"a": @"b"}]);
+    XCTAssertNotEqualObjects(contentHash, [MXTools contentHashOfJSON:@{@"a": @"b", @"c": @[@"d", @1]}]);
+    XCTAssertNotEqualObjects([MXTools contentHashOfJSON:@[@"ab", @"c"]], [MXTools contentHashOfJSON:@[@"a", @"bc"]]);
+
+    // Booleans are not numbers
+    XCTAssertNotEqualObjects([MXTools contentHashOfJSON:@{@"enabled": @YES}], [MXTools contentHashOfJSON:@{@"enabled": @1}]);
+    XCTAssertNotEqualObjects([MXTools contentHashOfJSON:@{@"enabled": @NO}], [MXTools contentHashOfJSON:@{@"enabled": @0}]);
+    XCTAssertNotEqualObjects([MXTools contentHashOfJSON:@{@"enabled": @YES}], [MXTools contentHashOfJSON:@{@"enabled": @NO}]);
+}
+
 @end
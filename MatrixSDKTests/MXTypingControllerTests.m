@@ -0,0 +1,155 @@
+/*
+ Copyright 2016 OpenMarket Ltd
+
+ Licensed under the Apache License, Version 2.0 (the "License");
+ you may not use this file except in compliance with the License.
+ You may obtain a copy of the License at
+
+ http://www.apache.org/licenses/LICENSE-2.0
+
+ Unless required by applicable law or agreed to in writing, software
+ distributed under the License is distributed on an "AS IS" BASIS,
+ WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ See the License for the specific language governing permissions and
+ limitations under the License.
+ */
+
+#import <UIKit/UIKit.h>
+#import <XCTest/XCTest.h>
+
+#import "MXRoom.h"
+#import "MXTypingController.h"
+
+/**
+ A room that records typing notifications instead of sending them.
+ */
+@interface MXTypingControllerTestsRoom : MXRoom
+
+@property (nonatomic) NSMutableArray<NSNumber*> *sentTypingNotifications;
+
+@end
+
+@implementation MXTypingControllerTestsRoom
+
+- (MXHTTPOperation *)sendTypingNotification:(BOOL)typing timeout:(NSUInteger)timeout success:(void (^)())success failure:(void (^)(NSError *))failure
+{
+    if (!_sentTypingNotifications)
+    {
+        _sentTypingNotifications = [NSMutableArray array];
+    }
+    [_sentTypingNotifications addObject:@(typing)];
+    return nil;
+}
+
+@end
+
+
+@interface MXTypingControllerTests : XCTestCase
+{
+    MXTypingControllerTestsRoom *room;
+    MXTypingController *typingController;
+}
+
+@end
+
+@implementation MXTypingControllerTests
+
+- (void)setUp
+{
+    [super setUp];
+
+    room = [[MXTypingControllerTestsRoom alloc] init];
+    typingController = [[MXTypingController alloc] initWithRoom:room];
+    typingController.minimumRequestInterval = 0.2;
+}
+
+- (void)tearDown
+{
+    [typingController close];
+    typingController = nil;
+    room = nil;
+
+    [super tearDown];
+}
+
+- (void)testStartOnce
+{
+    for (NSUInteger i = 0; i < 20; i++)
+    {
+        [typingController userIsTyping];
+    }
+
+    XCTAssertTrue(typingController.isTyping);
+    XCTAssertEqualObjects(room.sentTypingNotifications, @[@YES]);
+}
+
+- (void)testRateLimit
+{
+    XCTestExpectation *expectation = [self expectationWithDescription:@"asyncTest"];
+
+    [typingController userIsTyping];
+    [typingController userStoppedTyping];
+    [typingController userIsTyping];
+    [typingController userStoppedTyping];
+
+    // The stop must be delayed by the rate limit
+    XCTAssertEqualObjects(room.sentTypingNotifications, @[@YES]);
+
+    dispatch_after(dispatch_time(DISPATCH_TIME_NOW, 0.4 * NSEC_PER_SEC), dispatch_get_main_queue(), ^{
+
+        XCTAssertEqualObjects(room.sentTypingNotifications, (@[@YES, @NO]));
+        [expectation fulfill];
+    });
+
+    [self waitForExpectationsWithTimeout:1 handler:nil];
+}
+
+- (void)testIdle
+{
+    XCTestExpectation *expectation = [self expectationWithDescription:@"asyncTest"];
+
+    typingController.idleTimeout = 0.3;
+    [typingController userIsTyping];
+
+    dispatch_after(dispatch_time(DISPATCH_TIME_NOW, 0.5 * NSEC_PER_SEC), dispatch_get_main_queue(), ^{
+
+        XCTAssertFalse(typingController.isTyping);
+        XCTAssertEqualObjects(room.sentTypingNotifications, (@[@YES, @NO]));
+        [expectation fulfill];
+    });
+
+    [self waitForExpectationsWithTimeout:1 handler:nil];
+}
+
+- (void)testRenewal
+{
+    XCTestExpectation *expectation = [self expectationWithDescription:@"asyncTest"];
+
+    // The notification expires before the renewal margin: it is renewed at the rate limit
+    typingController.typingTimeout = 1000;
+    [typingController userIsTyping];
+
+    dispatch_after(dispatch_time(DISPATCH_TIME_NOW, 0.3 * NSEC_PER_SEC), dispatch_get_main_queue(), ^{
+
+        XCTAssertEqualObjects(room.sentTypingNotifications, (@[@YES, @YES]));
+        [expectation fulfill];
+    });
+
+    [self waitForExpectationsWithTimeout:1 handler:nil];
+}
+
+- (void)testPendingTimersDoNotRetainTheController
+{
+    __weak MXTypingController *weakTypingController;
+
+    @autoreleasepool
+    {
+        MXTypingController *typingController2 = [[MXTypingController alloc] initWithRoom:room];
+        [typingController2 userIsTyping];
+        weakTypingController = typingController2;
+    }
+
+    XCTAssertNil(weakTypingController);
+}
+
+@end
@@ -16,6 +16,7 @@
 
 #import <UIKit/UIKit.h>
 #import <XCTest/XCTest.h>
+#import <Security/Security.h>
 
 #import "MatrixSDKTestsData.h"
 #import "MXSession.h"
@@ -23,6 +24,12 @@
 #import "MXMockCallStack.h"
 #import "MXMockCallStackCall.h"
 
+@interface MXCallManager (MXVoIPTests)
+
+- (void)saveTURNServers;
+
+@end
+
 @interface MXVoIPTests : XCTestCase
 {
     MatrixSDKTestsData *matrixSDKTestsData;
@@ -141,5 +148,165 @@
 //}
 
 
+#pragma mark - Signalling and metrics
+- (void)testLocalICECandidatesAfterInvite
+{
+    [matrixSDKTestsData doMXSessionTestWithBobAndAliceInARoom:self readyToTest:^(MXSession *bobSession, MXRestClient *aliceRestClient, NSString *roomId, XCTestExpectation *expectation) {
+
+        mxSession = bobSession;
+        [mxSession enableVoIPWithCallStack:[[MXMockCallStack alloc] init]];
+
+        MXRoom *room = [mxSession roomWithRoomId:roomId];
+
+        __block MXCall *theCall;
+        __block NSUInteger candidatesCount = 0;
+        NSMutableArray<MXEvent*> *callEvents = [NSMutableArray array];
+
+        [room.liveTimeline listenToEventsOfTypes:@[kMXEventTypeStringCallInvite, kMXEventTypeStringCallCandidates] onEvent:^(MXEvent *event, MXTimelineDirection direction, MXRoomState *roomState) {
+
+            [callEvents addObject:event];
+            candidatesCount += ((NSArray*)event.content[@"candidates"]).count;
+
+            // The mock gathers 5 candidates
+            if (candidatesCount == 5)
+            {
+                XCTAssertEqualObjects(callEvents.firstObject.type, kMXEventTypeStringCallInvite, @"Candidates must be sent after the invite");
+                XCTAssertLessThan(callEvents.count - 1, 5, @"Candidates must be batched");
+                XCTAssertGreaterThan(theCall.firstICECandidateDelay, 0);
+
+                [expectation fulfill];
+            }
+        }];
+
+        [room placeCallWithVideo:NO success:^(MXCall *call) {
+
+            theCall = call;
+
+        } failure:^(NSError *error) {
+            XCTFail(@"The request should not fail - NSError: %@", error);
+            [expectation fulfill];
+        }];
+    }];
+}
+
+- (void)testCallSetupDuration
+{
+    [matrixSDKTestsData doMXSessionTestWithBobAndAliceInARoom:self readyToTest:^(MXSession *bobSession, MXRestClient *aliceRestClient, NSString *roomId, XCTestExpectation *expectation) {
+
+        mxSession = bobSession;
+        [mxSession enableVoIPWithCallStack:[[MXMockCallStack alloc] init]];
+
+        __block id newCallObserver, callStateObserver;
+
+        // Answer the incoming call
+        newCallObserver = [[NSNotificationCenter defaultCenter] addObserverForName:kMXCallManagerNewCall object:nil queue:nil usingBlock:^(NSNotification *notif) {
+
+            MXCall *call = notif.object;
+            XCTAssertEqual(call.setupDuration, 0);
+
+            [call answer];
+        }];
+
+        callStateObserver = [[NSNotificationCenter defaultCenter] addObserverForName:kMXCallStateDidChange object:nil queue:nil usingBlock:^(NSNotification *notif) {
+
+            MXCall *call = notif.object;
+            if (call.state == MXCallStateConnected)
+            {
+                XCTAssertGreaterThan(call.setupDuration, 0);
+                XCTAssertGreaterThan(call.firstICECandidateDelay, 0, @"Candidates must be sent once the answer has been sent");
+                XCTAssertLessThanOrEqual(call.firstICECandidateDelay, call.setupDuration);
+
+                [[NSNotificationCenter defaultCenter] removeObserver:newCallObserver];
+                [[NSNotificationCenter defaultCenter] removeObserver:callStateObserver];
+                [expectation fulfill];
+            }
+        }];
+
+        NSDictionary *content = @{
+                                  @"call_id": @"callId",
+                                  @"offer": @{
+                                          @"type": @"offer",
+                                          @"sdp": @"A SDP"
+                                          },
+                                  @"version": @(0),
+                                  @"lifetime": @(30 * 1000)
+                                  };
+
+        [aliceRestClient sendEventToRoom:roomId eventType:kMXEventTypeStringCallInvite content:content success:nil failure:^(NSError *error) {
+            XCTFail(@"Cannot set up intial test conditions - error: %@", error);
+            [expectation fulfill];
+        }];
+    }];
+}
+
+- (void)testTURNServersCache
+{
+    // No homeserver is required
+    MXCredentials *credentials = [[MXCredentials alloc] initWithHomeServer:@"http://localhost:1" userId:@"@turncache:localhost" accessToken:@"token"];
+    MXRestClient *restClient = [[MXRestClient alloc] initWithCredentials:credentials andOnUnrecognizedCertificateBlock:nil];
+
+    MXTurnServerResponse *turnServers = [MXTurnServerResponse modelFromJSON:@{
+                                                                              @"username": @"username",
+                                                                              @"password": @"password",
+                                                                              @"uris": @[@"turn:turn.localhost:3478?transport=udp"],
+                                                                              @"ttl": @(86400)
+                                                                              }];
+
+    MXSession *session = [[MXSession alloc] initWithMatrixRestClient:restClient];
+    [session enableVoIPWithCallStack:[[MXMockCallStack alloc] init]];
+    [session.callManager setValue:turnServers forKey:@"turnServers"];
+    [session.callManager saveTURNServers];
+    [session close];
+
+    // The credentials are secrets: they must be in the Keychain, readable after the first unlock
+    NSDictionary *query = @{
+                            (__bridge id)kSecClass: (__bridge id)kSecClassGenericPassword,
+                            (__bridge id)kSecAttrService: @"org.matrix.sdk.MXCallManager.turnServers",
+                            (__bridge id)kSecAttrAccount: credentials.userId,
+                            (__bridge id)kSecReturnAttributes: @(YES)
+                            };
+    CFTypeRef result = NULL;
+    XCTAssertEqual(SecItemCopyMatching((__bridge CFDictionaryRef)query, &result), errSecSuccess);
+    NSDictionary *attributes = (__bridge_transfer NSDictionary*)result;
+    XCTAssertEqualObjects(attributes[(__bridge id)kSecAttrAccessible], (__bridge id)kSecAttrAccessibleAfterFirstUnlock);
+
+    NSString *cachePath = [NSSearchPathForDirectoriesInDomains(NSCachesDirectory, NSUserDomainMask, YES) objectAtIndex:0];
+    XCTAssertFalse([[NSFileManager defaultManager] fileExistsAtPath:[cachePath stringByAppendingPathComponent:@"MXCallManager"]]);
+
+    // After an app restart, a new session of the same user gets them without request.
+    // Nothing is kept in memory between sessions: they are read back from the Keychain
+    session = [[MXSession alloc] initWithMatrixRestClient:restClient];
+    [session enableVoIPWithCallStack:[[MXMockCallStack alloc] init]];
+
+    MXTurnServerResponse *restoredTurnServers = session.callManager.turnServers;
+    XCTAssertNotNil(restoredTurnServers);
+    XCTAssertNotEqual(restoredTurnServers, turnServers);
+    XCTAssertEqualObjects(restoredTurnServers.username, turnServers.username);
+    XCTAssertEqualObjects(restoredTurnServers.password, turnServers.password);
+    XCTAssertEqualObjects(restoredTurnServers.uris, turnServers.uris);
+    XCTAssertEqual(restoredTurnServers.ttlExpirationLocalTs, turnServers.ttlExpirationLocalTs, @"The TTL must not restart from the launch");
+
+    // Credentials about to expire are not reused
+    MXTurnServerResponse *expiringTurnServers = [MXTurnServerResponse modelFromJSON:@{
+                                                                                      @"username": @"username",
+                                                                                      @"password": @"password",
+                                                                                      @"uris": @[@"turn:turn.localhost:3478?transport=udp"],
+                                                                                      @"ttl": @(30)
+                                                                                      }];
+    [session.callManager setValue:expiringTurnServers forKey:@"turnServers"];
+    [session.callManager saveTURNServers];
+    [session close];
+
+    session = [[MXSession alloc] initWithMatrixRestClient:restClient];
+    [session enableVoIPWithCallStack:[[MXMockCallStack alloc] init]];
+    XCTAssertNil(session.callManager.turnServers);
+
+    // Clearing the credentials removes them from the Keychain
+    [session.callManager setValue:nil forKey:@"turnServers"];
+    [session.callManager saveTURNServers];
+    [session close];
+
+    XCTAssertEqual(SecItemCopyMatching((__bridge CFDictionaryRef)query, NULL), errSecItemNotFound);
+}
 
 @end
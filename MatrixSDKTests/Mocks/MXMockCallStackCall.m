@@ -16,6 +16,11 @@
 
 #import "MXMockCallStackCall.h"
 
+/**
+ The number of local ICE candidates the mock gathers after creating an offer or an answer.
+ */
+#define MXMOCKCALLSTACKCALL_ICE_CANDIDATES_COUNT 5
+
 @interface MXMockCallStackCall ()
 {
 }
@@ -64,6 +69,7 @@
 {
     dispatch_async(dispatch_get_main_queue(), ^{
         success(@"SDP ANWER");
+        [self gatherLocalICECandidates];
     });
 }
 
@@ -73,6 +79,7 @@
 {
     dispatch_async(dispatch_get_main_queue(), ^{
         success(@"SDP OFFER");
+        [self gatherLocalICECandidates];
     });
 }
 
@@ -83,5 +90,20 @@
     });
 }
 
-@end
 
+#pragma mark - Private methods
+/**
+ Simulate the gathering of local ICE candidates like a real call stack would do:
+ candidates come with increasing delays.
+ */
+- (void)gatherLocalICECandidates
+{
+    for (NSUInteger i = 0; i < MXMOCKCALLSTACKCALL_ICE_CANDIDATES_COUNT; i++)
+    {
+        dispatch_after(dispatch_time(DISPATCH_TIME_NOW, (i * i * 10) * NSEC_PER_MSEC), dispatch_get_main_queue(), ^{
+            [self.delegate callStackCall:self onICECandidateWithSdpMid:@"audio" sdpMLineIndex:0 candidate:[NSString stringWithFormat:@"candidate:%tu 1 udp 2122260223 192.168.0.%tu 54321 typ host", i, i]];
+        });
+    }
+}
+
+@end